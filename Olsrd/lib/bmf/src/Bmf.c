@@ -54,7 +54,9 @@
 #include <netinet/ip.h> /* struct ip */
 #include <netinet/udp.h> /* struct udphdr */
 #include <unistd.h> /* read(), write() */
-#include <sys/poll.h> /* Daniele Lacamera: Added guard poll for sendto(), needs poll.h */
+#include <sys/socket.h> /* sendmsg(), struct msghdr */
+#include <sys/uio.h> /* struct iovec */
+#include <sys/syscall.h> /* syscall(), __NR_sendmmsg */
 
 /* OLSRD includes */
 #include "plugin_util.h" /* set_plugin_int */
@@ -65,6 +67,7 @@
 #include "mpr_selector_set.h" /* olsr_lookup_mprs_set() */
 #include "link_set.h" /* get_best_link_to_neighbor() */
 #include "net_olsr.h" /* ipequal */
+#include "scheduler.h" /* enable_olsr_socket(), disable_olsr_socket() */
 
 /* BMF includes */
 #include "NetworkInterfaces.h" /* TBmfInterface, CreateBmfNetworkInterfaces(), CloseBmfNetworkInterfaces() */
@@ -77,6 +80,17 @@ int FanOutLimit = 2;
 
 int BroadcastRetransmitCount = 1;
 
+/* What to drop when a transmit queue is full */
+enum TBmfTxDropPolicy TxDropPolicy = TDP_DROP_NEWEST;
+
+/* Layout of the kernel's struct mmsghdr. Declared here because not every
+ * C library (e.g. Android's bionic) provides sendmmsg() and its types. */
+struct TBmfMmsgHdr
+{
+  struct msghdr msg_hdr;
+  unsigned int msg_len;
+};
+
 /* -------------------------------------------------------------------------
  * Function   : BmfPError
  * Description: Prints an error message at OLSR debug level 1.
@@ -135,6 +149,234 @@ union olsr_ip_addr* MainAddressOf(union olsr_ip_addr* ip)
   return result;
 } /* MainAddressOf */
 
+/* -------------------------------------------------------------------------
+ * Function   : SendBatch
+ * Description: Send a batch of datagrams on a socket, in a single system call
+ *              if the kernel supports sendmmsg()
+ * Input      : skfd - the socket on which to send
+ *              msgs - the datagrams to send
+ *              nMsgs - the number of datagrams in 'msgs'
+ *              flags - flags for sending
+ * Output     : syscallName - the system call used, for error messages
+ * Return     : the number of datagrams sent, or -1 (with errno set) if none
+ *              could be sent
+ * Data Used  : none
+ * ------------------------------------------------------------------------- */
+static int SendBatch(int skfd, struct TBmfMmsgHdr* msgs, int nMsgs, int flags, const char** syscallName)
+{
+  int i;
+
+#ifdef __NR_sendmmsg
+  int nSent = syscall(__NR_sendmmsg, skfd, msgs, nMsgs, flags);
+  if (nSent >= 0 || errno != ENOSYS)
+  {
+    *syscallName = "sendmmsg()";
+    return nSent;
+  }
+  /* Kernel older than 3.0: fall back to one sendmsg() per datagram */
+#endif
+
+  *syscallName = "sendmsg()";
+
+  for (i = 0; i < nMsgs; i++)
+  {
+    if (sendmsg(skfd, &msgs[i].msg_hdr, flags) < 0)
+    {
+      /* Like sendmmsg(), only report an error if nothing was sent */
+      return i > 0 ? i : -1;
+    }
+  }
+  return nMsgs;
+} /* SendBatch */
+
+/* -------------------------------------------------------------------------
+ * Function   : SetTxBlocked
+ * Description: Set the socket for which the transmit queue of a network
+ *              interface awaits write readiness
+ * Input      : intf - the network interface
+ *              skfd - the socket to watch for write readiness, or -1 to
+ *                stop watching
+ * Output     : none
+ * Return     : none
+ * Data Used  : none
+ * ------------------------------------------------------------------------- */
+static void SetTxBlocked(struct TBmfInterface* intf, int skfd)
+{
+  struct TBmfTxQueue* txq = &intf->txQueue;
+
+  if (txq->blockedSkfd == skfd)
+  {
+    return;
+  }
+
+  if (txq->blockedSkfd >= 0)
+  {
+    disable_olsr_socket(
+      txq->blockedSkfd,
+      NULL,
+      txq->blockedSkfd == intf->encapsulatingSkfd ? &BMF_handle_encapsulatingFd : &BMF_handle_captureFd,
+      SP_IMM_WRITE);
+  }
+  if (skfd >= 0)
+  {
+    enable_olsr_socket(
+      skfd,
+      NULL,
+      skfd == intf->encapsulatingSkfd ? &BMF_handle_encapsulatingFd : &BMF_handle_captureFd,
+      SP_IMM_WRITE);
+  }
+  txq->blockedSkfd = skfd;
+} /* SetTxBlocked */
+
+/* -------------------------------------------------------------------------
+ * Function   : FlushTxQueue
+ * Description: Send as many queued packets of a network interface as
+ *              possible without blocking
+ * Input      : intf - the network interface
+ * Output     : none
+ * Return     : none
+ * Data Used  : none
+ * Notes      : Consecutive packets for the same socket are sent with one
+ *              sendmmsg() call. If the socket buffer is full, the remaining
+ *              packets stay queued and sending continues as soon as the
+ *              socket becomes writable.
+ * ------------------------------------------------------------------------- */
+static void FlushTxQueue(struct TBmfInterface* intf)
+{
+  struct TBmfTxQueue* txq = &intf->txQueue;
+  struct TBmfMmsgHdr msgs[BMF_TXQ_LEN];
+  struct iovec iov[BMF_TXQ_LEN];
+
+  while (txq->count > 0)
+  {
+    struct TBmfTxPacket* first = &txq->packets[txq->head];
+    const char* syscallName;
+    int nMsgs = 0;
+    int nSent;
+
+    /* Collect the run of packets that go out on the same socket */
+    while (nMsgs < txq->count)
+    {
+      struct TBmfTxPacket* pkt = &txq->packets[(txq->head + nMsgs) % BMF_TXQ_LEN];
+
+      if (pkt->skfd != first->skfd || pkt->flags != first->flags)
+      {
+        break;
+      }
+
+      iov[nMsgs].iov_base = pkt->data;
+      iov[nMsgs].iov_len = pkt->len;
+
+      memset(&msgs[nMsgs], 0, sizeof(msgs[nMsgs]));
+      msgs[nMsgs].msg_hdr.msg_name = &pkt->dest;
+      msgs[nMsgs].msg_hdr.msg_namelen = pkt->destLen;
+      msgs[nMsgs].msg_hdr.msg_iov = &iov[nMsgs];
+      msgs[nMsgs].msg_hdr.msg_iovlen = 1;
+
+      nMsgs++;
+    }
+
+    nSent = SendBatch(first->skfd, msgs, nMsgs, first->flags | MSG_DONTWAIT, &syscallName);
+    if (nSent < 0)
+    {
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+      {
+        /* Socket buffer is full. Keep the packets queued and continue when
+         * the socket becomes writable. */
+        SetTxBlocked(intf, first->skfd);
+        return;
+      }
+
+      BmfPError("%s error forwarding pkt on \"%s\"", syscallName, intf->ifName);
+
+      /* Give up on the packet at the head of the queue */
+      txq->nSendErrors++;
+      nSent = 1;
+    }
+    else
+    {
+      txq->nBatches++;
+      intf->nBmfPacketsTx += nSent;
+    }
+
+    txq->head = (txq->head + nSent) % BMF_TXQ_LEN;
+    txq->count -= nSent;
+  } /* while */
+
+  /* Queue is empty: no need to watch for write readiness anymore */
+  SetTxBlocked(intf, -1);
+} /* FlushTxQueue */
+
+/* -------------------------------------------------------------------------
+ * Function   : QueuePacket
+ * Description: Append a copy of a packet to the transmit queue of a network
+ *              interface
+ * Input      : intf - the network interface
+ *              skfd - the socket on which to send the packet
+ *              flags - flags for sending the packet
+ *              dest - the destination of the packet
+ *              destLen - the length of 'dest'
+ *              data - the packet
+ *              len - the length of the packet
+ * Output     : none
+ * Return     : fail (0) or success (1)
+ * Data Used  : TxDropPolicy
+ * Notes      : If the queue is full, either the new packet or the oldest
+ *              queued packet is dropped, as specified by 'TxDropPolicy'.
+ *              Only dropping the new packet fails.
+ * ------------------------------------------------------------------------- */
+static int QueuePacket(
+  struct TBmfInterface* intf,
+  int skfd,
+  int flags,
+  const void* dest,
+  socklen_t destLen,
+  const unsigned char* data,
+  u_int16_t len)
+{
+  struct TBmfTxQueue* txq = &intf->txQueue;
+  struct TBmfTxPacket* pkt;
+
+  if (txq->count >= BMF_TXQ_LEN)
+  {
+    txq->nDropped++;
+
+    if (TxDropPolicy == TDP_DROP_NEWEST)
+    {
+      OLSR_PRINTF(
+        8,
+        "%s: --> TX queue of \"%s\" is full, dropping pkt\n",
+        PLUGIN_NAME_SHORT,
+        intf->ifName);
+      return 0;
+    }
+
+    /* Make room by dropping the oldest packet */
+    OLSR_PRINTF(
+      8,
+      "%s: --> TX queue of \"%s\" is full, dropping oldest pkt\n",
+      PLUGIN_NAME_SHORT,
+      intf->ifName);
+    txq->head = (txq->head + 1) % BMF_TXQ_LEN;
+    txq->count--;
+  }
+
+  pkt = &txq->packets[(txq->head + txq->count) % BMF_TXQ_LEN];
+  pkt->skfd = skfd;
+  pkt->flags = flags;
+  memcpy(&pkt->dest, dest, destLen);
+  pkt->destLen = destLen;
+  memcpy(pkt->data, data, len);
+  pkt->len = len;
+
+  txq->count++;
+  if (txq->count > txq->maxDepth)
+  {
+    txq->maxDepth = txq->count;
+  }
+  return 1;
+} /* QueuePacket */
+
 /* -------------------------------------------------------------------------
  * Function   : ForwardPacket
  * Description: Forward a raw IP packet
@@ -153,14 +395,8 @@ static void ForwardPacket(
   u_int16_t ipPacketLen,
   const char* debugInfo)
 {
-  int nBytesWritten;
   struct sockaddr_ll dest;
 
-  int pollret;
-  struct pollfd guard;
-  guard.fd = intf->capturingSkfd;
-  guard.events = POLLOUT;
-
   /* If the IP packet is a local broadcast packet,
    * update its destination address to match the subnet of the network
    * interface on which the packet is being sent. */
@@ -180,36 +416,23 @@ static void ForwardPacket(
    * in that case. */
   memset(dest.sll_addr, 0xFF, IFHWADDRLEN);
 
-  /* Daniele Lacamera: poll guard to avoid locking in sendto().
-   * Wait at most 2 polling periods. Since we're running in the context of the main
-   * OLSR thread, we should not wait too long. 2 polling periods is considered a
-   * reasonable time. */
-  pollret = poll (&guard, 1, 2 * olsr_cnf->pollrate * MSEC_PER_SEC);
-  if (pollret <= 0)
+  /* Queue the BMF packet for the capturing socket. Unless the queue is
+   * waiting for the socket to become writable, send it right away. */
+  if (QueuePacket(intf, intf->capturingSkfd, 0, &dest, sizeof(dest), ipPacket, ipPacketLen) == 0)
   {
-    BmfPError("sendto() on \"%s\": not ready to send pkt. pollret=%d\n", intf->ifName, pollret);
-
-    /* Apparently the network interface is jammed. Give up. */
+    OLSR_PRINTF(
+      8,
+      "%s: --> TX queue full, packet dropped, not %s \"%s\"\n",
+      PLUGIN_NAME_SHORT,
+      debugInfo,
+      intf->ifName);
     return;
   }
-
-  /* Forward the BMF packet via the capturing socket */
-  nBytesWritten = sendto(
-    intf->capturingSkfd,
-    ipPacket,
-    ipPacketLen,
-    0,
-    (struct sockaddr*) &dest,
-    sizeof(dest));
-  if (nBytesWritten != ipPacketLen)
+  if (intf->txQueue.blockedSkfd < 0)
   {
-    BmfPError("sendto() error forwarding pkt on \"%s\"", intf->ifName);
-    return;
+    FlushTxQueue(intf);
   }
 
-  /* Increase counter */
-  intf->nBmfPacketsTx++;
-
   OLSR_PRINTF(
     8,
     "%s: --> %s \"%s\"\n",
@@ -317,51 +540,31 @@ static void EncapsulateAndForwardPacket(
 
   for (i = 0; i < nPacketsToSend; i++)
   {
-    int nBytesWritten;
-
-    int pollret;
-    struct pollfd guard;
-    guard.fd = intf->encapsulatingSkfd;
-    guard.events = POLLOUT;
-
     if (sendUnicast == 1)
     {
       /* For unicast, overwrite the local broadcast address which was filled in above */
       forwardTo.sin_addr = bestNeighborLinks.links[i]->neighbor_iface_addr.v4;
     }
 
-    /* Daniele Lacamera: poll guard to avoid locking in sendto().
-     * Wait at most 2 polling periods. Since we're running in the context of the main
-     * OLSR thread, we should not wait too long. 2 polling periods is considered a
-     * reasonable time. */
-    pollret = poll (&guard, 1, 2 * olsr_cnf->pollrate * MSEC_PER_SEC);
-    if (pollret <= 0)
+    /* Queue a copy of the BMF packet for the encapsulation socket */
+    if (QueuePacket(
+          intf,
+          intf->encapsulatingSkfd,
+          MSG_DONTROUTE,
+          &forwardTo,
+          sizeof(forwardTo),
+          encapsulationUdpData,
+          udpDataLen) == 0)
     {
-      BmfPError("sendto() on \"%s\": not ready to send pkt. pollret=%d\n", intf->ifName, pollret);
-
-      /* Apparently the network interface is jammed. Give up and return. */
-      return;
+      OLSR_PRINTF(
+        8,
+        "%s: --> dropped encapsulated packet on \"%s\" to %s\n",
+        PLUGIN_NAME_SHORT,
+        intf->ifName,
+        inet_ntoa(forwardTo.sin_addr));
+      continue;
     }
 
-    /* Forward the BMF packet via the encapsulation socket */
-    nBytesWritten = sendto(
-      intf->encapsulatingSkfd,
-      encapsulationUdpData,
-      udpDataLen,
-      MSG_DONTROUTE,
-      (struct sockaddr*) &forwardTo,
-      sizeof(forwardTo));                   
-
-    /* Evaluate and display result */
-    if (nBytesWritten != udpDataLen)
-    {
-      BmfPError("sendto() error forwarding encapsulated pkt on \"%s\"", intf->ifName);
-      return;
-    } /* if (nBytesWritten != udpDataLen) */
-
-    /* Increase counter */
-    intf->nBmfPacketsTx++;
-
     OLSR_PRINTF(
       8,
       "%s: --> forwarded encapsulated packet on \"%s\" to %s\n",
@@ -369,6 +572,13 @@ static void EncapsulateAndForwardPacket(
       intf->ifName,
       inet_ntoa(forwardTo.sin_addr));
   } /* for */
+
+  /* Send all copies in one batch, unless the queue is waiting for the
+   * socket to become writable */
+  if (intf->txQueue.blockedSkfd < 0)
+  {
+    FlushTxQueue(intf);
+  }
 } /* EncapsulateAndForwardPacket */
 
 /* -------------------------------------------------------------------------
@@ -886,16 +1096,96 @@ static void BmfTunPacketCaptured(unsigned char* encapsulationUdpData)
 } /* BmfTunPacketCaptured */
 
 /* -------------------------------------------------------------------------
- * Function   : DoBmf
- * Description: Wait (blocking) for IP packets, then call the handler for each
- *              received packet
- * Input      : none
+ * Function   : BmfFrameCaptured
+ * Description: Handle a frame captured on a network interface
+ * Input      : walker - the network interface on which the frame was captured
+ *              rxBuffer - the captured IP packet, preceded by space for the
+ *                BMF encapsulation header
+ *              nBytes - the number of captured bytes
+ *              pktType - the packet type reported by the packet socket
  * Output     : none
  * Return     : none
- * Data Used  : BmfInterfaces
+ * Data Used  : none
+ * ------------------------------------------------------------------------- */
+static void BmfFrameCaptured(
+  struct TBmfInterface* walker,
+  unsigned char* rxBuffer,
+  int nBytes,
+  unsigned char pktType)
+{
+  /* Check if the number of received bytes is large enough for an IP
+   * packet which contains at least a minimum-size IP header.
+   * Note: There is an apparent bug in the packet socket implementation in
+   * combination with VLAN interfaces. On a VLAN interface, the value returned
+   * by 'recvfrom' may (but need not) be 4 (bytes) larger than the value
+   * returned on a non-VLAN interface, for the same ethernet frame. */
+  if (nBytes < (int)sizeof(struct ip))
+  {
+    olsr_printf(
+      1,
+      "%s: captured frame too short (%d bytes) on \"%s\"\n",
+      PLUGIN_NAME,
+      nBytes,
+      walker->ifName);
+    return;
+  }
+
+  if (pktType == PACKET_OUTGOING ||
+      pktType == PACKET_MULTICAST ||
+      pktType == PACKET_BROADCAST)
+  {
+    /* A multicast or broadcast packet was captured */
+
+    BmfPacketCaptured(walker, pktType, rxBuffer);
+
+  } /* if (pktType == ...) */
+} /* BmfFrameCaptured */
+
+/* -------------------------------------------------------------------------
+ * Function   : BmfRingFrameCaptured
+ * Description: Handle a frame from the receive ring of a capturing socket
+ * Input      : frame - the captured IP packet, inside the ring
+ *              len - the number of captured bytes
+ *              addr - link layer address information of the frame
+ *              data - the network interface on which the frame was captured
+ * Output     : none
+ * Return     : none
+ * Data Used  : none
+ * ------------------------------------------------------------------------- */
+static void BmfRingFrameCaptured(
+  unsigned char* frame,
+  unsigned int len,
+  struct sockaddr_ll* addr,
+  void* data)
+{
+  unsigned char rxBuffer[BMF_BUFFER_SIZE];
+
+  /* Copy the frame out of the ring, leaving space for the BMF
+   * encapsulation header; truncate like recvfrom() would */
+  if (len > BMF_BUFFER_SIZE - ENCAP_HDR_LEN)
+  {
+    len = BMF_BUFFER_SIZE - ENCAP_HDR_LEN;
+  }
+  memcpy(GetIpPacket(rxBuffer), frame, len);
+
+  BmfFrameCaptured(data, rxBuffer, len, addr->sll_pkttype);
+} /* BmfRingFrameCaptured */
+
+/* -------------------------------------------------------------------------
+ * Function   : BMF_handle_captureFd
+ * Description: Receive the IP packets captured on a network interface, then
+ *              call the handler for each received packet
+ * Input      : skfd - the capturing socket
+ *              data - the network interface
+ *              flags - SP_IMM_READ and/or SP_IMM_WRITE
+ * Output     : none
+ * Return     : none
+ * Data Used  : none
+ * Notes      : SP_IMM_WRITE is only set while the transmit queue of the
+ *              network interface waits for the socket to become writable
  * ------------------------------------------------------------------------- */
 void
-BMF_handle_captureFd(int skfd, void *data, unsigned int flags __attribute__ ((unused))) {
+BMF_handle_captureFd(int skfd, void *data, unsigned int flags) {
   unsigned char rxBuffer[BMF_BUFFER_SIZE];
   struct TBmfInterface* walker = data;
   struct sockaddr_ll pktAddr;
@@ -903,6 +1193,23 @@ BMF_handle_captureFd(int skfd, void *data, unsigned int flags __attribute__ ((un
   int nBytes;
   unsigned char* ipPacket;
 
+  /* Socket became writable: continue sending queued packets */
+  if ((flags & SP_IMM_WRITE) != 0)
+  {
+    FlushTxQueue(walker);
+  }
+  if ((flags & SP_IMM_READ) == 0)
+  {
+    return;
+  }
+
+  /* With a receive ring, handle all frames the kernel has handed over */
+  if (walker->captureRing.map != NULL)
+  {
+    ProcessPacketRing(&walker->captureRing, &BmfRingFrameCaptured, walker);
+    return;
+  }
+
   /* Receive the captured Ethernet frame, leaving space for the BMF
    * encapsulation header */
   ipPacket = GetIpPacket(rxBuffer);
@@ -919,32 +1226,7 @@ BMF_handle_captureFd(int skfd, void *data, unsigned int flags __attribute__ ((un
     return;
   } /* if (nBytes < 0) */
 
-  /* Check if the number of received bytes is large enough for an IP
-   * packet which contains at least a minimum-size IP header.
-   * Note: There is an apparent bug in the packet socket implementation in
-   * combination with VLAN interfaces. On a VLAN interface, the value returned
-   * by 'recvfrom' may (but need not) be 4 (bytes) larger than the value
-   * returned on a non-VLAN interface, for the same ethernet frame. */
-  if (nBytes < (int)sizeof(struct ip))
-  {
-    olsr_printf(
-      1,
-      "%s: captured frame too short (%d bytes) on \"%s\"\n",
-      PLUGIN_NAME,
-      nBytes,
-      walker->ifName);
-    return;
-  }
-
-  if (pktAddr.sll_pkttype == PACKET_OUTGOING ||
-      pktAddr.sll_pkttype == PACKET_MULTICAST ||
-      pktAddr.sll_pkttype == PACKET_BROADCAST)
-  {
-    /* A multicast or broadcast packet was captured */
-
-    BmfPacketCaptured(walker, pktAddr.sll_pkttype, rxBuffer);
-
-  } /* if (pktAddr.sll_pkttype == ...) */
+  BmfFrameCaptured(walker, rxBuffer, nBytes, pktAddr.sll_pkttype);
 }
 
 void
@@ -1039,7 +1321,7 @@ BMF_handle_listeningFd(int skfd, void *data, unsigned int flags __attribute__ ((
 }
 
 void
-BMF_handle_encapsulatingFd(int skfd, void *data, unsigned int flags __attribute__ ((unused))) {
+BMF_handle_encapsulatingFd(int skfd, void *data, unsigned int flags) {
   unsigned char rxBuffer[BMF_BUFFER_SIZE];
   struct TBmfInterface* walker = data;
   struct sockaddr_in from;
@@ -1048,6 +1330,16 @@ BMF_handle_encapsulatingFd(int skfd, void *data, unsigned int flags __attribute_
   int minimumLength;
   union olsr_ip_addr forwardedBy;
 
+  /* Socket became writable: continue sending queued packets */
+  if ((flags & SP_IMM_WRITE) != 0)
+  {
+    FlushTxQueue(walker);
+  }
+  if ((flags & SP_IMM_READ) == 0)
+  {
+    return;
+  }
+
   /* An encapsulated packet was received */
   nBytes = recvfrom(
     skfd,
@@ -1212,6 +1504,36 @@ int SetFanOutLimit(
   return 1;
 }
 
+/* -------------------------------------------------------------------------
+ * Function   : SetTxDropPolicy
+ * Description: Specify what to drop when a transmit queue is full
+ * Input      : policy - either "DropNewest" or "DropOldest"
+ *              data - not used
+ *              addon - not used
+ * Output     : none
+ * Return     : success (0) or fail (1)
+ * Data Used  : TxDropPolicy
+ * ------------------------------------------------------------------------- */
+int SetTxDropPolicy(
+  const char* policy,
+  void* data __attribute__((unused)),
+  set_plugin_parameter_addon addon __attribute__((unused)))
+{
+  if (strcmp(policy, "DropNewest") == 0)
+  {
+    TxDropPolicy = TDP_DROP_NEWEST;
+    return 0;
+  }
+  else if (strcmp(policy, "DropOldest") == 0)
+  {
+    TxDropPolicy = TDP_DROP_OLDEST;
+    return 0;
+  }
+
+  /* Value not recognized */
+  return 1;
+} /* SetTxDropPolicy */
+
 /* -------------------------------------------------------------------------
  * Function   : InitBmf
  * Description: Initialize the BMF plugin
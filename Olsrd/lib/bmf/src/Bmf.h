@@ -61,6 +61,9 @@ struct interface;
 extern int FanOutLimit;
 extern int BroadcastRetransmitCount;
 
+enum TBmfTxDropPolicy { TDP_DROP_NEWEST = 0, TDP_DROP_OLDEST };
+extern enum TBmfTxDropPolicy TxDropPolicy;
+
 void BMF_handle_captureFd(int skfd, void *data, unsigned int);
 void BMF_handle_listeningFd(int skfd, void *data, unsigned int);
 void BMF_handle_encapsulatingFd(int skfd, void *data, unsigned int);
@@ -70,6 +73,7 @@ void BmfPError(const char* format, ...) __attribute__((format(printf, 1, 2)));
 union olsr_ip_addr* MainAddressOf(union olsr_ip_addr* ip);
 void InterfaceChange(int, struct interface* interf, enum olsr_ifchg_flag action);
 int SetFanOutLimit(const char* value, void* data, set_plugin_parameter_addon addon);
+int SetTxDropPolicy(const char* policy, void* data, set_plugin_parameter_addon addon);
 int InitBmf(struct interface* skipThisIntf);
 void CloseBmf(void);
 
@@ -999,6 +999,13 @@ static int CreateCaptureSocket(const char* ifName)
     return -1;
   }
 
+  /* Let the kernel drop frames that are not multicast, broadcast or
+   * outgoing, instead of queueing every promiscuously received frame */
+  if (AttachCaptureFilter(skfd) < 0)
+  {
+    BmfPError("setsockopt(SO_ATTACH_FILTER) error");
+  }
+
   /* Set socket to blocking operation */
   if (fcntl(skfd, F_SETFL, fcntl(skfd, F_GETFL, 0) & ~O_NONBLOCK) < 0)
   {
@@ -1416,6 +1423,17 @@ static int CreateInterface(
     return 0;
   }
 
+  /* Map a receive ring for the capturing socket if configured; without
+   * it, captured packets are read with recvfrom() */
+  memset(&newIf->captureRing, 0, sizeof(newIf->captureRing));
+  if (capturingSkfd != -1 && UseCaptureRing != 0)
+  {
+    if (CreatePacketRing(&newIf->captureRing, capturingSkfd) < 0)
+    {
+      BmfPError("PACKET_RX_RING error for interface \"%s\"", ifName);
+    }
+  }
+
   /* add listeners to sockets */
   if (capturingSkfd != -1) {
     add_olsr_socket(capturingSkfd, NULL, BMF_handle_captureFd, newIf, SP_IMM_READ);
@@ -1481,6 +1499,15 @@ static int CreateInterface(
   newIf->nBmfPacketsRxDup = 0;
   newIf->nBmfPacketsTx = 0;
 
+  /* Start with an empty transmit queue */
+  newIf->txQueue.head = 0;
+  newIf->txQueue.count = 0;
+  newIf->txQueue.blockedSkfd = -1;
+  newIf->txQueue.maxDepth = 0;
+  newIf->txQueue.nBatches = 0;
+  newIf->txQueue.nDropped = 0;
+  newIf->txQueue.nSendErrors = 0;
+
   /* Add new TBmfInterface object to global list. OLSR interfaces are
    * added at the front of the list, non-OLSR interfaces at the back. */
   if (BmfInterfaces == NULL)
@@ -1660,6 +1687,7 @@ void CloseBmfNetworkInterfaces(void)
 
     if (bmfIf->capturingSkfd >= 0)
     {
+      ClosePacketRing(&bmfIf->captureRing);
       close(bmfIf->capturingSkfd);
       remove_olsr_socket(bmfIf->capturingSkfd, NULL, BMF_handle_captureFd);
       nClosed++;
@@ -1687,6 +1715,18 @@ void CloseBmfNetworkInterfaces(void)
       bmfIf->nBmfPacketsRxDup,
       bmfIf->nBmfPacketsTx);
 
+    OLSR_PRINTF(
+      7,
+      "%s: %s interface \"%s\": TX batches %u; TX queue max depth %d, %d pkts unsent; %u pkts dropped; %u send errors\n",
+      PLUGIN_NAME_SHORT,
+      bmfIf->olsrIntf != NULL ? "OLSR" : "non-OLSR",
+      bmfIf->ifName,
+      bmfIf->txQueue.nBatches,
+      bmfIf->txQueue.maxDepth,
+      bmfIf->txQueue.count,
+      bmfIf->txQueue.nDropped,
+      bmfIf->txQueue.nSendErrors);
+
     olsr_printf(
       1,
       "%s: closed %s interface \"%s\"\n", 
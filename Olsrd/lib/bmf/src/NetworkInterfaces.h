@@ -41,7 +41,8 @@
  * ------------------------------------------------------------------------- */
 
 /* System includes */
-#include <netinet/in.h> /* struct in_addr */
+#include <netinet/in.h> /* struct in_addr, struct sockaddr_in */
+#include <linux/if_packet.h> /* struct sockaddr_ll */
 
 /* OLSR includes */
 #include "olsr_types.h" /* olsr_ip_addr */
@@ -49,15 +50,64 @@
 
 /* Plugin includes */
 #include "Packet.h" /* IFHWADDRLEN */
+#include "PacketRing.h" /* struct TPacketRing */
 
 /* Size of buffer in which packets are received */
 #define BMF_BUFFER_SIZE 2048
 
+/* Number of packets that can wait in the transmit queue of an interface */
+#define BMF_TXQ_LEN 32
+
+/* A packet waiting in a transmit queue */
+struct TBmfTxPacket
+{
+  /* Socket on which the packet is to be sent, and flags for sending it */
+  int skfd;
+  int flags;
+
+  /* Destination of the packet */
+  union
+  {
+    struct sockaddr_in in;
+    struct sockaddr_ll ll;
+  } dest;
+  socklen_t destLen;
+
+  u_int16_t len;
+  unsigned char data[BMF_BUFFER_SIZE];
+};
+
+/* Transmit queue of a network interface. Packets to be forwarded are
+ * queued here and sent in batches, without ever blocking OLSR. When the
+ * socket buffer is full, the remaining packets wait until the socket
+ * becomes writable; when the queue itself is full, packets are dropped
+ * according to PlParam "TxDropPolicy". */
+struct TBmfTxQueue
+{
+  /* Ring of queued packets, oldest at 'head' */
+  struct TBmfTxPacket packets[BMF_TXQ_LEN];
+  int head;
+  int count;
+
+  /* Socket for which write readiness is awaited, or -1 if none */
+  int blockedSkfd;
+
+  /* Statistics */
+  int maxDepth;
+  u_int32_t nBatches;
+  u_int32_t nDropped;
+  u_int32_t nSendErrors;
+};
+
 struct TBmfInterface
 {
   /* File descriptor of raw packet socket, used for capturing multicast packets */
   int capturingSkfd;
 
+  /* Receive ring of the capturing socket. Only used when PlParam
+   * "CaptureRing" is set; 'map' is NULL otherwise. */
+  struct TPacketRing captureRing;
+
   /* File descriptor of UDP (datagram) socket for encapsulated multicast packets. 
    * Only used for OLSR-enabled interfaces; set to -1 if interface is not OLSR-enabled. */
   int encapsulatingSkfd;
@@ -85,6 +135,9 @@ struct TBmfInterface
   u_int32_t nBmfPacketsRxDup;
   u_int32_t nBmfPacketsTx;
 
+  /* Queue of packets waiting to be sent on this interface */
+  struct TBmfTxQueue txQueue;
+
   /* Next element in list */
   struct TBmfInterface* next; 
 };
@@ -33,7 +33,7 @@
 /* -------------------------------------------------------------------------
  * File       : PacketHistory.c
  * Description: Functions for keeping and accessing the history of processed
- *              multicast IP packets.
+ *              multicast IP packets. Also used by the P2PD plugin.
  * Created    : 29 Jun 2006
  *
  * ------------------------------------------------------------------------- */
@@ -43,22 +43,26 @@
 /* System includes */
 #include <stddef.h> /* NULL */
 #include <assert.h> /* assert() */
-#include <string.h> /* memset */
+#include <string.h> /* memset(), memcpy() */
 #include <sys/types.h> /* u_int16_t, u_int32_t */
-#include <netinet/ip.h> /* struct iphdr */
-#include <stdlib.h> /* free() */
 
 /* OLSRD includes */
-#include "olsr.h" /* olsr_malloc */
-#include "scheduler.h" /* GET_TIMESTAMP, TIMED_OUT */
+#include "scheduler.h" /* olsr_getTimestamp(), olsr_isTimedOut() */
 
-/* Plugin includes */
-#include "Packet.h"
+/* Fixed size, set associative history: each hash bucket holds up to
+ * HISTORY_WAYS entries. An entry with a zero time-out is free. */
+static struct TDupEntry PacketHistory[HISTORY_HASH_SIZE][HISTORY_WAYS];
 
-static struct TDupEntry* PacketHistory[HISTORY_HASH_SIZE];
+/* Next bucket to be visited by PrunePacketHistory() */
+static u_int32_t PruneCursor = 0;
 
 #define CRC_UPTO_NBYTES 256
 
+/* Offsets of the TTL and header checksum fields in an IPv4 header */
+#define CRC_TTL_OFFSET 8
+#define CRC_SUM_OFFSET 10
+#define CRC_HDR_NBYTES 12
+
 #if 0
 /* -------------------------------------------------------------------------
  * Function   : CalcCrcCcitt
@@ -92,8 +96,10 @@ static u_int16_t CalcCrcCcitt(unsigned char* buffer, ssize_t len)
 
 /* -------------------------------------------------------------------------
  * Function   : GenerateCrc32Table
- * Description: Generate the table of CRC remainders for all possible bytes,
- *              according to CRC-32-IEEE 802.3
+ * Description: Generate the tables of CRC remainders for all possible bytes,
+ *              according to CRC-32-IEEE 802.3. CrcTable[0] is the classic
+ *              byte-at-a-time table; CrcTable[k] gives the remainder of a
+ *              byte followed by k zero bytes, for slice-by-8 calculation.
  * Input      : none
  * Output     : none
  * Return     : none
@@ -101,7 +107,7 @@ static u_int16_t CalcCrcCcitt(unsigned char* buffer, ssize_t len)
  * ------------------------------------------------------------------------- */
 #define CRC32_POLYNOMIAL 0xedb88320UL /* bit-inverse of 0x04c11db7UL */
 
-static unsigned long CrcTable[256];
+static u_int32_t CrcTable[8][256];
 
 static void GenerateCrc32Table(void)
 {
@@ -121,30 +127,61 @@ static void GenerateCrc32Table(void)
         crc = (crc >> 1);
       }
     }
-    CrcTable[i] = crc;
+    CrcTable[0][i] = crc;
+  } /* for */
+
+  for (i = 0; i < 256; i++)
+  {
+    crc = CrcTable[0][i];
+    for (j = 1; j < 8; j++)
+    {
+      crc = (crc >> 8) ^ CrcTable[0][crc & 0xFF];
+      CrcTable[j][i] = crc;
+    }
   } /* for */
 } /* GenerateCrc32Table */
 
 /* -------------------------------------------------------------------------
- * Function   : CalcCrc32
- * Description: Calculate CRC-32 according to CRC-32-IEEE 802.3
- * Input      : buffer - the bytes to calculate the CRC value over
+ * Function   : UpdateCrc32
+ * Description: Continue a CRC-32-IEEE 802.3 calculation over a number of
+ *              bytes, eight bytes at a time (slice-by-8)
+ * Input      : crc - the CRC value so far, not yet inverted
+ *              buffer - the bytes to calculate the CRC value over
  *              len - the number of bytes to calculate the CRC value over
  * Output     : none
- * Return     : CRC-32 value
- * Data Used  : none
+ * Return     : the CRC value, not yet inverted
+ * Data Used  : CrcTable
  * ------------------------------------------------------------------------- */
-static u_int32_t CalcCrc32(unsigned char* buffer, ssize_t len)
+static u_int32_t UpdateCrc32(u_int32_t crc, const unsigned char* buffer, ssize_t len)
 {
-  int i, j;
-  u_int32_t crc = 0xffffffffUL;
-  for (i = 0; i < len; i++)
+  while (len >= 8)
+  {
+    /* Assemble the words byte by byte: independent of alignment
+     * and byte order */
+    u_int32_t one = crc ^ ((u_int32_t) buffer[0] | ((u_int32_t) buffer[1] << 8) |
+                           ((u_int32_t) buffer[2] << 16) | ((u_int32_t) buffer[3] << 24));
+    u_int32_t two = (u_int32_t) buffer[4] | ((u_int32_t) buffer[5] << 8) |
+                    ((u_int32_t) buffer[6] << 16) | ((u_int32_t) buffer[7] << 24);
+
+    crc = CrcTable[7][one & 0xFF] ^
+          CrcTable[6][(one >> 8) & 0xFF] ^
+          CrcTable[5][(one >> 16) & 0xFF] ^
+          CrcTable[4][one >> 24] ^
+          CrcTable[3][two & 0xFF] ^
+          CrcTable[2][(two >> 8) & 0xFF] ^
+          CrcTable[1][(two >> 16) & 0xFF] ^
+          CrcTable[0][two >> 24];
+
+    buffer += 8;
+    len -= 8;
+  } /* while */
+
+  while (len-- > 0)
   {
-    j = ((int) (crc & 0xFF) ^ *buffer++);
-    crc = (crc >> 8) ^ CrcTable[j];
+    crc = (crc >> 8) ^ CrcTable[0][(crc ^ *buffer++) & 0xFF];
   }
-  return crc ^ 0xffffffffUL;
-} /* CalcCrc32 */
+  return crc;
+} /* UpdateCrc32 */
 
 /* -------------------------------------------------------------------------
  * Function   : PacketCrc32
@@ -157,9 +194,9 @@ static u_int32_t CalcCrc32(unsigned char* buffer, ssize_t len)
  * ------------------------------------------------------------------------- */
 u_int32_t PacketCrc32(unsigned char* ipPacket, ssize_t len)
 {
-  struct TSaveTtl sttl;
-  struct ip* ipHeader;
-  u_int32_t result;
+  unsigned char header[CRC_HDR_NBYTES];
+  ssize_t headerLen;
+  u_int32_t crc;
 
   assert(ipPacket != NULL);
 
@@ -178,16 +215,28 @@ u_int32_t PacketCrc32(unsigned char* ipPacket, ssize_t len)
     len = CRC_UPTO_NBYTES;
   }
 
-  SaveTtlAndChecksum(ipPacket, &sttl);
-
-  ipHeader = (struct ip*) ARM_NOWARN_ALIGN(ipPacket);
-  ipHeader->ip_ttl = 0xFF; /* fixed value of TTL for CRC-32 calculation */
-  ipHeader->ip_sum = 0x5A5A; /* fixed value of IP header checksum for CRC-32 calculation */
-
-  result = CalcCrc32(ipPacket, len);
+  /* The CRC is carried in the BMF encapsulation header, so it must stay
+   * CRC-32-IEEE 802.3 over the packet with a fixed TTL (0xFF) and a fixed
+   * header checksum (0x5A5A). Substitute them in a copy of the start of
+   * the header instead of modifying the packet. */
+  headerLen = len < CRC_HDR_NBYTES ? len : CRC_HDR_NBYTES;
+  memcpy(header, ipPacket, headerLen);
+  if (headerLen > CRC_TTL_OFFSET)
+  {
+    header[CRC_TTL_OFFSET] = 0xFF;
+  }
+  if (headerLen > CRC_SUM_OFFSET)
+  {
+    header[CRC_SUM_OFFSET] = 0x5A;
+  }
+  if (headerLen > CRC_SUM_OFFSET + 1)
+  {
+    header[CRC_SUM_OFFSET + 1] = 0x5A;
+  }
 
-  RestoreTtlAndChecksum(ipPacket, &sttl);
-  return result;
+  crc = UpdateCrc32(0xffffffffUL, header, headerLen);
+  crc = UpdateCrc32(crc, ipPacket + headerLen, len - headerLen);
+  return crc ^ 0xffffffffUL;
 } /* PacketCrc32 */
 
 /* -------------------------------------------------------------------------
@@ -203,6 +252,22 @@ u_int32_t Hash(u_int32_t from32)
   return ((from32 >> N_HASH_BITS) + from32) & ((1 << N_HASH_BITS) - 1);
 } /* Hash */
 
+/* -------------------------------------------------------------------------
+ * Function   : HistoryTimeOut
+ * Description: Calculates the time-out of an entry marked now
+ * Input      : none
+ * Output     : none
+ * Return     : time-out, never zero
+ * Data Used  : none
+ * ------------------------------------------------------------------------- */
+static u_int32_t HistoryTimeOut(void)
+{
+  u_int32_t timeOut = olsr_getTimestamp(HISTORY_HOLD_TIME);
+
+  /* Zero marks a free entry */
+  return timeOut != 0 ? timeOut : 1;
+} /* HistoryTimeOut */
+
 /* -------------------------------------------------------------------------
  * Function   : InitPacketHistory
  * Description: Initialize the packet history table and CRC-32 table
@@ -213,20 +278,17 @@ u_int32_t Hash(u_int32_t from32)
  * ------------------------------------------------------------------------- */
 void InitPacketHistory(void)
 {
-  int i;
-
   GenerateCrc32Table();
 
-  for(i = 0; i < HISTORY_HASH_SIZE; i++)
-  {
-    PacketHistory[i] = NULL;
-  }
+  memset(PacketHistory, 0, sizeof(PacketHistory));
+  PruneCursor = 0;
 } /* InitPacketHistory */
 
 /* -------------------------------------------------------------------------
  * Function   : CheckAndMarkRecentPacket
  * Description: Check if this packet was seen recently, then record the fact
- *              that this packet was seen recently.
+ *              that this packet was seen recently. If the hash bucket is
+ *              full, the entry that would time out first is replaced.
  * Input      : crc32 - 32-bits crc value of the packet
  * Output     : none
  * Return     : not recently seen (0), recently seen (1)
@@ -234,44 +296,61 @@ void InitPacketHistory(void)
  * ------------------------------------------------------------------------- */
 int CheckAndMarkRecentPacket(u_int32_t crc32)
 {
-  u_int32_t idx;
-  struct TDupEntry* walker;
-  struct TDupEntry* newEntry;
+  struct TDupEntry* bucket;
+  struct TDupEntry* freeEntry = NULL;
+  struct TDupEntry* oldestEntry = NULL;
+  int i;
 
-  idx = Hash(crc32);
-  assert(idx < HISTORY_HASH_SIZE);
+  bucket = PacketHistory[Hash(crc32)];
 
-  for (walker = PacketHistory[idx]; walker != NULL; walker = walker->next)
+  for (i = 0; i < HISTORY_WAYS; i++)
   {
-    if (walker->crc32 == crc32)
+    struct TDupEntry* entry = &bucket[i];
+
+    if (entry->timeOut != 0 && olsr_isTimedOut(entry->timeOut))
+    {
+      entry->timeOut = 0;
+    }
+
+    if (entry->timeOut == 0)
+    {
+      if (freeEntry == NULL)
+      {
+        freeEntry = entry;
+      }
+    }
+    else if (entry->crc32 == crc32)
     {
       /* Found duplicate entry */
 
       /* Always mark as "seen recently": refresh time-out */
-      walker->timeOut = olsr_getTimestamp(HISTORY_HOLD_TIME);
+      entry->timeOut = HistoryTimeOut();
 
       return 1;
+    }
+    else if (oldestEntry == NULL || (int32_t)(entry->timeOut - oldestEntry->timeOut) < 0)
+    {
+      oldestEntry = entry;
     } /* if */
   } /* for */
 
-  /* No duplicate entry found: create one */
-  newEntry = olsr_malloc(sizeof(struct TDupEntry), "BMF: TDupEntry");
-  if (newEntry != NULL)
+  /* No duplicate entry found: record this one */
+  if (freeEntry == NULL)
   {
-    newEntry->crc32 = crc32;
-    newEntry->timeOut = olsr_getTimestamp(HISTORY_HOLD_TIME);
-
-    /* Add new entry at the front of the list */
-    newEntry->next = PacketHistory[idx];
-    PacketHistory[idx] = newEntry;
+    freeEntry = oldestEntry;
   }
+  freeEntry->crc32 = crc32;
+  freeEntry->timeOut = HistoryTimeOut();
 
   return 0;
 } /* CheckAndMarkRecentPacket */
   
 /* -------------------------------------------------------------------------
  * Function   : PrunePacketHistory
- * Description: Prune the packet history table.
+ * Description: Prune the next HISTORY_PRUNE_BUCKETS buckets of the packet
+ *              history table. Lookups already ignore timed out entries;
+ *              this only makes sure that an entry is never left untouched
+ *              long enough for its time-out to wrap around.
  * Input      : useless - not used
  * Output     : none
  * Return     : none
@@ -279,38 +358,19 @@ int CheckAndMarkRecentPacket(u_int32_t crc32)
  * ------------------------------------------------------------------------- */
 void PrunePacketHistory(void* useless __attribute__((unused)))
 {
-  uint i;
-  for (i = 0; i < HISTORY_HASH_SIZE; i++)
+  int n, i;
+  for (n = 0; n < HISTORY_PRUNE_BUCKETS; n++)
   {
-    if (PacketHistory[i] != NULL)
+    struct TDupEntry* bucket = PacketHistory[PruneCursor];
+
+    for (i = 0; i < HISTORY_WAYS; i++)
     {
-      struct TDupEntry* nextEntry = PacketHistory[i];
-      struct TDupEntry* prevEntry = NULL;
-      while (nextEntry != NULL) 
+      if (bucket[i].timeOut != 0 && olsr_isTimedOut(bucket[i].timeOut))
       {
-        struct TDupEntry* entry = nextEntry;
-        nextEntry = entry->next;
-
-        if (olsr_isTimedOut(entry->timeOut))
-        {
-          /* De-queue */
-          if (prevEntry != NULL)
-          {
-            prevEntry->next = entry->next;
-          }
-          else
-          {
-            PacketHistory[i] = entry->next;
-          } /* if */
-
-          /* De-allocate memory */
-          free(entry); 
-	      }
-	      else
-	      {
-	        prevEntry = entry;
-	      } /* if */
-      } /* while */
-    } /* if (PacketHistory[i] != NULL) */
-  } /* for (i = ...) */
+        bucket[i].timeOut = 0;
+      }
+    } /* for (i = ...) */
+
+    PruneCursor = (PruneCursor + 1) & (HISTORY_HASH_SIZE - 1);
+  } /* for (n = ...) */
 } /* PrunePacketHistory */
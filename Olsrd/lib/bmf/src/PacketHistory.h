@@ -36,32 +36,38 @@
 /* -------------------------------------------------------------------------
  * File       : PacketHistory.h
  * Description: Functions for keeping and accessing the history of processed
- *              multicast IP packets.
+ *              multicast IP packets. Also used by the P2PD plugin.
  * Created    : 29 Jun 2006
  *
  * ------------------------------------------------------------------------- */
 
 /* System includes */
-#include <sys/types.h> /* ssize_t */
-#include <sys/times.h> /* clock_t */
+#include <sys/types.h> /* ssize_t, u_int32_t */
 
+/* Plugins sharing this file may build it with their own table size */
+#ifndef N_HASH_BITS
 #define N_HASH_BITS 12
+#endif
 #define HISTORY_HASH_SIZE (1 << N_HASH_BITS)
 
+/* Number of entries per hash bucket */
+#define HISTORY_WAYS 4
+
+/* Number of hash buckets visited by each call to PrunePacketHistory() */
+#define HISTORY_PRUNE_BUCKETS 64
+
 /* Time-out of duplicate entries, in milliseconds */
 #define HISTORY_HOLD_TIME 3000
 
 struct TDupEntry
 {
   u_int32_t crc32;
-  clock_t timeOut;
-  struct TDupEntry* next;
+  u_int32_t timeOut; /* olsrd scheduler clock, 0 if the entry is free */
 };
 
 void InitPacketHistory(void);
 u_int32_t PacketCrc32(unsigned char* ipPkt, ssize_t len);
 u_int32_t Hash(u_int32_t from32);
-void MarkRecentPacket(u_int32_t crc32);
 int CheckAndMarkRecentPacket(u_int32_t crc32);
 void PrunePacketHistory(void*);
 
@@ -0,0 +1,229 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004-2009, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/* -------------------------------------------------------------------------
+ * File       : PacketRing.c
+ * Description: Memory-mapped (PACKET_RX_RING, TPACKET_V3) receive rings and
+ *              kernel packet filters for capture sockets
+ * ------------------------------------------------------------------------- */
+
+#include "PacketRing.h"
+
+/* System includes */
+#include <string.h> /* memset() */
+#include <errno.h> /* errno */
+#include <sys/mman.h> /* mmap(), munmap() */
+#include <sys/socket.h> /* setsockopt() */
+#include <linux/filter.h> /* struct sock_filter, struct sock_fprog */
+
+int UseCaptureRing = 0;
+
+/* -------------------------------------------------------------------------
+ * Function   : CreatePacketRing
+ * Description: Set up a TPACKET_V3 receive ring on a packet socket and map
+ *              it into memory
+ * Input      : skfd - the packet socket
+ * Output     : ring - the mapped ring
+ * Return     : 0 on success, -1 with errno set if the ring could not be
+ *              set up; the socket can then still be read with recvfrom()
+ * Data Used  : none
+ * ------------------------------------------------------------------------- */
+int CreatePacketRing(struct TPacketRing* ring, int skfd)
+{
+#ifdef TPACKET3_HDRLEN
+  int version = TPACKET_V3;
+  struct tpacket_req3 req;
+  void* map;
+
+  memset(ring, 0, sizeof(*ring));
+
+  if (setsockopt(skfd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0)
+  {
+    return -1;
+  }
+
+  memset(&req, 0, sizeof(req));
+  req.tp_block_size = PACKET_RING_BLOCK_SIZE;
+  req.tp_block_nr = PACKET_RING_BLOCK_NR;
+  req.tp_frame_size = PACKET_RING_FRAME_SIZE;
+  req.tp_frame_nr = (PACKET_RING_BLOCK_SIZE / PACKET_RING_FRAME_SIZE) * PACKET_RING_BLOCK_NR;
+  req.tp_retire_blk_tov = PACKET_RING_RETIRE_MSEC;
+  if (setsockopt(skfd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0)
+  {
+    return -1;
+  }
+
+  map = mmap(NULL, req.tp_block_size * req.tp_block_nr, PROT_READ | PROT_WRITE, MAP_SHARED, skfd, 0);
+  if (map == MAP_FAILED)
+  {
+    int mmapErrno = errno;
+
+    /* Tear down the ring again so that recvfrom() keeps working */
+    memset(&req, 0, sizeof(req));
+    setsockopt(skfd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req));
+    errno = mmapErrno;
+    return -1;
+  }
+
+  ring->map = map;
+  ring->mapLen = req.tp_block_size * req.tp_block_nr;
+  return 0;
+#else
+  memset(ring, 0, sizeof(*ring));
+  errno = ENOSYS;
+  return -1;
+#endif
+} /* CreatePacketRing */
+
+/* -------------------------------------------------------------------------
+ * Function   : ProcessPacketRing
+ * Description: Pass all frames in the blocks the kernel has handed over to a
+ *              function, then return the blocks to the kernel. Called when
+ *              the socket is readable; no system call is made.
+ * Input      : ring - the mapped ring
+ *              func - function to call for each frame
+ *              data - passed on to func
+ * Output     : none
+ * Return     : the number of frames processed
+ * Data Used  : none
+ * ------------------------------------------------------------------------- */
+int ProcessPacketRing(struct TPacketRing* ring, packet_ring_frame_func func, void* data)
+{
+  int nFrames = 0;
+#ifdef TPACKET3_HDRLEN
+  unsigned int nBlocks;
+
+  /* Visit each block at most once, so that a busy interface cannot keep
+   * the scheduler here forever */
+  for (nBlocks = 0; nBlocks < PACKET_RING_BLOCK_NR; nBlocks++)
+  {
+    struct tpacket_block_desc* block =
+      (struct tpacket_block_desc*)(ring->map + ring->nextBlock * PACKET_RING_BLOCK_SIZE);
+    struct tpacket3_hdr* hdr;
+    unsigned int i;
+
+    if ((block->hdr.bh1.block_status & TP_STATUS_USER) == 0)
+    {
+      break;
+    }
+    __sync_synchronize();
+
+    hdr = (struct tpacket3_hdr*)((unsigned char*)block + block->hdr.bh1.offset_to_first_pkt);
+    for (i = 0; i < block->hdr.bh1.num_pkts; i++)
+    {
+      struct sockaddr_ll* addr =
+        (struct sockaddr_ll*)((unsigned char*)hdr + TPACKET_ALIGN(sizeof(struct tpacket3_hdr)));
+
+      func((unsigned char*)hdr + hdr->tp_mac, hdr->tp_snaplen, addr, data);
+      nFrames++;
+
+      hdr = (struct tpacket3_hdr*)((unsigned char*)hdr + hdr->tp_next_offset);
+    } /* for */
+
+    /* Hand the block back to the kernel */
+    __sync_synchronize();
+    block->hdr.bh1.block_status = TP_STATUS_KERNEL;
+
+    ring->nextBlock = (ring->nextBlock + 1) % PACKET_RING_BLOCK_NR;
+    ring->nBlocks++;
+  } /* for */
+
+  ring->nFrames += nFrames;
+#else
+  (void)ring;
+  (void)func;
+  (void)data;
+#endif
+  return nFrames;
+} /* ProcessPacketRing */
+
+/* -------------------------------------------------------------------------
+ * Function   : ClosePacketRing
+ * Description: Unmap a receive ring
+ * Input      : ring - the ring
+ * Output     : none
+ * Return     : none
+ * Data Used  : none
+ * ------------------------------------------------------------------------- */
+void ClosePacketRing(struct TPacketRing* ring)
+{
+  if (ring->map != NULL)
+  {
+    munmap(ring->map, ring->mapLen);
+    ring->map = NULL;
+    ring->mapLen = 0;
+  }
+} /* ClosePacketRing */
+
+/* -------------------------------------------------------------------------
+ * Function   : AttachCaptureFilter
+ * Description: Attach a kernel packet filter to a capture socket which only
+ *              lets multicast, broadcast and outgoing frames through, the
+ *              same frames the capture handlers look at. Other frames seen
+ *              in promiscuous mode are dropped before they are queued.
+ * Input      : skfd - the packet socket
+ * Output     : none
+ * Return     : 0 on success, -1 with errno set otherwise
+ * Data Used  : none
+ * ------------------------------------------------------------------------- */
+int AttachCaptureFilter(int skfd)
+{
+  static struct sock_filter code[] = {
+    /* A = skb->pkt_type */
+    BPF_STMT(BPF_LD | BPF_B | BPF_ABS, SKF_AD_OFF + SKF_AD_PKTTYPE),
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, PACKET_MULTICAST, 3, 0),
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, PACKET_BROADCAST, 2, 0),
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, PACKET_OUTGOING, 1, 0),
+    BPF_STMT(BPF_RET | BPF_K, 0),
+    BPF_STMT(BPF_RET | BPF_K, 0xFFFF),
+  };
+  struct sock_fprog prog;
+
+  prog.len = sizeof(code) / sizeof(code[0]);
+  prog.filter = code;
+  return setsockopt(skfd, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog));
+} /* AttachCaptureFilter */
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,98 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004-2009, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+#ifndef _BMF_PACKETRING_H
+#define _BMF_PACKETRING_H
+
+/* -------------------------------------------------------------------------
+ * File       : PacketRing.h
+ * Description: Memory-mapped (PACKET_RX_RING, TPACKET_V3) receive rings and
+ *              kernel packet filters for capture sockets. Also used by the
+ *              P2PD and MDNS plugins.
+ * ------------------------------------------------------------------------- */
+
+/* System includes */
+#include <stddef.h> /* size_t */
+#include <sys/types.h> /* u_int32_t */
+#include <linux/if_packet.h> /* struct sockaddr_ll */
+
+/* Geometry of a receive ring: PACKET_RING_BLOCK_NR blocks of
+ * PACKET_RING_BLOCK_SIZE bytes, each holding a variable number of frames */
+#define PACKET_RING_BLOCK_SIZE (1 << 16)
+#define PACKET_RING_BLOCK_NR 8
+#define PACKET_RING_FRAME_SIZE 2048
+
+/* Time in milliseconds after which the kernel hands over a block that is
+ * not yet full, bounding the extra latency of a quiet ring */
+#define PACKET_RING_RETIRE_MSEC 2
+
+struct TPacketRing
+{
+  /* Start and length of the mapped ring, NULL if the ring is not used */
+  unsigned char* map;
+  size_t mapLen;
+
+  /* Next block to be handed over by the kernel */
+  unsigned int nextBlock;
+
+  /* Number of blocks and frames processed */
+  u_int32_t nBlocks;
+  u_int32_t nFrames;
+};
+
+/* Called for each frame in a ring; 'frame' points to the network header */
+typedef void (*packet_ring_frame_func)(unsigned char* frame, unsigned int len, struct sockaddr_ll* addr, void* data);
+
+/* Plugin parameter "CaptureRing": use receive rings on capture sockets */
+extern int UseCaptureRing;
+
+int CreatePacketRing(struct TPacketRing* ring, int skfd);
+int ProcessPacketRing(struct TPacketRing* ring, packet_ring_frame_func func, void* data);
+void ClosePacketRing(struct TPacketRing* ring);
+int AttachCaptureFilter(int skfd);
+
+#endif /* _BMF_PACKETRING_H */
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
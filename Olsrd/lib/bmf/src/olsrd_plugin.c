@@ -52,6 +52,7 @@
 #include "PacketHistory.h" /* InitPacketHistory() */
 #include "NetworkInterfaces.h" /* AddNonOlsrBmfIf(), SetBmfInterfaceIp(), ... */
 #include "Address.h" /* DoLocalBroadcast() */
+#include "PacketRing.h" /* UseCaptureRing */
 
 static void __attribute__ ((constructor)) my_init(void);
 static void __attribute__ ((destructor)) my_fini(void);
@@ -127,7 +128,9 @@ static const struct olsrd_plugin_parameters plugin_parameters[] = {
     { .name = "CapturePacketsOnOlsrInterfaces", .set_plugin_parameter = &SetCapturePacketsOnOlsrInterfaces, .data = NULL },
     { .name = "BmfMechanism", .set_plugin_parameter = &SetBmfMechanism, .data = NULL },
     { .name = "FanOutLimit", .set_plugin_parameter = &SetFanOutLimit, .data = NULL },
+    { .name = "TxDropPolicy", .set_plugin_parameter = &SetTxDropPolicy, .data = NULL },
     { .name = "BroadcastRetransmitCount", .set_plugin_parameter = &set_plugin_int, .data = &BroadcastRetransmitCount},
+    { .name = "CaptureRing", .set_plugin_parameter = &set_plugin_boolean, .data = &UseCaptureRing },
 };
 
 /* -------------------------------------------------------------------------
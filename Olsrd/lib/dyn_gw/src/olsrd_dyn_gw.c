@@ -42,6 +42,8 @@
 /*
  * -Threaded ping code added by Jens Nachtigall
  * -HNA4 checking by bjoern riemer
+ * -ICMP probes from the olsrd scheduler and netlink route tracking
+ *  replace the ping thread and the polling of /proc/net/route
  */
 
 #include <arpa/inet.h>
@@ -59,36 +61,21 @@
 #include <string.h>
 #include <stdlib.h>
 #include <sys/time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/in_systm.h>
+#include <netinet/ip.h>
+#include <netinet/ip_icmp.h>
 #include <net/route.h>
 #ifdef linux
 #include <linux/in_route.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
 #endif
 #include <unistd.h>
+#include <fcntl.h>
 #include <errno.h>
 #include <time.h>
-#ifndef WIN32
-#include <pthread.h>
-#else
-#define WIN32_LEAN_AND_MEAN
-#include <windows.h>
-#undef interface
-
-#define close(x) closesocket(x)
-
-typedef HANDLE pthread_mutex_t;
-typedef HANDLE pthread_t;
-
-int pthread_create(HANDLE * Hand, void *Attr, void *(*Func) (void *), void *Arg);
-int pthread_kill(HANDLE Hand, int Sig);
-int pthread_mutex_init(HANDLE * Hand, void *Attr);
-int pthread_mutex_lock(HANDLE * Hand);
-int pthread_mutex_unlock(HANDLE * Hand);
-
-struct ThreadPara {
-  void *(*Func) (void *);
-  void *Arg;
-};
-#endif
 
 static int hna_check_interval	= DEFAULT_HNA_CHECK_INTERVAL;
 /* set default interval, in case none is given in the config file */
@@ -97,9 +84,24 @@ static int ping_check_interval = DEFAULT_PING_CHECK_INTERVAL;
 /* list to store the Ping IP addresses given in the config file */
 struct ping_list {
   char *ping_address;
+  struct in_addr addr;
+  uint16_t id;                          /* tells the probes of this host apart */
+  uint16_t seq;                         /* sequence number of the last probe */
+  uint32_t history;                     /* bit n set: reply to probe seq-n received */
+  uint32_t sent;                        /* probes sent, at most 32 counted in history */
+  uint32_t last_reply;                  /* timestamp of the last reply */
+  bool reachable;
+  long srtt;                            /* smoothed round trip time in usec */
   struct ping_list *next;
 };
 
+/* payload of the echo requests */
+struct ping_payload {
+  uint16_t id;
+  uint16_t pad;
+  struct timeval sent;
+};
+
 static struct ping_list *add_to_ping_list(const char *, struct ping_list *);
 
 struct hna_list {
@@ -125,20 +127,41 @@ static struct hna_group * hna_groups = NULL;
 
 static struct hna_group *add_to_hna_group(struct hna_group *);
 
-static void looped_checks(void *) __attribute__ ((noreturn));
-
-static bool check_gw(union olsr_ip_addr *, uint8_t, struct ping_list *);
+/* ICMP socket for the probes, raw if icmp_dgram is false */
+static int icmp_socket = -1;
+static bool icmp_dgram;
+static uint16_t icmp_ident;
 
-static int ping_is_possible(struct ping_list *);
+static void ping_send_probes(void *);
+static void ping_receive(int, void *, unsigned int);
+static int ping_open_socket(void);
 
 /* Event function to register with the scheduler */
 static void olsr_event_doing_hna(void *);
 
+static struct timer_entry *probe_timer, *hna_timer;
+
 struct hna_list* find_hna(uint32_t src_addr, uint32_t src_mask);
 
 char *get_ip_str(uint32_t address, char *s, size_t maxlen);
 int update_routing(void);
 
+#ifdef linux
+/* netlink sockets for route change events and for dumping the table */
+static int rtnl_event_socket = -1;
+static int rtnl_dump_socket = -1;
+static bool rtnl_dump_running, rtnl_dump_again;
+static uint32_t rtnl_dump_seq;
+
+/* a dump not finished by then is given up and requested again */
+#define RTNL_DUMP_TIMEOUT (5 * MSEC_PER_SEC)
+static struct timer_entry *rtnl_dump_timer;
+
+static int rtnl_open_sockets(void);
+static void rtnl_request_dump(void);
+static void rtnl_receive(int, void *, unsigned int);
+#endif
+
 /**
  * read config file parameters
  */
@@ -234,8 +257,6 @@ olsrd_get_plugin_parameters(const struct olsrd_plugin_parameters **params, int *
 int
 olsrd_plugin_init(void)
 {
-  pthread_t ping_thread;
-
   if (hna_groups == NULL) {
     hna_groups = add_to_hna_group(hna_groups);
     if (hna_groups == NULL)
@@ -256,10 +277,17 @@ olsrd_plugin_init(void)
   }
 	
   // Prepare all routing information
-  update_routing();
+#ifdef linux
+  if (rtnl_open_sockets() == 0) {
+    rtnl_request_dump();
+  } else
+#endif
+    update_routing();
   
-  if (hna_ping_check) {
-    pthread_create(&ping_thread, NULL, (void *(*)(void *))looped_checks, NULL);
+  if (hna_ping_check && ping_open_socket() == 0) {
+    /* the first probes go out right away */
+    ping_send_probes(NULL);
+    probe_timer = olsr_start_timer(ping_check_interval * MSEC_PER_SEC, 0, OLSR_TIMER_PERIODIC, &ping_send_probes, NULL, 0);
   } else {
     struct hna_group *grp;
     for (grp = hna_groups; grp; grp = grp->next) {
@@ -287,10 +315,41 @@ olsrd_plugin_init(void)
   }
 
   /* Register the GW check */
-  olsr_start_timer(hna_check_interval, 0, OLSR_TIMER_PERIODIC, &olsr_event_doing_hna, NULL, 0);
+  hna_timer = olsr_start_timer(hna_check_interval, 0, OLSR_TIMER_PERIODIC, &olsr_event_doing_hna, NULL, 0);
   return 1;
 }
 
+/**
+ * destructor - called at unload
+ */
+void
+olsr_plugin_exit(void)
+{
+  olsr_stop_timer(hna_timer);
+  hna_timer = NULL;
+  olsr_stop_timer(probe_timer);
+  probe_timer = NULL;
+  if (icmp_socket != -1) {
+    remove_olsr_socket(icmp_socket, NULL, &ping_receive);
+    close(icmp_socket);
+    icmp_socket = -1;
+  }
+#ifdef linux
+  olsr_stop_timer(rtnl_dump_timer);
+  rtnl_dump_timer = NULL;
+  if (rtnl_event_socket != -1) {
+    remove_olsr_socket(rtnl_event_socket, &rtnl_receive, NULL);
+    close(rtnl_event_socket);
+    rtnl_event_socket = -1;
+  }
+  if (rtnl_dump_socket != -1) {
+    remove_olsr_socket(rtnl_dump_socket, &rtnl_receive, NULL);
+    close(rtnl_dump_socket);
+    rtnl_dump_socket = -1;
+  }
+#endif
+}
+
 /**
  * Scheduled event to update the hna table,
  * called from olsrd main thread to keep the hna table thread-safe
@@ -301,7 +360,11 @@ olsr_event_doing_hna(void *foo __attribute__ ((unused)))
   struct hna_group* grp;
   struct hna_list *li;
 
-  update_routing();
+#ifdef linux
+  /* the routes are tracked by netlink events */
+  if (rtnl_event_socket == -1)
+#endif
+    update_routing();
   
   for (grp = hna_groups; grp; grp = grp->next) {
     for (li = grp->hna_list; li; li = li->next) {
@@ -323,39 +386,214 @@ olsr_event_doing_hna(void *foo __attribute__ ((unused)))
   }
 }
 
-/**
- * the threaded function which happens within an endless loop,
- * reiterated every "Interval" sec (as given in the config or
- * the default value)
- */
+/* -------------------------------------------------------------------------
+ * Function   : ping_checksum
+ * Description: Internet checksum (RFC 1071)
+ * Input      : data - the data to sum up
+ *              len  - its length in bytes
+ * Output     : none
+ * Return     : the checksum in network byte order
+ * Data Used  : none
+ * ------------------------------------------------------------------------- */
+static uint16_t
+ping_checksum(const void *data, size_t len)
+{
+  const uint16_t *p = data;
+  uint32_t sum = 0;
+
+  for (; len > 1; len -= 2) {
+    sum += *p++;
+  }
+  if (len == 1) {
+    sum += *(const uint8_t *)p;
+  }
+  sum = (sum >> 16) + (sum & 0xffff);
+  sum += sum >> 16;
+  return ~sum;
+}
+
+/* -------------------------------------------------------------------------
+ * Function   : ping_open_socket
+ * Description: Open the ICMP socket for the probes and register it with
+ *              the scheduler. An unprivileged ICMP datagram socket is used
+ *              where the system offers it, a raw socket otherwise.
+ * Input      : none
+ * Output     : none
+ * Return     : -1 if an error occurred, 0 otherwise
+ * Data Used  : icmp_socket, icmp_dgram, icmp_ident
+ * ------------------------------------------------------------------------- */
+static int
+ping_open_socket(void)
+{
+  icmp_dgram = true;
+  if ((icmp_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_ICMP)) == -1) {
+    icmp_dgram = false;
+    if ((icmp_socket = socket(AF_INET, SOCK_RAW, IPPROTO_ICMP)) == -1) {
+      olsr_printf(0, "DYN GW: cannot open ICMP socket: %s\n", strerror(errno));
+      return -1;
+    }
+  }
+  /* datagram sockets get their identifier from the kernel */
+  icmp_ident = getpid() & 0xffff;
+
+  fcntl(icmp_socket, F_SETFL, fcntl(icmp_socket, F_GETFL, 0) | O_NONBLOCK);
+  /* replies are read right away to keep the round trip times accurate */
+  add_olsr_socket(icmp_socket, NULL, &ping_receive, NULL, SP_IMM_READ);
+  return 0;
+}
+
+/* -------------------------------------------------------------------------
+ * Function   : ping_update_group
+ * Description: Recompute the probe result of a group of HNAs: the group is
+ *              ok if any of its ping hosts is reachable, or if it has none
+ * Input      : grp - the group
+ * Output     : none
+ * Return     : none
+ * Data Used  : none
+ * ------------------------------------------------------------------------- */
 static void
-looped_checks(void *foo __attribute__ ((unused)))
+ping_update_group(struct hna_group *grp)
 {
-  for (;;) {
-    struct hna_group *grp;
-    struct hna_list *li;
-    struct timespec remainder_spec;
-    /* the time to wait in "Interval" sec (see connfig), default=5sec */
-    struct timespec sleeptime_spec = { ping_check_interval, 0L };
+  struct ping_list *png;
+  bool ok = grp->ping_hosts == NULL;
+
+  for (png = grp->ping_hosts; png; png = png->next) {
+    ok = ok || png->reachable;
+  }
+  if (ok != grp->probe_ok && grp->ping_hosts != NULL) {
+    olsr_printf(1, "DYN GW: ping hosts of HNA group are %s\n", ok ? "reachable" : "unreachable");
+  }
+  grp->probe_ok = ok;
+}
+
+/* -------------------------------------------------------------------------
+ * Function   : ping_send_probes
+ * Description: Scheduled event: send an echo request to every ping host.
+ *              Replies are not waited for, a host is considered reachable
+ *              as long as one of its last PING_LOSS_TOLERANCE probes was
+ *              answered.
+ * Input      : none
+ * Output     : none
+ * Return     : none
+ * Data Used  : hna_groups, icmp_socket
+ * ------------------------------------------------------------------------- */
+static void
+ping_send_probes(void *foo __attribute__ ((unused)))
+{
+  struct hna_group *grp;
+
+  for (grp = hna_groups; grp; grp = grp->next) {
+    struct ping_list *png;
+
+    for (png = grp->ping_hosts; png; png = png->next) {
+      uint8_t req[ICMP_MINLEN + sizeof(struct ping_payload)];
+      struct icmp *hdr = (struct icmp *)req;
+      struct ping_payload payload;
+      struct sockaddr_in dst;
+
+      /* a host is lost when its last probes all went unanswered */
+      if (png->reachable && (png->history & ((1 << PING_LOSS_TOLERANCE) - 1)) == 0 && png->sent >= PING_LOSS_TOLERANCE) {
+        olsr_printf(1, "DYN GW: ping host %s lost\n", png->ping_address);
+        png->reachable = false;
+      }
+
+      png->seq++;
+      png->history <<= 1;
+      if (png->sent < 32) {
+        png->sent++;
+      }
+
+      memset(req, 0, sizeof(req));
+      memset(&payload, 0, sizeof(payload));
+      hdr->icmp_type = ICMP_ECHO;
+      hdr->icmp_id = htons(icmp_ident);
+      hdr->icmp_seq = htons(png->seq);
+      payload.id = png->id;
+      gettimeofday(&payload.sent, NULL);
+      memcpy(req + ICMP_MINLEN, &payload, sizeof(payload));
+      hdr->icmp_cksum = ping_checksum(req, sizeof(req));
+
+      memset(&dst, 0, sizeof(dst));
+      dst.sin_family = AF_INET;
+      dst.sin_addr = png->addr;
+      if (sendto(icmp_socket, req, sizeof(req), 0, (struct sockaddr *)&dst, sizeof(dst)) < 0) {
+        olsr_printf(2, "DYN GW: ping %s: %s\n", png->ping_address, strerror(errno));
+      }
+    }
+    ping_update_group(grp);
+  }
+}
+
+/* -------------------------------------------------------------------------
+ * Function   : ping_receive
+ * Description: Socket callback: match echo replies to their probes and
+ *              update reachability, loss and round trip times
+ * Input      : fd - the ICMP socket
+ * Output     : none
+ * Return     : none
+ * Data Used  : hna_groups
+ * ------------------------------------------------------------------------- */
+static void
+ping_receive(int fd, void *data __attribute__ ((unused)), unsigned int flags __attribute__ ((unused)))
+{
+  uint8_t buf[512];
+  struct sockaddr_in from;
+  socklen_t fromlen = sizeof(from);
+  const struct icmp *hdr;
+  struct ping_payload payload;
+  struct hna_group *grp;
+  struct timeval now;
+  ssize_t len;
+  size_t off = 0;
+  uint16_t seq;
+
+  while ((len = recvfrom(fd, buf, sizeof(buf), 0, (struct sockaddr *)&from, &fromlen)) > 0) {
+    fromlen = sizeof(from);
+
+    /* raw sockets deliver the IP header, and every ICMP message of the host */
+    if (!icmp_dgram) {
+      const struct ip *iph = (const struct ip *)buf;
+      off = iph->ip_hl * 4;
+    }
+    if ((size_t)len < off + ICMP_MINLEN + sizeof(payload)) {
+      continue;
+    }
+    hdr = (const struct icmp *)(buf + off);
+    if (hdr->icmp_type != ICMP_ECHOREPLY || (!icmp_dgram && ntohs(hdr->icmp_id) != icmp_ident)) {
+      continue;
+    }
+    memcpy(&payload, buf + off + ICMP_MINLEN, sizeof(payload));
+    seq = ntohs(hdr->icmp_seq);
+    gettimeofday(&now, NULL);
 
     for (grp = hna_groups; grp; grp = grp->next) {
-      for (li = grp->hna_list; li; li = li->next) {
-      
-    		// If this HNA is not active skip to the next one
-        if (!li->active)
+      struct ping_list *png;
+
+      for (png = grp->ping_hosts; png; png = png->next) {
+        uint16_t age = png->seq - seq;
+        long rtt;
+
+        if (png->id != payload.id || png->addr.s_addr != from.sin_addr.s_addr || age >= 32
+            || (png->history & (1u << age)) != 0) {
           continue;
-          
-        /* check for gw in table entry and if Ping IPs are given also do pings */
-        grp->probe_ok = check_gw(&li->hna_addr, li->hna_prefixlen, grp->ping_hosts);
-        if (grp->probe_ok)
-          break;	// Valid host found so we can bail out of the inner loop here
+        }
+        png->history |= 1u << age;
+        png->last_reply = now_times;
+
+        rtt = (now.tv_sec - payload.sent.tv_sec) * 1000000L + (now.tv_usec - payload.sent.tv_usec);
+        png->srtt = png->srtt == 0 ? rtt : png->srtt + (rtt - png->srtt) / 8;
+
+        if (!png->reachable) {
+          olsr_printf(1, "DYN GW: ping host %s reachable\n", png->ping_address);
+          png->reachable = true;
+          ping_update_group(grp);
+        }
+        OLSR_PRINTF(3, "DYN GW: ping %s seq %u rtt %ld.%03ld ms, srtt %ld.%03ld ms, loss %u/%u\n", png->ping_address, seq,
+                    rtt / 1000, rtt % 1000, png->srtt / 1000, png->srtt % 1000,
+                    png->sent - __builtin_popcount(png->history), png->sent);
       }
     }
-
-    while (nanosleep(&sleeptime_spec, &remainder_spec) < 0)
-      sleeptime_spec = remainder_spec;
   }
-  // return NULL;
 }
 
 /* -------------------------------------------------------------------------
@@ -406,12 +644,226 @@ get_ip_str(uint32_t address, char *s, size_t maxlen)
   return s;
 }
 
+#ifdef linux
+/* -------------------------------------------------------------------------
+ * Function   : rtnl_open_sockets
+ * Description: Open a netlink socket listening for IPv4 route changes and
+ *              one for dumping the routing table, and register both with
+ *              the scheduler
+ * Input      : none
+ * Output     : none
+ * Return     : -1 if an error occurred, 0 otherwise
+ * Data Used  : rtnl_event_socket, rtnl_dump_socket
+ * ------------------------------------------------------------------------- */
+
+static int
+rtnl_open_sockets(void)
+{
+  struct sockaddr_nl addr;
+
+  memset(&addr, 0, sizeof(addr));
+  addr.nl_family = AF_NETLINK;
+  addr.nl_groups = RTMGRP_IPV4_ROUTE;
+
+  if ((rtnl_event_socket = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE)) == -1
+      || bind(rtnl_event_socket, (struct sockaddr *)&addr, sizeof(addr)) == -1
+      || (rtnl_dump_socket = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE)) == -1) {
+    olsr_printf(1, "DYN GW: cannot open netlink socket (%s), polling %s\n", strerror(errno), PROCENTRY_ROUTE);
+    olsr_plugin_exit();
+    return -1;
+  }
+  fcntl(rtnl_event_socket, F_SETFL, fcntl(rtnl_event_socket, F_GETFL, 0) | O_NONBLOCK);
+  fcntl(rtnl_dump_socket, F_SETFL, fcntl(rtnl_dump_socket, F_GETFL, 0) | O_NONBLOCK);
+
+  add_olsr_socket(rtnl_event_socket, &rtnl_receive, NULL, NULL, SP_PR_READ);
+  add_olsr_socket(rtnl_dump_socket, &rtnl_receive, NULL, NULL, SP_PR_READ);
+  return 0;
+}
+
+/* -------------------------------------------------------------------------
+ * Function   : rtnl_dump_timeout
+ * Description: Timer callback for a dump whose end never arrived, e.g.
+ *              because the reply overran the socket buffer. Start over.
+ * Input      : none
+ * Output     : none
+ * Return     : none
+ * Data Used  : rtnl_dump_running
+ * ------------------------------------------------------------------------- */
+static void
+rtnl_dump_timeout(void *foo __attribute__ ((unused)))
+{
+  /* the scheduler removes the one-shot timer after this callback */
+  rtnl_dump_timer = NULL;
+
+  olsr_printf(1, "DYN GW: route dump timed out, retrying\n");
+  rtnl_dump_running = false;
+  rtnl_request_dump();
+}
+
+/* -------------------------------------------------------------------------
+ * Function   : rtnl_request_dump
+ * Description: Ask the kernel for the IPv4 routing table. The HNAs are
+ *              marked active again while the answer is read.
+ * Input      : none
+ * Output     : none
+ * Return     : none
+ * Data Used  : rtnl_dump_socket
+ * ------------------------------------------------------------------------- */
+static void
+rtnl_request_dump(void)
+{
+  struct {
+    struct nlmsghdr nlh;
+    struct rtmsg rtm;
+  } req;
+  struct hna_group *grp;
+  struct hna_list *li;
+
+  if (rtnl_dump_running) {
+    /* the routes changed while the table was read */
+    rtnl_dump_again = true;
+    return;
+  }
+
+  memset(&req, 0, sizeof(req));
+  req.nlh.nlmsg_len = NLMSG_LENGTH(sizeof(req.rtm));
+  req.nlh.nlmsg_type = RTM_GETROUTE;
+  req.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+  req.nlh.nlmsg_seq = ++rtnl_dump_seq;
+  req.rtm.rtm_family = AF_INET;
+
+  if (send(rtnl_dump_socket, &req, req.nlh.nlmsg_len, 0) < 0) {
+    olsr_printf(1, "DYN GW: cannot dump routes: %s\n", strerror(errno));
+    return;
+  }
+  rtnl_dump_running = true;
+  rtnl_dump_again = false;
+  olsr_stop_timer(rtnl_dump_timer);
+  rtnl_dump_timer = olsr_start_timer(RTNL_DUMP_TIMEOUT, 0, OLSR_TIMER_ONESHOT, &rtnl_dump_timeout, NULL, 0);
+
+  // Phase 1: reset the 'checked' flag, the dump (re)discovers whether the HNA is valid or not.
+  for (grp = hna_groups; grp; grp = grp->next) {
+    for (li = grp->hna_list; li; li = li->next) {
+      li->checked = false;
+    }
+  }
+}
+
+/* -------------------------------------------------------------------------
+ * Function   : rtnl_route_hna
+ * Description: Find the HNA a netlink route message is about. Like with
+ *              /proc/net/route only the main table is looked at, and
+ *              routes with the metric olsrd uses are ignored.
+ * Input      : nlh - the netlink message
+ * Output     : none
+ * Return     : the HNA or NULL
+ * Data Used  : none
+ * ------------------------------------------------------------------------- */
+static struct hna_list *
+rtnl_route_hna(struct nlmsghdr *nlh)
+{
+  struct rtmsg *rtm = NLMSG_DATA(nlh);
+  struct rtattr *rta;
+  int rtlen = RTM_PAYLOAD(nlh);
+  uint32_t dst = 0, metric = 0, table = rtm->rtm_table;
+  union olsr_ip_addr mask;
+
+  if (rtm->rtm_family != AF_INET || rtm->rtm_type != RTN_UNICAST) {
+    return NULL;
+  }
+  for (rta = RTM_RTA(rtm); RTA_OK(rta, rtlen); rta = RTA_NEXT(rta, rtlen)) {
+    switch (rta->rta_type) {
+    case RTA_DST:
+      memcpy(&dst, RTA_DATA(rta), sizeof(dst));
+      break;
+    case RTA_PRIORITY:
+      memcpy(&metric, RTA_DATA(rta), sizeof(metric));
+      break;
+    case RTA_TABLE:
+      memcpy(&table, RTA_DATA(rta), sizeof(table));
+      break;
+    }
+  }
+  if (table != RT_TABLE_MAIN || metric == RT_METRIC_DEFAULT) {
+    return NULL;
+  }
+  olsr_prefix_to_netmask(&mask, rtm->rtm_dst_len);
+  return find_hna(dst, mask.v4.s_addr);
+}
+
+/* -------------------------------------------------------------------------
+ * Function   : rtnl_receive
+ * Description: Socket callback for both netlink sockets. A change of a
+ *              route for one of the HNAs triggers a dump of the table, as
+ *              another route for the same prefix may still exist.
+ * Input      : fd - the netlink socket
+ * Output     : none
+ * Return     : none
+ * Data Used  : none
+ * ------------------------------------------------------------------------- */
+static void
+rtnl_receive(int fd, void *data __attribute__ ((unused)), unsigned int flags __attribute__ ((unused)))
+{
+  char buf[8192];
+  int len;
+
+  while ((len = recv(fd, buf, sizeof(buf), 0)) > 0) {
+    struct nlmsghdr *nlh;
+
+    for (nlh = (struct nlmsghdr *)buf; NLMSG_OK(nlh, (unsigned int)len); nlh = NLMSG_NEXT(nlh, len)) {
+      struct hna_list *hna;
+
+      if (fd == rtnl_event_socket) {
+        if ((nlh->nlmsg_type == RTM_NEWROUTE || nlh->nlmsg_type == RTM_DELROUTE) && rtnl_route_hna(nlh) != NULL) {
+          rtnl_request_dump();
+        }
+        continue;
+      }
+
+      if (nlh->nlmsg_seq != rtnl_dump_seq) {
+        continue;
+      }
+      if (nlh->nlmsg_type == NLMSG_DONE || nlh->nlmsg_type == NLMSG_ERROR) {
+        struct hna_group *grp;
+        struct hna_list *li;
+
+        // Phase 2: now copy the 'checked' flag to the 'active' flag.
+        for (grp = hna_groups; grp; grp = grp->next) {
+          for (li = grp->hna_list; li; li = li->next) {
+            li->active = li->checked;
+          }
+        }
+        rtnl_dump_running = false;
+        olsr_stop_timer(rtnl_dump_timer);
+        rtnl_dump_timer = NULL;
+        if (rtnl_dump_again) {
+          rtnl_request_dump();
+        }
+        break;
+      }
+      if (nlh->nlmsg_type == RTM_NEWROUTE && (hna = rtnl_route_hna(nlh)) != NULL) {
+        hna->checked = true;
+      }
+    }
+  }
+
+  if (len < 0 && errno == ENOBUFS) {
+    if (fd == rtnl_dump_socket) {
+      /* part of the dump was lost, its end may never come */
+      rtnl_dump_running = false;
+    }
+    /* events were lost, read the whole table again */
+    rtnl_request_dump();
+  }
+}
+#endif
+
 /* -------------------------------------------------------------------------
  * Function   : update_routing
  * Description: Mark the HNAs in the HNA list(s) corresponding to the results
  *              found in the routing table. HNAs that are found in the routing
  *              table will be marked as 'active', otherwise they'll remain
- *              inactive.    
+ *              inactive. Only used where netlink is not available.
  * Input      : nothing
  * Output     : none
  * Return     : -1 if an error occurred, 0 otherwise
@@ -489,68 +941,6 @@ update_routing(void)
   return 0;
 }
 
-/* -------------------------------------------------------------------------
- * Function   : check_gw
- * Description: Check the specified gateway(s) by sending a ping
- * Input      : addr      - the address of the HNA to which the ping is related
- *              prefixlen - the length of the prefix for this HNA 
- *              the_ping_list - list with related ping hosts
- * Output     : none
- * Return     : true if the ping host could be reached, false otherwise
- * Data Used  : none
- * ------------------------------------------------------------------------- */
-static bool
-check_gw(union olsr_ip_addr *addr, uint8_t prefixlen, struct ping_list *the_ping_list)
-{
-  bool retval = false;
-  union olsr_ip_addr mask;
-
-  olsr_prefix_to_netmask(&mask, prefixlen);
-  
-  /* don't ping, if there was no "Ping" IP addr in the config file */
-  if (the_ping_list != NULL) {
-    /*validate the found inet gw by pinging */
-    if (ping_is_possible(the_ping_list)) {
-      olsr_printf(1, "HNA[%08x/%08x](ping is possible) detected in routing table.\n", addr->v4.s_addr, mask.v4.s_addr);
-      retval = true;
-    }
-  } else {
-    olsr_printf(1, "HNA[%08x/%08x] detected in routing table.\n", addr->v4.s_addr, mask.v4.s_addr);
-    retval = true;
-  }
-
-  if (retval == false) {
-    /* And we cast here since we get warnings on Win32 */
-    olsr_printf(1, "HNA[%08x/%08x] is invalid\n", (unsigned int)addr->v4.s_addr, (unsigned int)mask.v4.s_addr);
-  }
-  return retval;
-}
-
-/* -------------------------------------------------------------------------
- * Function   : ping_is_possible
- * Description: Ping the specified host(s)
- * Input      : the_ping_list - the list of hosts to ping
- * Output     : none
- * Return     : 1 if any host responded, 0 otherwise
- * Data Used  : none
- * ------------------------------------------------------------------------- */
-static int
-ping_is_possible(struct ping_list *the_ping_list)
-{
-  struct ping_list *list;
-  for (list = the_ping_list; list; list = list->next) {
-    char ping_command[50];
-    snprintf(ping_command, sizeof(ping_command), "ping -c 1 -q %s", list->ping_address);
-    olsr_printf(1, "\nDo ping on %s ...\n", list->ping_address);
-    if (system(ping_command) == 0) {
-      olsr_printf(1, "...OK\n\n");
-      return 1;
-    }
-    olsr_printf(1, "...FAILED\n\n");
-  }
-  return 0;
-}
-
 /* -------------------------------------------------------------------------
  * Function   : add_to_ping_list
  * Description: Add a new ping host to the list of ping hosts
@@ -564,6 +954,7 @@ ping_is_possible(struct ping_list *the_ping_list)
 static struct ping_list *
 add_to_ping_list(const char *ping_address, struct ping_list *the_ping_list)
 {
+  static uint16_t next_id;
   struct ping_list *new = calloc(1, sizeof(struct ping_list));
   if (!new) {
     fprintf(stderr, "DYN GW: Out of memory!\n");
@@ -571,10 +962,11 @@ add_to_ping_list(const char *ping_address, struct ping_list *the_ping_list)
     exit(0);
   }
   new->ping_address = strdup(ping_address);
+  inet_pton(AF_INET, ping_address, &new->addr);
+  new->id = ++next_id;
   new->next = the_ping_list;
   return new;
 }
-
 /* -------------------------------------------------------------------------
  * Function   : add_to_hna_list
  * Description: Add a new HNA entry to the list of HNA entries
@@ -625,92 +1017,6 @@ add_to_hna_group(struct hna_group *list_root)
 }
 
 
-#ifdef WIN32
-
-/*
- * Windows pthread compat stuff
- */
-static unsigned long __stdcall
-ThreadWrapper(void *Para)
-{
-  struct ThreadPara *Cast;
-  void *(*Func) (void *);
-  void *Arg;
-
-  Cast = (struct ThreadPara *)Para;
-
-  Func = Cast->Func;
-  Arg = Cast->Arg;
-
-  HeapFree(GetProcessHeap(), 0, Para);
-
-  Func(Arg);
-
-  return 0;
-}
-
-int
-pthread_create(HANDLE * Hand, void *Attr __attribute__ ((unused)), void *(*Func) (void *), void *Arg)
-{
-  struct ThreadPara *Para;
-  unsigned long ThreadId;
-
-  Para = HeapAlloc(GetProcessHeap(), 0, sizeof(struct ThreadPara));
-
-  if (Para == NULL)
-    return -1;
-
-  Para->Func = Func;
-  Para->Arg = Arg;
-
-  *Hand = CreateThread(NULL, 0, ThreadWrapper, Para, 0, &ThreadId);
-
-  if (*Hand == NULL)
-    return -1;
-
-  return 0;
-}
-
-int
-pthread_kill(HANDLE Hand, int Sig __attribute__ ((unused)))
-{
-  if (!TerminateThread(Hand, 0))
-    return -1;
-
-  return 0;
-}
-
-int
-pthread_mutex_init(HANDLE * Hand, void *Attr __attribute__ ((unused)))
-{
-  *Hand = CreateMutex(NULL, FALSE, NULL);
-
-  if (*Hand == NULL)
-    return -1;
-
-  return 0;
-}
-
-int
-pthread_mutex_lock(HANDLE * Hand)
-{
-  if (WaitForSingleObject(*Hand, INFINITE) == WAIT_FAILED)
-    return -1;
-
-  return 0;
-}
-
-int
-pthread_mutex_unlock(HANDLE * Hand)
-{
-  if (!ReleaseMutex(*Hand))
-    return -1;
-
-  return 0;
-}
-
-#endif
-
 /*
  * Local Variables:
  * c-basic-offset: 2
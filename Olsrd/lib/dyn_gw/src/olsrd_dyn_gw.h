@@ -55,8 +55,13 @@
 #define DEFAULT_HNA_CHECK_INTERVAL	1000
 #define DEFAULT_PING_CHECK_INTERVAL	5
 
+/* a ping host is lost when this many probes in a row go unanswered */
+#define PING_LOSS_TOLERANCE	3
+
 int olsrd_plugin_init(void);
 
+void olsr_plugin_exit(void);
+
 int olsrd_plugin_interface_version(void);
 
 void olsrd_get_plugin_parameters(const struct olsrd_plugin_parameters **params, int *size);
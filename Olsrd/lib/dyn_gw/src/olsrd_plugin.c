@@ -54,6 +54,7 @@
  */
 
 static void my_init(void) __attribute__ ((constructor));
+static void my_fini(void) __attribute__ ((destructor));
 
 /*
  * Defines the version of the plugin interface that is used
@@ -76,6 +77,21 @@ my_init(void)
   printf("%s\n", MOD_DESC);
 }
 
+/**
+ *Destructor
+ */
+void
+my_fini(void)
+{
+  /* Calls the destruction function
+   * olsr_plugin_exit()
+   * This function should be present in your
+   * sourcefile and all data destruction
+   * should happen there - NOT HERE!
+   */
+  olsr_plugin_exit();
+}
+
 /*
  * Local Variables:
  * c-basic-offset: 2
@@ -45,7 +45,10 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <strings.h>
 #include <stdlib.h>
+#include <stddef.h>
+#include <ctype.h>
 #include <unistd.h>
 #include <errno.h>
 #ifdef WIN32
@@ -53,16 +56,23 @@
 #else
 #include <netdb.h>
 #endif
+#ifdef HTTPINFO_ZLIB
+#include <zlib.h>
+#endif
 
 #include "olsr.h"
 #include "olsr_cfg.h"
 #include "interfaces.h"
 #include "olsr_protocol.h"
 #include "net_olsr.h"
+#include "net_os.h"
 #include "link_set.h"
 #include "ipcalc.h"
 #include "lq_plugin.h"
+#include "parser.h"
+#include "scheduler.h"
 #include "common/autobuf.h"
+#include "common/list.h"
 
 #include "olsrd_httpinfo.h"
 #include "admin_interface.h"
@@ -90,13 +100,17 @@
 static char copyright_string[] __attribute__ ((unused)) =
   "olsr.org HTTPINFO plugin Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org) All rights reserved.";
 
-#define MAX_CLIENTS 3
+#define MAX_CLIENTS 16
 
 #define MAX_HTTPREQ_SIZE (1024 * 10)
 
 #define DEFAULT_TCP_PORT 1978
 
-#define HTML_BUFSIZE (1024 * 4000)
+/* connections making no progress for this long are closed (ms) */
+#define HTTP_IDLE_TIMEOUT (15 * MSEC_PER_SEC)
+
+/* body parts of a page, each one is rendered and sent on its own */
+#define MAX_PAGE_PARTS 5
 
 #define FRAMEWIDTH (resolve_ip_addresses ? 900 : 800)
 
@@ -134,8 +148,10 @@ typedef void (*build_body_callback) (struct autobuf *);
 struct tab_entry {
   const char *tab_label;
   const char *filename;
-  build_body_callback build_body_cb;
+  build_body_callback build_body_cb[MAX_PAGE_PARTS + 1];
   bool display_tab;
+  bool cacheable;                      /* shows tables only, ETag follows the table changes */
+  bool link_quality;                   /* shows link quality, ETag also expires after cache_max_age */
 };
 
 struct static_bin_file_entry {
@@ -154,15 +170,53 @@ struct dynamic_file_entry {
   int (*process_data_cb) (char *, uint32_t, char *, uint32_t);
 };
 
+/* A persistent connection, reading requests and sending responses in turn */
+struct http_client {
+  struct list_node node;
+  int fd;
+  uint32_t timeout;                    /* closed if nothing happens until then */
+  char request[MAX_HTTPREQ_SIZE];      /* received but unprocessed bytes */
+  size_t request_len;
+
+  /* current response */
+  struct autobuf out;
+  int out_offset;
+  int page;                            /* tab_entries index while a page is rendered, else -1 */
+  int part;                            /* next part of the page */
+  bool keep_alive;
+  bool chunked;
+#ifdef HTTPINFO_ZLIB
+  bool gzip;
+  z_stream zstream;
+#endif
+};
+
+struct http_request {
+  char method[11];
+  char filename[251];
+  char version[11];
+  bool http11;
+  bool keep_alive;
+  bool accept_gzip;
+  char if_none_match[64];
+  size_t body_len;
+};
+
 static int get_http_socket(int);
 
 static void build_tabs(struct autobuf *, int);
 
-static void parse_http_request(int fd, void *, unsigned int);
+static void accept_http_client(int fd, void *, unsigned int);
+
+static void http_client_action(int fd, void *, unsigned int);
+
+static void http_client_write(struct http_client *);
+
+static void http_client_close(struct http_client *);
 
-static int build_http_header(http_header_type, bool, uint32_t, char *, uint32_t);
+static bool http_process_request(struct http_client *);
 
-static void build_frame(struct autobuf *, const char *, const char *, int, build_body_callback frame_body_cb);
+static void build_http_header(struct http_client *, http_header_type, bool, int, const char *);
 
 static void build_routes_body(struct autobuf *);
 
@@ -174,9 +228,7 @@ static void build_topo_body(struct autobuf *);
 
 static void build_mid_body(struct autobuf *);
 
-static void build_nodes_body(struct autobuf *);
-
-static void build_all_body(struct autobuf *);
+static void build_msgstats_body(struct autobuf *);
 
 static void build_about_body(struct autobuf *);
 
@@ -190,39 +242,39 @@ static void build_ipaddr_link(struct autobuf *, const bool want_link, const unio
                              const int prefix_len);
 static void section_title(struct autobuf *, const char *title);
 
-static void httpinfo_write_data(void *foo);
+static void http_check_timeouts(void *);
 
 static struct timeval start_time;
 static struct http_stats stats;
 static int http_socket;
 
-static char *outbuffer[MAX_CLIENTS];
-static size_t outbuffer_size[MAX_CLIENTS];
-static size_t outbuffer_written[MAX_CLIENTS];
-static int outbuffer_socket[MAX_CLIENTS];
-static int outbuffer_count;
+static struct list_node client_head;
+static int client_count;
+static struct timer_entry *timeout_timer;
 
-static struct timer_entry *writetimer_entry;
+/* bumped whenever olsrd reports changed tables, part of the page ETags */
+static unsigned int table_generation;
 
-#if 0
-int netsprintf(char *str, const char *format, ...) __attribute__ ((format(printf, 2, 3)));
-static int netsprintf_direct = 0;
-static int netsprintf_error = 0;
-#define sprintf netsprintf
-#define NETDIRECT
+/* one part of a page, before compression and chunk framing */
+static struct autobuf part_buf;
+#ifdef HTTPINFO_ZLIB
+static struct autobuf gzip_buf;
 #endif
 
+LISTNODE2STRUCT(list2client, struct http_client, node);
+
 static const struct tab_entry tab_entries[] = {
-  {"Configuration", "config", build_config_body, true},
-  {"Routes", "routes", build_routes_body, true},
-  {"Links/Topology", "nodes", build_nodes_body, true},
-  {"All", "all", build_all_body, true},
+  {"Configuration", "config", {build_config_body}, true, false, false},
+  {"Routes", "routes", {build_routes_body}, true, true, true},
+  {"Links/Topology", "nodes", {build_neigh_body, build_topo_body, build_mid_body}, true, true, true},
+  {"Messages", "messages", {build_msgstats_body}, true, false, false},
+  {"All", "all", {build_config_body, build_routes_body, build_neigh_body, build_topo_body, build_mid_body}, true, false, false},
 #ifdef ADMIN_INTERFACE
-  {"Admin", "admin", build_admin_body, true},
+  {"Admin", "admin", {build_admin_body}, true, false, false},
 #endif
-  {"About", "about", build_about_body, true},
-  {"FOO", "cfgfile", build_cfgfile_body, false},
-  {NULL, NULL, NULL, false}
+  {"About", "about", {build_about_body}, true, true, false},
+  {"FOO", "cfgfile", {build_cfgfile_body}, false, true, false},
+  {NULL, NULL, {NULL}, false, false, false}
 };
 
 static const struct static_bin_file_entry static_bin_files[] = {
@@ -282,7 +334,7 @@ get_http_socket(int port)
   }
 
   /* show that we are willing to listen */
-  if (listen(s, 1) == -1) {
+  if (listen(s, SOMAXCONN) == -1) {
     olsr_printf(1, "(HTTPINFO) listen failed %s\n", strerror(errno));
     close(s);
     return -1;
@@ -291,6 +343,16 @@ get_http_socket(int port)
   return s;
 }
 
+/* pages showing tables get a new ETag after every change */
+static int
+httpinfo_pcf(int neighborhood, int topology, int hna)
+{
+  if (neighborhood || topology || hna) {
+    table_generation++;
+  }
+  return 0;
+}
+
 /**
  *Do initialization here
  *
@@ -303,6 +365,12 @@ olsrd_plugin_init(void)
   /* Get start time */
   gettimeofday(&start_time, NULL);
 
+  list_head_init(&client_head);
+  abuf_init(&part_buf, AUTOBUFCHUNK);
+#ifdef HTTPINFO_ZLIB
+  abuf_init(&gzip_buf, AUTOBUFCHUNK);
+#endif
+
   /* set up HTTP socket */
   http_socket = get_http_socket(http_port != 0 ? http_port : DEFAULT_TCP_PORT);
 
@@ -312,291 +380,538 @@ olsrd_plugin_init(void)
   }
 
   /* Register socket */
-  add_olsr_socket(http_socket, &parse_http_request, NULL, NULL, SP_PR_READ);
+  add_olsr_socket(http_socket, &accept_http_client, NULL, NULL, SP_PR_READ);
+
+  timeout_timer = olsr_start_timer(MSEC_PER_SEC, 0, OLSR_TIMER_PERIODIC, &http_check_timeouts, NULL, 0);
+  register_pcf(&httpinfo_pcf);
 
   return 1;
 }
 
-/* Non reentrant - but we are not multithreaded anyway */
 static void
-parse_http_request(int fd, void *data __attribute__ ((unused)), unsigned int flags __attribute__ ((unused)))
+http_client_touch(struct http_client *client)
+{
+  client->timeout = GET_TIMESTAMP(HTTP_IDLE_TIMEOUT);
+}
+
+static void
+http_check_timeouts(void *foo __attribute__ ((unused)))
+{
+  struct list_node *node, *next;
+
+  for (node = client_head.next; node != &client_head; node = next) {
+    next = node->next;
+    if (TIMED_OUT(list2client(node)->timeout)) {
+      http_client_close(list2client(node));
+    }
+  }
+}
+
+/* wait for either the next request (SP_IMM_READ) or a writable socket (SP_IMM_WRITE) */
+static void
+http_client_wait(struct http_client *client, unsigned int flags)
+{
+  disable_olsr_socket(client->fd, NULL, &http_client_action, ~flags & (SP_IMM_READ | SP_IMM_WRITE));
+  enable_olsr_socket(client->fd, NULL, &http_client_action, flags);
+}
+
+static void
+accept_http_client(int fd, void *data __attribute__ ((unused)), unsigned int flags __attribute__ ((unused)))
 {
   struct sockaddr_in pin;
-  struct autobuf body_abuf = { 0, 0, NULL };
+  struct http_client *client;
   socklen_t addrlen;
-  char header_buf[MAX_HTTPREQ_SIZE];
-  char req_type[11];
-  char filename[251];
-  char http_version[11];
   int client_socket;
-  size_t header_length = 0;
-  size_t c = 0;
-  int r = 1;
-#ifdef linux
-  struct timeval timeout = { 0, 200 };
-#endif
-
-  if (outbuffer_count >= MAX_CLIENTS) {
-    olsr_printf(1, "(HTTPINFO) maximum number of connection reached\n");
-    return;
-  }
 
   addrlen = sizeof(struct sockaddr_in);
   client_socket = accept(fd, (struct sockaddr *)&pin, &addrlen);
   if (client_socket == -1) {
     olsr_printf(1, "(HTTPINFO) accept: %s\n", strerror(errno));
-    goto close_connection;
+    return;
   }
 
-#ifdef linux
-  if (setsockopt(client_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) < 0) {
-    olsr_printf(1, "(HTTPINFO)SO_RCVTIMEO failed %s\n", strerror(errno));
-    goto close_connection;
+  if (client_count >= MAX_CLIENTS) {
+    olsr_printf(1, "(HTTPINFO) maximum number of connection reached\n");
+    close(client_socket);
+    return;
   }
 
-  if (setsockopt(client_socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) < 0) {
-    olsr_printf(1, "(HTTPINFO)SO_SNDTIMEO failed %s\n", strerror(errno));
-    goto close_connection;
-  }
-#endif
   if (!check_allowed_ip(allowed_nets, (union olsr_ip_addr *)&pin.sin_addr.s_addr)) {
     struct ipaddr_str strbuf;
     olsr_printf(0, "HTTP request from non-allowed host %s!\n",
                 olsr_ip_to_string(&strbuf, (union olsr_ip_addr *)&pin.sin_addr.s_addr));
-    goto close_connection;
+    close(client_socket);
+    return;
   }
 
-  memset(header_buf, 0, sizeof(header_buf));
+  if (olsr_set_nonblocking(client_socket) == -1) {
+    close(client_socket);
+    return;
+  }
+
+  client = olsr_malloc(sizeof(*client), "http client");
+  client->fd = client_socket;
+  client->page = -1;
+  abuf_init(&client->out, AUTOBUFCHUNK);
+  list_add_before(&client_head, &client->node);
+  client_count++;
 
-  while ((r = recv(client_socket, &header_buf[c], 1, 0)) > 0 && (c < sizeof(header_buf) - 1)) {
-    c++;
+  http_client_touch(client);
+  add_olsr_socket(client_socket, NULL, &http_client_action, client, SP_IMM_READ);
+}
 
-    if ((c > 3 && !strcmp(&header_buf[c - 4], "\r\n\r\n")) || (c > 1 && !strcmp(&header_buf[c - 2], "\n\n")))
-      break;
+static void
+http_end_response(struct http_client *client)
+{
+#ifdef HTTPINFO_ZLIB
+  if (client->gzip) {
+    deflateEnd(&client->zstream);
+    client->gzip = false;
   }
+#endif
+  client->page = -1;
+  client->chunked = false;
+  client->out.len = 0;
+  client->out_offset = 0;
+}
 
-  if (r < 0) {
-    olsr_printf(1, "(HTTPINFO) Failed to recieve data from client!\n");
-    stats.err_hits++;
-    goto close_connection;
+static void
+http_client_close(struct http_client *client)
+{
+  remove_olsr_socket(client->fd, NULL, &http_client_action);
+  close(client->fd);
+
+  http_end_response(client);
+  abuf_free(&client->out);
+  list_remove(&client->node);
+  free(client);
+  client_count--;
+}
+
+static void
+http_client_action(int fd, void *data, unsigned int flags)
+{
+  struct http_client *client = data;
+  ssize_t len;
+
+  if ((flags & SP_IMM_WRITE) != 0) {
+    http_client_write(client);
+    return;
   }
 
-  /* Get the request */
-  if (sscanf(header_buf, "%10s %250s %10s\n", req_type, filename, http_version) != 3) {
-    /* Try without HTTP version */
-    if (sscanf(header_buf, "%10s %250s\n", req_type, filename) != 2) {
-      olsr_printf(1, "(HTTPINFO) Error parsing request %s!\n", header_buf);
-      stats.err_hits++;
-      goto close_connection;
+  len = recv(fd, (void *)&client->request[client->request_len], sizeof(client->request) - 1 - client->request_len, 0);
+  if (len == 0 || (len < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+    /* client closed the connection */
+    http_client_close(client);
+    return;
+  }
+  if (len > 0) {
+    client->request_len += len;
+    http_client_touch(client);
+    if (http_process_request(client)) {
+      http_client_write(client);
     }
   }
+}
 
-  olsr_printf(1, "Request: %s\nfile: %s\nVersion: %s\n\n", req_type, filename, http_version);
-  abuf_init(&body_abuf, 102400);
-
-  if (!strcmp(req_type, "POST")) {
-#ifdef ADMIN_INTERFACE
-    int i = 0;
-    while (dynamic_files[i].filename) {
-      printf("POST checking %s\n", dynamic_files[i].filename);
-      if (FILENREQ_MATCH(filename, dynamic_files[i].filename)) {
-        uint32_t param_size;
+/* Append body data, compressing and framing it as needed */
+static void
+http_put_body(struct http_client *client, char *data, int len, bool last)
+{
+#ifdef HTTPINFO_ZLIB
+  if (client->gzip) {
+    gzip_buf.len = 0;
+    client->zstream.next_in = (Bytef *)data;
+    client->zstream.avail_in = len;
+    do {
+      Bytef zout[4096];
+
+      client->zstream.next_out = zout;
+      client->zstream.avail_out = sizeof(zout);
+      deflate(&client->zstream, last ? Z_FINISH : Z_NO_FLUSH);
+      abuf_memcpy(&gzip_buf, zout, sizeof(zout) - client->zstream.avail_out);
+    } while (client->zstream.avail_out == 0);
+
+    data = gzip_buf.buf;
+    len = gzip_buf.len;
+  }
+#endif
 
-        stats.ok_hits++;
+  if (client->chunked) {
+    if (len > 0) {
+      abuf_appendf(&client->out, "%x\r\n", len);
+      abuf_memcpy(&client->out, data, len);
+      abuf_puts(&client->out, "\r\n");
+    }
+    if (last) {
+      abuf_puts(&client->out, "0\r\n\r\n");
+    }
+  } else if (len > 0) {
+    abuf_memcpy(&client->out, data, len);
+  }
+}
 
-        param_size = recv(client_sockets[curr_clients], header_buf, sizeof(header_buf) - 1, 0);
+/* Render the next part of the current page, one table at a time */
+static void
+http_page_next_part(struct http_client *client)
+{
+  const struct tab_entry *tab = &tab_entries[client->page];
+  bool last = false;
+
+  part_buf.len = 0;
+  if (client->part == 0) {
+    abuf_appendf(&part_buf,
+               "<!DOCTYPE HTML PUBLIC \"-//W3C//DTD HTML 4.01 Transitional//EN\">\n" "<head>\n"
+               "<meta http-equiv=\"Content-type\" content=\"text/html; charset=ISO-8859-1\">\n"
+               "<title>olsr.org httpinfo plugin</title>\n" "<link rel=\"icon\" href=\"favicon.ico\" type=\"image/x-icon\">\n"
+               "<link rel=\"shortcut icon\" href=\"favicon.ico\" type=\"image/x-icon\">\n"
+               "<link rel=\"stylesheet\" type=\"text/css\" href=\"httpinfo.css\">\n" "</head>\n"
+               "<body bgcolor=\"#ffffff\" text=\"#000000\">\n"
+               "<table border=\"0\" cellpadding=\"0\" cellspacing=\"0\" width=\"%d\">\n"
+               "<tbody><tr bgcolor=\"#ffffff\">\n" "<td align=\"left\" height=\"69\" valign=\"middle\" width=\"80%%\">\n"
+               "<font color=\"black\" face=\"timesroman\" size=\"6\">&nbsp;&nbsp;&nbsp;<a href=\"http://www.olsr.org/\">olsr.org OLSR daemon</a></font></td>\n"
+               "<td height=\"69\" valign=\"middle\" width=\"20%%\">\n"
+               "<a href=\"http://www.olsr.org/\"><img border=\"0\" src=\"/logo.gif\" alt=\"olsrd logo\"></a></td>\n" "</tr>\n"
+               "</tbody>\n" "</table>\n", FRAMEWIDTH);
+
+    build_tabs(&part_buf, client->page);
+    abuf_puts(&part_buf, "<div id=\"maintable\">\n");
+  } else if (tab->build_body_cb[client->part - 1] != NULL) {
+    tab->build_body_cb[client->part - 1](&part_buf);
+  } else {
+    abuf_puts(&part_buf, "</div>\n");
+    abuf_appendf(&part_buf,
+               "</table>\n" "<div id=\"footer\">\n" "<center>\n" "(C)2005 Andreas T&oslash;nnesen<br/>\n"
+               "<a href=\"http://www.olsr.org/\">http://www.olsr.org</a>\n" "</center>\n" "</div>\n" "</body>\n" "</html>\n");
+    last = true;
+  }
 
-        header_buf[param_size] = '\0';
-        printf("Dynamic read %d bytes\n", param_size);
+  client->part++;
+  http_put_body(client, part_buf.buf, part_buf.len, last);
+  if (last) {
+    client->page = -1;
+  }
+}
 
-        //memcpy(body, dynamic_files[i].data, static_bin_files[i].data_size);
-        body_length += dynamic_files[i].process_data_cb(header_buf, param_size, &body_buf[body_length], sizeof(body_buf) - body_length);
-        header_length = build_http_header(HTTP_OK, true, body_length, header_buf, sizeof(header_buf));
-        goto send_http_data;
+static void
+http_client_write(struct http_client *client)
+{
+  for (;;) {
+    while (client->out_offset < client->out.len) {
+      ssize_t result = send(client->fd, client->out.buf + client->out_offset, client->out.len - client->out_offset, 0);
+      if (result < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+          http_client_wait(client, SP_IMM_WRITE);
+          return;
+        }
+        http_client_close(client);
+        return;
       }
-      i++;
+      client->out_offset += result;
+      http_client_touch(client);
     }
-#endif
-    /* We only support GET */
-    abuf_puts(&body_abuf, HTTP_400_MSG);
-    stats.ill_hits++;
-    header_length = build_http_header(HTTP_BAD_REQ, true, body_abuf.len, header_buf, sizeof(header_buf));
-  } else if (!strcmp(req_type, "GET")) {
-    int i = 0;
+    client->out.len = 0;
+    client->out_offset = 0;
 
-    for (i = 0; static_bin_files[i].filename; i++) {
-      if (FILENREQ_MATCH(filename, static_bin_files[i].filename)) {
-        break;
-      }
+    if (client->page != -1) {
+      http_page_next_part(client);
+      continue;
     }
 
-    if (static_bin_files[i].filename) {
-      stats.ok_hits++;
-      abuf_memcpy(&body_abuf, static_bin_files[i].data, static_bin_files[i].data_size);
-      header_length = build_http_header(HTTP_OK, false, body_abuf.len, header_buf, sizeof(header_buf));
-      goto send_http_data;
+    /* response complete */
+    if (!client->keep_alive) {
+      http_client_close(client);
+      return;
     }
+    http_end_response(client);
 
-    i = 0;
-    while (static_txt_files[i].filename) {
-      if (FILENREQ_MATCH(filename, static_txt_files[i].filename)) {
-        break;
-      }
-      i++;
+    /* pipelined requests */
+    if (client->request_len == 0 || !http_process_request(client)) {
+      http_client_wait(client, SP_IMM_READ);
+      return;
     }
+  }
+}
 
-    if (static_txt_files[i].filename) {
-      stats.ok_hits++;
-      abuf_puts(&body_abuf, static_txt_files[i].data);
-      header_length = build_http_header(HTTP_OK, false, body_abuf.len, header_buf, sizeof(header_buf));
-      goto send_http_data;
-    }
+/* length of the request header including the empty line, 0 if incomplete */
+static size_t
+http_header_length(const char *buf)
+{
+  const char *p;
 
-    i = 0;
-    if (strlen(filename) > 1) {
-      while (tab_entries[i].filename) {
-        if (FILENREQ_MATCH(filename, tab_entries[i].filename)) {
-          break;
-        }
-        i++;
-      }
+  for (p = buf; (p = strchr(p, '\n')) != NULL; p++) {
+    if (p[1] == '\n') {
+      return p + 2 - buf;
     }
+    if (p[1] == '\r' && p[2] == '\n') {
+      return p + 3 - buf;
+    }
+  }
+  return 0;
+}
 
-    if (tab_entries[i].filename) {
-#ifdef NETDIRECT
-      header_length = build_http_header(HTTP_OK, true, body_length, header_buf, sizeof(header_buf));
-      r = send(client_sockets[curr_clients], header_buf, header_length, 0);
-      if (r < 0) {
-        olsr_printf(1, "(HTTPINFO) Failed sending data to client!\n");
-        goto close_connection;
-      }
-      netsprintf_error = 0;
-      netsprintf_direct = 1;
-#endif
-      abuf_appendf(&body_abuf,
-                 "<!DOCTYPE HTML PUBLIC \"-//W3C//DTD HTML 4.01 Transitional//EN\">\n" "<head>\n"
-                 "<meta http-equiv=\"Content-type\" content=\"text/html; charset=ISO-8859-1\">\n"
-                 "<title>olsr.org httpinfo plugin</title>\n" "<link rel=\"icon\" href=\"favicon.ico\" type=\"image/x-icon\">\n"
-                 "<link rel=\"shortcut icon\" href=\"favicon.ico\" type=\"image/x-icon\">\n"
-                 "<link rel=\"stylesheet\" type=\"text/css\" href=\"httpinfo.css\">\n" "</head>\n"
-                 "<body bgcolor=\"#ffffff\" text=\"#000000\">\n"
-                 "<table border=\"0\" cellpadding=\"0\" cellspacing=\"0\" width=\"%d\">\n"
-                 "<tbody><tr bgcolor=\"#ffffff\">\n" "<td align=\"left\" height=\"69\" valign=\"middle\" width=\"80%%\">\n"
-                 "<font color=\"black\" face=\"timesroman\" size=\"6\">&nbsp;&nbsp;&nbsp;<a href=\"http://www.olsr.org/\">olsr.org OLSR daemon</a></font></td>\n"
-                 "<td height=\"69\" valign=\"middle\" width=\"20%%\">\n"
-                 "<a href=\"http://www.olsr.org/\"><img border=\"0\" src=\"/logo.gif\" alt=\"olsrd logo\"></a></td>\n" "</tr>\n"
-                 "</tbody>\n" "</table>\n", FRAMEWIDTH);
-
-      build_tabs(&body_abuf, i);
-      build_frame(&body_abuf, "Current Routes", "routes", FRAMEWIDTH, tab_entries[i].build_body_cb);
+/* copy the lowercased value of a header line if it has the given name */
+static bool
+http_header_value(const char *line, const char *eol, const char *name, char *value, size_t size)
+{
+  size_t len = strlen(name);
+  size_t i = 0;
 
-      stats.ok_hits++;
+  if (eol - line < (ptrdiff_t)len || strncasecmp(line, name, len) != 0) {
+    return false;
+  }
+  for (line += len; line < eol && (*line == ' ' || *line == '\t'); line++);
+  while (line < eol && *line != '\r' && i < size - 1) {
+    value[i++] = tolower((unsigned char)*line++);
+  }
+  value[i] = '\0';
+  return true;
+}
 
-      abuf_appendf(&body_abuf,
-                 "</table>\n" "<div id=\"footer\">\n" "<center>\n" "(C)2005 Andreas T&oslash;nnesen<br/>\n"
-                 "<a href=\"http://www.olsr.org/\">http://www.olsr.org</a>\n" "</center>\n" "</div>\n" "</body>\n" "</html>\n");
+static bool
+http_parse_request(const char *buf, size_t header_len, struct http_request *req)
+{
+  char line[300];
+  const char *p, *eol;
+  size_t len;
 
-#ifdef NETDIRECT
-      netsprintf_direct = 1;
-      goto close_connection;
-#else
-      header_length = build_http_header(HTTP_OK, true, body_abuf.len, header_buf, sizeof(header_buf));
-      goto send_http_data;
-#endif
-    }
+  memset(req, 0, sizeof(*req));
 
-    stats.ill_hits++;
-    abuf_puts(&body_abuf, HTTP_404_MSG);
-    header_length = build_http_header(HTTP_BAD_FILE, true, body_abuf.len, header_buf, sizeof(header_buf));
-  } else {
-    /* We only support GET */
-    abuf_puts(&body_abuf, HTTP_404_MSG);
-    stats.ill_hits++;
-    header_length = build_http_header(HTTP_BAD_REQ, true, body_abuf.len, header_buf, sizeof(header_buf));
+  /* Get the request */
+  eol = strchr(buf, '\n');
+  len = eol - buf < (ptrdiff_t)sizeof(line) ? (size_t)(eol - buf) : sizeof(line) - 1;
+  memcpy(line, buf, len);
+  line[len] = '\0';
+
+  if (sscanf(line, "%10s %250s %10s", req->method, req->filename, req->version) < 2) {
+    return false;
   }
 
-send_http_data:
-  if (header_length + body_abuf.len > 0) {
-    outbuffer[outbuffer_count] = olsr_malloc(header_length + body_abuf.len, "http output buffer");
-    outbuffer_size[outbuffer_count] = header_length + body_abuf.len;
-    outbuffer_written[outbuffer_count] = 0;
-    outbuffer_socket[outbuffer_count] = client_socket;
+  /* HTTP/1.1 connections are persistent unless the client says otherwise */
+  req->http11 = strcmp(req->version, "HTTP/1.1") == 0;
+  req->keep_alive = req->http11;
 
-    memcpy(outbuffer[outbuffer_count], header_buf, header_length);
-    if (body_abuf.len > 0) {
-      memcpy((outbuffer[outbuffer_count]) + header_length, body_abuf.buf, body_abuf.len);
-    }
-    outbuffer_count++;
+  for (p = eol + 1; p < buf + header_len; p = eol + 1) {
+    char value[80];
 
-    if (outbuffer_count == 1) {
-      writetimer_entry = olsr_start_timer(100, 0, OLSR_TIMER_PERIODIC, &httpinfo_write_data, NULL, 0);
+    eol = strchr(p, '\n');
+    if (http_header_value(p, eol, "Connection:", value, sizeof(value))) {
+      if (strstr(value, "close") != NULL) {
+        req->keep_alive = false;
+      }
+    } else if (http_header_value(p, eol, "Accept-Encoding:", value, sizeof(value))) {
+      const char *gzip = strstr(value, "gzip");
+      req->accept_gzip = gzip != NULL && (strncmp(gzip + 4, ";q=", 3) != 0 || atof(gzip + 7) > 0);
+    } else if (http_header_value(p, eol, "If-None-Match:", value, sizeof(value))) {
+      strscpy(req->if_none_match, value, sizeof(req->if_none_match));
+    } else if (http_header_value(p, eol, "Content-Length:", value, sizeof(value))) {
+      req->body_len = strtoul(value, NULL, 10);
     }
   }
-  abuf_free(&body_abuf);
-  return;
+  return true;
+}
+
+static void
+http_etag(char *buf, size_t size, bool weak, unsigned int generation, unsigned int period)
+{
+  snprintf(buf, size, "%s\"%lx-%x-%x\"", weak ? "W/" : "", (unsigned long)start_time.tv_sec, generation, period);
+}
+
+/* link quality changes without a table change, so it only stays valid for cache_max_age */
+static bool
+http_page_cacheable(int page)
+{
+  return tab_entries[page].cacheable && (!tab_entries[page].link_quality || cache_max_age > 0);
+}
+
+/* weak comparison as required for If-None-Match */
+static bool
+http_etag_match(const struct http_request *req, const char *etag)
+{
+  if (strncmp(etag, "W/", 2) == 0) {
+    etag += 2;
+  }
+  return strcmp(req->if_none_match, "*") == 0 || strstr(req->if_none_match, etag) != NULL;
+}
 
-close_connection:
-  abuf_free(&body_abuf);
-  close(client_socket);
+static void
+http_send_fixed(struct http_client *client, http_header_type type, bool is_html, const void *data, int len,
+                const char *etag, bool head_only)
+{
+  build_http_header(client, type, is_html, len, etag);
+  if (!head_only && len > 0) {
+    abuf_memcpy(&client->out, data, len);
+  }
 }
 
 static void
-httpinfo_write_data(void *foo __attribute__ ((unused))) {
-  fd_set set;
-  int result, i, j, max;
-  struct timeval tv;
-
-  FD_ZERO(&set);
-  max = 0;
-  for (i=0; i<outbuffer_count; i++) {
-    /* prevent warning in win32 */
-    FD_SET((unsigned int)outbuffer_socket[i], &set);
-    if (outbuffer_socket[i] > max) {
-      max = outbuffer_socket[i];
+http_start_page(struct http_client *client, const struct http_request *req, int page, bool head_only)
+{
+  char etag[48];
+  const bool cacheable = http_page_cacheable(page);
+
+  if (cacheable) {
+    /* tables did not change since the client got the page */
+    http_etag(etag, sizeof(etag), true, table_generation,
+              tab_entries[page].link_quality ? now_times / (unsigned int)cache_max_age : 0);
+    if (http_etag_match(req, etag)) {
+      build_http_header(client, HTTP_NOT_MODIFIED, true, -1, etag);
+      return;
     }
   }
 
-  tv.tv_sec = 0;
-  tv.tv_usec = 0;
+  stats.ok_hits++;
+
+  /* HTTP/1.0 clients read the page until the connection is closed */
+  client->chunked = req->http11;
+  if (!client->chunked) {
+    client->keep_alive = false;
+  }
+
+#ifdef HTTPINFO_ZLIB
+  if (req->accept_gzip && !head_only) {
+    memset(&client->zstream, 0, sizeof(client->zstream));
+    client->gzip = deflateInit2(&client->zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+  }
+#endif
+
+  build_http_header(client, HTTP_OK, true, -1, cacheable ? etag : NULL);
+  if (!head_only) {
+    client->page = page;
+    client->part = 0;
+  }
+}
+
+static void
+http_handle_request(struct http_client *client, const struct http_request *req, const char *body __attribute__ ((unused)))
+{
+  const bool head_only = !strcmp(req->method, "HEAD");
+  char etag[48];
+  int i;
+
+  client->keep_alive = req->keep_alive;
+
+  if (!strcmp(req->method, "POST")) {
+#ifdef ADMIN_INTERFACE
+    for (i = 0; dynamic_files[i].filename; i++) {
+      if (FILENREQ_MATCH(req->filename, dynamic_files[i].filename)) {
+        static char dyn_buf[MAX_HTTPREQ_SIZE];
+        char params[MAX_HTTPREQ_SIZE];
+        uint32_t param_size = req->body_len;
+        int size;
+
+        stats.ok_hits++;
+
+        memcpy(params, body, param_size);
+        params[param_size] = '\0';
 
-  result = select(max + 1, NULL, &set, NULL, &tv);
-  if (result <= 0) {
+        size = dynamic_files[i].process_data_cb(params, param_size, dyn_buf, sizeof(dyn_buf));
+        http_send_fixed(client, HTTP_OK, true, dyn_buf, size < 0 ? 0 : size, NULL, false);
+        return;
+      }
+    }
+#endif
+    /* We only support GET */
+    stats.ill_hits++;
+    http_send_fixed(client, HTTP_BAD_REQ, true, HTTP_400_MSG, strlen(HTTP_400_MSG), NULL, false);
     return;
   }
 
-  for (i=0; i<outbuffer_count; i++) {
-    if (FD_ISSET(outbuffer_socket[i], &set)) {
-      result = write(outbuffer_socket[i], outbuffer[i] + outbuffer_written[i], outbuffer_size[i] - outbuffer_written[i]);
-      if (result > 0) {
-        outbuffer_written[i] += result;
+  if (strcmp(req->method, "GET") && !head_only) {
+    /* We only support GET */
+    stats.ill_hits++;
+    http_send_fixed(client, HTTP_BAD_REQ, true, HTTP_400_MSG, strlen(HTTP_400_MSG), NULL, false);
+    return;
+  }
+
+  /* static files only change with the daemon */
+  http_etag(etag, sizeof(etag), false, 0, 0);
+
+  for (i = 0; static_bin_files[i].filename; i++) {
+    if (FILENREQ_MATCH(req->filename, static_bin_files[i].filename)) {
+      if (http_etag_match(req, etag)) {
+        build_http_header(client, HTTP_NOT_MODIFIED, false, -1, etag);
+        return;
       }
+      stats.ok_hits++;
+      http_send_fixed(client, HTTP_OK, false, static_bin_files[i].data, static_bin_files[i].data_size, etag, head_only);
+      return;
+    }
+  }
 
-      if (result <= 0 || outbuffer_written[i] == outbuffer_size[i]) {
-        /* close this socket and cleanup*/
-        close(outbuffer_socket[i]);
-        free (outbuffer[i]);
+  for (i = 0; static_txt_files[i].filename; i++) {
+    if (FILENREQ_MATCH(req->filename, static_txt_files[i].filename)) {
+      if (http_etag_match(req, etag)) {
+        build_http_header(client, HTTP_NOT_MODIFIED, false, -1, etag);
+        return;
+      }
+      stats.ok_hits++;
+      http_send_fixed(client, HTTP_OK, false, static_txt_files[i].data, strlen(static_txt_files[i].data), etag, head_only);
+      return;
+    }
+  }
 
-        for (j=i+1; j<outbuffer_count; j++) {
-          outbuffer[j-1] = outbuffer[j];
-          outbuffer_size[j-1] = outbuffer_size[j];
-          outbuffer_socket[j-1] = outbuffer_socket[j];
-          outbuffer_written[j-1] = outbuffer_written[j];
-        }
-        outbuffer_count--;
+  if (strlen(req->filename) > 1) {
+    for (i = 0; tab_entries[i].filename; i++) {
+      if (FILENREQ_MATCH(req->filename, tab_entries[i].filename)) {
+        http_start_page(client, req, i, head_only);
+        return;
       }
     }
+  } else {
+    /* the first tab is the index page */
+    http_start_page(client, req, 0, head_only);
+    return;
+  }
+
+  stats.ill_hits++;
+  http_send_fixed(client, HTTP_BAD_FILE, true, HTTP_404_MSG, strlen(HTTP_404_MSG), NULL, head_only);
+}
+
+/* Queue the response to the next complete request, if there is one */
+static bool
+http_process_request(struct http_client *client)
+{
+  struct http_request req;
+  size_t header_len;
+
+  client->request[client->request_len] = '\0';
+  header_len = http_header_length(client->request);
+  if (header_len == 0 && client->request_len < sizeof(client->request) - 1) {
+    /* wait for the rest */
+    return false;
   }
-  if (outbuffer_count == 0) {
-    olsr_stop_timer(writetimer_entry);
+
+  if (header_len == 0 || !http_parse_request(client->request, header_len, &req)
+      || header_len + req.body_len > sizeof(client->request) - 1) {
+    olsr_printf(1, "(HTTPINFO) Error parsing request %s!\n", client->request);
+    stats.err_hits++;
+    client->keep_alive = false;
+    client->request_len = 0;
+    http_send_fixed(client, HTTP_BAD_REQ, true, HTTP_400_MSG, strlen(HTTP_400_MSG), NULL, false);
+    return true;
+  }
+
+  if (client->request_len < header_len + req.body_len) {
+    /* wait for the request body */
+    return false;
   }
+
+  olsr_printf(1, "Request: %s\nfile: %s\nVersion: %s\n\n", req.method, req.filename, req.version);
+  http_handle_request(client, &req, client->request + header_len);
+
+  client->request_len -= header_len + req.body_len;
+  memmove(client->request, client->request + header_len + req.body_len, client->request_len);
+  return true;
 }
 
-int
-build_http_header(http_header_type type, bool is_html, uint32_t msgsize, char *buf, uint32_t bufsize)
+static void
+build_http_header(struct http_client *client, http_header_type type, bool is_html, int msgsize, const char *etag)
 {
+  struct autobuf *abuf = &client->out;
+  const int start = abuf->len;
   time_t currtime;
   const char *h;
-  int size;
 
   switch (type) {
   case HTTP_BAD_REQ:
@@ -605,45 +920,59 @@ build_http_header(http_header_type type, bool is_html, uint32_t msgsize, char *b
   case HTTP_BAD_FILE:
     h = HTTP_404;
     break;
+  case HTTP_NOT_MODIFIED:
+    h = HTTP_304;
+    break;
   default:
     /* Defaults to OK */
     h = HTTP_200;
     break;
   }
-  size = snprintf(buf, bufsize, "%s", h);
+  abuf_puts(abuf, h);
 
   /* Date */
   time(&currtime);
-  size += strftime(&buf[size], bufsize - size, "Date: %a, %d %b %Y %H:%M:%S GMT\r\n", localtime(&currtime));
+  abuf_strftime(abuf, "Date: %a, %d %b %Y %H:%M:%S GMT\r\n", gmtime(&currtime));
 
   /* Server version */
-  size += snprintf(&buf[size], bufsize - size, "Server: %s %s %s\r\n", PLUGIN_NAME, PLUGIN_VERSION, HTTP_VERSION);
+  abuf_appendf(abuf, "Server: %s %s %s\r\n", PLUGIN_NAME, PLUGIN_VERSION, HTTP_VERSION);
 
   /* connection-type */
-  size += snprintf(&buf[size], bufsize - size, "Connection: closed\r\n");
+  abuf_appendf(abuf, "Connection: %s\r\n", client->keep_alive ? "keep-alive" : "close");
 
-  /* MIME type */
-  size += snprintf(&buf[size], bufsize - size, "Content-type: text/%s\r\n", is_html ? "html" : "plain");
+  if (type != HTTP_NOT_MODIFIED) {
+    /* MIME type */
+    abuf_appendf(abuf, "Content-type: text/%s\r\n", is_html ? "html" : "plain");
+
+    /* Content length, pages are sent in chunks or until the connection closes */
+    if (msgsize >= 0) {
+      abuf_appendf(abuf, "Content-length: %i\r\n", msgsize);
+    } else if (client->chunked) {
+      abuf_puts(abuf, "Transfer-Encoding: chunked\r\n");
+    }
+#ifdef HTTPINFO_ZLIB
+    if (client->gzip) {
+      abuf_puts(abuf, "Content-Encoding: gzip\r\n");
+    }
+    if (msgsize < 0) {
+      abuf_puts(abuf, "Vary: Accept-Encoding\r\n");
+    }
+#endif
+  }
 
-  /* Content length */
-  if (msgsize > 0) {
-    size += snprintf(&buf[size], bufsize - size, "Content-length: %i\r\n", msgsize);
+  if (etag != NULL) {
+    abuf_appendf(abuf, "ETag: %s\r\n", etag);
   }
 
   /* Cache-control
-   * No caching dynamic pages
+   * Dynamic pages are revalidated with their ETag
    */
-  size += snprintf(&buf[size], bufsize - size, "Cache-Control: no-cache\r\n");
+  abuf_puts(abuf, "Cache-Control: no-cache\r\n");
 
-  if (!is_html) {
-    size += snprintf(&buf[size], bufsize - size, "Accept-Ranges: bytes\r\n");
-  }
   /* End header */
-  size += snprintf(&buf[size], bufsize - size, "\r\n");
+  abuf_puts(abuf, "\r\n");
 
-  olsr_printf(1, "HEADER:\n%s", buf);
-
-  return size;
+  olsr_printf(1, "HEADER:\n%s", abuf->buf + start);
 }
 
 static void
@@ -675,6 +1004,15 @@ olsr_plugin_exit(void)
     CLOSE(http_socket);
   }
 
+  while (!list_is_empty(&client_head)) {
+    http_client_close(list2client(client_head.next));
+  }
+  olsr_stop_timer(timeout_timer);
+  abuf_free(&part_buf);
+#ifdef HTTPINFO_ZLIB
+  abuf_free(&gzip_buf);
+#endif
+
   for (a = allowed_nets; a != NULL; a = next) {
     next = a->next;
 
@@ -690,15 +1028,6 @@ section_title(struct autobuf *abuf, const char *title)
                   title);
 }
 
-static void
-build_frame(struct autobuf *abuf, const char *title __attribute__ ((unused)), const char *the_link
-            __attribute__ ((unused)), int width __attribute__ ((unused)), build_body_callback frame_body_cb)
-{
-  abuf_puts(abuf, "<div id=\"maintable\">\n");
-  frame_body_cb(abuf);
-  abuf_puts(abuf, "</div>\n");
-}
-
 static void
 fmt_href(struct autobuf *abuf, const char *const ipaddr)
 {
@@ -1072,21 +1401,27 @@ build_mid_body(struct autobuf *abuf)
 }
 
 static void
-build_nodes_body(struct autobuf *abuf)
+build_msgstats_body(struct autobuf *abuf)
 {
-  build_neigh_body(abuf);
-  build_topo_body(abuf);
-  build_mid_body(abuf);
-}
+  int i;
 
-static void
-build_all_body(struct autobuf *abuf)
-{
-  build_config_body(abuf);
-  build_routes_body(abuf);
-  build_neigh_body(abuf);
-  build_topo_body(abuf);
-  build_mid_body(abuf);
+  section_title(abuf, "Received Messages");
+  abuf_puts(abuf, "<tr><th>Type</th><th>Messages</th><th>Bytes</th><th>Duplicates</th><th>Forwarded</th>"
+            "<th>Invalid</th><th>Handler Wall Time (usec/msg)</th></tr>\n");
+
+  for (i = 0; i < 256; i++) {
+    const struct olsr_msgtype_stats *msgstats = &olsr_msgtype_stats[i];
+
+    if (msgstats->messages == 0 && msgstats->dropped_invalid == 0) {
+      continue;
+    }
+    abuf_appendf(abuf, "<tr><td>%s</td><td>%u</td><td>%llu</td><td>%u</td><td>%u</td><td>%u</td><td>%.1f</td></tr>\n",
+                 olsr_msgtype_to_string(i), msgstats->messages, (unsigned long long)msgstats->bytes, msgstats->duplicates,
+                 msgstats->forwarded, msgstats->dropped_invalid,
+                 msgstats->handler_samples ? (double)msgstats->handler_usec / msgstats->handler_samples : 0.0);
+  }
+
+  abuf_puts(abuf, "</table>\n");
 }
 
 static void
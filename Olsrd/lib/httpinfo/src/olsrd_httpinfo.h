@@ -53,6 +53,7 @@
 
 /**Response types */
 #define HTTP_200 HTTP_VERSION " 200 OK\r\n"
+#define HTTP_304 HTTP_VERSION " 304 Not Modified\r\n"
 #define HTTP_400 HTTP_VERSION " 400 Bad Request\r\n"
 #define HTTP_404 HTTP_VERSION " 404 Not Found\r\n"
 
@@ -62,6 +63,7 @@
 typedef enum {
   HTTP_BAD_REQ,
   HTTP_BAD_FILE,
+  HTTP_NOT_MODIFIED,
   HTTP_OK
 } http_header_type;
 
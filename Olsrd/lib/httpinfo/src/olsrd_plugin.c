@@ -58,6 +58,7 @@
 
 int http_port = 0;
 int resolve_ip_addresses = 0;
+int cache_max_age = 1000;
 struct allowed_net *allowed_nets = NULL;
 union olsr_ip_addr httpinfo_listen_ip;
 
@@ -108,6 +109,7 @@ static const struct olsrd_plugin_parameters plugin_parameters[] = {
   {.name = "host",.set_plugin_parameter = &add_plugin_access,.data = &allowed_nets},
   {.name = "net",.set_plugin_parameter = &add_plugin_access,.data = &allowed_nets},
   {.name = "resolve",.set_plugin_parameter = &set_plugin_boolean,.data = &resolve_ip_addresses},
+  {.name = "cachemaxage",.set_plugin_parameter = &set_plugin_int,.data = &cache_max_age},
 };
 
 void
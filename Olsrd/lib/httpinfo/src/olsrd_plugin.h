@@ -73,6 +73,7 @@
 
 extern int http_port;
 extern int resolve_ip_addresses;
+extern int cache_max_age;
 
 /* Allowed hosts stuff */
 
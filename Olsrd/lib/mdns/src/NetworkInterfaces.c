@@ -94,14 +94,15 @@ fd_set InputSet;
  * Function   : CreateCaptureSocket
  * Description: Create socket for promiscuously capturing multicast IP traffic
  * Input      : ifname - network interface (e.g. "eth0")
- * Output     : none
+ * Output     : ring - receive ring of the socket, if PlParam "CaptureRing"
+ *                is set
  * Return     : the socket descriptor ( >= 0), or -1 if an error occurred
- * Data Used  : none
+ * Data Used  : UseCaptureRing
  * Notes      : The socket is a cooked IP packet socket, bound to the specified
  *              network interface
  * ------------------------------------------------------------------------- */
 static int
-CreateCaptureSocket(const char *ifName)
+CreateCaptureSocket(const char *ifName, struct TPacketRing *ring)
 {
   int ifIndex = if_nametoindex(ifName);
   struct packet_mreq mreq;
@@ -157,6 +158,19 @@ CreateCaptureSocket(const char *ifName)
     return -1;
   }
 
+  /* Let the kernel drop frames that are not multicast, broadcast or
+   * outgoing, instead of queueing every promiscuously received frame */
+  if (AttachCaptureFilter(skfd) < 0) {
+    BmfPError("setsockopt(SO_ATTACH_FILTER) error");
+  }
+
+  /* Map a receive ring if configured; without it, captured packets are
+   * read with recvfrom() */
+  memset(ring, 0, sizeof(*ring));
+  if (UseCaptureRing && CreatePacketRing(ring, skfd) < 0) {
+    BmfPError("PACKET_RX_RING error for interface \"%s\"", ifName);
+  }
+
   /* Set socket to blocking operation */
   if (fcntl(skfd, F_SETFL, fcntl(skfd, F_GETFL, 0) & ~O_NONBLOCK) < 0) {
     BmfPError("fcntl() error");
@@ -164,7 +178,7 @@ CreateCaptureSocket(const char *ifName)
     return -1;
   }
   //AddDescriptorToInputSet(skfd);
-  add_olsr_socket(skfd, &DoMDNS,NULL, NULL, SP_PR_READ);
+  add_olsr_socket(skfd, &DoMDNS, NULL, ring->map != NULL ? ring : NULL, SP_PR_READ);
 
   return skfd;
 }                               /* CreateCaptureSocket */
@@ -205,7 +219,7 @@ CreateInterface(const char *ifName, struct interface *olsrIntf)
   /* Create socket for capturing and sending of multicast packets on
    * non-OLSR interfaces, and on OLSR-interfaces if configured. */
   if ((olsrIntf == NULL)) {
-    capturingSkfd = CreateCaptureSocket(ifName);
+    capturingSkfd = CreateCaptureSocket(ifName, &newIf->captureRing);
     if (capturingSkfd < 0) {
       close(encapsulatingSkfd);
       free(newIf);
@@ -225,6 +239,10 @@ CreateInterface(const char *ifName, struct interface *olsrIntf)
   ifr.ifr_name[IFNAMSIZ - 1] = '\0';    /* Ensures null termination */
   if (ioctl(ioctlSkfd, SIOCGIFHWADDR, &ifr) < 0) {
     BmfPError("ioctl(SIOCGIFHWADDR) error for interface \"%s\"", ifName);
+    if (capturingSkfd >= 0) {
+      remove_olsr_socket(capturingSkfd, &DoMDNS, NULL);
+      ClosePacketRing(&newIf->captureRing);
+    }
     close(capturingSkfd);
     close(encapsulatingSkfd);
     free(newIf);
@@ -464,6 +482,7 @@ CloseBmfNetworkInterfaces(void)
     nextBmfIf = bmfIf->next;
 
     if (bmfIf->capturingSkfd >= 0) {
+      ClosePacketRing(&bmfIf->captureRing);
       close(bmfIf->capturingSkfd);
       nClosed++;
     }
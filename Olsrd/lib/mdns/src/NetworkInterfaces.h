@@ -51,6 +51,7 @@
 
 /* Plugin includes */
 #include "Packet.h"             /* IFHWADDRLEN */
+#include "PacketRing.h"         /* struct TPacketRing */
 #include "mdns.h"
 
 /* Size of buffer in which packets are received */
@@ -60,6 +61,10 @@ struct TBmfInterface {
   /* File descriptor of raw packet socket, used for capturing multicast packets */
   int capturingSkfd;
 
+  /* Receive ring of the capturing socket. Only used when PlParam
+   * "CaptureRing" is set; 'map' is NULL otherwise. */
+  struct TPacketRing captureRing;
+
   /* File descriptor of UDP (datagram) socket for encapsulated multicast packets.
    * Only used for OLSR-enabled interfaces; set to -1 if interface is not OLSR-enabled. */
   int encapsulatingSkfd;
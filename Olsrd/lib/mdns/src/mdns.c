@@ -392,18 +392,101 @@ BmfPacketCaptured(
 }                               /* BmfPacketCaptured */
 
 
+/* -------------------------------------------------------------------------
+ * Function   : MdnsFrameCaptured
+ * Description: Handle a frame captured on a non-OLSR interface
+ * Input      : ipPacket - the captured IP packet, preceded by space for the
+ *                encapsulation header
+ *              nBytes - the number of captured bytes
+ *              pktType - the packet type reported by the packet socket
+ * Output     : none
+ * Return     : none
+ * Data Used  : none
+ * ------------------------------------------------------------------------- */
+static void
+MdnsFrameCaptured(unsigned char *ipPacket, int nBytes, unsigned char pktType)
+{
+  /* Check if the number of received bytes is large enough for an IP
+   * packet which contains at least a minimum-size IP header.
+   * Note: There is an apparent bug in the packet socket implementation in
+   * combination with VLAN interfaces. On a VLAN interface, the value returned
+   * by 'recvfrom' may (but need not) be 4 (bytes) larger than the value
+   * returned on a non-VLAN interface, for the same ethernet frame. */
+  if (nBytes < (int)sizeof(struct ip)) {
+    ////OLSR_PRINTF(
+    //              1,
+    //              "%s: captured frame too short (%d bytes) on \"%s\"\n",
+    //              PLUGIN_NAME,
+    //              nBytes,
+    //              walker->ifName);
+
+    return;
+  }
+
+  if (pktType == PACKET_OUTGOING ||
+      pktType == PACKET_MULTICAST || pktType == PACKET_BROADCAST) {
+    /* A multicast or broadcast packet was captured */
+
+    ////OLSR_PRINTF(
+    //              1,
+    //              "%s: captured frame (%d bytes) on \"%s\"\n",
+    //              PLUGIN_NAME,
+    //              nBytes,
+    //              walker->ifName);
+    //BmfPacketCaptured(walker, pktAddr.sll_pkttype, rxBuffer);
+    BmfPacketCaptured(ipPacket, nBytes);
+
+  }                             /* if (pktType == ...) */
+}                               /* MdnsFrameCaptured */
+
+/* -------------------------------------------------------------------------
+ * Function   : MdnsRingFrameCaptured
+ * Description: Handle a frame from the receive ring of a capturing socket
+ * Input      : frame - the captured IP packet, inside the ring
+ *              len - the number of captured bytes
+ *              addr - link layer address information of the frame
+ *              data - unused
+ * Output     : none
+ * Return     : none
+ * Data Used  : none
+ * ------------------------------------------------------------------------- */
+static void
+MdnsRingFrameCaptured(unsigned char *frame, unsigned int len, struct sockaddr_ll *addr,
+                      void *data __attribute__ ((unused)))
+{
+  unsigned char rxBuffer[BMF_BUFFER_SIZE];
+  unsigned char *ipPacket = GetIpPacket(rxBuffer);
+
+  /* Copy the frame out of the ring, leaving space for the encapsulation
+   * header */
+  if (len > (unsigned int)(rxBuffer + sizeof(rxBuffer) - ipPacket)) {
+    len = rxBuffer + sizeof(rxBuffer) - ipPacket;
+  }
+  memcpy(ipPacket, frame, len);
+
+  MdnsFrameCaptured(ipPacket, len, addr->sll_pkttype);
+}                               /* MdnsRingFrameCaptured */
+
 /* -------------------------------------------------------------------------
  * Function   : DoMDNS
  * Description: This function is registered with the OLSR scheduler and called when something is captured
- * Input      : none
+ * Input      : skfd - the capturing socket
+ *              data - its receive ring, or NULL if it is read with recvfrom()
  * Output     : none
  * Return     : none
  * Data Used  :
  * ------------------------------------------------------------------------- */
 void
-DoMDNS(int skfd, void *data __attribute__ ((unused)), unsigned int flags __attribute__ ((unused)))
+DoMDNS(int skfd, void *data, unsigned int flags __attribute__ ((unused)))
 {
   unsigned char rxBuffer[BMF_BUFFER_SIZE];
+
+  /* With a receive ring, handle all frames the kernel has handed over */
+  if (data != NULL) {
+    ProcessPacketRing(data, &MdnsRingFrameCaptured, NULL);
+    return;
+  }
+
   if (skfd >= 0) {
     struct sockaddr_ll pktAddr;
     socklen_t addrLen = sizeof(pktAddr);
@@ -420,38 +503,7 @@ DoMDNS(int skfd, void *data __attribute__ ((unused)), unsigned int flags __attri
       return;                   /* for */
     }
 
-    /* if (nBytes < 0) */
-    /* Check if the number of received bytes is large enough for an IP
-     * packet which contains at least a minimum-size IP header.
-     * Note: There is an apparent bug in the packet socket implementation in
-     * combination with VLAN interfaces. On a VLAN interface, the value returned
-     * by 'recvfrom' may (but need not) be 4 (bytes) larger than the value
-     * returned on a non-VLAN interface, for the same ethernet frame. */
-    if (nBytes < (int)sizeof(struct ip)) {
-      ////OLSR_PRINTF(
-      //              1,
-      //              "%s: captured frame too short (%d bytes) on \"%s\"\n",
-      //              PLUGIN_NAME,
-      //              nBytes,
-      //              walker->ifName);
-
-      return;                   /* for */
-    }
-
-    if (pktAddr.sll_pkttype == PACKET_OUTGOING ||
-        pktAddr.sll_pkttype == PACKET_MULTICAST || pktAddr.sll_pkttype == PACKET_BROADCAST) {
-      /* A multicast or broadcast packet was captured */
-
-      ////OLSR_PRINTF(
-      //              1,
-      //              "%s: captured frame (%d bytes) on \"%s\"\n",
-      //              PLUGIN_NAME,
-      //              nBytes,
-      //              walker->ifName);
-      //BmfPacketCaptured(walker, pktAddr.sll_pkttype, rxBuffer);
-      BmfPacketCaptured(ipPacket, nBytes);
-
-    }                           /* if (pktAddr.sll_pkttype == ...) */
+    MdnsFrameCaptured(ipPacket, nBytes, pktAddr.sll_pkttype);
   }                             /* if (skfd >= 0 && (FD_ISSET...)) */
 }                               /* DoMDNS */
 
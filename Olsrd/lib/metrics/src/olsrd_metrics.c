@@ -0,0 +1,555 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/*
+ * Dynamic linked library for the olsr.org olsr daemon
+ *
+ * Exposes counters and gauges of the daemon in the Prometheus
+ * text format. Everything is read from counters the core keeps
+ * anyway, the work is done when a client asks.
+ */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "ipcalc.h"
+#include "olsr.h"
+#include "olsr_types.h"
+#include "olsr_cookie.h"
+#include "interfaces.h"
+#include "neighbor_table.h"
+#include "link_set.h"
+#include "tc_set.h"
+#include "routing_table.h"
+#include "process_routes.h"
+#include "olsr_spf.h"
+#include "parser.h"
+#include "scheduler.h"
+#include "trace.h"
+#include "convergence.h"
+#include "net_os.h"
+#include "common/autobuf.h"
+#include "common/list.h"
+
+#include "olsrd_metrics.h"
+#include "olsrd_plugin.h"
+
+#ifdef WIN32
+#define close(x) closesocket(x)
+#endif
+
+/* clients sending no complete request within this time get the metrics anyway (ms) */
+#define METRICS_REQUEST_TIMEOUT 1000
+
+static const char metrics_http_header[] = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n\r\n";
+
+/* A connection, first reading its request and then sending the metrics */
+struct metrics_client {
+  struct list_node node;
+  int fd;
+  struct timer_entry *request_timer;
+  char request[512];
+  size_t request_len;
+  struct autobuf out;
+  int out_offset;
+};
+
+LISTNODE2STRUCT(list2client, struct metrics_client, node);
+
+static struct list_node client_head;
+
+static int metrics_socket = -1;
+
+static void metrics_client_action(int, void *, unsigned int);
+
+static void
+metrics_family(struct autobuf *abuf, const char *name, const char *type, const char *help)
+{
+  abuf_appendf(abuf, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+static void
+metrics_value(struct autobuf *abuf, const char *name, const char *type, const char *help, unsigned long long value)
+{
+  metrics_family(abuf, name, type, help);
+  abuf_appendf(abuf, "%s %llu\n", name, value);
+}
+
+static void
+metrics_print_cookies(struct autobuf *abuf)
+{
+  struct olsr_cookie_info *ci;
+  olsr_cookie_t id;
+
+  metrics_family(abuf, "olsrd_cookie_usage", "gauge", "Objects or timers in use per cookie.");
+  for (id = 0; id < COOKIE_ID_MAX; id++) {
+    if ((ci = olsr_get_cookie(id)) != NULL) {
+      abuf_appendf(abuf, "olsrd_cookie_usage{cookie=\"%s\"} %u\n", ci->ci_name, ci->ci_usage);
+    }
+  }
+
+  metrics_family(abuf, "olsrd_cookie_changes_total", "counter", "Allocations and releases per cookie.");
+  for (id = 0; id < COOKIE_ID_MAX; id++) {
+    if ((ci = olsr_get_cookie(id)) != NULL) {
+      abuf_appendf(abuf, "olsrd_cookie_changes_total{cookie=\"%s\"} %u\n", ci->ci_name, ci->ci_changes);
+    }
+  }
+
+  metrics_family(abuf, "olsrd_cookie_free_list", "gauge", "Recyclable blocks on the free list per memory cookie.");
+  for (id = 0; id < COOKIE_ID_MAX; id++) {
+    if ((ci = olsr_get_cookie(id)) != NULL && ci->ci_type == OLSR_COOKIE_TYPE_MEMORY) {
+      abuf_appendf(abuf, "olsrd_cookie_free_list{cookie=\"%s\"} %u\n", ci->ci_name, ci->ci_free_list_usage);
+    }
+  }
+}
+
+static void
+metrics_print_scheduler(struct autobuf *abuf)
+{
+  const struct olsr_scheduler_stats *s = &olsr_scheduler_stats;
+
+  metrics_value(abuf, "olsrd_timer_walks_total", "counter", "Runs of the timer wheel.", s->timer_walks);
+  metrics_value(abuf, "olsrd_timers_walked_total", "counter", "Timers looked at by all runs of the timer wheel.",
+                s->timers_walked);
+  metrics_value(abuf, "olsrd_timers_fired_total", "counter", "Timers fired by all runs of the timer wheel.", s->timers_fired);
+  metrics_value(abuf, "olsrd_timers_walked_last", "gauge", "Timers looked at by the last run of the timer wheel.",
+                s->last_timers_walked);
+  metrics_value(abuf, "olsrd_timers_fired_last", "gauge", "Timers fired by the last run of the timer wheel.",
+                s->last_timers_fired);
+
+  metrics_family(abuf, "olsrd_scheduler_loop_seconds", "summary", "Time spent per scheduler round, without waiting.");
+  abuf_appendf(abuf, "olsrd_scheduler_loop_seconds_sum %.6f\n", s->loop_usec / 1e6);
+  abuf_appendf(abuf, "olsrd_scheduler_loop_seconds_count %u\n", s->loops);
+  metrics_family(abuf, "olsrd_scheduler_loop_seconds_max", "gauge", "Longest scheduler round.");
+  abuf_appendf(abuf, "olsrd_scheduler_loop_seconds_max %.6f\n", s->loop_usec_max / 1e6);
+}
+
+static void
+metrics_print_trace(struct autobuf *abuf)
+{
+  metrics_value(abuf, "olsrd_trace_events_total", "counter", "Debug events recorded.", olsr_trace_recorded);
+  metrics_value(abuf, "olsrd_trace_dropped_total", "counter", "Debug events lost because the trace ring was full.",
+                olsr_trace_dropped);
+}
+
+static void
+metrics_print_interfaces(struct autobuf *abuf)
+{
+  static const struct {
+    const char *name;
+    const char *help;
+    size_t offset;
+    bool wide;
+  } counters[] = {
+    {"olsrd_interface_rx_packets_total", "OLSR packets received.", offsetof(struct interface, rx_packets), false},
+    {"olsrd_interface_rx_bytes_total", "OLSR bytes received.", offsetof(struct interface, rx_bytes), true},
+    {"olsrd_interface_tx_packets_total", "OLSR packets sent.", offsetof(struct interface, tx_packets), false},
+    {"olsrd_interface_tx_bytes_total", "OLSR bytes sent.", offsetof(struct interface, tx_bytes), true},
+    {"olsrd_interface_tx_errors_total", "OLSR packets which could not be sent.", offsetof(struct interface, tx_errors), false},
+  };
+  const struct interface *ifp;
+  unsigned int i;
+
+  for (i = 0; i < ARRAYSIZE(counters); i++) {
+    metrics_family(abuf, counters[i].name, "counter", counters[i].help);
+    for (ifp = ifnet; ifp != NULL; ifp = ifp->int_next) {
+      const char *field = (const char *)ifp + counters[i].offset;
+      unsigned long long value = counters[i].wide ? *(const uint64_t *)field : *(const uint32_t *)field;
+
+      abuf_appendf(abuf, "%s{interface=\"%s\"} %llu\n", counters[i].name, ifp->int_name, value);
+    }
+  }
+}
+
+static void
+metrics_print_messages(struct autobuf *abuf)
+{
+  static const struct {
+    const char *name;
+    const char *help;
+  } families[] = {
+    {"olsrd_messages_total", "Messages received per type."},
+    {"olsrd_message_bytes_total", "Bytes of received messages per type."},
+    {"olsrd_message_duplicates_total", "Received messages dropped as duplicates per type."},
+    {"olsrd_messages_forwarded_total", "Messages forwarded per type."},
+    {"olsrd_messages_invalid_total", "Received messages dropped as invalid per type."},
+  };
+  unsigned int f;
+  int i;
+
+  for (f = 0; f < ARRAYSIZE(families); f++) {
+    metrics_family(abuf, families[f].name, "counter", families[f].help);
+    for (i = 0; i < 256; i++) {
+      const struct olsr_msgtype_stats *m = &olsr_msgtype_stats[i];
+
+      if (m->messages == 0 && m->dropped_invalid == 0) {
+        continue;
+      }
+      abuf_appendf(abuf, "%s{type=\"%s\"} ", families[f].name, olsr_msgtype_to_string(i));
+      switch (f) {
+      case 0:
+        abuf_appendf(abuf, "%u\n", m->messages);
+        break;
+      case 1:
+        abuf_appendf(abuf, "%llu\n", (unsigned long long)m->bytes);
+        break;
+      case 2:
+        abuf_appendf(abuf, "%u\n", m->duplicates);
+        break;
+      case 3:
+        abuf_appendf(abuf, "%u\n", m->forwarded);
+        break;
+      default:
+        abuf_appendf(abuf, "%u\n", m->dropped_invalid);
+        break;
+      }
+    }
+  }
+
+  metrics_family(abuf, "olsrd_message_handler_wall_seconds", "summary",
+                 "Wall clock time of the parse functions per type, sampled.");
+  for (i = 0; i < 256; i++) {
+    const struct olsr_msgtype_stats *m = &olsr_msgtype_stats[i];
+
+    if (m->messages == 0 && m->dropped_invalid == 0) {
+      continue;
+    }
+    abuf_appendf(abuf, "olsrd_message_handler_wall_seconds_sum{type=\"%s\"} %.6f\n", olsr_msgtype_to_string(i),
+                 m->handler_usec / 1e6);
+    abuf_appendf(abuf, "olsrd_message_handler_wall_seconds_count{type=\"%s\"} %u\n", olsr_msgtype_to_string(i),
+                 m->handler_samples);
+  }
+}
+
+static void
+metrics_print_routing(struct autobuf *abuf)
+{
+  const struct olsr_kernel_route_stats *k = &olsr_kernel_route_stats;
+
+  metrics_value(abuf, "olsrd_spf_runs_total", "counter", "Route calculations.", olsr_spf_stats.runs);
+  metrics_family(abuf, "olsrd_spf_seconds_total", "counter", "Time spent calculating and installing routes.");
+  abuf_appendf(abuf, "olsrd_spf_seconds_total %.6f\n", olsr_spf_stats.usec / 1e6);
+  metrics_family(abuf, "olsrd_spf_last_seconds", "gauge", "Duration of the last route calculation.");
+  abuf_appendf(abuf, "olsrd_spf_last_seconds %.6f\n", olsr_spf_stats.last_usec / 1e6);
+
+  metrics_family(abuf, "olsrd_kernel_route_operations_total", "counter", "Routes added to or deleted from the kernel.");
+  abuf_appendf(abuf, "olsrd_kernel_route_operations_total{op=\"add\"} %u\n", k->adds);
+  abuf_appendf(abuf, "olsrd_kernel_route_operations_total{op=\"delete\"} %u\n", k->deletes);
+  metrics_family(abuf, "olsrd_kernel_route_errors_total", "counter", "Kernel route operations which failed.");
+  abuf_appendf(abuf, "olsrd_kernel_route_errors_total{op=\"add\"} %u\n", k->add_errors);
+  abuf_appendf(abuf, "olsrd_kernel_route_errors_total{op=\"delete\"} %u\n", k->delete_errors);
+}
+
+static void
+metrics_print_convergence(struct autobuf *abuf)
+{
+  const struct olsr_conv_histogram *h;
+  unsigned int stage, i;
+  uint32_t cumulative;
+
+  metrics_value(abuf, "olsrd_convergence_batches_total", "counter",
+                "Topology changes followed from their cause to the kernel routes.", olsr_conv_stats.batches);
+
+  metrics_family(abuf, "olsrd_convergence_seconds", "histogram", "Latency of the convergence stages.");
+  for (stage = 0; stage < OLSR_CONV_STAGE_MAX; stage++) {
+    h = &olsr_conv_stats.stage[stage];
+    cumulative = 0;
+    for (i = 0; i < OLSR_CONV_BUCKETS - 1; i++) {
+      cumulative += h->bucket[i];
+      abuf_appendf(abuf, "olsrd_convergence_seconds_bucket{stage=\"%s\",le=\"%g\"} %u\n", olsr_conv_stage_names[stage],
+                   OLSR_CONV_BUCKET_BOUND(i) / 1e6, cumulative);
+    }
+    abuf_appendf(abuf, "olsrd_convergence_seconds_bucket{stage=\"%s\",le=\"+Inf\"} %u\n", olsr_conv_stage_names[stage],
+                 h->count);
+    abuf_appendf(abuf, "olsrd_convergence_seconds_sum{stage=\"%s\"} %.6f\n", olsr_conv_stage_names[stage], h->usec / 1e6);
+    abuf_appendf(abuf, "olsrd_convergence_seconds_count{stage=\"%s\"} %u\n", olsr_conv_stage_names[stage], h->count);
+  }
+
+  metrics_family(abuf, "olsrd_convergence_seconds_max", "gauge", "Longest latency of the convergence stages.");
+  for (stage = 0; stage < OLSR_CONV_STAGE_MAX; stage++) {
+    abuf_appendf(abuf, "olsrd_convergence_seconds_max{stage=\"%s\"} %.6f\n", olsr_conv_stage_names[stage],
+                 olsr_conv_stats.stage[stage].max_usec / 1e6);
+  }
+}
+
+static void
+metrics_print_tables(struct autobuf *abuf)
+{
+  struct link_entry *link __attribute__ ((unused));
+  struct neighbor_entry *neigh;
+  unsigned int links = 0, neighbors = 0;
+
+  OLSR_FOR_ALL_LINK_ENTRIES(link) {
+    links++;
+  } OLSR_FOR_ALL_LINK_ENTRIES_END(link);
+
+  OLSR_FOR_ALL_NBR_ENTRIES(neigh) {
+    neighbors++;
+  } OLSR_FOR_ALL_NBR_ENTRIES_END(neigh);
+
+  metrics_value(abuf, "olsrd_tc_entries", "gauge", "Entries of the topology database.", tc_tree.count);
+  metrics_value(abuf, "olsrd_routes", "gauge", "Entries of the routing table.", routingtree.count);
+  metrics_value(abuf, "olsrd_links", "gauge", "Entries of the link set.", links);
+  metrics_value(abuf, "olsrd_neighbors", "gauge", "Entries of the neighbor table.", neighbors);
+}
+
+static void
+metrics_client_close(struct metrics_client *client)
+{
+  if (client->request_timer != NULL) {
+    olsr_stop_timer(client->request_timer);
+  }
+  remove_olsr_socket(client->fd, NULL, &metrics_client_action);
+  close(client->fd);
+  abuf_free(&client->out);
+  list_remove(&client->node);
+  free(client);
+}
+
+static void
+metrics_client_write(struct metrics_client *client)
+{
+  while (client->out_offset < client->out.len) {
+    ssize_t result = send(client->fd, client->out.buf + client->out_offset, client->out.len - client->out_offset, 0);
+    if (result < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+        return;
+      }
+      break;
+    }
+    client->out_offset += result;
+  }
+  metrics_client_close(client);
+}
+
+static void
+metrics_client_reply(struct metrics_client *client)
+{
+  if (client->request_timer != NULL) {
+    olsr_stop_timer(client->request_timer);
+    client->request_timer = NULL;
+  }
+
+  abuf_init(&client->out, 8192);
+  abuf_puts(&client->out, metrics_http_header);
+  metrics_print_cookies(&client->out);
+  metrics_print_scheduler(&client->out);
+  metrics_print_trace(&client->out);
+  metrics_print_interfaces(&client->out);
+  metrics_print_messages(&client->out);
+  metrics_print_routing(&client->out);
+  metrics_print_convergence(&client->out);
+  metrics_print_tables(&client->out);
+
+  disable_olsr_socket(client->fd, NULL, &metrics_client_action, SP_IMM_READ);
+  enable_olsr_socket(client->fd, NULL, &metrics_client_action, SP_IMM_WRITE);
+  metrics_client_write(client);
+}
+
+static void
+metrics_request_timeout(void *data)
+{
+  struct metrics_client *client = data;
+
+  /* the scheduler frees the one shot timer */
+  client->request_timer = NULL;
+  metrics_client_reply(client);
+}
+
+static void
+metrics_client_action(int fd, void *data, unsigned int flags)
+{
+  struct metrics_client *client = data;
+  ssize_t len;
+
+  if ((flags & SP_IMM_WRITE) != 0) {
+    metrics_client_write(client);
+    return;
+  }
+
+  len = recv(fd, (void *)&client->request[client->request_len], sizeof(client->request) - 1 - client->request_len, 0);
+  if (len == 0 || (len < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+    metrics_client_close(client);
+    return;
+  }
+  if (len < 0) {
+    return;
+  }
+  client->request_len += len;
+  client->request[client->request_len] = '\0';
+
+  /* the request is not looked at, but read completely before answering */
+  if (strstr(client->request, "\n\n") != NULL || strstr(client->request, "\n\r\n") != NULL
+      || client->request_len == sizeof(client->request) - 1) {
+    metrics_client_reply(client);
+  }
+}
+
+static void
+metrics_accept(int fd, void *data __attribute__ ((unused)), unsigned int flags __attribute__ ((unused)))
+{
+  union olsr_sockaddr pin;
+  socklen_t addrlen = sizeof(pin);
+  struct metrics_client *client;
+  int conn;
+
+  if ((conn = accept(fd, &pin.in, &addrlen)) == -1) {
+    olsr_printf(1, "(METRICS) accept()=%s\n", strerror(errno));
+    return;
+  }
+
+  if (olsr_cnf->ip_version == AF_INET) {
+    if (metrics_accept_ip.v4.s_addr != INADDR_ANY && !ip4equal(&pin.in4.sin_addr, &metrics_accept_ip.v4)) {
+      close(conn);
+      return;
+    }
+  } else {
+    /* Use in6addr_any (::) in olsr.conf to allow anybody. */
+    if (!ip6equal(&in6addr_any, &metrics_accept_ip.v6) && !ip6equal(&pin.in6.sin6_addr, &metrics_accept_ip.v6)) {
+      close(conn);
+      return;
+    }
+  }
+
+  if (olsr_set_nonblocking(conn) == -1) {
+    close(conn);
+    return;
+  }
+
+  client = olsr_malloc(sizeof(*client), "metrics client");
+  client->fd = conn;
+  list_add_before(&client_head, &client->node);
+
+  add_olsr_socket(conn, NULL, &metrics_client_action, client, SP_IMM_READ);
+  client->request_timer = olsr_start_timer(METRICS_REQUEST_TIMEOUT, 0, OLSR_TIMER_ONESHOT,
+                                           &metrics_request_timeout, client, NULL);
+}
+
+static int
+metrics_socket_init(void)
+{
+  union olsr_sockaddr sst;
+  uint32_t yes = 1;
+  socklen_t addrlen;
+
+  if ((metrics_socket = socket(olsr_cnf->ip_version, SOCK_STREAM, 0)) == -1) {
+    olsr_printf(1, "(METRICS) socket()=%s\n", strerror(errno));
+    return 0;
+  }
+  if (setsockopt(metrics_socket, SOL_SOCKET, SO_REUSEADDR, (char *)&yes, sizeof(yes)) < 0) {
+    olsr_printf(1, "(METRICS) setsockopt()=%s\n", strerror(errno));
+    return 0;
+  }
+
+  memset(&sst, 0, sizeof(sst));
+  if (olsr_cnf->ip_version == AF_INET) {
+    sst.in4.sin_family = AF_INET;
+    addrlen = sizeof(struct sockaddr_in);
+#ifdef SIN6_LEN
+    sst.in4.sin_len = addrlen;
+#endif
+    sst.in4.sin_addr.s_addr = metrics_listen_ip.v4.s_addr;
+    sst.in4.sin_port = htons(metrics_port);
+  } else {
+    sst.in6.sin6_family = AF_INET6;
+    addrlen = sizeof(struct sockaddr_in6);
+#ifdef SIN6_LEN
+    sst.in6.sin6_len = addrlen;
+#endif
+    sst.in6.sin6_addr = metrics_listen_ip.v6;
+    sst.in6.sin6_port = htons(metrics_port);
+  }
+
+  if (bind(metrics_socket, &sst.in, addrlen) == -1) {
+    olsr_printf(1, "(METRICS) bind()=%s\n", strerror(errno));
+    return 0;
+  }
+  if (listen(metrics_socket, SOMAXCONN) == -1) {
+    olsr_printf(1, "(METRICS) listen()=%s\n", strerror(errno));
+    return 0;
+  }
+
+  add_olsr_socket(metrics_socket, &metrics_accept, NULL, NULL, SP_PR_READ);
+  olsr_printf(2, "(METRICS) listening on port %d\n", metrics_port);
+  return 1;
+}
+
+/**
+ *Do initialization here
+ *
+ *This function is called by the my_init
+ *function in uolsrd_plugin.c
+ */
+int
+olsrd_plugin_init(void)
+{
+  list_head_init(&client_head);
+  metrics_socket_init();
+  return 1;
+}
+
+/**
+ * destructor - called at unload
+ */
+void
+olsr_plugin_exit(void)
+{
+  if (metrics_socket != -1) {
+    close(metrics_socket);
+  }
+  while (!list_is_empty(&client_head)) {
+    metrics_client_close(list2client(client_head.next));
+  }
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,678 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/*
+ * Dynamic linked library for UniK OLSRd
+ *
+ * A small DNS responder answering A/AAAA and PTR queries straight from
+ * the hashes of the name database, so no hosts file and no external DNS server have
+ * to be reloaded when a name changes. Queries for names not in the
+ * database are relayed to an upstream resolver.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "olsr.h"
+#include "ipcalc.h"
+#include "scheduler.h"
+#include "mid_set.h"
+#include "common/list.h"
+
+#include "nameservice.h"
+#include "dnsserver.h"
+
+#define DNS_MAX_UDP             512
+#define DNS_MAX_PACKET          4096
+#define DNS_HEADER_SIZE         12
+#define DNS_MAX_PENDING         256
+#define DNS_FORWARD_TIMEOUT     5000    /* ms */
+#define DNS_UPSTREAM_PORT       53
+#define DNS_MAX_BURST           32      /* datagrams read per socket event */
+
+#define DNS_FLAG_QR             0x8000
+#define DNS_FLAG_OPCODE         0x7800
+#define DNS_FLAG_AA             0x0400
+#define DNS_FLAG_TC             0x0200
+#define DNS_FLAG_RD             0x0100
+#define DNS_FLAG_RA             0x0080
+
+#define DNS_RCODE_NOERROR       0
+#define DNS_RCODE_FORMERR       1
+#define DNS_RCODE_SERVFAIL      2
+#define DNS_RCODE_NXDOMAIN      3
+#define DNS_RCODE_NOTIMP        4
+#define DNS_RCODE_REFUSED       5
+
+#define DNS_TYPE_A              1
+#define DNS_TYPE_PTR            12
+#define DNS_TYPE_AAAA           28
+#define DNS_TYPE_ANY            255
+#define DNS_CLASS_IN            1
+
+/* configuration */
+int dns_port = 0;
+union olsr_ip_addr dns_listen_ip;
+union olsr_ip_addr dns_upstream_ip;
+int dns_ttl = 60;
+
+/* a query relayed to the upstream resolver */
+struct dns_pending {
+  bool used;
+  uint16_t id;
+  uint16_t client_id;
+  uint32_t valid_until;
+  int sock;                             /* upstream socket the query went out on */
+  union olsr_sockaddr client;
+  socklen_t client_len;
+};
+
+static struct dns_pending pending[DNS_MAX_PENDING];
+
+static const char *dns_suffix = "";
+static int dns_socket = -1;
+static int upstream_socket = -1;
+
+/* the upstream socket (and so its source port) is replaced every
+ * DNS_FORWARD_TIMEOUT, the previous one is kept for late answers */
+static int upstream_old = -1;
+static uint32_t upstream_rotate;
+
+static int dns_socket_open(const union olsr_ip_addr *ip, int port, bool do_connect);
+
+static void dns_upstream_action(int fd, void *data, unsigned int flags);
+
+static void
+dns_make_fqdn(char *dst, size_t size, const char *name, const char *suffix)
+{
+  char *p;
+
+  snprintf(dst, size, "%s%s", name, suffix);
+  for (p = dst; *p; p++) {
+    *p = tolower((unsigned char)*p);
+  }
+}
+
+/**
+ * Read the question name at pos into name (dotted, lower case,
+ * without the trailing dot). Returns the position behind it or -1.
+ */
+static int
+dns_read_qname(const uint8_t *pkt, int len, int pos, char *name, size_t size)
+{
+  size_t used = 0;
+
+  while (pos < len) {
+    int label = pkt[pos++];
+
+    if (label == 0) {
+      name[used] = '\0';
+      return pos;
+    }
+    /* compression is not used in questions */
+    if ((label & 0xc0) != 0 || pos + label > len || used + label + 2 > size) {
+      return -1;
+    }
+    if (used > 0) {
+      name[used++] = '.';
+    }
+    while (label--) {
+      name[used++] = tolower(pkt[pos++]);
+    }
+  }
+  return -1;
+}
+
+/**
+ * Write name in label form to buf. Returns the length or -1.
+ */
+static int
+dns_write_name(uint8_t *buf, int size, const char *name)
+{
+  int pos = 0;
+
+  while (*name) {
+    const char *dot = strchr(name, '.');
+    int label = dot != NULL ? dot - name : (int)strlen(name);
+
+    if (label == 0 || label > 63 || pos + label + 2 > size) {
+      return -1;
+    }
+    buf[pos++] = label;
+    memcpy(&buf[pos], name, label);
+    pos += label;
+    name += label;
+    if (*name == '.') {
+      name++;
+    }
+  }
+  if (pos + 1 > size) {
+    return -1;
+  }
+  buf[pos++] = 0;
+  return pos;
+}
+
+/**
+ * Convert the name of a reverse lookup into an address.
+ */
+static bool
+dns_reverse_to_ip(const char *name, union olsr_ip_addr *ip)
+{
+  memset(ip, 0, sizeof(*ip));
+
+  if (olsr_cnf->ip_version == AF_INET) {
+    unsigned int a, b, c, d;
+    int n = 0;
+
+    if (sscanf(name, "%u.%u.%u.%u.in-addr.arpa%n", &d, &c, &b, &a, &n) != 4 || name[n] != '\0' || a > 255 || b > 255
+        || c > 255 || d > 255) {
+      return false;
+    }
+    ip->v4.s_addr = htonl(a << 24 | b << 16 | c << 8 | d);
+    return true;
+  } else {
+    int i;
+
+    if (strlen(name) != 72 || strcmp(name + 64, "ip6.arpa") != 0) {
+      return false;
+    }
+    for (i = 0; i < 32; i++) {
+      int nibble;
+
+      if (!isxdigit((unsigned char)name[2 * i]) || name[2 * i + 1] != '.') {
+        return false;
+      }
+      nibble = isdigit((unsigned char)name[2 * i]) ? name[2 * i] - '0' : name[2 * i] - 'a' + 10;
+      ip->v6.s6_addr[15 - i / 2] |= (i & 1) ? nibble << 4 : nibble;
+    }
+    return true;
+  }
+}
+
+/**
+ * Append a resource record referring to the question name.
+ * Returns the new length or -1 if it does not fit.
+ */
+static int
+dns_put_answer(uint8_t *out, int pos, uint16_t type, const void *rdata, uint16_t rdlen)
+{
+  uint16_t u16;
+  uint32_t u32;
+
+  if (pos + 12 + rdlen > DNS_MAX_UDP) {
+    return -1;
+  }
+  u16 = htons(0xc000 | DNS_HEADER_SIZE);
+  memcpy(&out[pos], &u16, 2);
+  u16 = htons(type);
+  memcpy(&out[pos + 2], &u16, 2);
+  u16 = htons(DNS_CLASS_IN);
+  memcpy(&out[pos + 4], &u16, 2);
+  u32 = htonl(dns_ttl);
+  memcpy(&out[pos + 6], &u32, 4);
+  u16 = htons(rdlen);
+  memcpy(&out[pos + 10], &u16, 2);
+  memcpy(&out[pos + 12], rdata, rdlen);
+  return pos + 12 + rdlen;
+}
+
+/**
+ * Answer a query from the database. Returns the length of the
+ * answer, or 0 if the name is not known here.
+ */
+static int
+dns_answer(uint8_t *out, int qend, const char *qname, uint16_t qtype, uint16_t *flags, uint16_t *ancount)
+{
+  union olsr_ip_addr ip;
+  struct list_node *head, *node;
+  bool known = false;
+  int pos = qend;
+
+  if (qtype == DNS_TYPE_PTR) {
+    union olsr_ip_addr *main_addr;
+
+    if (!dns_reverse_to_ip(qname, &ip)) {
+      return 0;
+    }
+    /* names of the interface addresses of a node are those of its main address */
+    head = &host_ip_hash[namesvc_ip_hash(&ip)];
+    for (node = head->next; node != head && !known; node = node->next) {
+      known = ipequal(&ip_node2name(node)->ip, &ip);
+    }
+    if (!known && (main_addr = mid_lookup_main_addr(&ip)) != NULL) {
+      ip = *main_addr;
+      head = &host_ip_hash[namesvc_ip_hash(&ip)];
+    }
+
+    for (node = head->next; node != head; node = node->next) {
+      struct name_entry *name = ip_node2name(node);
+      char fqdn[MAX_NAME + MAX_SUFFIX + 1];
+      uint8_t rdata[MAX_NAME + MAX_SUFFIX + 2];
+      int rdlen, next;
+
+      if (!ipequal(&name->ip, &ip)) {
+        continue;
+      }
+      known = true;
+      dns_make_fqdn(fqdn, sizeof(fqdn), name->name, dns_suffix);
+      if ((rdlen = dns_write_name(rdata, sizeof(rdata), fqdn)) < 0) {
+        continue;
+      }
+      if ((next = dns_put_answer(out, pos, DNS_TYPE_PTR, rdata, rdlen)) < 0) {
+        *flags |= DNS_FLAG_TC;
+        break;
+      }
+      pos = next;
+      (*ancount)++;
+    }
+  } else {
+    uint16_t addrtype = olsr_cnf->ip_version == AF_INET ? DNS_TYPE_A : DNS_TYPE_AAAA;
+    size_t qlen = strlen(qname), slen = strlen(dns_suffix);
+    char base[MAX_NAME + 1];
+
+    /* the names are stored without the suffix */
+    if (qlen <= slen || qlen - slen > MAX_NAME || strcasecmp(qname + qlen - slen, dns_suffix) != 0) {
+      return 0;
+    }
+    memcpy(base, qname, qlen - slen);
+    base[qlen - slen] = '\0';
+
+    head = &host_name_hash[namesvc_name_hash(base)];
+    for (node = head->next; node != head; node = node->next) {
+      struct name_entry *name = name_node2name(node);
+      int next;
+
+      if (strcasecmp(name->name, base) != 0) {
+        continue;
+      }
+      known = true;
+      /* a known name without an address of the asked type gets an empty answer */
+      if (qtype != addrtype && qtype != DNS_TYPE_ANY) {
+        continue;
+      }
+      if ((next = dns_put_answer(out, pos, addrtype, &name->ip, olsr_cnf->ipsize)) < 0) {
+        *flags |= DNS_FLAG_TC;
+        break;
+      }
+      pos = next;
+      (*ancount)++;
+    }
+  }
+  return known ? pos : 0;
+}
+
+static bool
+dns_in_suffix(const char *qname)
+{
+  size_t slen = strlen(dns_suffix), qlen = strlen(qname);
+  const char *suffix = dns_suffix;
+
+  if (*suffix == '.') {
+    suffix++;
+    slen--;
+  }
+  if (slen == 0 || qlen < slen || strcasecmp(qname + qlen - slen, suffix) != 0) {
+    return false;
+  }
+  return qlen == slen || qname[qlen - slen - 1] == '.';
+}
+
+/* the query waiting for the answer with this id, if any */
+static struct dns_pending *
+dns_pending_find(uint16_t id, int sock)
+{
+  int i;
+
+  for (i = 0; i < DNS_MAX_PENDING; i++) {
+    if (pending[i].used && pending[i].id == id && (sock == -1 || pending[i].sock == sock)
+        && !TIMED_OUT(pending[i].valid_until)) {
+      return &pending[i];
+    }
+  }
+  return NULL;
+}
+
+static struct dns_pending *
+dns_pending_alloc(void)
+{
+  int i;
+
+  for (i = 0; i < DNS_MAX_PENDING; i++) {
+    if (!pending[i].used || TIMED_OUT(pending[i].valid_until)) {
+      return &pending[i];
+    }
+  }
+  return NULL;
+}
+
+static void
+dns_upstream_rotate(void)
+{
+  int sock;
+
+  if (!TIMED_OUT(upstream_rotate)) {
+    return;
+  }
+  if ((sock = dns_socket_open(&dns_upstream_ip, DNS_UPSTREAM_PORT, true)) == -1) {
+    /* keep using the current one */
+    return;
+  }
+  /* all queries sent on the old socket have timed out by now */
+  if (upstream_old != -1) {
+    remove_olsr_socket(upstream_old, NULL, &dns_upstream_action);
+    close(upstream_old);
+  }
+  upstream_old = upstream_socket;
+  upstream_socket = sock;
+  add_olsr_socket(upstream_socket, NULL, &dns_upstream_action, NULL, SP_IMM_READ);
+  upstream_rotate = GET_TIMESTAMP(DNS_FORWARD_TIMEOUT);
+}
+
+static void
+dns_forward(const uint8_t *query, int len, const union olsr_sockaddr *from, socklen_t fromlen)
+{
+  struct dns_pending *p;
+  uint8_t buf[DNS_MAX_PACKET];
+  uint16_t id;
+
+  if ((p = dns_pending_alloc()) == NULL) {
+    OLSR_PRINTF(2, "NAME PLUGIN: too many dns queries waiting for upstream\n");
+    return;
+  }
+  dns_upstream_rotate();
+
+  memcpy(buf, query, len);
+  memcpy(&p->client_id, query, 2);
+  p->client = *from;
+  p->client_len = fromlen;
+  p->valid_until = GET_TIMESTAMP(DNS_FORWARD_TIMEOUT);
+
+  /* a random id makes spoofed answers less likely, it must not be in use */
+  do {
+    id = random() & 0xffff;
+  } while (dns_pending_find(id, -1) != NULL);
+  p->id = id;
+  p->sock = upstream_socket;
+  p->used = true;
+  id = htons(id);
+  memcpy(buf, &id, 2);
+
+  if (send(upstream_socket, buf, len, 0) < 0) {
+    OLSR_PRINTF(2, "NAME PLUGIN: dns upstream send failed: %s\n", strerror(errno));
+    p->used = false;
+  }
+}
+
+static void
+dns_relay_answer(int fd, uint8_t *buf, ssize_t len)
+{
+  struct dns_pending *p;
+  uint16_t id;
+
+  if (len < DNS_HEADER_SIZE) {
+    return;
+  }
+  memcpy(&id, buf, 2);
+  if ((p = dns_pending_find(ntohs(id), fd)) == NULL) {
+    return;
+  }
+  p->used = false;
+
+  memcpy(buf, &p->client_id, 2);
+  sendto(dns_socket, buf, len, 0, &p->client.in, p->client_len);
+}
+
+/* read until the socket is empty, with a limit per event like olsr_input() */
+static void
+dns_upstream_action(int fd, void *data __attribute__ ((unused)), unsigned int flags __attribute__ ((unused)))
+{
+  uint8_t buf[DNS_MAX_PACKET];
+  ssize_t len;
+  int i;
+
+  for (i = 0; i < DNS_MAX_BURST; i++) {
+    if ((len = recv(fd, buf, sizeof(buf), 0)) < 0) {
+      break;
+    }
+    dns_relay_answer(fd, buf, len);
+  }
+}
+
+static void
+dns_answer_query(int fd, const uint8_t *query, int len, const union olsr_sockaddr *from, socklen_t fromlen)
+{
+  uint8_t out[DNS_MAX_UDP];
+  char qname[256];
+  uint16_t qflags, rflags, qdcount, qtype, qclass, ancount = 0, u16;
+  int qend, pos = DNS_HEADER_SIZE;
+
+  if (len < DNS_HEADER_SIZE) {
+    return;
+  }
+
+  memcpy(&qflags, &query[2], 2);
+  qflags = ntohs(qflags);
+  memcpy(&qdcount, &query[4], 2);
+  qdcount = ntohs(qdcount);
+
+  /* never answer answers */
+  if ((qflags & DNS_FLAG_QR) != 0) {
+    return;
+  }
+
+  rflags = DNS_FLAG_QR | (qflags & (DNS_FLAG_OPCODE | DNS_FLAG_RD));
+  if (!ipequal(&dns_upstream_ip, &olsr_ip_zero)) {
+    rflags |= DNS_FLAG_RA;
+  }
+
+  qend = DNS_HEADER_SIZE;
+  if ((qflags & DNS_FLAG_OPCODE) != 0) {
+    rflags |= DNS_RCODE_NOTIMP;
+    qdcount = 0;
+  } else if (qdcount != 1 || (qend = dns_read_qname(query, len, DNS_HEADER_SIZE, qname, sizeof(qname))) < 0
+             || qend + 4 > len || qend + 4 > DNS_MAX_UDP) {
+    rflags |= DNS_RCODE_FORMERR;
+    qdcount = 0;
+    qend = DNS_HEADER_SIZE;
+  } else {
+    memcpy(&qtype, &query[qend], 2);
+    qtype = ntohs(qtype);
+    memcpy(&qclass, &query[qend + 2], 2);
+    qclass = ntohs(qclass);
+    qend += 4;
+    memcpy(out, query, qend);
+
+    if (qclass == DNS_CLASS_IN && (pos = dns_answer(out, qend, qname, qtype, &rflags, &ancount)) > 0) {
+      rflags |= DNS_FLAG_AA | DNS_RCODE_NOERROR;
+    } else if (dns_in_suffix(qname)) {
+      rflags |= DNS_FLAG_AA | DNS_RCODE_NXDOMAIN;
+    } else if ((rflags & DNS_FLAG_RA) != 0) {
+      dns_forward(query, len, from, fromlen);
+      return;
+    } else if (qtype == DNS_TYPE_PTR) {
+      rflags |= DNS_RCODE_NXDOMAIN;
+    } else {
+      rflags |= DNS_RCODE_REFUSED;
+    }
+  }
+
+  memcpy(out, query, 2);
+  if (qend == DNS_HEADER_SIZE) {
+    pos = DNS_HEADER_SIZE;
+  } else if (ancount == 0) {
+    pos = qend;
+  }
+  u16 = htons(rflags);
+  memcpy(&out[2], &u16, 2);
+  u16 = htons(qdcount);
+  memcpy(&out[4], &u16, 2);
+  u16 = htons(ancount);
+  memcpy(&out[6], &u16, 2);
+  memset(&out[8], 0, 4);
+
+  sendto(fd, out, pos, 0, &from->in, fromlen);
+}
+
+static void
+dns_query_action(int fd, void *data __attribute__ ((unused)), unsigned int flags __attribute__ ((unused)))
+{
+  uint8_t query[DNS_MAX_PACKET];
+  union olsr_sockaddr from;
+  socklen_t fromlen;
+  int len, i;
+
+  for (i = 0; i < DNS_MAX_BURST; i++) {
+    fromlen = sizeof(from);
+    if ((len = recvfrom(fd, query, sizeof(query), 0, &from.in, &fromlen)) < 0) {
+      break;
+    }
+    dns_answer_query(fd, query, len, &from, fromlen);
+  }
+}
+
+static int
+dns_socket_open(const union olsr_ip_addr *ip, int port, bool do_connect)
+{
+  union olsr_sockaddr sst;
+  socklen_t addrlen;
+  uint32_t yes = 1;
+  int sock;
+
+  memset(&sst, 0, sizeof(sst));
+  if (olsr_cnf->ip_version == AF_INET) {
+    sst.in4.sin_family = AF_INET;
+    sst.in4.sin_addr = ip->v4;
+    sst.in4.sin_port = htons(port);
+    addrlen = sizeof(struct sockaddr_in);
+  } else {
+    sst.in6.sin6_family = AF_INET6;
+    sst.in6.sin6_addr = ip->v6;
+    sst.in6.sin6_port = htons(port);
+    addrlen = sizeof(struct sockaddr_in6);
+  }
+
+  if ((sock = socket(olsr_cnf->ip_version, SOCK_DGRAM, 0)) == -1) {
+    OLSR_PRINTF(0, "NAME PLUGIN: dns socket()=%s\n", strerror(errno));
+    return -1;
+  }
+  if (do_connect) {
+    if (connect(sock, &sst.in, addrlen) == -1) {
+      OLSR_PRINTF(0, "NAME PLUGIN: dns upstream connect()=%s\n", strerror(errno));
+      close(sock);
+      return -1;
+    }
+  } else {
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (char *)&yes, sizeof(yes));
+    if (bind(sock, &sst.in, addrlen) == -1) {
+      OLSR_PRINTF(0, "NAME PLUGIN: dns bind() on port %d=%s\n", port, strerror(errno));
+      close(sock);
+      return -1;
+    }
+  }
+  fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+  return sock;
+}
+
+/**
+ * Open the DNS sockets if a "dns-port" is configured.
+ */
+void
+dnsserver_init(const char *suffix)
+{
+  if (dns_port == 0) {
+    return;
+  }
+  dns_suffix = suffix;
+
+  if ((dns_socket = dns_socket_open(&dns_listen_ip, dns_port, false)) == -1) {
+    return;
+  }
+  add_olsr_socket(dns_socket, NULL, &dns_query_action, NULL, SP_IMM_READ);
+
+  if (!ipequal(&dns_upstream_ip, &olsr_ip_zero)) {
+    if ((upstream_socket = dns_socket_open(&dns_upstream_ip, DNS_UPSTREAM_PORT, true)) != -1) {
+      add_olsr_socket(upstream_socket, NULL, &dns_upstream_action, NULL, SP_IMM_READ);
+      upstream_rotate = GET_TIMESTAMP(DNS_FORWARD_TIMEOUT);
+    } else {
+      memset(&dns_upstream_ip, 0, sizeof(dns_upstream_ip));
+    }
+  }
+  OLSR_PRINTF(1, "NAME PLUGIN: answering DNS queries on port %d\n", dns_port);
+}
+
+void
+dnsserver_exit(void)
+{
+  if (dns_socket == -1) {
+    return;
+  }
+
+  if (upstream_socket != -1) {
+    remove_olsr_socket(upstream_socket, NULL, &dns_upstream_action);
+    close(upstream_socket);
+    upstream_socket = -1;
+  }
+  if (upstream_old != -1) {
+    remove_olsr_socket(upstream_old, NULL, &dns_upstream_action);
+    close(upstream_old);
+    upstream_old = -1;
+  }
+  remove_olsr_socket(dns_socket, NULL, &dns_query_action);
+  close(dns_socket);
+  dns_socket = -1;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
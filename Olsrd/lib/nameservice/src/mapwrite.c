@@ -55,24 +55,15 @@ static char my_latlon_str[48];
 static char *
 lookup_position_latlon(union olsr_ip_addr *ip)
 {
-  int hash;
   struct db_entry *entry;
-  struct list_node *list_head, *list_node;
 
   if (ipequal(ip, &olsr_cnf->main_addr)) {
     return my_latlon_str;
   }
 
-  for (hash = 0; hash < HASHSIZE; hash++) {
-    list_head = &latlon_list[hash];
-    for (list_node = list_head->next; list_node != list_head; list_node = list_node->next) {
-
-      entry = list2db(list_node);
-
-      if (entry->names && ipequal(&entry->originator, ip)) {
-        return entry->names->name;
-      }
-    }
+  entry = lookup_db_entry(latlon_list, ip);
+  if (entry != NULL && entry->names) {
+    return entry->names->name;
   }
   return NULL;
 }
@@ -135,7 +126,7 @@ mapwrite_work(FILE * fmap)
               olsr_ip_to_string(&strbuf2, &ip), my_names->name)) {
     return;
   }
-  for (hash = 0; hash < HASHSIZE; hash++) {
+  for (hash = 0; hash < NAMESVC_HASHSIZE; hash++) {
     struct db_entry *entry;
     struct list_node *list_head, *list_node;
 
@@ -56,6 +56,7 @@
 #include "mantissa.h"
 #include "scheduler.h"
 #include "parser.h"
+#include "common/autobuf.h"
 #include "duplicate_set.h"
 #include "tc_set.h"
 #include "hna_set.h"
@@ -65,6 +66,7 @@
 #include "plugin_util.h"
 #include "nameservice.h"
 #include "mapwrite.h"
+#include "dnsserver.h"
 #include "compat.h"
 
 /* true if plugin has been configured */
@@ -86,6 +88,8 @@ static char my_services_change_script[MAX_FILE + 1];
 static char my_macs_change_script[MAX_FILE + 1];
 static char latlon_in_file[MAX_FILE + 1];
 static char my_latlon_file[MAX_FILE + 1];
+static int my_write_delay = 5000;
+static int my_write_max_delay = 30000;
 float my_lat = 0.0, my_lon = 0.0;
 
 /* the databases (using hashing)
@@ -93,29 +97,39 @@ float my_lat = 0.0, my_lon = 0.0;
  *
  * my own hostnames, service_lines and dns-servers
  * are store in a linked list (without hashing)
+ *
+ * all host names, my own included, are also hashed
+ * by name and by ip for lookups
  * */
-static struct list_node name_list[HASHSIZE];
+struct list_node host_name_hash[NAMESVC_HASHSIZE];
+struct list_node host_ip_hash[NAMESVC_HASHSIZE];
+
+static struct list_node name_list[NAMESVC_HASHSIZE];
 struct name_entry *my_names = NULL;
 struct timer_entry *name_table_write = NULL;
 static bool name_table_changed = true;
 
-static struct list_node service_list[HASHSIZE];
+static struct list_node service_list[NAMESVC_HASHSIZE];
 static struct name_entry *my_services = NULL;
 static bool service_table_changed = true;
 
-static struct list_node mac_list[HASHSIZE];
+static struct list_node mac_list[NAMESVC_HASHSIZE];
 static struct name_entry *my_macs = NULL;
 static bool mac_table_changed = true;
 
-static struct list_node forwarder_list[HASHSIZE];
+static struct list_node forwarder_list[NAMESVC_HASHSIZE];
 static struct name_entry *my_forwarders = NULL;
 static bool forwarder_table_changed = true;
 
-struct list_node latlon_list[HASHSIZE];
+struct list_node latlon_list[NAMESVC_HASHSIZE];
 static bool latlon_table_changed = true;
 
 /* backoff timer for writing changes into a file */
 struct timer_entry *write_file_timer = NULL;
+static uint32_t write_file_deadline;
+
+/* hashes of what was last written into the files */
+static uint64_t hosts_file_hash, services_file_hash, macs_file_hash, resolv_file_hash;
 
 /* periodic message generation */
 struct timer_entry *msg_gen_timer = NULL;
@@ -181,12 +195,14 @@ name_constructor(void)
   my_macs_change_script[0] = '\0';
 
   /* init the lists heads */
-  for (i = 0; i < HASHSIZE; i++) {
+  for (i = 0; i < NAMESVC_HASHSIZE; i++) {
     list_head_init(&name_list[i]);
     list_head_init(&forwarder_list[i]);
     list_head_init(&service_list[i]);
     list_head_init(&mac_list[i]);
     list_head_init(&latlon_list[i]);
+    list_head_init(&host_name_hash[i]);
+    list_head_init(&host_ip_hash[i]);
   }
 
 }
@@ -269,11 +285,17 @@ static const struct olsrd_plugin_parameters plugin_parameters[] = {
   { .name = "lat",                    .set_plugin_parameter = &set_nameservice_float,  .data = &my_lat },
   { .name = "lon",                    .set_plugin_parameter = &set_nameservice_float,  .data = &my_lon },
   { .name = "latlon-file",            .set_plugin_parameter = &set_plugin_string,      .data = &my_latlon_file,            .addon = {sizeof(my_latlon_file)} },
+  { .name = "write-delay",            .set_plugin_parameter = &set_plugin_int,         .data = &my_write_delay },
+  { .name = "write-max-delay",        .set_plugin_parameter = &set_plugin_int,         .data = &my_write_max_delay },
   { .name = "latlon-infile",          .set_plugin_parameter = &set_plugin_string,      .data = &latlon_in_file,            .addon = {sizeof(latlon_in_file)} },
   { .name = "dns-server",             .set_plugin_parameter = &set_nameservice_server, .data = &my_forwarders,             .addon = {NAME_FORWARDER} },
   { .name = "name",                   .set_plugin_parameter = &set_nameservice_name,   .data = &my_names,                  .addon = {NAME_HOST} },
   { .name = "service",                .set_plugin_parameter = &set_nameservice_name,   .data = &my_services,               .addon = {NAME_SERVICE} },
   { .name = "mac",                    .set_plugin_parameter = &set_nameservice_name,   .data = &my_macs,                   .addon = {NAME_MACADDR} },
+  { .name = "dns-port",               .set_plugin_parameter = &set_plugin_port,        .data = &dns_port },
+  { .name = "dns-listen",             .set_plugin_parameter = &set_plugin_ipaddress,   .data = &dns_listen_ip },
+  { .name = "dns-upstream",           .set_plugin_parameter = &set_plugin_ipaddress,   .data = &dns_upstream_ip },
+  { .name = "dns-ttl",                .set_plugin_parameter = &set_plugin_int,         .data = &dns_ttl },
   { .name = "",                       .set_plugin_parameter = &set_nameservice_host,   .data = &my_names },
 };
 /* *INDENT-OFF* */
@@ -285,6 +307,69 @@ olsrd_get_plugin_parameters(const struct olsrd_plugin_parameters **params, int *
   *size = sizeof(plugin_parameters) / sizeof(*plugin_parameters);
 }
 
+/**
+ * FNV-1a over a byte string
+ */
+static uint32_t
+namesvc_hash(const void *data, size_t len, bool nocase)
+{
+  const unsigned char *p = data;
+  uint32_t hash = 2166136261u;
+
+  while (len--) {
+    hash ^= nocase ? tolower(*p++) : *p++;
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+/**
+ * bucket of a host name, names are case insensitive
+ */
+uint32_t
+namesvc_name_hash(const char *name)
+{
+  return namesvc_hash(name, strlen(name), true) & (NAMESVC_HASHSIZE - 1);
+}
+
+/**
+ * bucket of an ip address
+ */
+uint32_t
+namesvc_ip_hash(const union olsr_ip_addr *ip)
+{
+  return namesvc_hash(ip, olsr_cnf->ipsize, false) & (NAMESVC_HASHSIZE - 1);
+}
+
+/**
+ * find the db_entry of an originator
+ */
+struct db_entry *
+lookup_db_entry(struct list_node *this_list, const union olsr_ip_addr *originator)
+{
+  struct list_node *list_head, *list_node;
+
+  list_head = &this_list[namesvc_ip_hash(originator)];
+  for (list_node = list_head->next; list_node != list_head; list_node = list_node->next) {
+    struct db_entry *entry = list2db(list_node);
+
+    if (ipequal(originator, &entry->originator)) {
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * add a host name to the name and ip hashes
+ */
+static void
+hash_host_name(struct name_entry *name)
+{
+  list_add_before(&host_name_hash[namesvc_name_hash(name->name)], &name->name_node);
+  list_add_before(&host_ip_hash[namesvc_ip_hash(&name->ip)], &name->ip_node);
+}
+
 /**
  * queue the name/forwarder/service given in value
  * to the front of my_list
@@ -302,6 +387,8 @@ add_name_to_list(struct name_entry *my_list, const char *value, int type, const
     memset(&tmp->ip, 0, sizeof(tmp->ip));
   else
     tmp->ip = *ip;
+  list_node_init(&tmp->name_node);
+  list_node_init(&tmp->ip_node);
   tmp->next = my_list;
   return tmp;
 }
@@ -328,6 +415,9 @@ name_init(void)
   /* periodic message generation */
   msg_gen_timer = olsr_start_timer(my_interval * MSEC_PER_SEC, EMISSION_JITTER, OLSR_TIMER_PERIODIC, &olsr_namesvc_gen, NULL, 0);
 
+  /* answer DNS queries from the name database */
+  dnsserver_init(my_suffix);
+
   return 1;
 }
 
@@ -418,6 +508,10 @@ static void name_lazy_init(void) {
   my_services = remove_nonvalid_names_from_list(my_services, NAME_SERVICE);
   my_macs = remove_nonvalid_names_from_list(my_macs, NAME_MACADDR);
 
+  for (name = my_names; name != NULL; name = name->next) {
+    hash_host_name(name);
+  }
+
   mapwrite_init(my_latlon_file);
 
   return;
@@ -489,6 +583,8 @@ name_destructor(void)
   free_all_list_entries(forwarder_list);
   free_all_list_entries(latlon_list);
 
+  dnsserver_exit();
+
   olsr_stop_timer(write_file_timer);
   olsr_stop_timer(msg_gen_timer);
 
@@ -506,7 +602,7 @@ free_all_list_entries(struct list_node *this_db_list)
 
   int i;
 
-  for (i = 0; i < HASHSIZE; i++) {
+  for (i = 0; i < NAMESVC_HASHSIZE; i++) {
 
     list_head = &this_db_list[i];
 
@@ -540,16 +636,23 @@ olsr_expire_write_file_timer(void *context __attribute__ ((unused)))
 
 /*
  * Kick a timer to write everything into a file.
- * This also paces things a bit.
+ * Every change postpones the write by write-delay, so a burst of
+ * changes is written once, but never later than write-max-delay
+ * after the first of them.
  */
 static void
 olsr_start_write_file_timer(void)
 {
-  if (write_file_timer) {
+  int32_t due;
+
+  if (!write_file_timer) {
+    write_file_deadline = GET_TIMESTAMP(my_write_max_delay);
+    write_file_timer = olsr_start_timer(my_write_delay, 5, OLSR_TIMER_ONESHOT, olsr_expire_write_file_timer, NULL, 0);
     return;
   }
 
-  write_file_timer = olsr_start_timer(5 * MSEC_PER_SEC, 5, OLSR_TIMER_ONESHOT, olsr_expire_write_file_timer, NULL, 0);
+  due = TIME_DUE(write_file_deadline);
+  olsr_change_timer(write_file_timer, due < my_write_delay ? (due > 0 ? due : 0) : my_write_delay, 5, OLSR_TIMER_ONESHOT);
 }
 
 /*
@@ -866,6 +969,8 @@ decap_namemsg(struct name *from_packet, struct name_entry **to, bool * this_tabl
   tmp->name = olsr_malloc(tmp->len + 1, "new name_entry name");
   tmp->ip = from_packet->ip;
   strscpy(tmp->name, name, tmp->len + 1);
+  list_node_init(&tmp->name_node);
+  list_node_init(&tmp->ip_node);
 
   OLSR_PRINTF(3, "\nNAME PLUGIN: create new name/service/forwarder entry %s (%s) [len=%d] [type=%d] in linked list\n", tmp->name,
               olsr_ip_to_string(&strbuf, &tmp->ip), tmp->len, tmp->type);
@@ -876,6 +981,10 @@ decap_namemsg(struct name *from_packet, struct name_entry **to, bool * this_tabl
   // queue to front
   tmp->next = *to;
   *to = tmp;
+
+  if (tmp->type == NAME_HOST) {
+    hash_host_name(tmp);
+  }
 }
 
 /**
@@ -942,36 +1051,21 @@ void
 insert_new_name_in_list(union olsr_ip_addr *originator, struct list_node *this_list, struct name *from_packet,
                         bool * this_table_changed, olsr_reltime vtime)
 {
-  int hash;
   struct db_entry *entry;
-  struct list_node *list_head, *list_node;
-
-  bool entry_found = false;
-
-  hash = olsr_ip_hashing(originator);
 
   /* find the entry for originator, if there is already one */
-  list_head = &this_list[hash];
-  for (list_node = list_head->next; list_node != list_head; list_node = list_node->next) {
-
-    entry = list2db(list_node);
-
-    if (ipequal(originator, &entry->originator)) {
-      struct ipaddr_str strbuf;
-      // found
-      OLSR_PRINTF(4, "NAME PLUGIN: found entry for (%s) in its hash table\n", olsr_ip_to_string(&strbuf, originator));
-
-      //delegate to function for parsing the packet and linking it to entry->names
-      decap_namemsg(from_packet, &entry->names, this_table_changed);
-
-      olsr_set_timer(&entry->db_timer, vtime, OLSR_NAMESVC_DB_JITTER, OLSR_TIMER_ONESHOT, &olsr_nameservice_expire_db_timer, entry,
-                     0);
+  entry = lookup_db_entry(this_list, originator);
+  if (entry != NULL) {
+    struct ipaddr_str strbuf;
+    // found
+    OLSR_PRINTF(4, "NAME PLUGIN: found entry for (%s) in its hash table\n", olsr_ip_to_string(&strbuf, originator));
 
-      entry_found = true;
-    }
-  }
+    //delegate to function for parsing the packet and linking it to entry->names
+    decap_namemsg(from_packet, &entry->names, this_table_changed);
 
-  if (!entry_found) {
+    olsr_set_timer(&entry->db_timer, vtime, OLSR_NAMESVC_DB_JITTER, OLSR_TIMER_ONESHOT, &olsr_nameservice_expire_db_timer, entry,
+                   0);
+  } else {
     struct ipaddr_str strbuf;
     OLSR_PRINTF(3, "NAME PLUGIN: create new db entry for ip (%s) in hash table\n", olsr_ip_to_string(&strbuf, originator));
 
@@ -986,7 +1080,7 @@ insert_new_name_in_list(union olsr_ip_addr *originator, struct list_node *this_l
     entry->names = NULL;
 
     /* insert to the list */
-    list_add_before(&this_list[hash], &entry->db_list);
+    list_add_before(&this_list[namesvc_ip_hash(originator)], &entry->db_list);
 
     //delegate to function for parsing the packet and linking it to entry->names
     decap_namemsg(from_packet, &entry->names, this_table_changed);
@@ -1039,6 +1133,73 @@ send_sighup_to_pidfile(char *pid_file)
 }
 #endif
 
+/**
+ * 64 bit FNV-1a of rendered file contents
+ */
+static uint64_t
+content_hash(const struct autobuf *abuf)
+{
+  const unsigned char *p = (const unsigned char *)abuf->buf;
+  uint64_t hash = 14695981039346656037ULL;
+  int i;
+
+  for (i = 0; i < abuf->len; i++) {
+    hash ^= p[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+/**
+ * Replace file with the rendered contents, unless they are the
+ * same as last time. The contents are written to a temporary file
+ * which is renamed over the old one, so readers never see a half
+ * written file.
+ *
+ * Returns 1 if the file was written, 0 if it is unchanged and
+ * -1 on errors.
+ */
+static int
+write_file_atomic(const char *file, struct autobuf *abuf, uint64_t *last_hash)
+{
+  char tmpname[MAX_FILE + 5];
+  uint64_t hash = content_hash(abuf);
+  time_t currtime;
+  FILE *out;
+  bool ok;
+
+  if (hash == *last_hash) {
+    OLSR_PRINTF(3, "NAME PLUGIN: %s is unchanged\n", file);
+    return 0;
+  }
+
+  snprintf(tmpname, sizeof(tmpname), "%s.tmp", file);
+  out = fopen(tmpname, "w");
+  if (out == NULL) {
+    OLSR_PRINTF(2, "NAME PLUGIN: cant write %s\n", tmpname);
+    return -1;
+  }
+
+  ok = fwrite(abuf->buf, 1, abuf->len, out) == (size_t)abuf->len;
+  if (time(&currtime)) {
+    fprintf(out, "\n### written by olsrd at %s", ctime(&currtime));
+  }
+  ok = fclose(out) == 0 && ok;
+#ifdef WIN32
+  if (ok) {
+    remove(file);
+  }
+#endif
+  if (!ok || rename(tmpname, file) != 0) {
+    OLSR_PRINTF(2, "NAME PLUGIN: cant write %s\n", file);
+    unlink(tmpname);
+    return -1;
+  }
+
+  *last_hash = hash;
+  return 1;
+}
+
 /**
  * write names to a file in /etc/hosts compatible format
  */
@@ -1049,31 +1210,25 @@ write_hosts_file(void)
   struct name_entry *name;
   struct db_entry *entry;
   struct list_node *list_head, *list_node;
-  FILE *hosts;
+  struct autobuf abuf;
   FILE *add_hosts;
-  int c = 0;
-  time_t currtime;
+  int written;
 
 #ifdef MID_ENTRIES
   struct mid_address *alias;
 #endif
 
-  if (!name_table_changed)
+  if (!name_table_changed || my_hosts_file[0] == '\0')
     return;
 
   OLSR_PRINTF(2, "NAME PLUGIN: writing hosts file\n");
 
-  hosts = fopen(my_hosts_file, "w");
-  if (hosts == NULL) {
-    OLSR_PRINTF(2, "NAME PLUGIN: cant write hosts file\n");
-    return;
-  }
-
-  fprintf(hosts, "### this /etc/hosts file is overwritten regularly by olsrd\n");
-  fprintf(hosts, "### do not edit\n\n");
+  abuf_init(&abuf, 4096);
+  abuf_puts(&abuf, "### this /etc/hosts file is overwritten regularly by olsrd\n");
+  abuf_puts(&abuf, "### do not edit\n\n");
 
-  fprintf(hosts, "127.0.0.1\tlocalhost\n");
-  fprintf(hosts, "::1\t\tlocalhost\n\n");
+  abuf_puts(&abuf, "127.0.0.1\tlocalhost\n");
+  abuf_puts(&abuf, "::1\t\tlocalhost\n\n");
 
   // copy content from additional hosts filename
   if (my_add_hosts[0] != '\0') {
@@ -1081,21 +1236,24 @@ write_hosts_file(void)
     if (add_hosts == NULL) {
       OLSR_PRINTF(2, "NAME PLUGIN: cant open additional hosts file\n");
     } else {
-      fprintf(hosts, "### contents from '%s' ###\n\n", my_add_hosts);
-      while ((c = getc(add_hosts)) != EOF)
-        putc(c, hosts);
+      char buf[1024];
+      size_t len;
+
+      abuf_appendf(&abuf, "### contents from '%s' ###\n\n", my_add_hosts);
+      while ((len = fread(buf, 1, sizeof(buf), add_hosts)) > 0)
+        abuf_memcpy(&abuf, buf, len);
+      fclose(add_hosts);
     }
-    fclose(add_hosts);
-    fprintf(hosts, "\n### olsr names ###\n\n");
+    abuf_puts(&abuf, "\n### olsr names ###\n\n");
   }
   // write own names
   for (name = my_names; name != NULL; name = name->next) {
     struct ipaddr_str strbuf;
-    fprintf(hosts, "%s\t%s%s\t# myself\n", olsr_ip_to_string(&strbuf, &name->ip), name->name, my_suffix);
+    abuf_appendf(&abuf, "%s\t%s%s\t# myself\n", olsr_ip_to_string(&strbuf, &name->ip), name->name, my_suffix);
   }
 
   // write received names
-  for (hash = 0; hash < HASHSIZE; hash++) {
+  for (hash = 0; hash < NAMESVC_HASHSIZE; hash++) {
     list_head = &name_list[hash];
     for (list_node = list_head->next; list_node != list_head; list_node = list_node->next) {
 
@@ -1106,8 +1264,8 @@ write_hosts_file(void)
         OLSR_PRINTF(6, "%s\t%s%s\t#%s\n", olsr_ip_to_string(&strbuf1, &name->ip), name->name, my_suffix,
                     olsr_ip_to_string(&strbuf2, &entry->originator));
 
-        fprintf(hosts, "%s\t%s%s\t# %s\n", olsr_ip_to_string(&strbuf1, &name->ip), name->name, my_suffix,
-                olsr_ip_to_string(&strbuf2, &entry->originator));
+        abuf_appendf(&abuf, "%s\t%s%s\t# %s\n", olsr_ip_to_string(&strbuf1, &name->ip), name->name, my_suffix,
+                     olsr_ip_to_string(&strbuf2, &entry->originator));
 
 #ifdef MID_ENTRIES
         // write mid entries
@@ -1122,8 +1280,8 @@ write_hosts_file(void)
             OLSR_PRINTF(6, "%s\t%s%s%s\t# %s (mid #%i)\n", olsr_ip_to_string(&strbuf1, &alias->alias), mid_prefix, name->name,
                         my_suffix, olsr_ip_to_string(&strbuf2, &entry->originator), mid_num);
 
-            fprintf(hosts, "%s\t%s%s%s\t# %s (mid #%i)\n", olsr_ip_to_string(&strbuf1, &alias->alias), mid_prefix, name->name,
-                    my_suffix, olsr_ip_to_string(&strbuf2, &entry->originator), mid_num);
+            abuf_appendf(&abuf, "%s\t%s%s%s\t# %s (mid #%i)\n", olsr_ip_to_string(&strbuf1, &alias->alias), mid_prefix,
+                         name->name, my_suffix, olsr_ip_to_string(&strbuf2, &entry->originator), mid_num);
 
             alias = alias->next_alias;
             mid_num++;
@@ -1134,17 +1292,19 @@ write_hosts_file(void)
     }
   }
 
-  if (time(&currtime)) {
-    fprintf(hosts, "\n### written by olsrd at %s", ctime(&currtime));
-  }
+  written = write_file_atomic(my_hosts_file, &abuf, &hosts_file_hash);
+  abuf_free(&abuf);
+  if (written < 0)
+    return;
 
-  fclose(hosts);
+  name_table_changed = false;
+  if (written == 0)
+    return;
 
 #ifndef WIN32
   if (*my_sighup_pid_file)
     send_sighup_to_pidfile(my_sighup_pid_file);
 #endif
-  name_table_changed = false;
 
   // Executes my_name_change_script after writing the hosts file
   if (my_name_change_script[0] != '\0') {
@@ -1173,30 +1333,30 @@ write_services_file(bool writemacs)
   struct name_entry *name;
   struct db_entry *entry;
   struct list_node *list_head, *list_node;
-  FILE *file;
-  time_t currtime;
+  struct autobuf abuf;
+  uint64_t *last_hash = writemacs ? &macs_file_hash : &services_file_hash;
+  const char *file = writemacs ? my_macs_file : my_services_file;
+  const char *script = writemacs ? my_macs_change_script : my_services_change_script;
+  int written;
 
   if ((writemacs && !mac_table_changed) || (!writemacs && !service_table_changed))
     return;
+  if (file[0] == '\0')
+    return;
 
   OLSR_PRINTF(2, "NAME PLUGIN: writing %s file\n", writemacs ? "macs" : "services");
 
-  file = fopen(writemacs ? my_macs_file : my_services_file, "w");
-  if (file == NULL) {
-    OLSR_PRINTF(2, "NAME PLUGIN: cant write %s\n", writemacs ? my_macs_file : my_services_file);
-    return;
-  }
-
-  fprintf(file, "### this file is overwritten regularly by olsrd\n");
-  fprintf(file, "### do not edit\n\n");
+  abuf_init(&abuf, 4096);
+  abuf_puts(&abuf, "### this file is overwritten regularly by olsrd\n");
+  abuf_puts(&abuf, "### do not edit\n\n");
 
   // write own services or macs
   for (name = writemacs ? my_macs : my_services; name != NULL; name = name->next) {
-    fprintf(file, "%s\t# my own %s\n", name->name, writemacs ? "mac" : "service");
+    abuf_appendf(&abuf, "%s\t# my own %s\n", name->name, writemacs ? "mac" : "service");
   }
 
   // write received services or macs
-  for (hash = 0; hash < HASHSIZE; hash++) {
+  for (hash = 0; hash < NAMESVC_HASHSIZE; hash++) {
     list_head = writemacs ? &mac_list[hash] : &service_list[hash];
     for (list_node = list_head->next; list_node != list_head; list_node = list_node->next) {
 
@@ -1207,38 +1367,30 @@ write_services_file(bool writemacs)
         OLSR_PRINTF(6, "%s\t", name->name);
         OLSR_PRINTF(6, "\t#%s\n", olsr_ip_to_string(&strbuf, &entry->originator));
 
-        fprintf(file, "%s\t", name->name);
-        fprintf(file, "\t#%s\n", olsr_ip_to_string(&strbuf, &entry->originator));
+        abuf_appendf(&abuf, "%s\t\t#%s\n", name->name, olsr_ip_to_string(&strbuf, &entry->originator));
       }
     }
   }
 
-  if (time(&currtime)) {
-    fprintf(file, "\n### written by olsrd at %s", ctime(&currtime));
-  }
+  written = write_file_atomic(file, &abuf, last_hash);
+  abuf_free(&abuf);
+  if (written < 0)
+    return;
 
-  fclose(file);
-  if (writemacs) {
-    // Executes my_macs_change_script after writing the macs file
-    if (my_macs_change_script[0] != '\0') {
-      if (system(my_macs_change_script) != -1) {
-        OLSR_PRINTF(2, "NAME PLUGIN: Service changed, %s executed\n", my_macs_change_script);
-      } else {
-        OLSR_PRINTF(2, "NAME PLUGIN: WARNING! Failed to execute %s on mac change\n", my_macs_change_script);
-      }
-    }
+  if (writemacs)
     mac_table_changed = false;
-  }
-  else {
-    // Executes my_services_change_script after writing the services file
-    if (my_services_change_script[0] != '\0') {
-      if (system(my_services_change_script) != -1) {
-        OLSR_PRINTF(2, "NAME PLUGIN: Service changed, %s executed\n", my_services_change_script);
-      } else {
-        OLSR_PRINTF(2, "NAME PLUGIN: WARNING! Failed to execute %s on service change\n", my_services_change_script);
-      }
-    }
+  else
     service_table_changed = false;
+  if (written == 0)
+    return;
+
+  // Executes the change script after writing the services or macs file
+  if (script[0] != '\0') {
+    if (system(script) != -1) {
+      OLSR_PRINTF(2, "NAME PLUGIN: Service changed, %s executed\n", script);
+    } else {
+      OLSR_PRINTF(2, "NAME PLUGIN: WARNING! Failed to execute %s on %s change\n", script, writemacs ? "mac" : "service");
+    }
   }
 }
 
@@ -1293,9 +1445,8 @@ write_resolv_file(void)
   struct list_node *list_head, *list_node;
   struct rt_entry *route;
   static struct rt_entry *nameserver_routes[NAMESERVER_COUNT + 1];
-  FILE *resolv;
+  struct autobuf abuf;
   int i = 0;
-  time_t currtime;
 
   if (!forwarder_table_changed || my_forwarders != NULL || my_resolv_file[0] == '\0')
     return;
@@ -1303,7 +1454,7 @@ write_resolv_file(void)
   /* clear the array of 3+1 nameserver routes */
   memset(nameserver_routes, 0, sizeof(nameserver_routes));
 
-  for (hash = 0; hash < HASHSIZE; hash++) {
+  for (hash = 0; hash < NAMESVC_HASHSIZE; hash++) {
     list_head = &forwarder_list[hash];
     for (list_node = list_head->next; list_node != list_head; list_node = list_node->next) {
 
@@ -1339,13 +1490,9 @@ write_resolv_file(void)
 
   /* write to file */
   OLSR_PRINTF(2, "NAME PLUGIN: try to write to resolv file\n");
-  resolv = fopen(my_resolv_file, "w");
-  if (resolv == NULL) {
-    OLSR_PRINTF(2, "NAME PLUGIN: can't write resolv file\n");
-    return;
-  }
-  fprintf(resolv, "### this file is overwritten regularly by olsrd\n");
-  fprintf(resolv, "### do not edit\n\n");
+  abuf_init(&abuf, 256);
+  abuf_puts(&abuf, "### this file is overwritten regularly by olsrd\n");
+  abuf_puts(&abuf, "### do not edit\n\n");
 
   for (i = NAMESERVER_COUNT; i >= 0; i--) {
     struct ipaddr_str strbuf;
@@ -1359,13 +1506,11 @@ write_resolv_file(void)
     }
 
     OLSR_PRINTF(2, "NAME PLUGIN: nameserver %s\n", olsr_ip_to_string(&strbuf, &route->rt_dst.prefix));
-    fprintf(resolv, "nameserver %s\n", olsr_ip_to_string(&strbuf, &route->rt_dst.prefix));
-  }
-  if (time(&currtime)) {
-    fprintf(resolv, "\n### written by olsrd at %s", ctime(&currtime));
+    abuf_appendf(&abuf, "nameserver %s\n", olsr_ip_to_string(&strbuf, &route->rt_dst.prefix));
   }
-  fclose(resolv);
-  forwarder_table_changed = false;
+  if (write_file_atomic(my_resolv_file, &abuf, &resolv_file_hash) >= 0)
+    forwarder_table_changed = false;
+  abuf_free(&abuf);
 }
 
 /**
@@ -1401,6 +1546,10 @@ free_name_entry_list(struct name_entry **list)
       break;
     }
 
+    if (list_node_on_list(&to_delete->name_node)) {
+      list_remove(&to_delete->name_node);
+      list_remove(&to_delete->ip_node);
+    }
     free(to_delete->name);
     to_delete->name = NULL;
     free(to_delete);
@@ -1612,22 +1761,14 @@ lookup_defhna_latlon(union olsr_ip_addr *ip)
 const char *
 lookup_name_latlon(union olsr_ip_addr *ip)
 {
-  int hash;
-  struct db_entry *entry;
   struct list_node *list_head, *list_node;
-  struct name_entry *name;
 
-  for (hash = 0; hash < HASHSIZE; hash++) {
-    list_head = &name_list[hash];
-    for (list_node = list_head->next; list_node != list_head; list_node = list_node->next) {
-
-      entry = list2db(list_node);
+  list_head = &host_ip_hash[namesvc_ip_hash(ip)];
+  for (list_node = list_head->next; list_node != list_head; list_node = list_node->next) {
+    struct name_entry *name = ip_node2name(list_node);
 
-      for (name = entry->names; name != NULL; name = name->next) {
-        if (ipequal(&name->ip, ip))
-          return name->name;
-      }
-    }
+    if (ipequal(&name->ip, ip))
+      return name->name;
   }
   return "";
 }
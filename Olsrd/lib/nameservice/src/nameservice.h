@@ -72,6 +72,9 @@
 #define MAX_FILE 255
 #define MAX_SUFFIX 63
 
+/* buckets of the name database hashes, a power of 2 */
+#define NAMESVC_HASHSIZE 1024
+
 #define MID_ENTRIES 1
 #define MID_MAXLEN 16
 #define MID_PREFIX "mid%i."
@@ -89,8 +92,14 @@ struct name_entry {
   uint16_t len;
   char *name;
   struct name_entry *next;             /* linked list */
+  struct list_node name_node;          /* host names hashed by name */
+  struct list_node ip_node;            /* host names hashed by ip */
 };
 
+/* inline to recast from the hash lists back to name_entry */
+LISTNODE2STRUCT(name_node2name, struct name_entry, name_node);
+LISTNODE2STRUCT(ip_node2name, struct name_entry, ip_node);
+
 /* *
  * linked list of db_entries for each originator with
  * originator being its main_addr
@@ -98,8 +107,9 @@ struct name_entry {
  * names points to the name_entry with its hostname, dns-server or
  * service-line entry
  *
- * all the db_entries are hashed in nameservice.c to avoid a too long list
- * for many nodes in a net
+ * all the db_entries are hashed by originator in nameservice.c to avoid
+ * a too long list for many nodes in a net, the host names of all of them
+ * are additionally hashed by name and by ip (host_name_hash, host_ip_hash)
  *
  * */
 struct db_entry {
@@ -115,9 +125,17 @@ LISTNODE2STRUCT(list2db, struct db_entry, db_list);
 #define OLSR_NAMESVC_DB_JITTER 5        /* percent */
 
 extern struct name_entry *my_names;
-extern struct list_node latlon_list[HASHSIZE];
+extern struct list_node latlon_list[NAMESVC_HASHSIZE];
+extern struct list_node host_name_hash[NAMESVC_HASHSIZE];
+extern struct list_node host_ip_hash[NAMESVC_HASHSIZE];
 extern float my_lat, my_lon;
 
+uint32_t namesvc_name_hash(const char *name);
+
+uint32_t namesvc_ip_hash(const union olsr_ip_addr *ip);
+
+struct db_entry *lookup_db_entry(struct list_node *this_list, const union olsr_ip_addr *originator);
+
 void olsr_expire_write_file_timer(void *);
 void olsr_namesvc_delete_db_entry(struct db_entry *);
 
@@ -0,0 +1,378 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004-2009, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/* -------------------------------------------------------------------------
+ * File       : DupFilter.c
+ * Description: Constant-time duplicate message filter for the P2PD plugin
+ * ------------------------------------------------------------------------- */
+
+#include "DupFilter.h"
+
+/* System includes */
+#include <stdlib.h>             /* free() */
+#include <string.h>             /* memset(), memcpy() */
+
+/* OLSRD includes */
+#include "defs.h"               /* olsr_cnf */
+#include "olsr.h"               /* olsr_malloc() */
+#include "ipcalc.h"             /* ipequal() */
+#include "scheduler.h"          /* GET_TIMESTAMP(), TIMED_OUT() */
+
+/* Remembered messages in arrival order, the oldest one at DupRingHead */
+static struct DupFilterEntry *DupRing = NULL;
+static unsigned int DupRingBits = 0;
+static unsigned int DupRingMask = 0;
+static unsigned int DupRingHead = 0;
+static unsigned int DupRingCount = 0;
+
+/* Open addressing (linear probing) index into DupRing, twice the size of
+ * the ring; each slot holds a ring position plus one, zero marks an empty
+ * slot */
+static uint32_t *DupIndex = NULL;
+static unsigned int DupIndexMask = 0;
+
+/* Time in milliseconds a message is remembered */
+static uint32_t DupHoldTime = 0;
+
+struct DupFilterStats DupFilterStats;
+
+/* -------------------------------------------------------------------------
+ * Function   : DupFilterHash
+ * Description: Calculate the home slot in DupIndex of a message key
+ * Input      : addr    - originator address of the message
+ *              msgtype - message type
+ *              seqno   - message sequence number
+ * Output     : none
+ * Return     : index into DupIndex
+ * Data Used  : olsr_cnf, DupRingBits
+ * ------------------------------------------------------------------------- */
+static uint32_t
+DupFilterHash(const union olsr_ip_addr *addr, uint8_t msgtype, uint16_t seqno)
+{
+  uint32_t hash = ((uint32_t)seqno << 8) | msgtype;
+
+  if (olsr_cnf->ip_version == AF_INET) {
+    hash ^= addr->v4.s_addr;
+  } else {
+    int i;
+
+    for (i = 0; i < 16; i += 4) {
+      hash ^= ((uint32_t)addr->v6.s6_addr[i] << 24) | ((uint32_t)addr->v6.s6_addr[i + 1] << 16) |
+        ((uint32_t)addr->v6.s6_addr[i + 2] << 8) | addr->v6.s6_addr[i + 3];
+      hash *= 0x9e3779b1;
+    }
+  }
+
+  /* Fibonacci hashing, take the top bits */
+  hash *= 0x9e3779b1;
+  return hash >> (32 - (DupRingBits + 1));
+}
+
+/* -------------------------------------------------------------------------
+ * Function   : DupFilterFreeSlot
+ * Description: Find the first empty slot of the probe sequence of a key
+ * Input      : home - home slot of the key
+ * Output     : none
+ * Return     : index into DupIndex
+ * Data Used  : DupIndex
+ * ------------------------------------------------------------------------- */
+static uint32_t
+DupFilterFreeSlot(uint32_t home)
+{
+  uint32_t slot = home;
+
+  while (DupIndex[slot] != 0) {
+    slot = (slot + 1) & DupIndexMask;
+  }
+  return slot;
+}
+
+/* -------------------------------------------------------------------------
+ * Function   : DupFilterUnindex
+ * Description: Remove a ring position from the hash index, moving later
+ *              entries of the same probe sequence back so that no
+ *              tombstones are needed
+ * Input      : pos - ring position to remove
+ * Output     : none
+ * Return     : none
+ * Data Used  : DupRing, DupIndex
+ * ------------------------------------------------------------------------- */
+static void
+DupFilterUnindex(unsigned int pos)
+{
+  struct DupFilterEntry *entry = &DupRing[pos];
+  uint32_t hole, next;
+
+  hole = DupFilterHash(&entry->address, entry->msgtype, entry->seqno);
+  while (DupIndex[hole] != pos + 1) {
+    hole = (hole + 1) & DupIndexMask;
+  }
+
+  for (next = (hole + 1) & DupIndexMask; DupIndex[next] != 0; next = (next + 1) & DupIndexMask) {
+    struct DupFilterEntry *other = &DupRing[DupIndex[next] - 1];
+    uint32_t home = DupFilterHash(&other->address, other->msgtype, other->seqno);
+
+    /* Move the entry into the hole unless its home slot lies
+     * cyclically in (hole, next] */
+    if (((next - home) & DupIndexMask) >= ((next - hole) & DupIndexMask)) {
+      DupIndex[hole] = DupIndex[next];
+      hole = next;
+    }
+  }
+
+  DupIndex[hole] = 0;
+}
+
+/* -------------------------------------------------------------------------
+ * Function   : DupFilterDropOldest
+ * Description: Forget the oldest remembered message
+ * Input      : none
+ * Output     : none
+ * Return     : none
+ * Data Used  : DupRing, DupRingHead, DupRingCount
+ * ------------------------------------------------------------------------- */
+static void
+DupFilterDropOldest(void)
+{
+  DupFilterUnindex(DupRingHead);
+  DupRingHead = (DupRingHead + 1) & DupRingMask;
+  DupRingCount--;
+}
+
+/* -------------------------------------------------------------------------
+ * Function   : DupFilterResize
+ * Description: Move all remembered messages into a ring of the given size
+ *              and rebuild the hash index for it
+ * Input      : bits - log2 of the new ring size
+ * Output     : none
+ * Return     : none
+ * Data Used  : DupRing, DupIndex
+ * ------------------------------------------------------------------------- */
+static void
+DupFilterResize(unsigned int bits)
+{
+  struct DupFilterEntry *ring = olsr_malloc(sizeof(*ring) << bits, "P2PD duplicate ring");
+  unsigned int i;
+
+  for (i = 0; i < DupRingCount; i++) {
+    ring[i] = DupRing[(DupRingHead + i) & DupRingMask];
+  }
+  free(DupRing);
+  free(DupIndex);
+
+  DupRing = ring;
+  DupRingBits = bits;
+  DupRingMask = (1u << bits) - 1;
+  DupRingHead = 0;
+  DupIndex = olsr_malloc(sizeof(*DupIndex) << (bits + 1), "P2PD duplicate index");
+  DupIndexMask = (1u << (bits + 1)) - 1;
+
+  for (i = 0; i < DupRingCount; i++) {
+    DupIndex[DupFilterFreeSlot(DupFilterHash(&ring[i].address, ring[i].msgtype, ring[i].seqno))] = i + 1;
+  }
+}
+
+/* -------------------------------------------------------------------------
+ * Function   : InitDupFilter
+ * Description: Initialize the duplicate message filter
+ * Input      : holdTimeMs - time in milliseconds a message is remembered
+ * Output     : none
+ * Return     : none
+ * Data Used  : none
+ * ------------------------------------------------------------------------- */
+void
+InitDupFilter(uint32_t holdTimeMs)
+{
+  FlushDupFilter();
+  DupHoldTime = holdTimeMs;
+  DupFilterResize(DUPFILTER_MIN_BITS);
+  memset(&DupFilterStats, 0, sizeof(DupFilterStats));
+}
+
+/* -------------------------------------------------------------------------
+ * Function   : FlushDupFilter
+ * Description: Forget all remembered messages and release the ring
+ * Input      : none
+ * Output     : none
+ * Return     : none
+ * Data Used  : DupRing, DupIndex, DupRingHead, DupRingCount
+ * ------------------------------------------------------------------------- */
+void
+FlushDupFilter(void)
+{
+  free(DupRing);
+  free(DupIndex);
+  DupRing = NULL;
+  DupIndex = NULL;
+  DupRingBits = 0;
+  DupRingMask = 0;
+  DupIndexMask = 0;
+  DupRingHead = 0;
+  DupRingCount = 0;
+}
+
+/* -------------------------------------------------------------------------
+ * Function   : AgeDupFilter
+ * Description: Forget all messages whose hold time has passed. Entries are
+ *              stored in arrival order with the same hold time, so only
+ *              the head of the ring has to be looked at. Called from a
+ *              periodic scheduler timer.
+ * Input      : none
+ * Output     : none
+ * Return     : none
+ * Data Used  : DupRing, now_times
+ * ------------------------------------------------------------------------- */
+void
+AgeDupFilter(void)
+{
+  while (DupRingCount > 0 && TIMED_OUT(DupRing[DupRingHead].expires)) {
+    DupFilterDropOldest();
+    DupFilterStats.expired++;
+  }
+}
+
+/* -------------------------------------------------------------------------
+ * Function   : CheckAndMarkDupFilter
+ * Description: Check whether a message has been seen before and remember
+ *              it if not. Messages past their hold time which the aging
+ *              timer did not remove yet do not count. When the ring is full
+ *              it is doubled unless its head has expired; only at
+ *              DUPFILTER_MAX_BITS is the oldest message forgotten early.
+ * Input      : m - message to check
+ * Output     : none
+ * Return     : true if the message was seen before, false otherwise
+ * Data Used  : DupRing, DupIndex
+ * ------------------------------------------------------------------------- */
+bool
+CheckAndMarkDupFilter(const union olsr_message *m)
+{
+  union olsr_ip_addr originator;
+  struct DupFilterEntry *entry;
+  uint32_t home, slot;
+  uint16_t seqno;
+  uint8_t msgtype;
+
+  memset(&originator, 0, sizeof(originator));
+  if (olsr_cnf->ip_version == AF_INET) {
+    originator.v4.s_addr = m->v4.originator;
+    msgtype = m->v4.olsr_msgtype;
+    seqno = m->v4.seqno;
+  } else {
+    memcpy(&originator.v6, &m->v6.originator, sizeof(originator.v6));
+    msgtype = m->v6.olsr_msgtype;
+    seqno = m->v6.seqno;
+  }
+
+  DupFilterStats.checked++;
+
+  home = DupFilterHash(&originator, msgtype, seqno);
+  for (slot = home; DupIndex[slot] != 0; slot = (slot + 1) & DupIndexMask) {
+    entry = &DupRing[DupIndex[slot] - 1];
+    if (entry->seqno == seqno && entry->msgtype == msgtype && ipequal(&entry->address, &originator)
+        && !TIMED_OUT(entry->expires)) {
+      DupFilterStats.duplicates++;
+      return true;
+    }
+  }
+
+  if (DupRingCount > DupRingMask) {
+    /* reuse expired entries the timer did not get to yet */
+    AgeDupFilter();
+
+    if (DupRingCount <= DupRingMask) {
+      /* the probe sequence may have been shifted */
+      slot = DupFilterFreeSlot(home);
+    } else if (DupRingBits < DUPFILTER_MAX_BITS) {
+      DupFilterResize(DupRingBits + 1);
+      DupFilterStats.grown++;
+      slot = DupFilterFreeSlot(DupFilterHash(&originator, msgtype, seqno));
+    } else {
+      DupFilterDropOldest();
+      DupFilterStats.evicted++;
+      slot = DupFilterFreeSlot(home);
+    }
+  }
+
+  entry = &DupRing[(DupRingHead + DupRingCount) & DupRingMask];
+  entry->address = originator;
+  entry->msgtype = msgtype;
+  entry->seqno = seqno;
+  entry->expires = GET_TIMESTAMP(DupHoldTime);
+
+  DupIndex[slot] = ((DupRingHead + DupRingCount) & DupRingMask) + 1;
+  DupRingCount++;
+
+  return false;
+}
+
+/* -------------------------------------------------------------------------
+ * Function   : DupFilterCount
+ * Description: Number of messages currently remembered
+ * Input      : none
+ * Output     : none
+ * Return     : number of entries
+ * Data Used  : DupRingCount
+ * ------------------------------------------------------------------------- */
+unsigned int
+DupFilterCount(void)
+{
+  return DupRingCount;
+}
+
+/* -------------------------------------------------------------------------
+ * Function   : DupFilterSize
+ * Description: Number of messages the ring holds before it has to grow
+ * Input      : none
+ * Output     : none
+ * Return     : ring size
+ * Data Used  : DupRingMask
+ * ------------------------------------------------------------------------- */
+unsigned int
+DupFilterSize(void)
+{
+  return DupRing != NULL ? DupRingMask + 1 : 0;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
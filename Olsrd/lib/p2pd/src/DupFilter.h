@@ -0,0 +1,96 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004-2009, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+#ifndef _P2PD_DUPFILTER_H
+#define _P2PD_DUPFILTER_H
+
+/* -------------------------------------------------------------------------
+ * File       : DupFilter.h
+ * Description: Constant-time duplicate message filter for the P2PD plugin.
+ *              Entries live in a ring in arrival order, so the oldest ones
+ *              can be aged out from the head; an open addressing hash index
+ *              on (originator, message type, sequence number) refers into
+ *              the ring. The ring grows while all of its entries are still
+ *              within their hold time.
+ * ------------------------------------------------------------------------- */
+
+#include "olsr_types.h"
+#include "olsr_protocol.h"      /* union olsr_message */
+
+/* Ring size bounds, as a power of two; the maximum holds the default hold
+ * time at 5000 messages per second */
+#define DUPFILTER_MIN_BITS        10
+#define DUPFILTER_MAX_BITS        20
+
+/* Interval of the timer aging the filter, in milliseconds */
+#define DUPFILTER_AGE_INTERVAL    1000
+
+struct DupFilterEntry {
+  union olsr_ip_addr             address;
+  uint32_t                       expires;    /* olsrd scheduler clock */
+  uint16_t                       seqno;
+  uint8_t                        msgtype;
+};
+
+struct DupFilterStats {
+  uint32_t                       checked;
+  uint32_t                       duplicates;
+  uint32_t                       expired;
+  uint32_t                       grown;      /* times the ring was doubled */
+  uint32_t                       evicted;    /* dropped before timing out */
+};
+
+extern struct DupFilterStats DupFilterStats;
+
+void InitDupFilter(uint32_t holdTimeMs);
+void FlushDupFilter(void);
+void AgeDupFilter(void);
+bool CheckAndMarkDupFilter(const union olsr_message *m);
+unsigned int DupFilterCount(void);
+unsigned int DupFilterSize(void);
+
+#endif /* _P2PD_DUPFILTER_H */
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
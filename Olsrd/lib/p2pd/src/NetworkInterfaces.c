@@ -83,14 +83,15 @@ struct NonOlsrInterface *lastNonOlsrInterface = NULL;
  * Function   : CreateCaptureSocket
  * Description: Create socket for promiscuously capturing multicast IP traffic
  * Input      : ifname - network interface (e.g. "eth0")
- * Output     : none
+ * Output     : ring - receive ring of the socket, if PlParam "CaptureRing"
+ *                is set
  * Return     : the socket descriptor ( >= 0), or -1 if an error occurred
- * Data Used  : none
+ * Data Used  : UseCaptureRing
  * Notes      : The socket is a cooked IP packet socket, bound to the specified
  *              network interface
  * ------------------------------------------------------------------------- */
 int
-CreateCaptureSocket(const char *ifName)
+CreateCaptureSocket(const char *ifName, struct TPacketRing *ring)
 {
   int ifIndex = if_nametoindex(ifName);
   struct packet_mreq mreq;
@@ -146,6 +147,19 @@ CreateCaptureSocket(const char *ifName)
     return -1;
   }
 
+  /* Let the kernel drop frames that are not multicast, broadcast or
+   * outgoing, instead of queueing every promiscuously received frame */
+  if (AttachCaptureFilter(skfd) < 0) {
+    P2pdPError("setsockopt(SO_ATTACH_FILTER) error");
+  }
+
+  /* Map a receive ring if configured; without it, captured packets are
+   * read with recvfrom() */
+  memset(ring, 0, sizeof(*ring));
+  if (UseCaptureRing && CreatePacketRing(ring, skfd) < 0) {
+    P2pdPError("PACKET_RX_RING error for interface \"%s\"", ifName);
+  }
+
   /* Set socket to blocking operation */
   if (fcntl(skfd, F_SETFL, fcntl(skfd, F_GETFL, 0) & ~O_NONBLOCK) < 0) {
     P2pdPError("fcntl() error");
@@ -153,7 +167,7 @@ CreateCaptureSocket(const char *ifName)
     return -1;
   }
   //AddDescriptorToInputSet(skfd);
-  add_olsr_socket(skfd, (socket_handler_func)&DoP2pd, NULL, NULL, SP_PR_READ);
+  add_olsr_socket(skfd, (socket_handler_func)&DoP2pd, NULL, ring->map != NULL ? ring : NULL, SP_PR_READ);
 
   return skfd;
 }                               /* CreateCaptureSocket */
@@ -194,7 +208,7 @@ CreateInterface(const char *ifName, struct interface *olsrIntf)
   /* Create socket for capturing and sending of multicast packets on
    * non-OLSR interfaces, and on OLSR-interfaces if configured. */
   if ((olsrIntf == NULL)) {
-    capturingSkfd = CreateCaptureSocket(ifName);
+    capturingSkfd = CreateCaptureSocket(ifName, &newIf->captureRing);
     if (capturingSkfd < 0) {
       close(encapsulatingSkfd);
       free(newIf);
@@ -214,6 +228,10 @@ CreateInterface(const char *ifName, struct interface *olsrIntf)
   ifr.ifr_name[IFNAMSIZ - 1] = '\0';    /* Ensures null termination */
   if (ioctl(ioctlSkfd, SIOCGIFHWADDR, &ifr) < 0) {
     P2pdPError("ioctl(SIOCGIFHWADDR) error for interface \"%s\"", ifName);
+    if (capturingSkfd >= 0) {
+      remove_olsr_socket(capturingSkfd, (socket_handler_func)&DoP2pd, NULL);
+      ClosePacketRing(&newIf->captureRing);
+    }
     close(capturingSkfd);
     close(encapsulatingSkfd);
     free(newIf);
@@ -453,6 +471,7 @@ CloseNonOlsrNetworkInterfaces(void)
     nextIf = ifc->next;
 
     if (ifc->capturingSkfd >= 0) {
+      ClosePacketRing(&ifc->captureRing);
       close(ifc->capturingSkfd);
       nClosed++;
     }
@@ -112,6 +112,7 @@ static const struct olsrd_plugin_parameters plugin_parameters[] = {
   {.name = "P2pdTtl", .set_plugin_parameter = &SetP2pdTtl, .data = NULL },
   {.name = "UdpDestPort",.set_plugin_parameter = &AddUdpDestPort,.data = NULL},
   {.name = "UseHashFilter",.set_plugin_parameter = &SetP2pdUseHashFilter,.data = NULL},
+  {.name = "CaptureRing",.set_plugin_parameter = &set_plugin_boolean,.data = &UseCaptureRing},
 };
 
 /* -------------------------------------------------------------------------
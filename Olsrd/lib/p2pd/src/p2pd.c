@@ -72,6 +72,8 @@
 #include "link_set.h"           /* get_best_link_to_neighbor() */
 #include "net_olsr.h"           /* ipequal */
 #include "parser.h"
+#include "scheduler.h"          /* olsr_start_timer() */
+#include "olsr_cookie.h"        /* olsr_alloc_cookie() */
 
 /* plugin includes */
 #include "NetworkInterfaces.h"  /* NonOlsrInterface,
@@ -82,7 +84,7 @@
                                    BMF_ENCAP_TYPE,
                                    BMF_ENCAP_LEN etc. */
 #include "PacketHistory.h"
-#include "dllist.h"
+#include "DupFilter.h"          /* CheckAndMarkDupFilter() */
 
 int P2pdTtl                        = 0;
 int P2pdUseHash                    = 0;  /* Switch off hash filter by default */
@@ -91,10 +93,9 @@ int P2pdDuplicateTimeout           = P2PD_VALID_TIME;
 /* List of UDP destination address and port information */
 struct UdpDestPort *                 UdpDestPortList = NULL;
 
-/* List of filter entries to check for duplicate messages
- */
-struct node *                        dupFilterHead = NULL;
-struct node *                        dupFilterTail = NULL;
+/* Periodic aging of the duplicate message filter */
+static struct olsr_cookie_info *     DupFilterTimerCookie = NULL;
+static struct timer_entry *          DupFilterTimer = NULL;
 
 bool is_broadcast(const struct sockaddr_in addr);
 bool is_multicast(const struct sockaddr_in addr);
@@ -272,105 +273,6 @@ int HighestSkfd = -1;
 /* Set of socket file descriptors */
 fd_set InputSet;
 
-/* -------------------------------------------------------------------------
- * Function   : p2pd_message_seen
- * Description: Check whether the current message has been seen before
- * Input      : head - start of the list to check for the message
- *              tail - end of the list to check for the message
- *              m    - message to check for in the list
- * Output     : none
- * Return     : true if message was found, false otherwise
- * Data Used  : P2pdDuplicateTimeout
- * ------------------------------------------------------------------------- */
-bool
-p2pd_message_seen(struct node **head, struct node **tail, union olsr_message *m)
-{
-  struct node * curr;
-  time_t now;
-
-  now = time(NULL);
-
-  // Check whether any entries have aged
-  curr = *head;
-  while (curr) {
-    struct DupFilterEntry *filter;
-    struct node * next = curr->next; // Save the current pointer since curr may
-                                     // be destroyed
-
-    filter = (struct DupFilterEntry*)curr->data;
-
-    if ((filter->creationtime + P2pdDuplicateTimeout) < now)
-      remove_node(head, tail, curr, true);
-
-    // Skip to the next element
-    curr = next;
-  }
-
-  // Now check whether there are any duplicates
-  for (curr = *head; curr; curr = curr->next) {
-    struct DupFilterEntry *filter = (struct DupFilterEntry*)curr->data;
-
-    if (olsr_cnf->ip_version == AF_INET) {
-      if (filter->address.v4.s_addr == m->v4.originator &&
-          filter->msgtype == m->v4.olsr_msgtype &&
-          filter->seqno == m->v4.seqno) {
-          return true;
-      }
-    } else /* if (olsr_cnf->ip_version == AF_INET6) */ {
-      if (memcmp(filter->address.v6.s6_addr,
-                 m->v6.originator.s6_addr,
-                 sizeof(m->v6.originator.s6_addr)) == 0 &&
-          filter->msgtype == m->v6.olsr_msgtype &&
-          filter->seqno == m->v6.seqno) {
-          return true;
-      }
-    }
-  }
-
-  return false;
-}
-
-/* -------------------------------------------------------------------------
- * Function   : p2pd_store_message
- * Description: Store a new message in the duplicate message check list
- * Input      : head - start of the list to add the message to
- *              tail - end of the list to add the message to
- *              m    - message to add to the list
- * Output     : none
- * Return     : nothing
- * Data Used  : none
- * ------------------------------------------------------------------------- */
-void
-p2pd_store_message(struct node **head, struct node **tail, union olsr_message *m)
-{
-  time_t now;
-
-  // Store a message into the database
-  struct DupFilterEntry *new_dup = calloc(1, sizeof(struct DupFilterEntry));
-  if (new_dup == NULL) {
-    OLSR_PRINTF(1, "%s: Out of memory\n", PLUGIN_NAME_SHORT);
-    return;
-  }
-
-  now = time(NULL);
-
-  new_dup->creationtime = now;
-  if (olsr_cnf->ip_version == AF_INET) {
-    new_dup->address.v4.s_addr = m->v4.originator;
-    new_dup->msgtype           = m->v4.olsr_msgtype;
-    new_dup->seqno             = m->v4.seqno;
-  } else /* if (olsr_cnf->ip_version == AF_INET6) */ {
-    memcpy(new_dup->address.v6.s6_addr,
-           m->v6.originator.s6_addr,
-           sizeof(m->v6.originator.s6_addr));
-    new_dup->msgtype           = m->v6.olsr_msgtype;
-    new_dup->seqno             = m->v6.seqno;
-  }
-
-  // Add the element to the head of the list
-  append_node(head, tail, new_dup);
-}
-
 /* -------------------------------------------------------------------------
  * Function   : p2pd_is_duplicate_message
  * Description: Check whether the specified message is a duplicate
@@ -382,13 +284,7 @@ p2pd_store_message(struct node **head, struct node **tail, union olsr_message *m
 bool
 p2pd_is_duplicate_message(union olsr_message *msg)
 {
-  if(p2pd_message_seen(&dupFilterHead, &dupFilterTail, msg)) {
-    return true;
-  }
-
-  p2pd_store_message(&dupFilterHead, &dupFilterTail, msg);
-
-  return false;
+  return CheckAndMarkDupFilter(msg);
 }
 
 /* -------------------------------------------------------------------------
@@ -709,21 +605,102 @@ P2pdPacketCaptured(unsigned char *encapsulationUdpData, int nBytes)
 }                               /* P2pdPacketCaptured */
 
 
+/* -------------------------------------------------------------------------
+ * Function   : P2pdFrameCaptured
+ * Description: Handle a frame captured on a non-OLSR interface
+ * Input      : ipPacket - the captured IP packet, preceded by space for the
+ *                encapsulation header
+ *              nBytes - the number of captured bytes
+ *              pktType - the packet type reported by the packet socket
+ * Output     : none
+ * Return     : none
+ * Data Used  : none
+ * ------------------------------------------------------------------------- */
+static void
+P2pdFrameCaptured(unsigned char *ipPacket, int nBytes, unsigned char pktType)
+{
+  /* Check if the number of received bytes is large enough for an IP
+   * packet which contains at least a minimum-size IP header.
+   * Note: There is an apparent bug in the packet socket implementation in
+   * combination with VLAN interfaces. On a VLAN interface, the value returned
+   * by 'recvfrom' may (but need not) be 4 (bytes) larger than the value
+   * returned on a non-VLAN interface, for the same ethernet frame. */
+  if (nBytes < (int)sizeof(struct ip)) {
+    ////OLSR_PRINTF(
+    //              1,
+    //              "%s: captured frame too short (%d bytes) on \"%s\"\n",
+    //              PLUGIN_NAME_SHORT,
+    //              nBytes,
+    //              walker->ifName);
+
+    return;
+  }
+
+  if (pktType == PACKET_OUTGOING ||
+      pktType == PACKET_MULTICAST ||
+      pktType == PACKET_BROADCAST) {
+#ifdef INCLUDE_DEBUG_OUTPUT
+    OLSR_PRINTF(1, "%s: Multicast or broadcast packet was captured.\n",
+                PLUGIN_NAME_SHORT);
+    dump_packet(ipPacket, nBytes);
+#endif
+    /* A multicast or broadcast packet was captured */
+    P2pdPacketCaptured(ipPacket, nBytes);
+
+  }                             /* if (pktType == ...) */
+}                               /* P2pdFrameCaptured */
+
+/* -------------------------------------------------------------------------
+ * Function   : P2pdRingFrameCaptured
+ * Description: Handle a frame from the receive ring of a capturing socket
+ * Input      : frame - the captured IP packet, inside the ring
+ *              len - the number of captured bytes
+ *              addr - link layer address information of the frame
+ *              data - unused
+ * Output     : none
+ * Return     : none
+ * Data Used  : none
+ * ------------------------------------------------------------------------- */
+static void
+P2pdRingFrameCaptured(unsigned char *frame, unsigned int len, struct sockaddr_ll *addr,
+                      void *data __attribute__ ((unused)))
+{
+  unsigned char rxBuffer[P2PD_BUFFER_SIZE];
+  unsigned char *ipPacket = GetIpPacket(rxBuffer);
+
+  /* Copy the frame out of the ring, leaving space for the encapsulation
+   * header */
+  if (len > (unsigned int)(rxBuffer + sizeof(rxBuffer) - ipPacket)) {
+    len = rxBuffer + sizeof(rxBuffer) - ipPacket;
+  }
+  memcpy(ipPacket, frame, len);
+
+  P2pdFrameCaptured(ipPacket, len, addr->sll_pkttype);
+}                               /* P2pdRingFrameCaptured */
+
 /* -------------------------------------------------------------------------
  * Function   : DoP2pd
  * Description: This function is registered with the OLSR scheduler and called
  *              when something is captured
- * Input      : none
+ * Input      : skfd - the capturing socket
+ *              data - its receive ring, or NULL if it is read with recvfrom()
  * Output     : none
  * Return     : none
  * Data Used  :
  * ------------------------------------------------------------------------- */
 void
 DoP2pd(int skfd,
-       void *data __attribute__ ((unused)),
+       void *data,
        unsigned int flags __attribute__ ((unused)))
 {
   unsigned char rxBuffer[P2PD_BUFFER_SIZE];
+
+  /* With a receive ring, handle all frames the kernel has handed over */
+  if (data != NULL) {
+    ProcessPacketRing(data, &P2pdRingFrameCaptured, NULL);
+    return;
+  }
+
   if (skfd >= 0) {
     struct sockaddr_ll pktAddr;
     socklen_t addrLen = sizeof(pktAddr);
@@ -744,39 +721,24 @@ DoP2pd(int skfd,
       return;                   /* for */
     }
 
-    /* if (nBytes < 0) */
-    /* Check if the number of received bytes is large enough for an IP
-     * packet which contains at least a minimum-size IP header.
-     * Note: There is an apparent bug in the packet socket implementation in
-     * combination with VLAN interfaces. On a VLAN interface, the value returned
-     * by 'recvfrom' may (but need not) be 4 (bytes) larger than the value
-     * returned on a non-VLAN interface, for the same ethernet frame. */
-    if (nBytes < (int)sizeof(struct ip)) {
-      ////OLSR_PRINTF(
-      //              1,
-      //              "%s: captured frame too short (%d bytes) on \"%s\"\n",
-      //              PLUGIN_NAME_SHORT,
-      //              nBytes,
-      //              walker->ifName);
-
-      return;                   /* for */
-    }
-
-    if (pktAddr.sll_pkttype == PACKET_OUTGOING ||
-        pktAddr.sll_pkttype == PACKET_MULTICAST ||
-        pktAddr.sll_pkttype == PACKET_BROADCAST) {
-#ifdef INCLUDE_DEBUG_OUTPUT
-      OLSR_PRINTF(1, "%s: Multicast or broadcast packet was captured.\n",
-                  PLUGIN_NAME_SHORT);
-      dump_packet(ipPacket, nBytes);
-#endif
-      /* A multicast or broadcast packet was captured */
-      P2pdPacketCaptured(ipPacket, nBytes);
-
-    }                           /* if (pktAddr.sll_pkttype == ...) */
+    P2pdFrameCaptured(ipPacket, nBytes, pktAddr.sll_pkttype);
   }                             /* if (skfd >= 0 && (FD_ISSET...)) */
 }                               /* DoP2pd */
 
+/* -------------------------------------------------------------------------
+ * Function   : AgeP2pdDupFilter
+ * Description: Timer callback forgetting the messages whose hold time passed
+ * Input      : context - unused
+ * Output     : none
+ * Return     : none
+ * Data Used  : none
+ * ------------------------------------------------------------------------- */
+static void
+AgeP2pdDupFilter(void *context __attribute__ ((unused)))
+{
+  AgeDupFilter();
+}
+
 /* -------------------------------------------------------------------------
  * Function   : InitP2pd
  * Description: Initialize the P2pd plugin
@@ -793,6 +755,14 @@ InitP2pd(struct interface *skipThisIntf)
     InitPacketHistory();
   }
 
+  // Initialize the filter for duplicate OLSR messages
+  InitDupFilter(P2pdDuplicateTimeout * MSEC_PER_SEC);
+  if (DupFilterTimerCookie == NULL) {
+    DupFilterTimerCookie = olsr_alloc_cookie("P2PD: age duplicate filter", OLSR_COOKIE_TYPE_TIMER);
+  }
+  DupFilterTimer = olsr_start_timer(DUPFILTER_AGE_INTERVAL, 0, OLSR_TIMER_PERIODIC,
+                                    &AgeP2pdDupFilter, NULL, DupFilterTimerCookie);
+
   //Tells OLSR to launch olsr_parser when the packets for this plugin arrive
   //olsr_parser_add_function(&olsr_parser, PARSER_TYPE,1);
   olsr_parser_add_function(&olsr_parser, PARSER_TYPE);
@@ -815,6 +785,11 @@ void
 CloseP2pd(void)
 {
   CloseNonOlsrNetworkInterfaces();
+  if (DupFilterTimer != NULL) {
+    olsr_stop_timer(DupFilterTimer);
+    DupFilterTimer = NULL;
+  }
+  FlushDupFilter();
 }
 
 /* -------------------------------------------------------------------------
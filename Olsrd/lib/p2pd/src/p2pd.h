@@ -67,14 +67,6 @@
 /* Forward declaration of OLSR interface type */
 struct interface;
 
-struct DupFilterEntry {
-  int                            ip_version;
-  union olsr_ip_addr             address;
-  uint16_t                       seqno;
-  uint8_t                        msgtype;
-  time_t                         creationtime;
-};
-
 struct UdpDestPort {
   int                            ip_version;
   union olsr_ip_addr             address;
@@ -87,7 +79,6 @@ extern int P2pdDuplicateTimeout;
 extern int HighestSkfd;
 extern fd_set InputSet;
 extern struct UdpDestPort * UdpDestPortList;
-extern struct DuplicateFilterEntry * FilterList;
 
 void DoP2pd(int sd, void *x, unsigned int y);
 void P2pdPError(const char *format, ...) __attribute__ ((format(printf, 1, 2)));
@@ -99,8 +90,6 @@ int AddUdpDestPort(const char *value, void *data __attribute__ ((unused)), set_p
 bool InUdpDestPortList(int ip_version, union olsr_ip_addr *addr, uint16_t port);
 int SetP2pdTtl(const char *value, void *data __attribute__ ((unused)), set_plugin_parameter_addon addon __attribute__ ((unused)));
 int SetP2pdUseHashFilter(const char *value, void *data __attribute__ ((unused)), set_plugin_parameter_addon addon __attribute__ ((unused)));
-bool p2pd_message_seen(struct node **head, struct node **tail, union olsr_message *m);
-void p2pd_store_message(struct node **head, struct node **tail, union olsr_message *m);
 bool p2pd_is_duplicate_message(union olsr_message *msg);
 
 void olsr_p2pd_gen(unsigned char *packet, int len);
@@ -0,0 +1,232 @@
+#!/usr/bin/env python3
+#
+# OLSRd Quagga plugin
+#
+# Minimal stand-in for the zebra daemon, to test the quagga plugin
+# without a quagga installation. It speaks the zserv protocol the
+# plugin uses (version 0 or 1), keeps the routes olsrd exports and
+# answers redistribution requests with a configurable set of routes.
+#
+# usage: zebra_standin.py [--socket PATH | --port PORT] [--version 0|1]
+#                         [--ipv6] [--route PREFIX ...] [--dump FILE]
+#                         [--drop-after N] [--read-delay SECONDS] [-v]
+#
+# --route       prefix announced for every redistributed route type
+# --dump        file rewritten with the route table after each change,
+#               one "prefix nexthop metric" line per route
+# --drop-after  close the connection after N messages, to test the
+#               reconnect (and resync) of the plugin
+# --read-delay  sleep before each read, to make the plugin queue
+#
+# The statistics are printed when the stand-in is terminated.
+#
+
+import argparse
+import ipaddress
+import os
+import signal
+import socket
+import struct
+import sys
+import time
+
+ZEBRA_HEADER_MARKER = 255
+
+ZEBRA_IPV4_ROUTE_ADD = 7
+ZEBRA_IPV4_ROUTE_DELETE = 8
+ZEBRA_IPV6_ROUTE_ADD = 9
+ZEBRA_IPV6_ROUTE_DELETE = 10
+ZEBRA_REDISTRIBUTE_ADD = 11
+ZEBRA_REDISTRIBUTE_DELETE = 12
+
+ZEBRA_NEXTHOP_IFINDEX = 1
+ZEBRA_NEXTHOP_IPV4 = 3
+ZEBRA_NEXTHOP_IPV6 = 6
+
+ZAPI_MESSAGE_NEXTHOP = 0x01
+ZAPI_MESSAGE_DISTANCE = 0x04
+ZAPI_MESSAGE_METRIC = 0x08
+
+stats = {"connections": 0, "messages": 0, "adds": 0, "deletes": 0,
+         "delete_unknown": 0, "redistribute": 0}
+rib = {}
+
+
+def parse_route(body, ipv6):
+    """Decode a route add/delete sent by the plugin (packet.c)."""
+    alen = 16 if ipv6 else 4
+    rtype, flags, message, plen = body[0], body[1], body[2], body[3]
+    size = (plen + 7) // 8
+    raw = body[4:4 + size] + bytes(alen - size)
+    prefix = ipaddress.ip_network((ipaddress.ip_address(raw), plen), strict=False)
+    pnt = 4 + size
+    nexthops = []
+    if message & ZAPI_MESSAGE_NEXTHOP:
+        count = body[pnt]
+        pnt += 1
+        for _ in range(count):
+            nhtype = body[pnt]
+            pnt += 1
+            if nhtype == ZEBRA_NEXTHOP_IFINDEX:
+                nexthops.append("if%d" % struct.unpack("!I", body[pnt:pnt + 4])[0])
+                pnt += 4
+            elif nhtype == ZEBRA_NEXTHOP_IPV4:
+                nexthops.append(str(ipaddress.IPv4Address(body[pnt:pnt + 4])))
+                pnt += 4
+            elif nhtype == ZEBRA_NEXTHOP_IPV6:
+                nexthops.append(str(ipaddress.IPv6Address(body[pnt:pnt + 16])))
+                pnt += 16
+            else:
+                raise ValueError("unknown nexthop type %d" % nhtype)
+    if message & ZAPI_MESSAGE_DISTANCE:
+        pnt += 1
+    metric = 0
+    if message & ZAPI_MESSAGE_METRIC:
+        metric = struct.unpack("!I", body[pnt:pnt + 4])[0]
+        pnt += 4
+    if pnt != len(body):
+        raise ValueError("route message length mismatch")
+    return str(prefix), ",".join(nexthops), metric, rtype
+
+
+def encode(version, cmd, body):
+    if version:
+        header = struct.pack("!BBH", ZEBRA_HEADER_MARKER, version, cmd)
+    else:
+        header = struct.pack("!B", cmd)
+    return struct.pack("!H", 2 + len(header) + len(body)) + header + body
+
+
+def redistributed_route(args, rtype, prefix):
+    """Route add as parse.c expects it: metric always present."""
+    net = ipaddress.ip_network(prefix, strict=False)
+    size = (net.prefixlen + 7) // 8
+    body = struct.pack("!BBBB", rtype, 0, ZAPI_MESSAGE_METRIC, net.prefixlen)
+    body += net.network_address.packed[:size] + struct.pack("!I", 1)
+    return encode(args.version, ZEBRA_IPV6_ROUTE_ADD if args.ipv6 else ZEBRA_IPV4_ROUTE_ADD, body)
+
+
+def dump(args):
+    if not args.dump:
+        return
+    tmp = args.dump + ".tmp"
+    with open(tmp, "w") as f:
+        for prefix in sorted(rib):
+            f.write("%s %s %d\n" % (prefix, rib[prefix][0], rib[prefix][1]))
+    os.rename(tmp, args.dump)
+
+
+def handle(args, conn, msg):
+    if args.version:
+        marker, version, cmd = struct.unpack("!BBH", msg[2:6])
+        if marker != ZEBRA_HEADER_MARKER or version != args.version:
+            raise ValueError("bad header")
+        body = msg[6:]
+    else:
+        cmd = msg[2]
+        body = msg[3:]
+    stats["messages"] += 1
+
+    if cmd in (ZEBRA_IPV4_ROUTE_ADD, ZEBRA_IPV6_ROUTE_ADD):
+        prefix, nexthop, metric, _ = parse_route(body, cmd == ZEBRA_IPV6_ROUTE_ADD)
+        rib[prefix] = (nexthop, metric)
+        stats["adds"] += 1
+        if args.verbose:
+            print("add %s via %s metric %d" % (prefix, nexthop, metric))
+        dump(args)
+    elif cmd in (ZEBRA_IPV4_ROUTE_DELETE, ZEBRA_IPV6_ROUTE_DELETE):
+        prefix, nexthop, _, _ = parse_route(body, cmd == ZEBRA_IPV6_ROUTE_DELETE)
+        stats["deletes"] += 1
+        if rib.pop(prefix, None) is None:
+            stats["delete_unknown"] += 1
+        if args.verbose:
+            print("delete %s via %s" % (prefix, nexthop))
+        dump(args)
+    elif cmd == ZEBRA_REDISTRIBUTE_ADD:
+        stats["redistribute"] += 1
+        rtype = body[0]
+        if args.verbose:
+            print("redistribute type %d" % rtype)
+        for prefix in args.route:
+            conn.sendall(redistributed_route(args, rtype, prefix))
+    elif cmd == ZEBRA_REDISTRIBUTE_DELETE:
+        if args.verbose:
+            print("redistribute delete type %d" % body[0])
+    elif args.verbose:
+        print("command %d ignored" % cmd)
+
+
+def serve(args, conn):
+    buf = b""
+    messages = 0
+    while True:
+        if args.read_delay:
+            time.sleep(args.read_delay)
+        data = conn.recv(65536)
+        if not data:
+            return
+        buf += data
+        while len(buf) >= 2:
+            length = struct.unpack("!H", buf[:2])[0]
+            if length < 3:
+                raise ValueError("bad message length %d" % length)
+            if len(buf) < length:
+                break
+            handle(args, conn, buf[:length])
+            buf = buf[length:]
+            messages += 1
+            if args.drop_after and messages >= args.drop_after:
+                if args.verbose:
+                    print("dropping connection")
+                return
+
+
+def report(*_):
+    print(" ".join("%s=%d" % kv for kv in stats.items()) + " routes=%d" % len(rib))
+    sys.stdout.flush()
+    sys.exit(0)
+
+
+def main():
+    p = argparse.ArgumentParser(description="zebra stand-in for the olsrd quagga plugin")
+    p.add_argument("--socket", default="/var/run/quagga/zserv.api")
+    p.add_argument("--port", type=int, default=0)
+    p.add_argument("--version", type=int, default=0, choices=(0, 1))
+    p.add_argument("--ipv6", action="store_true")
+    p.add_argument("--route", action="append", default=[])
+    p.add_argument("--dump")
+    p.add_argument("--drop-after", type=int, default=0)
+    p.add_argument("--read-delay", type=float, default=0)
+    p.add_argument("-v", "--verbose", action="store_true")
+    args = p.parse_args()
+
+    signal.signal(signal.SIGTERM, report)
+    signal.signal(signal.SIGINT, report)
+
+    if args.port:
+        srv = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        srv.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        srv.bind(("127.0.0.1", args.port))
+    else:
+        if os.path.exists(args.socket):
+            os.unlink(args.socket)
+        srv = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        srv.bind(args.socket)
+    srv.listen(1)
+
+    while True:
+        conn, _ = srv.accept()
+        stats["connections"] += 1
+        if args.verbose:
+            print("connection %d" % stats["connections"])
+        sys.stdout.flush()
+        try:
+            serve(args, conn)
+        except (ValueError, ConnectionError) as e:
+            print("error: %s" % e)
+        conn.close()
+        sys.stdout.flush()
+
+
+if __name__ == "__main__":
+    main()
@@ -25,15 +25,73 @@
 #include "defs.h"
 #include "olsr.h"
 #include "log.h"
+#include "scheduler.h"
+#include "olsr_cookie.h"
 #include "routing_table.h"
+#include "common/avl.h"
+#include "common/list.h"
 
 #include "common.h"
 #include "quagga.h"
 #include "packet.h"
+#include "parse.h"
 #include "client.h"
 
+/*
+ * Messages to zebra are not written right away. Route changes are
+ * collected per prefix for ZEBRA_FLUSH_INTERVAL, so that a route
+ * that is deleted and added again (or changed several times) by
+ * consecutive SPF runs costs one message, and are then moved into
+ * an output ring which is written whenever the socket accepts data.
+ */
+
+/* route changes of one prefix not sent yet */
+struct zpending {
+  struct avl_node tree_node;
+  struct list_node queue_node;
+  struct olsr_ip_prefix prefix;
+  uint16_t del_len;                    /* delete of the route zebra knows */
+  uint16_t add_len;                    /* latest add */
+  unsigned char del[ZEBRA_ROUTE_PACKET_SIZ];
+  unsigned char add[ZEBRA_ROUTE_PACKET_SIZ];
+};
+
+AVLNODE2STRUCT(tree2zpending, struct zpending, tree_node);
+LISTNODE2STRUCT(queue2zpending, struct zpending, queue_node);
+
+static struct avl_tree zpending_tree;
+static struct list_node zpending_queue;
+static struct olsr_cookie_info *zpending_cookie;
+static struct timer_entry *zflush_timer;
+
+/* output ring */
+static struct {
+  unsigned char *buf;
+  size_t size;
+  size_t head;
+  size_t len;
+} zring;
+
+/* input buffer, may end with a partial message */
+static struct {
+  unsigned char *buf;
+  size_t size;
+  size_t len;
+} zinput;
+
+static struct timer_entry *zreconnect_timer;
+static unsigned int zreconnect_delay = ZEBRA_RECONNECT_MIN;
+static uint32_t zstable_time;
+
 static void *my_realloc(void *, size_t, const char *);
 static void zclient_connect(void);
+static void zclient_connected(void);
+static void zclient_disconnect(void);
+static void zclient_action(int, void *, unsigned int);
+static void zclient_send(void);
+static void zclient_flush(void);
+static void zclient_flush_timer(void *);
+static void zclient_reconnect_timer(void *);
 
 static void *
 my_realloc(void *buf, size_t s, const char *c)
@@ -49,6 +107,37 @@ my_realloc(void *buf, size_t s, const char *c)
   return buf;
 }
 
+static void
+zring_put(const unsigned char *data, size_t len)
+{
+  size_t tail, part;
+
+  if (zring.size - zring.len < len) {
+    /* grow and make the content contiguous again */
+    size_t size = zring.size ? zring.size : BUFSIZE;
+    unsigned char *buf;
+
+    while (size - zring.len < len)
+      size *= 2;
+    buf = olsr_malloc(size, "QUAGGA: Grow output ring");
+    part = zring.size - zring.head < zring.len ? zring.size - zring.head : zring.len;
+    if (zring.len) {
+      memcpy(buf, zring.buf + zring.head, part);
+      memcpy(buf + part, zring.buf, zring.len - part);
+    }
+    free(zring.buf);
+    zring.buf = buf;
+    zring.size = size;
+    zring.head = 0;
+  }
+
+  tail = (zring.head + zring.len) % zring.size;
+  part = zring.size - tail < len ? zring.size - tail : len;
+  memcpy(zring.buf + tail, data, part);
+  memcpy(zring.buf, data + part, len - part);
+  zring.len += len;
+}
+
 static void
 zclient_connect(void)
 {
@@ -59,12 +148,11 @@ zclient_connect(void)
     struct sockaddr_un sun;
   } sockaddr;
 
-  if (close(zebra.sock) < 0)
-    olsr_exit("(QUAGGA) Could not close socket!", EXIT_FAILURE);
   zebra.sock = socket(zebra.port ? AF_INET : AF_UNIX, SOCK_STREAM, 0);
 
   if (zebra.sock < 0)
     olsr_exit("(QUAGGA) Could not create socket!", EXIT_FAILURE);
+  fcntl(zebra.sock, F_SETFL, fcntl(zebra.sock, F_GETFL) | O_NONBLOCK);
 
   memset(&sockaddr, 0, sizeof sockaddr);
 
@@ -79,134 +167,340 @@ zclient_connect(void)
     ret = connect(zebra.sock, (struct sockaddr *)&sockaddr.sun, sizeof sockaddr.sun);
   }
 
-  if (ret < 0)
-    zebra.status &= ~STATUS_CONNECTED;
-  else
-    zebra.status |= STATUS_CONNECTED;
+  if (ret < 0 && errno != EINPROGRESS) {
+    close(zebra.sock);
+    zebra.sock = -1;
+    zclient_disconnect();
+    return;
+  }
 
+  add_olsr_socket(zebra.sock, NULL, &zclient_action, NULL, SP_IMM_READ | SP_IMM_WRITE);
+  if (ret < 0) {
+    /* finished when the socket gets writable */
+    zebra.status |= STATUS_CONNECTING;
+    return;
+  }
+  zclient_connected();
 }
 
-void
-zclient_reconnect(void)
+/* resync zebra with the routing table after (re)connecting */
+static void
+zclient_connected(void)
 {
+  struct list_node *node;
   struct rt_entry *tmp;
 
-  zclient_connect();
-  if (!(zebra.status & STATUS_CONNECTED))
-    return;                     // try again next time
+  OLSR_PRINTF(1, "(QUAGGA) Connected to zebra.\n");
+  zebra.status &= ~STATUS_CONNECTING;
+  zebra.status |= STATUS_CONNECTED;
+  /* the backoff is only reset once the connection proved stable */
+  zstable_time = GET_TIMESTAMP(ZEBRA_RECONNECT_MAX);
+
+  /* the deletes collected meanwhile still refer to routes zebra
+   * may have kept, the adds are sent again below anyway */
+  for (node = zpending_queue.next; node != &zpending_queue; node = node->next)
+    queue2zpending(node)->add_len = 0;
 
   if (zebra.options & OPTION_EXPORT) {
     OLSR_FOR_ALL_RT_ENTRIES(tmp) {
-      zebra_addroute(tmp);
+      if (tmp->rt_best)
+        zebra_addroute(tmp);
     }
     OLSR_FOR_ALL_RT_ENTRIES_END(tmp);
   }
   zebra_redistribute(ZEBRA_REDISTRIBUTE_ADD);
 
+  /* no reason to wait with the resync */
+  zclient_flush();
+
+}
+
+static void
+zclient_disconnect(void)
+{
+  bool was_stable = (zebra.status & STATUS_CONNECTED) && TIMED_OUT(zstable_time);
+
+  if (zebra.sock >= 0) {
+    OLSR_PRINTF(1, "(QUAGGA) Disconnected from zebra.\n");
+    remove_olsr_socket(zebra.sock, NULL, &zclient_action);
+    close(zebra.sock);
+    zebra.sock = -1;
+    /* TODO: Remove HNAs added from redistribution */
+  }
+  zebra.status &= ~(STATUS_CONNECTED | STATUS_CONNECTING);
+  zring.head = zring.len = 0;
+  zinput.len = 0;
+
+  /* exponential backoff, failed connects keep doubling the delay */
+  if (was_stable)
+    zreconnect_delay = ZEBRA_RECONNECT_MIN;
+  olsr_set_timer(&zreconnect_timer, zreconnect_delay, 0, OLSR_TIMER_ONESHOT, &zclient_reconnect_timer, NULL, 0);
+  if (zreconnect_delay < ZEBRA_RECONNECT_MAX)
+    zreconnect_delay *= 2;
+
+}
+
+static void
+zclient_reconnect_timer(void *foo __attribute__ ((unused)))
+{
+
+  zreconnect_timer = NULL;
+  zclient_reconnect();
+
+}
+
+void
+zclient_reconnect(void)
+{
+
+  if (zebra.status & (STATUS_CONNECTED | STATUS_CONNECTING))
+    return;
+  zclient_connect();
+
+}
+
+void
+zclient_init(void)
+{
+
+  avl_init(&zpending_tree, avl_comp_prefix_default);
+  list_head_init(&zpending_queue);
+  zpending_cookie = olsr_alloc_cookie("QUAGGA pending route", OLSR_COOKIE_TYPE_MEMORY);
+  olsr_cookie_set_memory_size(zpending_cookie, sizeof(struct zpending));
+
+  zclient_connect();
+
+}
+
+/* write out everything queued, blocking, and close the connection */
+void
+zclient_fini(void)
+{
+
+  if (!(zebra.status & STATUS_CONNECTED))
+    return;
+
+  zclient_flush();
+  fcntl(zebra.sock, F_SETFL, fcntl(zebra.sock, F_GETFL) & ~O_NONBLOCK);
+  zclient_send();
+
+  remove_olsr_socket(zebra.sock, NULL, &zclient_action);
+  close(zebra.sock);
+  zebra.sock = -1;
+  zebra.status &= ~STATUS_CONNECTED;
+
 }
 
+/* queue a message, it is copied */
 int
 zclient_write(unsigned char *options)
 {
-  unsigned char *pnt;
   uint16_t len;
-  int ret;
 
   if (!(zebra.status & STATUS_CONNECTED))
     return 0;
 
-  pnt = options;
-  memcpy(&len, pnt, sizeof len);
+  memcpy(&len, options, sizeof len);
+  zring_put(options, ntohs(len));
+  enable_olsr_socket(zebra.sock, NULL, &zclient_action, SP_IMM_WRITE);
+
+  return 0;
+}
+
+/* queue a route add or delete for the prefix, coalesced with the
+ * changes of the same prefix not sent yet */
+int
+zclient_route(const struct olsr_ip_prefix *prefix, unsigned char *options, bool add)
+{
+  struct zpending *p;
+  struct avl_node *node;
+  uint16_t len;
+
+  /* routes are all sent again after reconnecting, only deletes
+   * are kept in case zebra still has the route */
+  if (!(zebra.status & STATUS_CONNECTED) && add) {
+    if ((node = avl_find(&zpending_tree, prefix)) != NULL)
+      tree2zpending(node)->add_len = 0;
+    return 0;
+  }
 
+  memcpy(&len, options, sizeof len);
   len = ntohs(len);
 
-  do {
-    ret = write(zebra.sock, pnt, len);
+  if ((node = avl_find(&zpending_tree, prefix)) != NULL) {
+    p = tree2zpending(node);
+  } else {
+    p = olsr_cookie_malloc(zpending_cookie);
+    p->prefix = *prefix;
+    p->tree_node.key = &p->prefix;
+    avl_insert(&zpending_tree, &p->tree_node, AVL_DUP_NO);
+    list_add_before(&zpending_queue, &p->queue_node);
+  }
+
+  if (add) {
+    memcpy(p->add, options, len);
+    p->add_len = len;
+  } else {
+    /* a route added in this window never reached zebra, the
+     * first delete is the one of the route zebra knows about */
+    p->add_len = 0;
+    if (!p->del_len) {
+      memcpy(p->del, options, len);
+      p->del_len = len;
+    }
+  }
+
+  if (!zflush_timer && (zebra.status & STATUS_CONNECTED))
+    zflush_timer = olsr_start_timer(ZEBRA_FLUSH_INTERVAL, 0, OLSR_TIMER_ONESHOT, &zclient_flush_timer, NULL, 0);
+
+  return 0;
+}
+
+static void
+zclient_flush_timer(void *foo __attribute__ ((unused)))
+{
+
+  zflush_timer = NULL;
+  zclient_flush();
+
+}
+
+/* move the coalesced route changes into the output ring */
+static void
+zclient_flush(void)
+{
+  struct zpending *p;
+
+  if (zflush_timer) {
+    olsr_stop_timer(zflush_timer);
+    zflush_timer = NULL;
+  }
+  if (!(zebra.status & STATUS_CONNECTED))
+    return;
+
+  while (!list_is_empty(&zpending_queue)) {
+    p = queue2zpending(zpending_queue.next);
+
+    if (p->del_len)
+      zring_put(p->del, p->del_len);
+    if (p->add_len)
+      zring_put(p->add, p->add_len);
+
+    list_remove(&p->queue_node);
+    avl_delete(&zpending_tree, &p->tree_node);
+    olsr_cookie_free(zpending_cookie, p);
+  }
+  if (zring.len)
+    enable_olsr_socket(zebra.sock, NULL, &zclient_action, SP_IMM_WRITE);
+}
+
+/* write as much of the output ring as the socket takes */
+static void
+zclient_send(void)
+{
+  ssize_t ret;
+
+  while (zring.len) {
+    size_t part = zring.size - zring.head < zring.len ? zring.size - zring.head : zring.len;
+
+    ret = write(zebra.sock, zring.buf + zring.head, part);
     if (ret < 0) {
-      if ((errno == EINTR) || (errno == EAGAIN)) {
-        errno = 0;
-        ret = 0;
+      if (errno == EINTR)
         continue;
-      } else {
-        OLSR_PRINTF(1, "(QUAGGA) Disconnected from zebra.\n");
-        zebra.status &= ~STATUS_CONNECTED;
-        /* TODO: Remove HNAs added from redistribution */
-        free(options);
-        return -1;
-      }
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+        return;
+      zclient_disconnect();
+      return;
     }
-    pnt = pnt + ret;
+    zring.head = (zring.head + ret) % zring.size;
+    zring.len -= ret;
   }
-  while ((len -= ret));
-  free(options);
+  disable_olsr_socket(zebra.sock, NULL, &zclient_action, SP_IMM_WRITE);
+}
+
+static void
+zclient_action(int fd, void *data __attribute__ ((unused)), unsigned int flags)
+{
+
+  if (zebra.status & STATUS_CONNECTING) {
+    int err = 0;
+    socklen_t len = sizeof err;
+
+    if (!(flags & SP_IMM_WRITE))
+      return;
+    if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err) {
+      zclient_disconnect();
+      return;
+    }
+    zclient_connected();
+    return;
+  }
+
+  if (flags & SP_IMM_WRITE) {
+    zclient_send();
+    if (zebra.sock != fd)
+      return;
+  }
+  if (flags & SP_IMM_READ)
+    zparse(NULL);
 
-  return 0;
 }
 
+/* return the complete messages received, or NULL */
 unsigned char *
 zclient_read(ssize_t * size)
 {
   unsigned char *buf;
-  ssize_t bytes, bufsize;
-  uint16_t length, offset;
-  int sockstatus;
+  ssize_t bytes;
+  uint16_t length;
+  size_t offset;
 
-  /* initialize variables */
-  buf = NULL;
-  offset = 0;
   *size = 0;
-  bufsize = 0;
-
-  /* save socket status and set non-blocking for read */
-  sockstatus = fcntl(zebra.sock, F_GETFL);
-  fcntl(zebra.sock, F_SETFL, sockstatus|O_NONBLOCK);
-
-  /* read whole packages */
-  do {
+  if (!(zebra.status & STATUS_CONNECTED))
+    return NULL;
 
+  for (;;) {
     /* (re)allocate buffer */
-    if (*size == bufsize) {
-      bufsize += BUFSIZE;
-      buf = my_realloc(buf, bufsize, "QUAGGA: Grow read buffer");
+    if (zinput.len == zinput.size) {
+      zinput.size += BUFSIZE;
+      zinput.buf = my_realloc(zinput.buf, zinput.size, "QUAGGA: Grow read buffer");
     }
 
     /* read from socket */
-    bytes = read(zebra.sock, buf + *size, bufsize - *size);
-    /* handle broken packet */
-    if (!bytes) {
-      free(buf);
+    bytes = read(zebra.sock, zinput.buf + zinput.len, zinput.size - zinput.len);
+    if (bytes < 0 && errno == EINTR)
+      continue;
+    if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      break;
+    if (bytes <= 0) {
+      // oops - we got disconnected
+      zclient_disconnect();
       return NULL;
     }
-    /* handle no data available */
-    if (bytes < 0) {
-      /* handle disconnect */
-      if (errno != EAGAIN) {    // oops - we got disconnected
-        OLSR_PRINTF(1, "(QUAGGA) Disconnected from zebra\n");
-        zebra.status &= ~STATUS_CONNECTED;
-        /* TODO: Remove HNAs added from redistribution */
-      }
-      free(buf);
-      return NULL;
-    }
-
-    *size += bytes;
+    zinput.len += bytes;
+  }
 
-    /* detect zebra packet fragmentation */
-    do {
-      memcpy(&length, buf + offset, sizeof length);
-      length = ntohs(length);
-      offset += length;
+  /* hand out the complete packets, keep a fragment */
+  offset = 0;
+  while (zinput.len >= offset + sizeof length) {
+    memcpy(&length, zinput.buf + offset, sizeof length);
+    length = ntohs(length);
+    if (length < sizeof length) {
+      zclient_disconnect();
+      return NULL;
     }
-    while (*size >= (ssize_t) (offset + sizeof length));
-    /* set blocking socket on fragmented packet */
-    if (*size != offset)
-      fcntl(zebra.sock, F_SETFL, sockstatus);
-
+    if (zinput.len < offset + length)
+      break;
+    offset += length;
   }
-  while (*size != offset);
-
-  /* restore socket status */
-  fcntl(zebra.sock, F_SETFL, sockstatus);
+  if (!offset)
+    return NULL;
+
+  buf = olsr_malloc(offset, "QUAGGA: Read packets");
+  memcpy(buf, zinput.buf, offset);
+  memmove(zinput.buf, zinput.buf + offset, zinput.len - offset);
+  zinput.len -= offset;
+  *size = offset;
 
   return buf;
 }
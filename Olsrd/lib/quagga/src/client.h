@@ -18,12 +18,23 @@
  * ------------------------------------------------------------------------- */
 
 #define STATUS_CONNECTED 1
+#define STATUS_CONNECTING 2
 
 /* Buffer size */
 #define BUFSIZE 1024
 
+/* Reconnect backoff in ms, doubled after every failure */
+#define ZEBRA_RECONNECT_MIN 1000
+#define ZEBRA_RECONNECT_MAX 64000
+
+/* Changes of a route within this many ms are sent as one */
+#define ZEBRA_FLUSH_INTERVAL 100
+
+void zclient_init(void);
+void zclient_fini(void);
 void zclient_reconnect(void);
 int zclient_write(unsigned char *);
+int zclient_route(const struct olsr_ip_prefix *, unsigned char *, bool);
 unsigned char *zclient_read(ssize_t *);
 
 /*
@@ -24,6 +24,7 @@
 #include "quagga.h"
 #include "plugin.h"
 #include "parse.h"
+#include "client.h"
 
 #define PLUGIN_NAME    "OLSRD quagga plugin"
 #define PLUGIN_VERSION "0.2.2"
@@ -64,7 +65,7 @@ int
 olsrd_plugin_init(void)
 {
 
-  olsr_start_timer(1 * MSEC_PER_SEC, 0, OLSR_TIMER_PERIODIC, &zparse, NULL, 0);
+  zclient_init();
 
   return 0;
 }
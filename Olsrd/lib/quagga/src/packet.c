@@ -23,16 +23,16 @@
 #include "common.h"
 #include "packet.h"
 
-unsigned char
-*zpacket_route(uint16_t cmd, struct zroute *r)
+/* encode into cmdopt, which holds ZEBRA_ROUTE_PACKET_SIZ bytes
+ * for routes with a single nexthop, and return the length */
+uint16_t
+zpacket_route(uint16_t cmd, struct zroute *r, unsigned char *cmdopt)
 {
   int count;
   uint8_t len;
   uint16_t size;
   uint32_t ind, metric;
-  unsigned char *cmdopt, *t;
-
-  cmdopt = olsr_malloc(ZEBRA_MAX_PACKET_SIZ, "QUAGGA: New route packet");
+  unsigned char *t;
 
   t = &cmdopt[2];
   if (zebra.version) {
@@ -85,17 +85,15 @@ unsigned char
   size = htons(t - cmdopt);
   memcpy(cmdopt, &size, sizeof size);
 
-  return cmdopt;
+  return t - cmdopt;
 }
 
-unsigned char
-*zpacket_redistribute (uint16_t cmd, unsigned char type)
+uint16_t
+zpacket_redistribute (uint16_t cmd, unsigned char type, unsigned char *data)
 {
-  unsigned char *data, *pnt;
+  unsigned char *pnt;
   uint16_t size;
 
-  data = olsr_malloc(ZEBRA_MAX_PACKET_SIZ , "QUAGGA: New redistribute packet");
-
   pnt = &data[2];
   if (zebra.version) {
     *pnt++ = ZEBRA_HEADER_MARKER;
@@ -109,7 +107,7 @@ unsigned char
   size = htons(pnt - data);
   memcpy(data, &size, sizeof size);
 
-  return data;
+  return pnt - data;
 }
 
 /*
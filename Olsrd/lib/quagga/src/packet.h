@@ -19,6 +19,8 @@
 
 /* Zebra packet size */
 #define ZEBRA_MAX_PACKET_SIZ		4096
+/* route or redistribute packet of olsrd, at most one nexthop */
+#define ZEBRA_ROUTE_PACKET_SIZ		64
 
 /* Zebra header marker */
 #ifndef ZEBRA_HEADER_MARKER
@@ -61,8 +63,8 @@ struct zroute {
   uint8_t distance;
 };
 
-unsigned char *zpacket_route(uint16_t, struct zroute *);
-unsigned char *zpacket_redistribute(uint16_t, unsigned char);
+uint16_t zpacket_route(uint16_t, struct zroute *, unsigned char *);
+uint16_t zpacket_redistribute(uint16_t, unsigned char, unsigned char *);
 
 /*
  * Local Variables:
@@ -125,10 +125,8 @@ zparse(void *foo __attribute__ ((unused)))
   ssize_t len;
   struct zroute *route;
 
-  if (!(zebra.status & STATUS_CONNECTED)) {
-    zclient_reconnect();
+  if (!(zebra.status & STATUS_CONNECTED))
     return;
-  }
   data = zclient_read(&len);
   if (data) {
     f = data;
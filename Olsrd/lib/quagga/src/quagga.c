@@ -33,6 +33,7 @@ zebra_init(void)
 {
 
   memset(&zebra, 0, sizeof zebra);
+  zebra.sock = -1;
   zebra.sockpath = olsr_malloc(sizeof ZEBRA_SOCKPATH  + 1, "QUAGGA: New socket path");
   strscpy(zebra.sockpath, ZEBRA_SOCKPATH, sizeof ZEBRA_SOCKPATH);
 
@@ -51,13 +52,18 @@ zebra_fini(void)
   }
   zebra_redistribute(ZEBRA_REDISTRIBUTE_DELETE);
 
+  /* send it all before olsrd goes away */
+  zclient_fini();
+
 }
 
 int
 zebra_addroute(const struct rt_entry *r)
 {
   struct zroute route;
-  int retval;
+  union olsr_ip_addr nexthop;
+  uint32_t ifindex;
+  unsigned char packet[ZEBRA_ROUTE_PACKET_SIZ];
 
   route.distance = 0;
   route.type = ZEBRA_ROUTE_OLSR;
@@ -79,11 +85,11 @@ zebra_addroute(const struct rt_entry *r)
         !memcmp(r->rt_best->rtp_nexthop.gateway.v6.s6_addr, r->rt_dst.prefix.v6.s6_addr, sizeof r->rt_best->rtp_nexthop.gateway.v6.s6_addr) &&
         route.prefixlen == 128)) {
     route.ifindex_num++;
-    route.ifindex = olsr_malloc(sizeof *route.ifindex, "QUAGGA: New zebra route ifindex");
+    route.ifindex = &ifindex;
     *route.ifindex = r->rt_best->rtp_nexthop.iif_index;
   } else {
     route.nexthop_num++;
-    route.nexthop = olsr_malloc(sizeof *route.nexthop, "QUAGGA: New zebra route nexthop");
+    route.nexthop = &nexthop;
     if (olsr_cnf->ip_version == AF_INET)
       route.nexthop->v4.s_addr = r->rt_best->rtp_nexthop.gateway.v4.s_addr;
     else
@@ -97,16 +103,18 @@ zebra_addroute(const struct rt_entry *r)
     route.distance = zebra.distance;
   }
 
-  retval = zclient_write(zpacket_route(olsr_cnf->ip_version == AF_INET ? ZEBRA_IPV4_ROUTE_ADD : ZEBRA_IPV6_ROUTE_ADD, &route));
+  zpacket_route(olsr_cnf->ip_version == AF_INET ? ZEBRA_IPV4_ROUTE_ADD : ZEBRA_IPV6_ROUTE_ADD, &route, packet);
 
-  return retval;
+  return zclient_route(&r->rt_dst, packet, true);
 }
 
 int
 zebra_delroute(const struct rt_entry *r)
 {
   struct zroute route;
-  int retval;
+  union olsr_ip_addr nexthop;
+  uint32_t ifindex;
+  unsigned char packet[ZEBRA_ROUTE_PACKET_SIZ];
 
   route.distance = 0;
   route.type = ZEBRA_ROUTE_OLSR;
@@ -128,11 +136,11 @@ zebra_delroute(const struct rt_entry *r)
         !memcmp(r->rt_nexthop.gateway.v6.s6_addr, r->rt_dst.prefix.v6.s6_addr, sizeof r->rt_nexthop.gateway.v6.s6_addr) &&
         route.prefixlen == 128)) {
     route.ifindex_num++;
-    route.ifindex = olsr_malloc(sizeof *route.ifindex, "QUAGGA: New zebra route ifindex");
+    route.ifindex = &ifindex;
     *route.ifindex = r->rt_nexthop.iif_index;
   } else {
     route.nexthop_num++;
-    route.nexthop = olsr_malloc(sizeof *route.nexthop, "QUAGGA: New zebra route nexthop");
+    route.nexthop = &nexthop;
     if (olsr_cnf->ip_version == AF_INET)
       route.nexthop->v4.s_addr = r->rt_nexthop.gateway.v4.s_addr;
     else
@@ -146,20 +154,21 @@ zebra_delroute(const struct rt_entry *r)
     route.distance = zebra.distance;
   }
 
-  retval = zclient_write(zpacket_route(olsr_cnf->ip_version == AF_INET ? ZEBRA_IPV4_ROUTE_DELETE : ZEBRA_IPV6_ROUTE_DELETE, &route));
+  zpacket_route(olsr_cnf->ip_version == AF_INET ? ZEBRA_IPV4_ROUTE_DELETE : ZEBRA_IPV6_ROUTE_DELETE, &route, packet);
 
-  return retval;
+  return zclient_route(&r->rt_dst, packet, false);
 }
 
 void
 zebra_redistribute(uint16_t cmd)
 {
   unsigned char type;
+  unsigned char packet[ZEBRA_ROUTE_PACKET_SIZ];
 
   for (type = 0; type < ZEBRA_ROUTE_MAX; type++)
     if (zebra.redistribute[type]) {
-      if (zclient_write(zpacket_redistribute(cmd, type)) < 0)
-        olsr_exit("(QUAGGA) Could not write redistribute packet!", EXIT_FAILURE);
+      zpacket_redistribute(cmd, type, packet);
+      zclient_write(packet);
     }
 
 }
@@ -69,7 +69,7 @@ my_init(void)
   /* Print plugin info to stdout */
   /* We cannot use olsr_printf yet! */
   printf("%s\n", MOD_DESC);
-  printf("[ENC]Accepted parameter pairs: (\"Keyfile\" <FILENAME>)\n");
+  printf("[ENC]Accepted parameter pairs: (\"Keyfile\" <FILENAME>) (\"Algorithm\" <ALGORITHM>)\n");
 }
 
 /**
@@ -96,8 +96,35 @@ store_string(const char *value, void *data, set_plugin_parameter_addon addon __a
   return 0;
 }
 
+static int
+set_algorithm(const char *value, void *data __attribute__ ((unused)), set_plugin_parameter_addon addon __attribute__ ((unused)))
+{
+#ifdef USE_OPENSSL
+  if (strcasecmp(value, "sha1") == 0) {
+    sig_algorithm = SHA1_INCLUDING_KEY;
+    return 0;
+  }
+  if (strcasecmp(value, "hmac-sha256") == 0) {
+    sig_algorithm = HMAC_SHA256;
+    return 0;
+  }
+#else
+  if (strcasecmp(value, "md5") == 0) {
+    sig_algorithm = MD5_INCLUDING_KEY;
+    return 0;
+  }
+  if (strcasecmp(value, "hmac-sha256") == 0) {
+    fprintf(stderr, "[ENC]hmac-sha256 needs the plugin built with USE_OPENSSL\n");
+    return 1;
+  }
+#endif
+  fprintf(stderr, "[ENC]Unknown algorithm \"%s\"\n", value);
+  return 1;
+}
+
 static const struct olsrd_plugin_parameters plugin_parameters[] = {
   {.name = "keyfile",.set_plugin_parameter = &store_string,.data = keyfile},
+  {.name = "algorithm",.set_plugin_parameter = &set_algorithm,.data = NULL},
 };
 
 void
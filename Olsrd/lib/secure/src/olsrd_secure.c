@@ -46,6 +46,7 @@
  */
 
 #include "olsrd_secure.h"
+#include "secure_digest.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -135,6 +136,7 @@ static struct stamp timestamps[HASHSIZE];
 
 char keyfile[FILENAME_MAX + 1];
 char aes_key[16];
+uint8_t sig_algorithm = SCHEME;
 
 /* Event function to register with the sceduler */
 #if 0
@@ -190,6 +192,7 @@ secure_plugin_init(void)
     olsr_printf(1, "[ENC]There was a problem reading key from file %s. Is the key long enough?\nExitting!\n\n", keyfile);
     exit(1);
   }
+  secure_digest_init((uint8_t *)aes_key);
 
   /* Register the packet transform function */
   add_ptf(&add_signature);
@@ -333,7 +336,7 @@ add_signature(uint8_t * pck, int *size)
 
   /* Fill subheader */
   msg->sig.type = ONE_CHECKSUM;
-  msg->sig.algorithm = SCHEME;
+  msg->sig.algorithm = sig_algorithm;
   memset(&msg->sig.reserved, 0, 2);
 
   /* Add timestamp */
@@ -344,17 +347,8 @@ add_signature(uint8_t * pck, int *size)
   /* Set the new size */
   *size += sizeof(struct s_olsrmsg);
 
-  {
-    uint8_t checksum_cache[512 + KEYLENGTH];
-    /* Create packet + key cache */
-    /* First the OLSR packet + signature message - digest */
-    memcpy(checksum_cache, pck, *size - SIGNATURE_SIZE);
-    /* Then the key */
-    memcpy(&checksum_cache[*size - SIGNATURE_SIZE], aes_key, KEYLENGTH);
-
-    /* Create the hash */
-    CHECKSUM(checksum_cache, (*size - SIGNATURE_SIZE) + KEYLENGTH, &pck[*size - SIGNATURE_SIZE]);
-  }
+  /* Sign the packet and the signature message up to the signature itself */
+  secure_digest(sig_algorithm, (const uint8_t *)pck, *size - SIGNATURE_SIZE, &pck[*size - SIGNATURE_SIZE]);
 
 #ifdef DEBUG
   olsr_printf(1, "Signature message:\n");
@@ -425,35 +419,14 @@ validate_packet(struct interface *olsr_if, const char *pck, int *size)
   }
 
   /* Check scheme and type */
-  switch (sig->sig.type) {
-  case (ONE_CHECKSUM):
-    switch (sig->sig.algorithm) {
-    case (SCHEME):
-      goto one_checksum_SHA;    /* Ahhh... fix this */
-      break;
-
-    }
-    break;
-
-  default:
+  if (sig->sig.type != ONE_CHECKSUM || sig->sig.algorithm != sig_algorithm) {
     olsr_printf(1, "[ENC]Unsupported sceme: %d enc: %d!\n", sig->sig.type, sig->sig.algorithm);
     return 0;
   }
   //olsr_printf(1, "Packet sane...\n");
 
-one_checksum_SHA:
-
-  {
-    uint8_t checksum_cache[512 + KEYLENGTH];
-    /* Create packet + key cache */
-    /* First the OLSR packet + signature message - digest */
-    memcpy(checksum_cache, pck, *size - SIGNATURE_SIZE);
-    /* Then the key */
-    memcpy(&checksum_cache[*size - SIGNATURE_SIZE], aes_key, KEYLENGTH);
-
-    /* generate SHA-1 */
-    CHECKSUM(checksum_cache, *size - SIGNATURE_SIZE + KEYLENGTH, sha1_hash);
-  }
+  /* Digest the received packet the same way to compare the signatures */
+  secure_digest(sig_algorithm, (const uint8_t *)pck, *size - SIGNATURE_SIZE, sha1_hash);
 
 #ifdef DEBUG
   olsr_printf(1, "Recevied hash:\n");
@@ -577,17 +550,8 @@ send_challenge(struct interface *olsr_if, const union olsr_ip_addr *new_host)
 
   olsr_printf(3, "[ENC]Size: %lu\n", (unsigned long)sizeof(struct challengemsg));
 
-  {
-    uint8_t checksum_cache[512 + KEYLENGTH];
-    /* Create packet + key cache */
-    /* First the OLSR packet + signature message - digest */
-    memcpy(checksum_cache, &cmsg, sizeof(struct challengemsg) - SIGNATURE_SIZE);
-    /* Then the key */
-    memcpy(&checksum_cache[sizeof(struct challengemsg) - SIGNATURE_SIZE], aes_key, KEYLENGTH);
-
-    /* Create the hash */
-    CHECKSUM(checksum_cache, (sizeof(struct challengemsg) - SIGNATURE_SIZE) + KEYLENGTH, cmsg.signature);
-  }
+  /* Sign the challenge message with the shared key */
+  secure_digest(sig_algorithm, (const uint8_t *)&cmsg, sizeof(struct challengemsg) - SIGNATURE_SIZE, cmsg.signature);
   olsr_printf(3, "[ENC]Sending timestamp request to %s challenge 0x%x\n", olsr_ip_to_string(&buf, new_host), challenge);
 
   /* Add to buffer */
@@ -642,17 +606,8 @@ parse_cres(struct interface *olsr_if, char *in_msg)
 
   /* Check signature */
 
-  {
-    uint8_t checksum_cache[512 + KEYLENGTH];
-    /* Create packet + key cache */
-    /* First the OLSR packet + signature message - digest */
-    memcpy(checksum_cache, msg, sizeof(struct c_respmsg) - SIGNATURE_SIZE);
-    /* Then the key */
-    memcpy(&checksum_cache[sizeof(struct c_respmsg) - SIGNATURE_SIZE], aes_key, KEYLENGTH);
-
-    /* Create the hash */
-    CHECKSUM(checksum_cache, (sizeof(struct c_respmsg) - SIGNATURE_SIZE) + KEYLENGTH, sha1_hash);
-  }
+  /* Digest the challenge response, the signature field excluded */
+  secure_digest(sig_algorithm, (const uint8_t *)msg, sizeof(struct c_respmsg) - SIGNATURE_SIZE, sha1_hash);
 
   if (memcmp(sha1_hash, &msg->signature, SIGNATURE_SIZE) != 0) {
     olsr_printf(1, "[ENC]Signature missmatch in challenge-response!\n");
@@ -738,17 +693,8 @@ parse_rres(char *in_msg)
 
   /* Check signature */
 
-  {
-    uint8_t checksum_cache[512 + KEYLENGTH];
-    /* Create packet + key cache */
-    /* First the OLSR packet + signature message - digest */
-    memcpy(checksum_cache, msg, sizeof(struct r_respmsg) - SIGNATURE_SIZE);
-    /* Then the key */
-    memcpy(&checksum_cache[sizeof(struct r_respmsg) - SIGNATURE_SIZE], aes_key, KEYLENGTH);
-
-    /* Create the hash */
-    CHECKSUM(checksum_cache, (sizeof(struct r_respmsg) - SIGNATURE_SIZE) + KEYLENGTH, sha1_hash);
-  }
+  /* Digest the response-response, the signature field excluded */
+  secure_digest(sig_algorithm, (const uint8_t *)msg, sizeof(struct r_respmsg) - SIGNATURE_SIZE, sha1_hash);
 
   if (memcmp(sha1_hash, &msg->signature, SIGNATURE_SIZE) != 0) {
     olsr_printf(1, "[ENC]Signature missmatch in response-response!\n");
@@ -854,17 +800,8 @@ parse_challenge(struct interface *olsr_if, char *in_msg)
 
   /* Check signature */
 
-  {
-    uint8_t checksum_cache[512 + KEYLENGTH];
-    /* Create packet + key cache */
-    /* First the OLSR packet + signature message - digest */
-    memcpy(checksum_cache, msg, sizeof(struct challengemsg) - SIGNATURE_SIZE);
-    /* Then the key */
-    memcpy(&checksum_cache[sizeof(struct challengemsg) - SIGNATURE_SIZE], aes_key, KEYLENGTH);
-
-    /* Create the hash */
-    CHECKSUM(checksum_cache, (sizeof(struct challengemsg) - SIGNATURE_SIZE) + KEYLENGTH, sha1_hash);
-  }
+  /* Digest the challenge, the signature field excluded */
+  secure_digest(sig_algorithm, (const uint8_t *)msg, sizeof(struct challengemsg) - SIGNATURE_SIZE, sha1_hash);
   if (memcmp(sha1_hash, &msg->signature, SIGNATURE_SIZE) != 0) {
     olsr_printf(1, "[ENC]Signature missmatch in challenge!\n");
     return 0;
@@ -946,17 +883,7 @@ send_cres(struct interface *olsr_if, union olsr_ip_addr *to, union olsr_ip_addr
 
   /* Now create the digest of the message and the key */
 
-  {
-    uint8_t checksum_cache[512 + KEYLENGTH];
-    /* Create packet + key cache */
-    /* First the OLSR packet + signature message - digest */
-    memcpy(checksum_cache, &crmsg, sizeof(struct c_respmsg) - SIGNATURE_SIZE);
-    /* Then the key */
-    memcpy(&checksum_cache[sizeof(struct c_respmsg) - SIGNATURE_SIZE], aes_key, KEYLENGTH);
-
-    /* Create the hash */
-    CHECKSUM(checksum_cache, (sizeof(struct c_respmsg) - SIGNATURE_SIZE) + KEYLENGTH, crmsg.signature);
-  }
+  secure_digest(sig_algorithm, (const uint8_t *)&crmsg, sizeof(struct c_respmsg) - SIGNATURE_SIZE, crmsg.signature);
 
   olsr_printf(3, "[ENC]Sending challenge response to %s challenge 0x%x\n", olsr_ip_to_string(&buf, to), challenge);
 
@@ -1017,17 +944,7 @@ send_rres(struct interface *olsr_if, union olsr_ip_addr *to, union olsr_ip_addr
 
   /* Now create the digest of the message and the key */
 
-  {
-    uint8_t checksum_cache[512 + KEYLENGTH];
-    /* Create packet + key cache */
-    /* First the OLSR packet + signature message - digest */
-    memcpy(checksum_cache, &rrmsg, sizeof(struct r_respmsg) - SIGNATURE_SIZE);
-    /* Then the key */
-    memcpy(&checksum_cache[sizeof(struct r_respmsg) - SIGNATURE_SIZE], aes_key, KEYLENGTH);
-
-    /* Create the hash */
-    CHECKSUM(checksum_cache, (sizeof(struct r_respmsg) - SIGNATURE_SIZE) + KEYLENGTH, rrmsg.signature);
-  }
+  secure_digest(sig_algorithm, (const uint8_t *)&rrmsg, sizeof(struct r_respmsg) - SIGNATURE_SIZE, rrmsg.signature);
 
   olsr_printf(3, "[ENC]Sending response response to %s\n", olsr_ip_to_string(&buf, to));
 
@@ -54,6 +54,7 @@
 /* Algorithm definitions */
 #define SHA1_INCLUDING_KEY   1
 #define MD5_INCLUDING_KEY   2
+#define HMAC_SHA256         3
 
 #ifdef USE_OPENSSL
 #define SIGNATURE_SIZE 20
@@ -68,6 +69,9 @@
 
 extern char aes_key[16];
 
+/* algorithm of the signatures sent and accepted */
+extern uint8_t sig_algorithm;
+
 /* Seconds of slack allowed */
 #define SLACK 3
 
@@ -0,0 +1,158 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/*
+ * Keyed digests signing the secure OLSR messages. The data is hashed
+ * where it lies, the key is never concatenated to a copy of it.
+ */
+
+#include <string.h>
+
+#include "secure_digest.h"
+
+#ifdef USE_OPENSSL
+
+/*
+ * The low level digest interface (deprecated by OpenSSL 3, but the only
+ * one of the 1.0 in external/openssl as well) keeps the contexts plain
+ * structures that can be copied. libcrypto picks the fastest block
+ * function for the CPU, e.g. the SHA extensions, by itself.
+ */
+#define OPENSSL_SUPPRESS_DEPRECATED
+#include <openssl/sha.h>
+
+/* HMAC contexts after the padded key has been hashed */
+static SHA256_CTX hmac_inner;
+static SHA256_CTX hmac_outer;
+
+#else
+
+#include "md5.h"
+
+#endif
+
+static uint8_t digest_key[KEYLENGTH];
+
+/**
+ *Set the shared key and precompute the keyed contexts
+ *
+ *@param key the KEYLENGTH bytes of the shared key
+ */
+void
+secure_digest_init(const uint8_t *key)
+{
+  memcpy(digest_key, key, KEYLENGTH);
+
+#ifdef USE_OPENSSL
+  {
+    uint8_t pad[SHA256_CBLOCK];
+    unsigned int i;
+
+    /* RFC 2104, the key is shorter than a block */
+    memset(pad, 0, sizeof(pad));
+    memcpy(pad, key, KEYLENGTH);
+
+    for (i = 0; i < sizeof(pad); i++) {
+      pad[i] ^= 0x36;
+    }
+    SHA256_Init(&hmac_inner);
+    SHA256_Update(&hmac_inner, pad, sizeof(pad));
+
+    for (i = 0; i < sizeof(pad); i++) {
+      pad[i] ^= 0x36 ^ 0x5c;
+    }
+    SHA256_Init(&hmac_outer);
+    SHA256_Update(&hmac_outer, pad, sizeof(pad));
+
+    memset(pad, 0, sizeof(pad));
+  }
+#endif
+}
+
+/**
+ *Sign a message
+ *
+ *@param algorithm SCHEME (digest over the data followed by
+ * the key) or HMAC_SHA256 (truncated to SIGNATURE_SIZE)
+ *@param data the message up to the signature
+ *@param len the length of the data
+ *@param sig the SIGNATURE_SIZE bytes to store the signature in
+ */
+void
+secure_digest(uint8_t algorithm __attribute__ ((unused)), const uint8_t *data, size_t len, uint8_t *sig)
+{
+#ifdef USE_OPENSSL
+  if (algorithm == HMAC_SHA256) {
+    SHA256_CTX ctx = hmac_inner;
+    uint8_t hash[SHA256_DIGEST_LENGTH];
+
+    SHA256_Update(&ctx, data, len);
+    SHA256_Final(hash, &ctx);
+
+    ctx = hmac_outer;
+    SHA256_Update(&ctx, hash, sizeof(hash));
+    SHA256_Final(hash, &ctx);
+
+    memcpy(sig, hash, SIGNATURE_SIZE);
+  } else {
+    SHA_CTX ctx;
+
+    SHA1_Init(&ctx);
+    SHA1_Update(&ctx, data, len);
+    SHA1_Update(&ctx, digest_key, KEYLENGTH);
+    SHA1_Final(sig, &ctx);
+  }
+#else
+  MD5_CTX ctx;
+
+  MD5Init(&ctx);
+  MD5Update(&ctx, data, len);
+  MD5Update(&ctx, digest_key, KEYLENGTH);
+  MD5Final(sig, &ctx);
+#endif
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -81,7 +81,8 @@ struct sig_msg {
   uint8_t algorithm;
   uint16_t reserved;
 
-  time_t timestamp;
+  /* 32 bit on the wire, a 64 bit time_t would move the signature */
+  uint32_t timestamp;
   uint8_t signature[SIGSIZE];
 };
 
@@ -134,7 +135,7 @@ struct c_respmsg {
 
   uint32_t destination;
   uint32_t challenge;
-  time_t timestamp;
+  uint32_t timestamp;
 
   uint8_t res_sig[SIGSIZE];
 
@@ -151,7 +152,7 @@ struct r_respmsg {
   uint16_t seqno;
 
   uint32_t destination;
-  time_t timestamp;
+  uint32_t timestamp;
 
   uint8_t res_sig[SIGSIZE];
 
@@ -64,6 +64,8 @@ union olsr_ip_addr txtinfo_accept_ip;
 union olsr_ip_addr txtinfo_listen_ip;
 int ipc_port;
 int nompr;
+int cache_max_age;
+int stream_backlog;
 
 static void my_init(void) __attribute__ ((constructor));
 static void my_fini(void) __attribute__ ((destructor));
@@ -89,6 +91,12 @@ my_init(void)
 
   /* highlite neighbours by default */
   nompr = 0;
+
+  /* re-render cached tables at least once a second */
+  cache_max_age = 1000;
+
+  /* changes queued for a slow /stream client before it is resynced */
+  stream_backlog = 256 * 1024;
 }
 
 /**
@@ -116,6 +124,8 @@ static const struct olsrd_plugin_parameters plugin_parameters[] = {
   {.name = "port",.set_plugin_parameter = &set_plugin_port,.data = &ipc_port},
   {.name = "accept",.set_plugin_parameter = &set_plugin_ipaddress,.data = &txtinfo_accept_ip},
   {.name = "listen",.set_plugin_parameter = &set_plugin_ipaddress,.data = &txtinfo_listen_ip},
+  {.name = "cachemaxage",.set_plugin_parameter = &set_plugin_int,.data = &cache_max_age},
+  {.name = "streambacklog",.set_plugin_parameter = &set_plugin_int,.data = &stream_backlog},
 };
 
 void
@@ -76,9 +76,14 @@
 #include "mid_set.h"
 #include "link_set.h"
 #include "net_olsr.h"
+#include "net_os.h"
 #include "lq_plugin.h"
 #include "common/autobuf.h"
 #include "gateway.h"
+#include "parser.h"
+#include "scheduler.h"
+#include "common/list.h"
+#include "change_notify.h"
 
 #include "olsrd_txtinfo.h"
 #include "olsrd_plugin.h"
@@ -92,12 +97,16 @@ static int ipc_socket;
 /* IPC initialization function */
 static int plugin_ipc_init(void);
 
-static void send_info(unsigned int /*send_what*/, int /*socket*/);
-
 static void ipc_action(int, void *, unsigned int);
 
+static int txtinfo_pcf(int, int, int);
+
 static void ipc_print_neigh(struct autobuf *, bool);
 
+static void ipc_print_1hop(struct autobuf *);
+
+static void ipc_print_2hop(struct autobuf *);
+
 static void ipc_print_link(struct autobuf *);
 
 static void ipc_print_routes(struct autobuf *);
@@ -114,6 +123,24 @@ static void ipc_print_config(struct autobuf *);
 
 static void ipc_print_interface(struct autobuf *);
 
+static void ipc_print_msg_cache(struct autobuf *);
+
+static void ipc_print_msg_stats(struct autobuf *);
+
+struct txtinfo_blob;
+
+struct txtinfo_client;
+
+static void blob_put(struct txtinfo_blob *);
+
+static void txtinfo_client_close(struct txtinfo_client *);
+
+static void txtinfo_client_action(int, void *, unsigned int);
+
+static void txtinfo_request_timeout(void *);
+
+static void txtinfo_check_timeouts(void *);
+
 #define TXT_IPC_BUFSIZE 256
 
 #define SIW_NEIGH 0x0001
@@ -126,19 +153,125 @@ static void ipc_print_interface(struct autobuf *);
 #define SIW_INTERFACE 0x0080
 #define SIW_CONFIG 0x0100
 #define SIW_2HOP 0x0200
+#define SIW_MSGCACHE 0x0400
+#define SIW_MSGSTATS 0x0800
+#define SIW_STREAM 0x1000
 
 /* ALL = neigh link route hna mid topo */
 #define SIW_ALL 0x003F
 
-#define MAX_CLIENTS 3
+/* how long (ms) to wait for a request before sending all tables */
+#define TXT_REQUEST_TIMEOUT 1000
 
-static char *outbuffer[MAX_CLIENTS];
-static size_t outbuffer_size[MAX_CLIENTS];
-static size_t outbuffer_written[MAX_CLIENTS];
-static int outbuffer_socket[MAX_CLIENTS];
-static int outbuffer_count;
+/* how long (ms) a client may stall a reply before it is dropped */
+#define TXT_IDLE_TIMEOUT (15 * MSEC_PER_SEC)
 
-static struct timer_entry *writetimer_entry;
+/* table changes reported through the pcf hook */
+#define TXT_CHG_NEIGH 0x01
+#define TXT_CHG_TOPO 0x02
+#define TXT_CHG_HNA 0x04
+
+/*
+ * A piece of rendered output. Blobs are shared between the section cache
+ * and the connections sending them and are freed with the last reference,
+ * so a section can be re-rendered while an older copy is still being sent.
+ */
+struct txtinfo_blob {
+  int refcount;
+  size_t len;
+  char *data;
+};
+
+/*
+ * One table of the output. The rendered text is kept until one of the
+ * tables it depends on changes, or until it is older than cache_max_age.
+ */
+struct txtinfo_section {
+  unsigned int siw;                    /* SIW_* flag selecting this section */
+  unsigned int changes;                /* TXT_CHG_* flags invalidating it */
+  bool cacheable;                      /* false for counters read on every request */
+  void (*print)(struct autobuf *);
+  struct txtinfo_blob *cached;
+  uint32_t expires;
+};
+
+static struct txtinfo_section sections[] = {
+  {SIW_LINK, TXT_CHG_NEIGH, true, &ipc_print_link, NULL, 0},
+  {SIW_NEIGH, TXT_CHG_NEIGH, true, &ipc_print_1hop, NULL, 0},
+  {SIW_TOPO, TXT_CHG_TOPO, true, &ipc_print_topology, NULL, 0},
+  {SIW_HNA, TXT_CHG_HNA, true, &ipc_print_hna, NULL, 0},
+  {SIW_MID, TXT_CHG_NEIGH | TXT_CHG_TOPO, true, &ipc_print_mid, NULL, 0},
+  {SIW_ROUTE, TXT_CHG_NEIGH | TXT_CHG_TOPO | TXT_CHG_HNA, true, &ipc_print_routes, NULL, 0},
+  {SIW_GATEWAY, TXT_CHG_TOPO | TXT_CHG_HNA, true, &ipc_print_gateway, NULL, 0},
+  {SIW_CONFIG, 0, true, &ipc_print_config, NULL, 0},
+  {SIW_INTERFACE, TXT_CHG_NEIGH, true, &ipc_print_interface, NULL, 0},
+  {SIW_2HOP, TXT_CHG_NEIGH, true, &ipc_print_2hop, NULL, 0},
+  {SIW_MSGCACHE, 0, false, &ipc_print_msg_cache, NULL, 0},
+  {SIW_MSGSTATS, 0, false, &ipc_print_msg_stats, NULL, 0},
+};
+
+#define TXT_SECTIONS (sizeof(sections) / sizeof(*sections))
+
+static char http_header_text[] = "HTTP/1.0 200 OK\nContent-type: text/plain\n\n";
+
+/* never freed: the static reference keeps the count above zero */
+static struct txtinfo_blob http_header = { 1, sizeof(http_header_text) - 1, http_header_text };
+
+/*
+ * Topology stream ("/stream"): a snapshot of links, TC edges, routes,
+ * HNA and MID entries, followed by one record per change. Every record
+ * starts with a header in network byte order:
+ *
+ *   uint16 length     of the whole record
+ *   uint8  type       enum olsr_change_type, or STREAM_* below
+ *   uint8  prefix     prefix length (routes, HNA)
+ *   uint32 seqno      number of changes seen by the plugin so far
+ *   uint32 cost       link cost, or the format version for SNAPSHOT_BEGIN
+ *   uint32 hops       hopcount (routes), or the IP version for SNAPSHOT_BEGIN
+ *
+ * followed by the two addresses of struct olsr_change, except for the
+ * STREAM_* records. A client that cannot keep up gets no more changes;
+ * once it has read everything queued, it gets a RESYNC record and a
+ * new snapshot.
+ */
+#define STREAM_VERSION 1
+#define STREAM_SNAPSHOT_BEGIN 0x80
+#define STREAM_SNAPSHOT_END 0x81
+#define STREAM_RESYNC 0x82
+#define STREAM_HDR_LEN 16
+
+static char stream_header_text[] = "HTTP/1.0 200 OK\nContent-type: application/octet-stream\n\n";
+
+static uint32_t stream_seqno;
+static int stream_clients;
+
+/* A connection, first reading its request and then sending the reply */
+struct txtinfo_client {
+  struct list_node node;
+  int fd;
+  struct timer_entry *request_timer;
+  uint32_t timeout;                    /* closed if no output is taken until then */
+  char request[128];
+  size_t request_len;
+  struct txtinfo_blob *parts[1 + TXT_SECTIONS];
+  unsigned int part_count;
+  unsigned int part_current;
+  size_t part_offset;
+
+  /* topology stream */
+  bool streaming;
+  bool stream_resync;                  /* stopped queueing, snapshot follows when drained */
+  bool stream_writing;                 /* SP_IMM_WRITE enabled */
+  struct autobuf stream;               /* queued records */
+  int stream_offset;                   /* bytes of 'stream' already sent */
+  int stream_limit;                    /* maximum of queued bytes */
+};
+
+LISTNODE2STRUCT(list2client, struct txtinfo_client, node);
+
+static struct list_node client_head;
+
+static struct timer_entry *timeout_timer;
 
 /**
  *Do initialization here
@@ -151,8 +284,11 @@ olsrd_plugin_init(void)
 {
   /* Initial IPC value */
   ipc_socket = -1;
+  list_head_init(&client_head);
 
   plugin_ipc_init();
+  register_pcf(&txtinfo_pcf);
+  timeout_timer = olsr_start_timer(MSEC_PER_SEC, 0, OLSR_TIMER_PERIODIC, &txtinfo_check_timeouts, NULL, 0);
   return 1;
 }
 
@@ -162,8 +298,21 @@ olsrd_plugin_init(void)
 void
 olsr_plugin_exit(void)
 {
+  unsigned int i;
+
   if (ipc_socket != -1)
     close(ipc_socket);
+
+  olsr_stop_timer(timeout_timer);
+  while (!list_is_empty(&client_head)) {
+    txtinfo_client_close(list2client(client_head.next));
+  }
+  for (i = 0; i < TXT_SECTIONS; i++) {
+    if (sections[i].cached != NULL) {
+      blob_put(sections[i].cached);
+      sections[i].cached = NULL;
+    }
+  }
 }
 
 static int
@@ -223,7 +372,7 @@ plugin_ipc_init(void)
     }
 
     /* show that we are willing to listen */
-    if (listen(ipc_socket, 1) == -1) {
+    if (listen(ipc_socket, SOMAXCONN) == -1) {
 #ifndef NODEBUG
       olsr_printf(1, "(TXTINFO) listen()=%s\n", strerror(errno));
 #endif
@@ -246,9 +395,7 @@ ipc_action(int fd, void *data __attribute__ ((unused)), unsigned int flags __att
   union olsr_sockaddr pin;
 
   char addr[INET6_ADDRSTRLEN];
-  fd_set rfds;
-  struct timeval tv;
-  unsigned int send_what = 0;
+  struct txtinfo_client *client;
   int ipc_connection;
 
   socklen_t addrlen = sizeof(pin);
@@ -260,7 +407,6 @@ ipc_action(int fd, void *data __attribute__ ((unused)), unsigned int flags __att
     return;
   }
 
-  tv.tv_sec = tv.tv_usec = 0;
   if (olsr_cnf->ip_version == AF_INET) {
     if (inet_ntop(olsr_cnf->ip_version, &pin.in4.sin_addr, addr, INET6_ADDRSTRLEN) == NULL)
       addr[0] = '\0';
@@ -290,41 +436,55 @@ ipc_action(int fd, void *data __attribute__ ((unused)), unsigned int flags __att
   olsr_printf(2, "(TXTINFO) Connect from %s\n", addr);
 #endif
 
-  /* purge read buffer to prevent blocking on linux */
-  FD_ZERO(&rfds);
-  FD_SET((unsigned int)ipc_connection, &rfds);  /* Win32 needs the cast here */
-  if (0 <= select(ipc_connection + 1, &rfds, NULL, NULL, &tv)) {
-    char requ[128];
-    ssize_t s = recv(ipc_connection, (void *)&requ, sizeof(requ), 0);   /* Win32 needs the cast here */
-    if (0 < s) {
-      requ[s] = 0;
-      /* To print out neighbours only on the Freifunk Status
-       * page the normal output is somewhat lengthy. The
-       * header parsing is sufficient for standard wget.
-       */
-      if (0 != strstr(requ, "/neighbours")) send_what = SIW_NEIGH | SIW_LINK;
-      else {
-        /* print out every combinations of requested tabled
-         * 3++ letter abbreviations are matched */
-        if (0 != strstr(requ, "/all")) send_what = SIW_ALL;
-        else { /*already included in /all*/
-          if (0 != strstr(requ, "/nei")) send_what |= SIW_NEIGH;
-          if (0 != strstr(requ, "/lin")) send_what |= SIW_LINK;
-          if (0 != strstr(requ, "/rou")) send_what |= SIW_ROUTE;
-          if (0 != strstr(requ, "/hna")) send_what |= SIW_HNA;
-          if (0 != strstr(requ, "/mid")) send_what |= SIW_MID;
-          if (0 != strstr(requ, "/top")) send_what |= SIW_TOPO;
-        }
-        if (0 != strstr(requ, "/gat")) send_what |= SIW_GATEWAY;
-        if (0 != strstr(requ, "/con")) send_what |= SIW_CONFIG;
-        if (0 != strstr(requ, "/int")) send_what |= SIW_INTERFACE;
-        if (0 != strstr(requ, "/2ho")) send_what |= SIW_2HOP;
-      }
-    }
-    if ( send_what == 0 ) send_what = SIW_ALL;
+  if (olsr_set_nonblocking(ipc_connection) == -1) {
+    close(ipc_connection);
+    return;
   }
 
-  send_info(send_what, ipc_connection);
+  client = olsr_malloc(sizeof(*client), "txtinfo client");
+  client->fd = ipc_connection;
+  client->timeout = GET_TIMESTAMP(TXT_IDLE_TIMEOUT);
+  list_add_before(&client_head, &client->node);
+
+  /* wait for the request; clients sending none get all tables */
+  add_olsr_socket(ipc_connection, NULL, &txtinfo_client_action, client, SP_IMM_READ);
+  client->request_timer = olsr_start_timer(TXT_REQUEST_TIMEOUT, 0, OLSR_TIMER_ONESHOT,
+                                           &txtinfo_request_timeout, client, NULL);
+}
+
+static unsigned int
+txtinfo_parse_request(const char *requ)
+{
+  unsigned int send_what = 0;
+
+  if (0 != strstr(requ, "/stream")) return SIW_STREAM;
+
+  /* To print out neighbours only on the Freifunk Status
+   * page the normal output is somewhat lengthy. The
+   * header parsing is sufficient for standard wget.
+   */
+  if (0 != strstr(requ, "/neighbours")) send_what = SIW_NEIGH | SIW_LINK;
+  else {
+    /* print out every combinations of requested tabled
+     * 3++ letter abbreviations are matched */
+    if (0 != strstr(requ, "/all")) send_what = SIW_ALL;
+    else { /*already included in /all*/
+      if (0 != strstr(requ, "/nei")) send_what |= SIW_NEIGH;
+      if (0 != strstr(requ, "/lin")) send_what |= SIW_LINK;
+      if (0 != strstr(requ, "/rou")) send_what |= SIW_ROUTE;
+      if (0 != strstr(requ, "/hna")) send_what |= SIW_HNA;
+      if (0 != strstr(requ, "/mid")) send_what |= SIW_MID;
+      if (0 != strstr(requ, "/top")) send_what |= SIW_TOPO;
+    }
+    if (0 != strstr(requ, "/gat")) send_what |= SIW_GATEWAY;
+    if (0 != strstr(requ, "/con")) send_what |= SIW_CONFIG;
+    if (0 != strstr(requ, "/int")) send_what |= SIW_INTERFACE;
+    if (0 != strstr(requ, "/2ho")) send_what |= SIW_2HOP;
+    if (0 != strstr(requ, "/cac")) send_what |= SIW_MSGCACHE;
+    if (0 != strstr(requ, "/msg")) send_what |= SIW_MSGSTATS;
+  }
+  if ( send_what == 0 ) send_what = SIW_ALL;
+  return send_what;
 }
 
 static void
@@ -357,6 +517,18 @@ ipc_print_neigh(struct autobuf *abuf, bool list_2hop)
   abuf_puts(abuf, "\n");
 }
 
+static void
+ipc_print_1hop(struct autobuf *abuf)
+{
+  ipc_print_neigh(abuf, false);
+}
+
+static void
+ipc_print_2hop(struct autobuf *abuf)
+{
+  ipc_print_neigh(abuf, true);
+}
+
 static void
 ipc_print_link(struct autobuf *abuf)
 {
@@ -645,106 +817,440 @@ ipc_print_interface(struct autobuf *abuf)
   abuf_puts(abuf, "\n");
 }
 
+static void
+ipc_print_msg_cache(struct autobuf *abuf)
+{
+  int i;
+
+  abuf_puts(abuf, "Table: Message cache\nType\tHits\tRebuilds\n");
+  for (i = 0; i < MSG_CACHE_TYPES; i++) {
+    abuf_appendf(abuf, "%s\t%u\t%u\n", olsr_msg_cache_type_to_string(i),
+                 msg_cache_stats[i].hits, msg_cache_stats[i].rebuilds);
+  }
+  abuf_puts(abuf, "\n");
+}
+
+static void
+ipc_print_msg_stats(struct autobuf *abuf)
+{
+  int i;
+
+  abuf_puts(abuf, "Table: Messages\nType\tMessages\tBytes\tDuplicates\tForwarded\tInvalid\tHandler wall usec/msg\n");
+  for (i = 0; i < 256; i++) {
+    const struct olsr_msgtype_stats *stats = &olsr_msgtype_stats[i];
+
+    if (stats->messages == 0 && stats->dropped_invalid == 0) {
+      continue;
+    }
+    abuf_appendf(abuf, "%s\t%u\t%llu\t%u\t%u\t%u\t%.1f\n", olsr_msgtype_to_string(i),
+                 stats->messages, (unsigned long long)stats->bytes, stats->duplicates, stats->forwarded,
+                 stats->dropped_invalid, stats->handler_samples ? (double)stats->handler_usec / stats->handler_samples : 0.0);
+  }
+  abuf_puts(abuf, "\n");
+}
+
+
+static struct txtinfo_blob *
+blob_get(struct txtinfo_blob *blob)
+{
+  blob->refcount++;
+  return blob;
+}
 
 static void
-txtinfo_write_data(void *foo __attribute__ ((unused))) {
-  fd_set set;
-  int result, i, j, max;
-  struct timeval tv;
+blob_put(struct txtinfo_blob *blob)
+{
+  if (--blob->refcount == 0) {
+    free(blob->data);
+    free(blob);
+  }
+}
 
-  FD_ZERO(&set);
-  max = 0;
-  for (i=0; i<outbuffer_count; i++) {
-    /* And we cast here since we get a warning on Win32 */
-    FD_SET((unsigned int)(outbuffer_socket[i]), &set);
+/*
+ * Get the text of a section, rendering it only if there is no
+ * valid cached copy. Returns a new reference.
+ */
+static struct txtinfo_blob *
+txtinfo_render(struct txtinfo_section *section)
+{
+  struct autobuf abuf;
+  struct txtinfo_blob *blob;
 
-    if (outbuffer_socket[i] > max) {
-      max = outbuffer_socket[i];
+  if (section->cached != NULL) {
+    if (!TIMED_OUT(section->expires)) {
+      return blob_get(section->cached);
     }
+    blob_put(section->cached);
+    section->cached = NULL;
   }
 
-  tv.tv_sec = 0;
-  tv.tv_usec = 0;
+  abuf_init(&abuf, 4096);
+  section->print(&abuf);
+
+  /* take over the autobuf memory instead of copying it */
+  blob = olsr_malloc(sizeof(*blob), "txtinfo blob");
+  blob->refcount = 1;
+  blob->len = abuf.len;
+  blob->data = abuf.buf;
 
-  result = select(max + 1, NULL, &set, NULL, &tv);
-  if (result <= 0) {
-    return;
+  if (section->cacheable && cache_max_age > 0) {
+    section->cached = blob_get(blob);
+    section->expires = GET_TIMESTAMP(cache_max_age);
+  }
+  return blob;
+}
+
+/* drop the cached sections depending on the tables that changed */
+static int
+txtinfo_pcf(int neigh_changed, int topo_changed, int hna_changed)
+{
+  unsigned int changes = 0;
+  unsigned int i;
+
+  if (neigh_changed) changes |= TXT_CHG_NEIGH;
+  if (topo_changed) changes |= TXT_CHG_TOPO;
+  if (hna_changed) changes |= TXT_CHG_HNA;
+
+  for (i = 0; i < TXT_SECTIONS; i++) {
+    if (sections[i].cached != NULL && (sections[i].changes & changes) != 0) {
+      blob_put(sections[i].cached);
+      sections[i].cached = NULL;
+    }
   }
+  return 0;
+}
+
+static void
+stream_put_record(struct autobuf *abuf, uint8_t type, uint8_t prefix_len, uint32_t cost, uint32_t hops,
+                  const union olsr_ip_addr *addr1, const union olsr_ip_addr *addr2)
+{
+  uint8_t record[STREAM_HDR_LEN + 2 * sizeof(union olsr_ip_addr)];
+  uint16_t len = STREAM_HDR_LEN;
+  uint16_t net16;
+  uint32_t net32;
+
+  if (addr1 != NULL) {
+    memcpy(record + len, addr1, olsr_cnf->ipsize);
+    memcpy(record + len + olsr_cnf->ipsize, addr2, olsr_cnf->ipsize);
+    len += 2 * olsr_cnf->ipsize;
+  }
+
+  net16 = htons(len);
+  memcpy(record, &net16, sizeof(net16));
+  record[2] = type;
+  record[3] = prefix_len;
+  net32 = htonl(stream_seqno);
+  memcpy(record + 4, &net32, sizeof(net32));
+  net32 = htonl(cost);
+  memcpy(record + 8, &net32, sizeof(net32));
+  net32 = htonl(hops);
+  memcpy(record + 12, &net32, sizeof(net32));
+
+  abuf_memcpy(abuf, record, len);
+}
 
-  for (i=0; i<outbuffer_count; i++) {
-    if (FD_ISSET(outbuffer_socket[i], &set)) {
-      result = send(outbuffer_socket[i], outbuffer[i] + outbuffer_written[i], outbuffer_size[i] - outbuffer_written[i], 0);
-      if (result > 0) {
-        outbuffer_written[i] += result;
+static void
+stream_put_snapshot(struct autobuf *abuf)
+{
+  struct link_entry *link;
+  struct tc_entry *tc;
+  struct rt_entry *rt;
+  struct hna_entry *hna;
+  struct mid_entry *mid;
+  int idx;
+
+  stream_put_record(abuf, STREAM_SNAPSHOT_BEGIN, 0, STREAM_VERSION, olsr_cnf->ip_version == AF_INET ? 4 : 6, NULL, NULL);
+
+  OLSR_FOR_ALL_LINK_ENTRIES(link) {
+    stream_put_record(abuf, OLSR_CHG_LINK_ADD, 0, link->linkcost, 0, &link->local_iface_addr, &link->neighbor_iface_addr);
+  } OLSR_FOR_ALL_LINK_ENTRIES_END(link);
+
+  OLSR_FOR_ALL_TC_ENTRIES(tc) {
+    struct tc_edge_entry *tc_edge;
+    OLSR_FOR_ALL_TC_EDGE_ENTRIES(tc, tc_edge) {
+      stream_put_record(abuf, OLSR_CHG_TC_EDGE_ADD, 0, tc_edge->cost, 0, &tc->addr, &tc_edge->T_dest_addr);
+    } OLSR_FOR_ALL_TC_EDGE_ENTRIES_END(tc, tc_edge);
+  } OLSR_FOR_ALL_TC_ENTRIES_END(tc);
+
+  OLSR_FOR_ALL_RT_ENTRIES(rt) {
+    if (rt->rt_best != NULL) {
+      stream_put_record(abuf, OLSR_CHG_ROUTE_ADD, rt->rt_dst.prefix_len, rt->rt_best->rtp_metric.cost,
+                        rt->rt_best->rtp_metric.hops, &rt->rt_dst.prefix, &rt->rt_best->rtp_nexthop.gateway);
+    }
+  } OLSR_FOR_ALL_RT_ENTRIES_END(rt);
+
+  OLSR_FOR_ALL_HNA_ENTRIES(hna) {
+    struct hna_net *net;
+    for (net = hna->networks.next; net != &hna->networks; net = net->next) {
+      stream_put_record(abuf, OLSR_CHG_HNA_ADD, net->hna_prefix.prefix_len, 0, 0, &net->hna_prefix.prefix, &hna->A_gateway_addr);
+    }
+  } OLSR_FOR_ALL_HNA_ENTRIES_END(hna);
+
+  for (idx = 0; idx < HASHSIZE; idx++) {
+    for (mid = mid_set[idx].next; mid != &mid_set[idx]; mid = mid->next) {
+      struct mid_address *alias;
+      for (alias = mid->aliases; alias != NULL; alias = alias->next_alias) {
+        stream_put_record(abuf, OLSR_CHG_MID_ADD, 0, 0, 0, &mid->main_addr, &alias->alias);
       }
+    }
+  }
 
-      if (result <= 0 || outbuffer_written[i] == outbuffer_size[i]) {
-        /* close this socket and cleanup*/
-        close(outbuffer_socket[i]);
-        free (outbuffer[i]);
+  stream_put_record(abuf, STREAM_SNAPSHOT_END, 0, 0, 0, NULL, NULL);
+}
+
+static void
+stream_want_write(struct txtinfo_client *client, bool enable)
+{
+  if (client->stream_writing != enable) {
+    client->stream_writing = enable;
+    if (enable) {
+      client->timeout = GET_TIMESTAMP(TXT_IDLE_TIMEOUT);
+      enable_olsr_socket(client->fd, NULL, &txtinfo_client_action, SP_IMM_WRITE);
+    } else {
+      disable_olsr_socket(client->fd, NULL, &txtinfo_client_action, SP_IMM_WRITE);
+    }
+  }
+}
+
+/* queue a record for every streaming client that keeps up */
+static void
+txtinfo_stream_change(const struct olsr_change *change)
+{
+  struct list_node *node;
+
+  stream_seqno++;
+
+  for (node = client_head.next; node != &client_head; node = node->next) {
+    struct txtinfo_client *client = list2client(node);
+
+    if (!client->streaming || client->stream_resync) {
+      continue;
+    }
+    if (client->stream.len - client->stream_offset + STREAM_HDR_LEN + 2 * (int)olsr_cnf->ipsize > client->stream_limit) {
+      client->stream_resync = true;
+      continue;
+    }
+    stream_put_record(&client->stream, change->type, change->prefix_len, change->cost, change->hops,
+                      change->addr1, change->addr2);
+    stream_want_write(client, true);
+  }
+}
 
-        for (j=i+1; j<outbuffer_count; j++) {
-          outbuffer[j-1] = outbuffer[j];
-          outbuffer_size[j-1] = outbuffer_size[j];
-          outbuffer_socket[j-1] = outbuffer_socket[j];
-          outbuffer_written[j-1] = outbuffer_written[j];
+/* send queued records; start over with a snapshot after an overflow */
+static void
+txtinfo_stream_write(struct txtinfo_client *client)
+{
+  for (;;) {
+    while (client->stream_offset < client->stream.len) {
+      ssize_t result = send(client->fd, client->stream.buf + client->stream_offset,
+                            client->stream.len - client->stream_offset, 0);
+      if (result < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+          return;
         }
-        outbuffer_count--;
+        txtinfo_client_close(client);
+        return;
       }
+      client->stream_offset += result;
+      client->timeout = GET_TIMESTAMP(TXT_IDLE_TIMEOUT);
+    }
+    client->stream.len = 0;
+    client->stream_offset = 0;
+
+    if (!client->stream_resync) {
+      break;
     }
+    client->stream_resync = false;
+    stream_put_record(&client->stream, STREAM_RESYNC, 0, 0, 0, NULL, NULL);
+    stream_put_snapshot(&client->stream);
+    client->stream_limit = client->stream.len + stream_backlog;
   }
-  if (outbuffer_count == 0) {
-    olsr_stop_timer(writetimer_entry);
+  stream_want_write(client, false);
+}
+
+static void
+txtinfo_stream_start(struct txtinfo_client *client)
+{
+  client->streaming = true;
+  abuf_init(&client->stream, 4096);
+  abuf_puts(&client->stream, stream_header_text);
+  stream_put_snapshot(&client->stream);
+  client->stream_limit = client->stream.len + stream_backlog;
+
+  if (stream_clients++ == 0) {
+    olsr_add_change_handler(&txtinfo_stream_change);
   }
+
+  /* SP_IMM_READ stays enabled to notice when the client goes away */
+  stream_want_write(client, true);
+  txtinfo_stream_write(client);
 }
 
 static void
-send_info(unsigned int send_what, int the_socket)
+txtinfo_client_close(struct txtinfo_client *client)
 {
-  struct autobuf abuf;
+  unsigned int i;
 
-  abuf_init(&abuf, 4096);
+  if (client->request_timer != NULL) {
+    olsr_stop_timer(client->request_timer);
+  }
+  if (client->streaming) {
+    abuf_free(&client->stream);
+    if (--stream_clients == 0) {
+      olsr_remove_change_handler(&txtinfo_stream_change);
+    }
+  }
+  remove_olsr_socket(client->fd, NULL, &txtinfo_client_action);
+  close(client->fd);
+
+  for (i = 0; i < client->part_count; i++) {
+    blob_put(client->parts[i]);
+  }
+  list_remove(&client->node);
+  free(client);
+}
+
+/* send as much of the reply as the socket takes, close when done */
+static void
+txtinfo_client_write(struct txtinfo_client *client)
+{
+  while (client->part_current < client->part_count) {
+    struct txtinfo_blob *part = client->parts[client->part_current];
+
+    if (client->part_offset < part->len) {
+      ssize_t result = send(client->fd, part->data + client->part_offset, part->len - client->part_offset, 0);
+      if (result < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+          /* wait until the socket is writable again */
+          return;
+        }
+        break;
+      }
+      client->part_offset += result;
+      client->timeout = GET_TIMESTAMP(TXT_IDLE_TIMEOUT);
+      if (client->part_offset < part->len) {
+        continue;
+      }
+    }
+    client->part_current++;
+    client->part_offset = 0;
+  }
+  txtinfo_client_close(client);
+}
+
+static void
+txtinfo_client_reply(struct txtinfo_client *client, unsigned int send_what)
+{
+  unsigned int i;
+
+  if (client->request_timer != NULL) {
+    olsr_stop_timer(client->request_timer);
+    client->request_timer = NULL;
+  }
+
+  if (send_what == SIW_STREAM) {
+    txtinfo_stream_start(client);
+    return;
+  }
 
   /* Print minimal http header */
-  abuf_puts(&abuf, "HTTP/1.0 200 OK\n");
-  abuf_puts(&abuf, "Content-type: text/plain\n\n");
+  client->parts[client->part_count++] = blob_get(&http_header);
 
   /* Print tables to IPC socket */
+  for (i = 0; i < TXT_SECTIONS; i++) {
+    if ((send_what & sections[i].siw) == sections[i].siw) {
+      client->parts[client->part_count++] = txtinfo_render(&sections[i]);
+    }
+  }
 
-  /* links */
-  if ((send_what & SIW_LINK) == SIW_LINK) ipc_print_link(&abuf);
-  /* neighbours */
-  if ((send_what & SIW_NEIGH) == SIW_NEIGH) ipc_print_neigh(&abuf,false);
-  /* topology */
-  if ((send_what & SIW_TOPO) == SIW_TOPO) ipc_print_topology(&abuf);
-  /* hna */
-  if ((send_what & SIW_HNA) == SIW_HNA) ipc_print_hna(&abuf);
-  /* mid */
-  if ((send_what & SIW_MID) == SIW_MID) ipc_print_mid(&abuf);
-  /* routes */
-  if ((send_what & SIW_ROUTE) == SIW_ROUTE) ipc_print_routes(&abuf);
-  /* gateways */
-  if ((send_what & SIW_GATEWAY) == SIW_GATEWAY) ipc_print_gateway(&abuf);
-  /* config */
-  if ((send_what & SIW_CONFIG) == SIW_CONFIG) ipc_print_config(&abuf);
-  /* interface */
-  if ((send_what & SIW_INTERFACE) == SIW_INTERFACE) ipc_print_interface(&abuf);
-  /* 2hop neighbour list */
-  if ((send_what & SIW_2HOP) == SIW_2HOP) ipc_print_neigh(&abuf,true);
-
-  outbuffer[outbuffer_count] = olsr_malloc(abuf.len, "txt output buffer");
-  outbuffer_size[outbuffer_count] = abuf.len;
-  outbuffer_written[outbuffer_count] = 0;
-  outbuffer_socket[outbuffer_count] = the_socket;
-
-  memcpy(outbuffer[outbuffer_count], abuf.buf, abuf.len);
-  outbuffer_count++;
-
-  if (outbuffer_count == 1) {
-    writetimer_entry = olsr_start_timer(100, 0, OLSR_TIMER_PERIODIC, &txtinfo_write_data, NULL, 0);
-  }
-
-  abuf_free(&abuf);
+  disable_olsr_socket(client->fd, NULL, &txtinfo_client_action, SP_IMM_READ);
+  enable_olsr_socket(client->fd, NULL, &txtinfo_client_action, SP_IMM_WRITE);
+  client->timeout = GET_TIMESTAMP(TXT_IDLE_TIMEOUT);
+  txtinfo_client_write(client);
+}
+
+static void
+txtinfo_request_timeout(void *context)
+{
+  struct txtinfo_client *client = context;
+
+  /* the scheduler removes the one-shot timer after this callback */
+  client->request_timer = NULL;
+
+  client->request[client->request_len] = 0;
+  txtinfo_client_reply(client, txtinfo_parse_request(client->request));
+}
+
+/* drop clients that stopped reading; idle streams have nothing to send */
+static void
+txtinfo_check_timeouts(void *context __attribute__ ((unused)))
+{
+  struct list_node *node, *next;
+
+  for (node = client_head.next; node != &client_head; node = next) {
+    struct txtinfo_client *client = list2client(node);
+
+    next = node->next;
+    if (client->streaming && !client->stream_writing) {
+      continue;
+    }
+    if (TIMED_OUT(client->timeout)) {
+      txtinfo_client_close(client);
+    }
+  }
+}
+
+static void
+txtinfo_client_action(int fd, void *data, unsigned int flags)
+{
+  struct txtinfo_client *client = data;
+
+  if (client->streaming) {
+    if ((flags & SP_IMM_READ) != 0) {
+      char discard[128];
+      ssize_t s = recv(fd, (void *)discard, sizeof(discard), 0);   /* Win32 needs the cast here */
+      if (s == 0 || (s < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        txtinfo_client_close(client);
+        return;
+      }
+    }
+    if ((flags & SP_IMM_WRITE) != 0) {
+      txtinfo_stream_write(client);
+    }
+    return;
+  }
+
+  if (client->part_count > 0) {
+    if ((flags & SP_IMM_WRITE) != 0) {
+      txtinfo_client_write(client);
+    }
+    return;
+  }
+
+  if ((flags & SP_IMM_READ) != 0) {
+    ssize_t s = recv(fd, (void *)(client->request + client->request_len),
+                     sizeof(client->request) - 1 - client->request_len, 0);   /* Win32 needs the cast here */
+    if (s < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+      return;
+    }
+    if (s == 0 && client->request_len > 0) {
+      /* the client shut down its side after the request, answer it anyway */
+      txtinfo_client_reply(client, txtinfo_parse_request(client->request));
+      return;
+    }
+    if (s <= 0) {
+      /* client went away before asking for anything */
+      txtinfo_client_close(client);
+      return;
+    }
+    client->request_len += s;
+    client->request[client->request_len] = 0;
+
+    /* the first line carries the request */
+    if (strchr(client->request, '\n') != NULL || client->request_len == sizeof(client->request) - 1) {
+      txtinfo_client_reply(client, txtinfo_parse_request(client->request));
+    }
+  }
 }
 
 /*
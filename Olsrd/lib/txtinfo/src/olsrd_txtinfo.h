@@ -61,6 +61,8 @@ extern union olsr_ip_addr txtinfo_accept_ip;
 extern union olsr_ip_addr txtinfo_listen_ip;
 extern int ipc_port;
 extern int nompr;
+extern int cache_max_age;
+extern int stream_backlog;
 
 int olsrd_plugin_interface_version(void);
 int olsrd_plugin_init(void);
@@ -0,0 +1,361 @@
+#!/bin/sh
+
+# olsrd network namespace testbed
+#
+# Starts one olsrd per network namespace, connects the namespaces
+# with veth pairs shaped by tc netem, measures route convergence and
+# netperf throughput and latency across the mesh, then takes links
+# down and up again and measures the same after every change.
+# Needs root, iproute2 and a kernel with veth and sch_netem.
+#
+# usage:
+# ./testbed.sh (-line N | -ring N | -topo file) [options]
+
+usage() {
+  cat >&2 <<EOT
+usage: $0 (-line N | -ring N | -topo file) [options]
+  -netem "args"    netem parameters of every link, e.g. "delay 5ms loss 1% rate 10mbit"
+  -pairs "a-b .."  node pairs to measure (default: first to last node)
+  -fail a-b        take link a-b down after the first measurement, may be repeated
+  -time s          duration of every netperf test (default 5)
+  -timeout s       give up waiting for convergence after s seconds (default 120)
+  -hint s          HELLO interval (default 2)
+  -tcint s         TC interval (default 5)
+  -report file     JSON report (default testbed-report.json)
+  -olsrd path      olsrd binary (default ../../olsrd)
+  -netperf dir     directory with netperf and netserver (default .)
+  -keep            leave the work directory with configs and logs
+EOT
+  exit 1
+}
+
+dir=$(cd "$(dirname "$0")" && pwd)
+olsrd=$dir/../../olsrd
+netperf_dir=$dir
+report=testbed-report.json
+netem=
+pairs=
+fails=
+test_time=5
+conv_timeout=120
+hint=2
+tcint=5
+keep=
+topo=
+prefix=olsrtb
+
+while [ $# -gt 0 ]; do
+  case $1 in
+    -line|-ring) topo=$1; topo_arg=$2; shift ;;
+    -topo) topo=$1; topo_arg=$2; shift ;;
+    -netem) netem=$2; shift ;;
+    -pairs) pairs=$2; shift ;;
+    -fail) fails="$fails $2"; shift ;;
+    -time) test_time=$2; shift ;;
+    -timeout) conv_timeout=$2; shift ;;
+    -hint) hint=$2; shift ;;
+    -tcint) tcint=$2; shift ;;
+    -report) report=$2; shift ;;
+    -olsrd) olsrd=$2; shift ;;
+    -netperf) netperf_dir=$2; shift ;;
+    -keep) keep=1 ;;
+    *) usage ;;
+  esac
+  [ $# -gt 0 ] || usage
+  shift
+done
+[ -n "$topo" ] || usage
+
+if [ "$(id -u)" != 0 ]; then
+  echo "$0: needs root" >&2
+  exit 1
+fi
+for bin in "$olsrd" "$netperf_dir/netperf" "$netperf_dir/netserver"; do
+  if [ ! -x "$bin" ]; then
+    echo "$0: $bin not found, run \"make testbed\" from the top directory" >&2
+    exit 1
+  fi
+done
+
+work=$(mktemp -d /tmp/olsrtb.XXXXXX)
+
+# topology as lines "nodes N", "link a b [netem args]" and
+# "down a b" / "up a b" events, the same file syntax as olsr_switch
+case $topo in
+  -line|-ring)
+    echo "nodes $topo_arg" > "$work/topo"
+    i=0
+    while [ $i -lt $((topo_arg - 1)) ]; do
+      echo "link $i $((i + 1))" >> "$work/topo"
+      i=$((i + 1))
+    done
+    [ $topo = -ring ] && [ "$topo_arg" -gt 2 ] && echo "link $((topo_arg - 1)) 0" >> "$work/topo"
+    ;;
+  -topo)
+    sed 's/#.*//' "$topo_arg" > "$work/topo" || exit 1
+    ;;
+esac
+for f in $fails; do
+  echo "down ${f%-*} ${f#*-}" >> "$work/topo"
+done
+
+nodes=$(awk '$1 == "nodes" { print $2 }' "$work/topo")
+if [ -z "$nodes" ] || [ "$nodes" -lt 2 ]; then
+  echo "$0: topology needs \"nodes N\" with N >= 2" >&2
+  exit 1
+fi
+[ -n "$pairs" ] || pairs="0-$((nodes - 1))"
+
+# only touch the namespaces this run created
+created=0
+cleanup() {
+  trap - EXIT INT TERM
+  i=0
+  while [ $i -lt $created ]; do
+    pids=$(ip netns pids $prefix$i 2>/dev/null)
+    [ -n "$pids" ] && kill $pids 2>/dev/null
+    i=$((i + 1))
+  done
+  [ $created -gt 0 ] && sleep 1
+  i=0
+  while [ $i -lt $created ]; do
+    pids=$(ip netns pids $prefix$i 2>/dev/null)
+    [ -n "$pids" ] && kill -9 $pids 2>/dev/null
+    ip netns del $prefix$i 2>/dev/null
+    i=$((i + 1))
+  done
+  if [ -n "$keep" ]; then
+    echo "work directory: $work" >&2
+  else
+    rm -rf "$work"
+  fi
+}
+trap cleanup EXIT
+trap 'exit 1' INT TERM
+
+now() {
+  date +%s.%N
+}
+
+# node i reaches node j over the link to it on interface tb<j>,
+# link k uses the subnet 10.99.<k / 64>.<k % 64 * 4>/30
+i=0
+while [ $i -lt $nodes ]; do
+  ip netns add $prefix$i || exit 1
+  created=$((i + 1))
+  ip -n $prefix$i link set lo up
+  i=$((i + 1))
+done
+
+k=0
+: > "$work/links"
+while read -r kw a b args; do
+  [ "$kw" = link ] || continue
+  sub=10.99.$((k / 64)).$((k % 64 * 4))
+  addr_a=${sub%.*}.$((k % 64 * 4 + 1))
+  addr_b=${sub%.*}.$((k % 64 * 4 + 2))
+  ip link add tb$b netns $prefix$a type veth peer name tb$a netns $prefix$b || exit 1
+  ip -n $prefix$a addr add $addr_a/30 brd + dev tb$b
+  ip -n $prefix$b addr add $addr_b/30 brd + dev tb$a
+  [ -n "$args" ] || args=$netem
+  for side in "$a $b" "$b $a"; do
+    set -- $side
+    ip -n $prefix$1 link set tb$2 up
+    if [ -n "$args" ] && ! tc -n $prefix$1 qdisc add dev tb$2 root netem $args; then
+      echo "$0: netem failed, is the sch_netem module available?" >&2
+      exit 1
+    fi
+  done
+  echo "link $a $b $addr_a $addr_b up" >> "$work/links"
+  eval "[ -n \"\$main_$a\" ] || main_$a=$addr_a"
+  eval "[ -n \"\$main_$b\" ] || main_$b=$addr_b"
+  eval "ifs_$a=\"\$ifs_$a \\\"tb$b\\\"\""
+  eval "ifs_$b=\"\$ifs_$b \\\"tb$a\\\"\""
+  k=$((k + 1))
+done < "$work/topo"
+links=$k
+
+i=0
+while [ $i -lt $nodes ]; do
+  eval "main=\$main_$i ifs=\$ifs_$i"
+  if [ -z "$main" ]; then
+    echo "$0: node $i has no links" >&2
+    exit 1
+  fi
+  echo "main $i $main" >> "$work/links"
+  cat > "$work/olsrd$i.conf" <<EOT
+DebugLevel 0
+MainIp $main
+LockFile "$work/olsrd$i.lock"
+AllowNoInt yes
+InterfaceDefaults {
+  HelloInterval $hint
+  HelloValidityTime $(awk "BEGIN { print $hint * 3 }")
+  TcInterval $tcint
+  TcValidityTime $(awk "BEGIN { print $tcint * 3 }")
+}
+Interface $ifs {
+}
+EOT
+  i=$((i + 1))
+done
+
+# olsrd skips interfaces without carrier, wait for the veth pairs
+no_carrier() {
+  i=0
+  while [ $i -lt $nodes ]; do
+    ip -n $prefix$i link show | grep -q NO-CARRIER && return 0
+    i=$((i + 1))
+  done
+  return 1
+}
+n=0
+while no_carrier && [ $n -lt 50 ]; do
+  sleep 0.1
+  n=$((n + 1))
+done
+
+start=$(now)
+i=0
+while [ $i -lt $nodes ]; do
+  ip netns exec $prefix$i "$olsrd" -f "$work/olsrd$i.conf" -nofork > "$work/olsrd$i.log" 2>&1 &
+  ip netns exec $prefix$i "$netperf_dir/netserver" > /dev/null 2>&1
+  i=$((i + 1))
+done
+
+# Follow the routing tables hop by hop from every node to every node
+# it can reach over links that are up. Prints "converged" if every
+# path arrives without using a link that is down, and "hops i j n"
+# for every pair.
+check_routes() {
+  i=0
+  while [ $i -lt $nodes ]; do
+    ip -n $prefix$i -4 route show | sed "s/^/route $i /"
+    i=$((i + 1))
+  done | cat "$work/links" - | awk -v nodes=$nodes '
+    $1 == "link" {
+      up[$2, $3] = up[$3, $2] = ($6 == "up")
+      owner[$4] = $2; owner[$5] = $3
+    }
+    $1 == "main" { main[$2] = $3 }
+    $1 == "route" && $3 ~ /^[0-9.]+$/ {
+      dev = via = ""
+      for (f = 4; f < NF; f++) {
+        if ($f == "via") via = $(f + 1)
+        if ($f == "dev") dev = $(f + 1)
+      }
+      if (via != "") next_hop[$2, $3] = owner[via]
+      else if (dev ~ /^tb[0-9]+$/) next_hop[$2, $3] = substr(dev, 3)
+    }
+    END {
+      ok = 1
+      for (i = 0; i < nodes; i++) {
+        # nodes reachable from i over links that are up
+        delete seen; seen[i] = 1; queue[0] = i; head = 0; tail = 1
+        while (head < tail) {
+          c = queue[head++]
+          for (n = 0; n < nodes; n++)
+            if (!(n in seen) && up[c, n]) { seen[n] = 1; queue[tail++] = n }
+        }
+        for (j in seen) {
+          if (j == i) continue
+          c = i; hops = 0
+          while (c != j && hops <= nodes) {
+            if (!((c, main[j]) in next_hop)) break
+            n = next_hop[c, main[j]]
+            if (!up[c, n]) break
+            c = n; hops++
+          }
+          if (c != j) ok = 0
+          else print "hops", i, j, hops
+        }
+      }
+      if (ok) print "converged"
+    }'
+}
+
+# wait for convergence, prints the time since $1 or "null"
+wait_converged() {
+  deadline=$(awk "BEGIN { printf \"%.3f\", $1 + $conv_timeout }")
+  while :; do
+    check_routes > "$work/routes"
+    t=$(now)
+    if grep -q '^converged' "$work/routes"; then
+      awk "BEGIN { printf \"%.2f\", $t - $1 }"
+      return
+    fi
+    if awk "BEGIN { exit !($t > $deadline) }"; then
+      printf null
+      return
+    fi
+    sleep 0.2
+  done
+}
+
+# netperf result field, or null if the test failed
+netperf_value() {
+  out=$(ip netns exec $prefix$1 "$netperf_dir/netperf" -H $2 -l $test_time -t $3 -P 0 2>/dev/null) || out=
+  echo "$out" | awk -v want=$4 '
+    NF > 0 { line[++n] = $0 }
+    END {
+      if (want == "stream" && n >= 1) { split(line[1], f); v = f[5] }
+      if (want == "udp" && n >= 2) { split(line[2], f); v = f[4] }
+      if (want == "rr" && n >= 1) { split(line[1], f); v = f[6] }
+      if (v == "" || v + 0 == 0) printf "null"; else printf "%s", v
+    }'
+}
+
+measure_pairs() {
+  sep=
+  for p in $pairs; do
+    a=${p%-*}
+    b=${p#*-}
+    eval "dst=\$main_$b"
+    hops=$(awk -v a=$a -v b=$b '$1 == "hops" && $2 == a && $3 == b { print $4 }' "$work/routes")
+    tcp=$(netperf_value $a $dst TCP_STREAM stream)
+    udp=$(netperf_value $a $dst UDP_STREAM udp)
+    rr=$(netperf_value $a $dst TCP_RR rr)
+    lat=$(awk -v rr=$rr 'BEGIN { if (rr == "null") printf "null"; else printf "%.1f", 1000000 / rr }')
+    echo "  $a -> $b: hops ${hops:-none} tcp $tcp udp $udp Mbit/s, rtt $lat us" >&2
+    printf '%s\n        {"src": %s, "dst": %s, "hops": %s, "tcp_mbps": %s, "udp_mbps": %s, "tcp_rr_per_s": %s, "rtt_us": %s}' \
+      "$sep" $a $b ${hops:-null} $tcp $udp $rr $lat
+    sep=,
+  done
+}
+
+phase() {
+  conv=$(wait_converged $2)
+  echo "$1: converged after $conv s" >&2
+  printf '    {"event": "%s", "convergence_s": %s, "tests": [' "$1" $conv
+  measure_pairs
+  printf '\n    ]}'
+}
+
+{
+  printf '{\n  "nodes": %s,\n  "links": %s,\n  "netem": "%s",\n' $nodes $links "$netem"
+  printf '  "hello_interval": %s,\n  "tc_interval": %s,\n  "test_time_s": %s,\n' $hint $tcint $test_time
+  printf '  "phases": [\n'
+  phase start $start < /dev/null
+
+  while read -r kw a b rest; do
+    case $kw in
+      down|up) ;;
+      *) continue ;;
+    esac
+    if ! grep -q "^link $a $b \|^link $b $a " "$work/links"; then
+      echo "$0: no link $a - $b" >&2
+      exit 1
+    fi
+    t=$(now)
+    ip -n $prefix$a link set tb$b $kw
+    ip -n $prefix$b link set tb$a $kw
+    sed -i -e "s/^\(link $a $b .*\) [a-z]*\$/\1 $kw/" -e "s/^\(link $b $a .*\) [a-z]*\$/\1 $kw/" "$work/links"
+    printf ',\n'
+    phase "$kw $a $b" $t < /dev/null
+  done < "$work/topo"
+
+  printf '\n  ]\n}\n'
+} > "$work/report"
+
+cp "$work/report" "$report"
+echo "report written to $report" >&2
@@ -0,0 +1,209 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+#include <sys/time.h>
+
+#include "bench_util.h"
+#include "olsr.h"
+#include "olsr_cookie.h"
+#include "scheduler.h"
+#include "olsr_cfg.h"
+#include "parser.h"
+#include "interfaces.h"
+#include "net_olsr.h"
+#include "build_msg.h"
+#include "mantissa.h"
+#include "process_routes.h"
+
+/* normally provided by main.c */
+struct olsr_cookie_info *def_timer_ci = NULL;
+
+static uint32_t bench_seed = 0x2545f491;
+
+/**
+ *Set up the global configuration and the tables
+ *the way main() does, without interfaces or sockets
+ *
+ *@param ip_version AF_INET or AF_INET6
+ */
+void
+bench_init(int ip_version)
+{
+  olsr_cnf = olsrd_get_default_cnf();
+  olsr_cnf->debug_level = 0;
+  olsr_cnf->ip_version = ip_version;
+  olsr_cnf->ipsize = ip_version == AF_INET ? sizeof(struct in_addr) : sizeof(struct in6_addr);
+  olsr_cnf->maxplen = ip_version == AF_INET ? 32 : 128;
+  olsr_cnf->host_emul = true;
+
+  olsr_init_timers();
+  def_timer_ci = olsr_alloc_cookie("Default Timer Cookie", OLSR_COOKIE_TYPE_TIMER);
+  olsr_init_tables();
+}
+
+/**
+ *Run the daemon initialization of main() with the
+ *configuration in olsr_cnf and one host emulation
+ *interface, so that no kernel routes are touched
+ *
+ *@param local the address of the interface and main address
+ *@param name the name of the interface
+ *@return the interface
+ */
+struct interface *
+bench_init_daemon(const union olsr_ip_addr *local, const char *name)
+{
+  struct if_config_options *ifcnf;
+  struct olsr_if *iface;
+  struct interface *ifp;
+
+  olsr_cnf->ipsize = olsr_cnf->ip_version == AF_INET ? sizeof(struct in_addr) : sizeof(struct in6_addr);
+  olsr_cnf->maxplen = olsr_cnf->ip_version == AF_INET ? 32 : 128;
+  olsr_cnf->host_emul = true;
+  olsr_cnf->main_addr = *local;
+  olsr_cnf->unicast_src_ip = *local;
+
+  olsr_init_timers();
+  def_timer_ci = olsr_alloc_cookie("Default Timer Cookie", OLSR_COOKIE_TYPE_TIMER);
+
+  set_empty_tc_timer(GET_TIMESTAMP(0));
+  olsr_init_parser();
+  olsr_init_export_route();
+  init_msg_seqno();
+  olsr_init_willingness();
+  init_net();
+  olsr_init_interfacedb();
+  olsr_init_tables();
+
+  /*
+   * The interface is set up by hand, add_hemu_if() would connect
+   * to olsr_switch and start the message generation.
+   */
+  ifcnf = get_default_if_config();
+  olsr_cnf->interface_defaults = ifcnf;
+  iface = olsr_create_olsrif(name, true);
+  memcpy(iface->cnf, ifcnf, sizeof(*ifcnf));
+  iface->hemu_ip = *local;
+  iface->configured = true;
+
+  ifp = olsr_malloc(sizeof(struct interface), "bench interface");
+  ifp->olsr_if = iface;
+  iface->interf = ifp;
+  ifp->is_hcif = true;
+  ifp->int_name = iface->name;
+  ifp->olsr_socket = -1;
+  ifp->send_socket = -1;
+  ifp->ip_addr = *local;
+  if (olsr_cnf->ip_version == AF_INET) {
+    ifp->int_addr.sin_family = AF_INET;
+    ifp->int_addr.sin_addr = local->v4;
+  } else {
+    ifp->int6_addr.sin6_family = AF_INET6;
+    ifp->int6_addr.sin6_addr = local->v6;
+  }
+  ifp->int_mtu = OLSR_DEFAULT_MTU;
+  net_add_buffer(ifp);
+
+  ifp->hello_etime = (olsr_reltime) (iface->cnf->hello_params.emission_interval * MSEC_PER_SEC);
+  ifp->valtimes.hello = reltime_to_me(iface->cnf->hello_params.validity_time * MSEC_PER_SEC);
+  ifp->valtimes.tc = reltime_to_me(iface->cnf->tc_params.validity_time * MSEC_PER_SEC);
+  ifp->valtimes.mid = reltime_to_me(iface->cnf->mid_params.validity_time * MSEC_PER_SEC);
+  ifp->valtimes.hna = reltime_to_me(iface->cnf->hna_params.validity_time * MSEC_PER_SEC);
+  ifp->mode = iface->cnf->mode;
+
+  ifp->int_next = ifnet;
+  ifnet = ifp;
+
+  return ifp;
+}
+
+/**
+ *@return the current time in microseconds
+ */
+uint64_t
+bench_usec(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/**
+ *Small deterministic xorshift generator, so that every
+ *run of a benchmark works on the same topology
+ */
+uint32_t
+bench_random(void)
+{
+  bench_seed ^= bench_seed << 13;
+  bench_seed ^= bench_seed >> 17;
+  bench_seed ^= bench_seed << 5;
+  return bench_seed;
+}
+
+/**
+ *Create the address of a synthetic node
+ *
+ *@param addr the address to fill
+ *@param id the node number
+ */
+void
+bench_make_addr(union olsr_ip_addr *addr, uint32_t id)
+{
+  memset(addr, 0, sizeof(*addr));
+  if (olsr_cnf->ip_version == AF_INET) {
+    addr->v4.s_addr = htonl(0x0a000000 | (id & 0x00ffffff));
+  } else {
+    addr->v6.s6_addr[0] = 0xfd;
+    addr->v6.s6_addr[12] = id >> 24;
+    addr->v6.s6_addr[13] = id >> 16;
+    addr->v6.s6_addr[14] = id >> 8;
+    addr->v6.s6_addr[15] = id;
+  }
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
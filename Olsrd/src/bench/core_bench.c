@@ -0,0 +1,931 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+/*
+ * Times the core algorithms on generated topologies and prints
+ * the results as one JSON document, to be kept per commit.
+ *
+ * Every topology is loaded into a fresh daemon in a child process:
+ * HELLOs of the neighbors of the local node go through
+ * parse_packet(), the TCs of all other nodes through olsr_input_tc().
+ * The etx_fpm metric is used, so the link costs are valid after a
+ * few HELLOs without running the link quality timers.
+ *
+ * usage: core_bench [-topo grid|rgg|scalefree] [-sizes n,n,...] [-time ms]
+ */
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench_util.h"
+#include "olsr.h"
+#include "olsr_cfg.h"
+#include "olsr_cookie.h"
+#include "scheduler.h"
+#include "parser.h"
+#include "mantissa.h"
+#include "interfaces.h"
+#include "lq_packet.h"
+#include "lq_plugin.h"
+#include "tc_set.h"
+#include "duplicate_set.h"
+#include "neighbor_table.h"
+#include "routing_table.h"
+#include "mpr.h"
+#include "lq_mpr.h"
+#include "olsr_spf.h"
+#include "common/avl.h"
+
+/* HELLOs per neighbor, enough for the etx_fpm quickstart */
+#define BENCH_HELLOS          8
+
+/* mean degree of the random geometric graph */
+#define BENCH_RGG_DEGREE      8
+
+/* links of every new node in the scale-free graph */
+#define BENCH_SF_LINKS        2
+
+#define BENCH_MSG_HDRSIZE     12       /* IPv4 message header */
+
+struct bench_graph {
+  const char *name;
+  uint32_t nodes;
+  uint32_t edges;                      /* undirected */
+  uint32_t local;                      /* the node running the daemon */
+  uint32_t *start;                     /* neighbors of i are adj[start[i]] to adj[start[i + 1] - 1] */
+  uint32_t *adj;
+};
+
+struct bench_edges {
+  uint32_t count;
+  uint32_t size;
+  uint32_t *pairs;
+};
+
+struct bench_result {
+  const char *benchmark;
+  unsigned int runs;
+  uint64_t ops;                        /* operations per run */
+  uint64_t usec;                       /* of all runs */
+};
+
+static const char *const topologies[] = { "grid", "rgg", "scalefree" };
+
+static const uint32_t default_sizes[] = { 100, 1000, 5000, 20000 };
+
+/* minimal time spent on each benchmark */
+static uint64_t time_budget = 200000;
+
+/* one JSON object per line, collected by the parent */
+static FILE *result_out;
+
+static void
+usage(void)
+{
+  fprintf(stderr, "usage: core_bench [-topo grid|rgg|scalefree] [-sizes n,n,...] [-time ms]\n");
+  exit(EXIT_FAILURE);
+}
+
+static uint32_t
+bench_isqrt(uint64_t v)
+{
+  uint64_t r = 0, bit = (uint64_t)1 << 62;
+
+  while (bit > v)
+    bit >>= 2;
+  while (bit != 0) {
+    if (v >= r + bit) {
+      v -= r + bit;
+      r = (r >> 1) + bit;
+    } else {
+      r >>= 1;
+    }
+    bit >>= 2;
+  }
+  return r;
+}
+
+static void
+bench_add_edge(struct bench_edges *e, uint32_t a, uint32_t b)
+{
+  if (e->count == e->size) {
+    uint32_t *p;
+
+    e->size = e->size ? e->size * 2 : 1024;
+    p = realloc(e->pairs, e->size * 2 * sizeof(uint32_t));
+    if (p == NULL) {
+      fprintf(stderr, "core_bench: out of memory\n");
+      exit(EXIT_FAILURE);
+    }
+    e->pairs = p;
+  }
+  e->pairs[2 * e->count] = a;
+  e->pairs[2 * e->count + 1] = b;
+  e->count++;
+}
+
+/**
+ *Turn the edge list into adjacency arrays
+ */
+static void
+bench_graph_build(struct bench_graph *g, struct bench_edges *e)
+{
+  uint32_t *fill;
+  uint32_t i;
+
+  g->edges = e->count;
+  g->start = olsr_malloc((g->nodes + 1) * sizeof(uint32_t), "bench graph");
+  g->adj = olsr_malloc(2 * e->count * sizeof(uint32_t) + 1, "bench graph");
+  fill = olsr_malloc(g->nodes * sizeof(uint32_t), "bench graph");
+
+  for (i = 0; i < 2 * e->count; i++) {
+    g->start[e->pairs[i] + 1]++;
+  }
+  for (i = 0; i < g->nodes; i++) {
+    g->start[i + 1] += g->start[i];
+    fill[i] = g->start[i];
+  }
+  for (i = 0; i < e->count; i++) {
+    uint32_t a = e->pairs[2 * i], b = e->pairs[2 * i + 1];
+
+    g->adj[fill[a]++] = b;
+    g->adj[fill[b]++] = a;
+  }
+  free(fill);
+  free(e->pairs);
+}
+
+/**
+ *Square grid, the local node in the middle
+ */
+static void
+bench_gen_grid(struct bench_graph *g, struct bench_edges *e)
+{
+  uint32_t side = bench_isqrt(g->nodes), i;
+
+  if (side * side < g->nodes)
+    side++;
+  for (i = 0; i < g->nodes; i++) {
+    if (i % side + 1 < side && i + 1 < g->nodes)
+      bench_add_edge(e, i, i + 1);
+    if (i + side < g->nodes)
+      bench_add_edge(e, i, i + side);
+  }
+  g->local = (side / 2) * side + side / 2;
+  if (g->local >= g->nodes)
+    g->local = g->nodes / 2;
+}
+
+/**
+ *Random geometric graph in the unit square with a mean
+ *degree of BENCH_RGG_DEGREE, the local node nearest to
+ *the center. Neighbors are found through a grid of cells
+ *of the size of the radio range.
+ */
+static void
+bench_gen_rgg(struct bench_graph *g, struct bench_edges *e)
+{
+  const uint64_t area = (uint64_t)1 << 32;   /* 65536 x 65536 */
+  uint32_t *x = olsr_malloc(g->nodes * sizeof(uint32_t), "bench rgg");
+  uint32_t *y = olsr_malloc(g->nodes * sizeof(uint32_t), "bench rgg");
+  uint32_t *cell_start, *cell_nodes, *cell_fill;
+  uint64_t r2, best = UINT64_MAX;
+  uint32_t r, cells, i;
+
+  /* pi * r^2 * nodes = degree * area, pi taken as 355/113 */
+  r2 = area / g->nodes * BENCH_RGG_DEGREE * 113 / 355;
+  r = bench_isqrt(r2) + 1;
+  cells = 65536 / r + 1;
+
+  cell_start = olsr_malloc((cells * cells + 1) * sizeof(uint32_t), "bench rgg");
+  cell_fill = olsr_malloc(cells * cells * sizeof(uint32_t), "bench rgg");
+  cell_nodes = olsr_malloc(g->nodes * sizeof(uint32_t), "bench rgg");
+
+  for (i = 0; i < g->nodes; i++) {
+    int64_t dx, dy;
+
+    x[i] = bench_random() & 0xffff;
+    y[i] = bench_random() & 0xffff;
+    cell_start[(y[i] / r) * cells + x[i] / r + 1]++;
+
+    dx = (int64_t)x[i] - 32768;
+    dy = (int64_t)y[i] - 32768;
+    if ((uint64_t)(dx * dx + dy * dy) < best) {
+      best = dx * dx + dy * dy;
+      g->local = i;
+    }
+  }
+  for (i = 0; i < cells * cells; i++) {
+    cell_start[i + 1] += cell_start[i];
+    cell_fill[i] = cell_start[i];
+  }
+  for (i = 0; i < g->nodes; i++) {
+    cell_nodes[cell_fill[(y[i] / r) * cells + x[i] / r]++] = i;
+  }
+
+  for (i = 0; i < g->nodes; i++) {
+    uint32_t cx = x[i] / r, cy = y[i] / r, nx, ny;
+
+    for (ny = cy ? cy - 1 : 0; ny <= cy + 1 && ny < cells; ny++) {
+      for (nx = cx ? cx - 1 : 0; nx <= cx + 1 && nx < cells; nx++) {
+        uint32_t c = ny * cells + nx, k;
+
+        for (k = cell_start[c]; k < cell_start[c + 1]; k++) {
+          uint32_t j = cell_nodes[k];
+          int64_t dx = (int64_t)x[i] - x[j], dy = (int64_t)y[i] - y[j];
+
+          /* every pair once */
+          if (j > i && (uint64_t)(dx * dx + dy * dy) <= r2)
+            bench_add_edge(e, i, j);
+        }
+      }
+    }
+  }
+
+  free(x);
+  free(y);
+  free(cell_start);
+  free(cell_fill);
+  free(cell_nodes);
+}
+
+/**
+ *Scale-free graph by preferential attachment, every new
+ *node links to BENCH_SF_LINKS existing ones. The local node
+ *is the first one, which ends up as the biggest hub.
+ */
+static void
+bench_gen_scalefree(struct bench_graph *g, struct bench_edges *e)
+{
+  uint32_t i;
+
+  g->local = 0;
+  if (g->nodes > 1)
+    bench_add_edge(e, 0, 1);
+
+  for (i = 2; i < g->nodes; i++) {
+    uint32_t picked[BENCH_SF_LINKS], k, n;
+
+    for (k = 0; k < BENCH_SF_LINKS && k < i; k++) {
+      uint32_t target;
+
+      /* an end of a random edge is picked in proportion to its degree */
+      do {
+        target = e->pairs[bench_random() % (2 * e->count)];
+        for (n = 0; n < k && picked[n] != target; n++);
+      } while (n < k);
+      picked[k] = target;
+      bench_add_edge(e, target, i);
+    }
+  }
+}
+
+static void
+bench_graph_generate(struct bench_graph *g, const char *name, uint32_t nodes)
+{
+  struct bench_edges e;
+
+  memset(g, 0, sizeof(*g));
+  memset(&e, 0, sizeof(e));
+  g->name = name;
+  g->nodes = nodes;
+
+  if (strcmp(name, "grid") == 0)
+    bench_gen_grid(g, &e);
+  else if (strcmp(name, "rgg") == 0)
+    bench_gen_rgg(g, &e);
+  else
+    bench_gen_scalefree(g, &e);
+
+  bench_graph_build(g, &e);
+}
+
+static uint32_t
+bench_degree(const struct bench_graph *g, uint32_t i)
+{
+  return g->start[i + 1] - g->start[i];
+}
+
+static unsigned char *
+bench_put16(unsigned char *p, uint16_t v)
+{
+  p[0] = v >> 8;
+  p[1] = v & 0xff;
+  return p + 2;
+}
+
+/**
+ *Write the common header of an IPv4 message
+ */
+static unsigned char *
+bench_put_header(unsigned char *p, uint8_t type, olsr_reltime vtime, uint16_t size, uint32_t node, uint16_t seqno)
+{
+  union olsr_ip_addr orig;
+
+  bench_make_addr(&orig, node + 1);
+  p[0] = type;
+  p[1] = reltime_to_me(vtime);
+  p = bench_put16(p + 2, size);
+  memcpy(p, &orig.v4, sizeof(orig.v4));
+  p += sizeof(orig.v4);
+  p[0] = 255;                          /* ttl */
+  p[1] = 0;                            /* hop count */
+  return bench_put16(p + 2, seqno);
+}
+
+/**
+ *Write the neighbors of node as link quality address list
+ */
+static unsigned char *
+bench_put_neighbors(unsigned char *p, const struct bench_graph *g, uint32_t node)
+{
+  uint32_t k;
+
+  for (k = g->start[node]; k < g->start[node + 1]; k++) {
+    union olsr_ip_addr addr;
+
+    bench_make_addr(&addr, g->adj[k] + 1);
+    memcpy(p, &addr.v4, sizeof(addr.v4));
+    p[4] = 255;                        /* LQ */
+    p[5] = 255;                        /* NLQ */
+    p[6] = 0;
+    p[7] = 0;
+    p += 8;
+  }
+  return p;
+}
+
+/**
+ *Feed the HELLOs of the neighbors of the local node through
+ *parse_packet(), they list all their neighbors as symmetric
+ */
+static void
+bench_load_hellos(const struct bench_graph *g, struct interface *ifp)
+{
+  uint32_t k, round, max = 0;
+  unsigned char *buf;
+
+  for (k = g->start[g->local]; k < g->start[g->local + 1]; k++) {
+    if (bench_degree(g, g->adj[k]) > max)
+      max = bench_degree(g, g->adj[k]);
+  }
+  buf = olsr_malloc(4 + BENCH_MSG_HDRSIZE + 8 + max * 8, "bench hello");
+
+  for (round = 0; round < BENCH_HELLOS; round++) {
+    for (k = g->start[g->local]; k < g->start[g->local + 1]; k++) {
+      uint32_t nbr = g->adj[k];
+      uint16_t size = BENCH_MSG_HDRSIZE + 8 + bench_degree(g, nbr) * 8;
+      union olsr_ip_addr from;
+      unsigned char *p;
+
+      p = bench_put16(buf, 4 + size);
+      p = bench_put16(p, round);
+      p = bench_put_header(p, LQ_HELLO_MESSAGE, 20 * MSEC_PER_SEC, size, nbr, round);
+      p = bench_put16(p, 0);
+      p[0] = reltime_to_me(2 * MSEC_PER_SEC);
+      p[1] = WILL_DEFAULT;
+      p[2] = CREATE_LINK_CODE(SYM_NEIGH, SYM_LINK);
+      p[3] = 0;
+      p = bench_put16(p + 4, 4 + bench_degree(g, nbr) * 8);
+      bench_put_neighbors(p, g, nbr);
+
+      bench_make_addr(&from, nbr + 1);
+      parse_packet((struct olsr *)buf, 4 + size, ifp, &from, NULL);
+    }
+  }
+  free(buf);
+}
+
+/**
+ *Build the TCs of all nodes but the local one, each
+ *advertising all neighbors, into one buffer
+ *
+ *@param offsets filled with the start of each message
+ *@return the buffer
+ */
+static unsigned char *
+bench_build_tcs(const struct bench_graph *g, uint32_t *offsets)
+{
+  unsigned char *buf = olsr_malloc((g->nodes - 1) * (BENCH_MSG_HDRSIZE + 4) + 2 * g->edges * 8 + 1, "bench tc");
+  unsigned char *p = buf;
+  uint32_t i, n = 0;
+
+  for (i = 0; i < g->nodes; i++) {
+    uint16_t size = BENCH_MSG_HDRSIZE + 4 + bench_degree(g, i) * 8;
+
+    if (i == g->local)
+      continue;
+    offsets[n++] = p - buf;
+    p = bench_put_header(p, LQ_TC_MESSAGE, 256 * MSEC_PER_SEC, size, i, 1);
+    p = bench_put16(p, 1);             /* ANSN */
+    p[0] = 0xff;                       /* no fragmentation */
+    p[1] = 0xff;
+    p = bench_put_neighbors(p + 2, g, i);
+  }
+  return buf;
+}
+
+/**
+ *Give all TCs the next message sequence number and ANSN
+ */
+static void
+bench_bump_tcs(unsigned char *buf, const uint32_t *offsets, uint32_t count, uint16_t seqno)
+{
+  uint32_t n;
+
+  for (n = 0; n < count; n++) {
+    unsigned char *m = buf + offsets[n];
+
+    bench_put16(m + 10, seqno);
+    bench_put16(m + BENCH_MSG_HDRSIZE, seqno);
+  }
+}
+
+static void
+bench_input_tcs(unsigned char *buf, const uint32_t *offsets, uint32_t count, struct interface *ifp, union olsr_ip_addr *from)
+{
+  uint32_t n;
+
+  for (n = 0; n < count; n++) {
+    olsr_input_tc((union olsr_message *)(buf + offsets[n]), ifp, from);
+  }
+}
+
+static void
+bench_report(const struct bench_result *r, const char *topology, uint32_t nodes, uint32_t edges, const char *extra)
+{
+  fprintf(result_out, "{\"benchmark\": \"%s\", \"topology\": \"%s\", \"nodes\": %u, \"edges\": %u, \"runs\": %u, "
+          "\"ops_per_run\": %llu, \"nsec_per_op\": %.1f%s}\n",
+          r->benchmark, topology, nodes, edges, r->runs, (unsigned long long)r->ops,
+          r->runs && r->ops ? r->usec * 1000.0 / r->runs / r->ops : 0.0, extra ? extra : "");
+}
+
+/**
+ *@return true while a benchmark should do another run
+ */
+static bool
+bench_more(const struct bench_result *r)
+{
+  return r->runs < 3 || r->usec < time_budget;
+}
+
+/**
+ *Benchmarks on the daemon loaded with topology g
+ */
+static void
+bench_topology(const struct bench_graph *g)
+{
+  struct bench_result r;
+  struct interface *ifp;
+  struct neighbor_entry *nbr;
+  union olsr_ip_addr local, from;
+  uint32_t *offsets = olsr_malloc(g->nodes * sizeof(uint32_t), "bench tc");
+  unsigned char *tcs;
+  uint16_t seqno = 1;
+  uint64_t t;
+  unsigned int mprs;
+  char extra[64];
+
+  olsr_cnf = olsrd_get_default_cnf();
+  olsr_cnf->debug_level = 0;
+  olsr_cnf->ip_version = AF_INET;
+  olsr_cnf->lq_algorithm = "etx_fpm";
+
+  bench_make_addr(&local, g->local + 1);
+  ifp = bench_init_daemon(&local, "bench0");
+
+  bench_load_hellos(g, ifp);
+  tcs = bench_build_tcs(g, offsets);
+
+  /* TCs are accepted from symmetric neighbors only */
+  if (bench_degree(g, g->local) > 0)
+    bench_make_addr(&from, g->adj[g->start[g->local]] + 1);
+  else
+    from = local;
+  bench_input_tcs(tcs, offsets, g->nodes - 1, ifp, &from);
+
+  /* new edges get their cost from the following TC */
+  bench_bump_tcs(tcs, offsets, g->nodes - 1, ++seqno);
+  bench_input_tcs(tcs, offsets, g->nodes - 1, ifp, &from);
+
+  olsr_calculate_lq_mpr();
+  olsr_calculate_routing_table(true);
+  changes_neighborhood = changes_topology = changes_hna = false;
+
+  memset(&r, 0, sizeof(r));
+  r.benchmark = "spf";
+  r.ops = 1;
+  while (bench_more(&r)) {
+    t = bench_usec();
+    olsr_calculate_routing_table(true);
+    r.usec += bench_usec() - t;
+    r.runs++;
+  }
+  snprintf(extra, sizeof(extra), ", \"routes\": %u", routingtree.count);
+  bench_report(&r, g->name, g->nodes, g->edges, extra);
+
+  memset(&r, 0, sizeof(r));
+  r.benchmark = "mpr";
+  r.ops = 1;
+  while (bench_more(&r)) {
+    t = bench_usec();
+    olsr_calculate_mpr();
+    r.usec += bench_usec() - t;
+    r.runs++;
+  }
+  mprs = 0;
+  OLSR_FOR_ALL_NBR_ENTRIES(nbr) {
+    if (nbr->is_mpr)
+      mprs++;
+  }
+  OLSR_FOR_ALL_NBR_ENTRIES_END(nbr);
+  snprintf(extra, sizeof(extra), ", \"mprs\": %u", mprs);
+  bench_report(&r, g->name, g->nodes, g->edges, extra);
+
+  memset(&r, 0, sizeof(r));
+  r.benchmark = "lq_mpr";
+  r.ops = 1;
+  while (bench_more(&r)) {
+    t = bench_usec();
+    olsr_calculate_lq_mpr();
+    r.usec += bench_usec() - t;
+    r.runs++;
+  }
+  mprs = 0;
+  OLSR_FOR_ALL_NBR_ENTRIES(nbr) {
+    if (nbr->is_mpr)
+      mprs++;
+  }
+  OLSR_FOR_ALL_NBR_ENTRIES_END(nbr);
+  snprintf(extra, sizeof(extra), ", \"mprs\": %u", mprs);
+  bench_report(&r, g->name, g->nodes, g->edges, extra);
+
+  /* refreshes of the whole topology with a new ANSN */
+  memset(&r, 0, sizeof(r));
+  r.benchmark = "input_tc";
+  r.ops = g->nodes - 1;
+  while (bench_more(&r)) {
+    bench_bump_tcs(tcs, offsets, g->nodes - 1, ++seqno);
+    t = bench_usec();
+    bench_input_tcs(tcs, offsets, g->nodes - 1, ifp, &from);
+    r.usec += bench_usec() - t;
+    r.runs++;
+  }
+  snprintf(extra, sizeof(extra), ", \"tc_entries\": %u", tc_tree.count);
+  bench_report(&r, g->name, g->nodes, g->edges, extra);
+
+  /* a new message of every node, then the same again */
+  memset(&r, 0, sizeof(r));
+  r.benchmark = "dup_new";
+  r.ops = g->nodes - 1;
+  while (bench_more(&r)) {
+    uint32_t n;
+
+    bench_bump_tcs(tcs, offsets, g->nodes - 1, ++seqno);
+    t = bench_usec();
+    for (n = 0; n < g->nodes - 1; n++) {
+      olsr_message_is_duplicate((union olsr_message *)(tcs + offsets[n]));
+    }
+    r.usec += bench_usec() - t;
+    r.runs++;
+  }
+  bench_report(&r, g->name, g->nodes, g->edges, NULL);
+
+  memset(&r, 0, sizeof(r));
+  r.benchmark = "dup_repeat";
+  r.ops = g->nodes - 1;
+  while (bench_more(&r)) {
+    uint32_t n;
+
+    t = bench_usec();
+    for (n = 0; n < g->nodes - 1; n++) {
+      olsr_message_is_duplicate((union olsr_message *)(tcs + offsets[n]));
+    }
+    r.usec += bench_usec() - t;
+    r.runs++;
+  }
+  bench_report(&r, g->name, g->nodes, g->edges, NULL);
+}
+
+struct bench_avl_entry {
+  struct avl_node node;
+  uint32_t key;
+};
+
+static unsigned int bench_timers_fired;
+
+static void
+bench_timer_cb(void *context __attribute__ ((unused)))
+{
+  bench_timers_fired++;
+}
+
+/**
+ *Benchmarks of the building blocks with n elements
+ */
+static void
+bench_primitives(uint32_t n)
+{
+  struct bench_result ins, find, del, alloc, release, start, change, stop, walk;
+  struct bench_avl_entry *entries = olsr_malloc(n * sizeof(*entries), "bench avl");
+  struct timer_entry **timers = olsr_malloc(n * sizeof(*timers), "bench timers");
+  void **objs = olsr_malloc(n * sizeof(*objs), "bench cookies");
+  struct olsr_cookie_info *obj_cookie, *timer_cookie;
+  struct avl_tree tree;
+  uint32_t clock_base, i;
+  uint64_t t;
+
+  bench_init(AF_INET);
+
+  memset(&ins, 0, sizeof(ins));
+  memset(&find, 0, sizeof(find));
+  memset(&del, 0, sizeof(del));
+  ins.benchmark = "avl_insert";
+  find.benchmark = "avl_find";
+  del.benchmark = "avl_delete";
+  ins.ops = find.ops = del.ops = n;
+
+  /* the multiplier makes the keys distinct and unordered */
+  for (i = 0; i < n; i++) {
+    entries[i].key = htonl(i * 2654435761u);
+    entries[i].node.key = &entries[i].key;
+  }
+  while (bench_more(&ins) || bench_more(&find) || bench_more(&del)) {
+    avl_init(&tree, avl_comp_ipv4);
+
+    t = bench_usec();
+    for (i = 0; i < n; i++) {
+      avl_insert(&tree, &entries[i].node, 0);
+    }
+    ins.usec += bench_usec() - t;
+
+    t = bench_usec();
+    for (i = 0; i < n; i++) {
+      avl_find(&tree, &entries[(i * 7919) % n].key);
+    }
+    find.usec += bench_usec() - t;
+
+    t = bench_usec();
+    for (i = 0; i < n; i++) {
+      avl_delete(&tree, &entries[i].node);
+    }
+    del.usec += bench_usec() - t;
+
+    ins.runs++;
+    find.runs++;
+    del.runs++;
+  }
+  bench_report(&ins, "none", n, 0, NULL);
+  bench_report(&find, "none", n, 0, NULL);
+  bench_report(&del, "none", n, 0, NULL);
+
+  obj_cookie = olsr_alloc_cookie("bench objects", OLSR_COOKIE_TYPE_MEMORY);
+  olsr_cookie_set_memory_size(obj_cookie, 64);
+  memset(&alloc, 0, sizeof(alloc));
+  memset(&release, 0, sizeof(release));
+  alloc.benchmark = "cookie_malloc";
+  release.benchmark = "cookie_free";
+  alloc.ops = release.ops = n;
+  while (bench_more(&alloc) || bench_more(&release)) {
+    t = bench_usec();
+    for (i = 0; i < n; i++) {
+      objs[i] = olsr_cookie_malloc(obj_cookie);
+    }
+    alloc.usec += bench_usec() - t;
+
+    t = bench_usec();
+    for (i = 0; i < n; i++) {
+      olsr_cookie_free(obj_cookie, objs[i]);
+    }
+    release.usec += bench_usec() - t;
+
+    alloc.runs++;
+    release.runs++;
+  }
+  bench_report(&alloc, "none", n, 0, NULL);
+  bench_report(&release, "none", n, 0, NULL);
+
+  timer_cookie = olsr_alloc_cookie("bench timers", OLSR_COOKIE_TYPE_TIMER);
+  memset(&start, 0, sizeof(start));
+  memset(&change, 0, sizeof(change));
+  memset(&stop, 0, sizeof(stop));
+  memset(&walk, 0, sizeof(walk));
+  start.benchmark = "timer_start";
+  change.benchmark = "timer_change";
+  stop.benchmark = "timer_stop";
+  walk.benchmark = "timer_walk";
+  start.ops = change.ops = n;
+  stop.ops = n / 2;
+  walk.ops = n - n / 2;
+  clock_base = now_times;
+  while (bench_more(&start) || bench_more(&change) || bench_more(&stop) || bench_more(&walk)) {
+    t = bench_usec();
+    for (i = 0; i < n; i++) {
+      timers[i] = olsr_start_timer(1 + bench_random() % 60000, 0, OLSR_TIMER_ONESHOT, &bench_timer_cb, NULL, timer_cookie);
+    }
+    start.usec += bench_usec() - t;
+
+    t = bench_usec();
+    for (i = 0; i < n; i++) {
+      olsr_change_timer(timers[i], 1 + bench_random() % 60000, 0, OLSR_TIMER_ONESHOT);
+    }
+    change.usec += bench_usec() - t;
+
+    t = bench_usec();
+    for (i = 0; i < n / 2; i++) {
+      olsr_stop_timer(timers[2 * i]);
+    }
+    stop.usec += bench_usec() - t;
+
+    /* the remaining timers fire while the clock runs a minute ahead */
+    bench_timers_fired = 0;
+    t = bench_usec();
+    now_times += 60001;
+    olsr_scheduler_round();
+    walk.usec += bench_usec() - t;
+    if (bench_timers_fired != n - n / 2) {
+      fprintf(stderr, "core_bench: %u of %u timers fired\n", bench_timers_fired, n - n / 2);
+      exit(EXIT_FAILURE);
+    }
+
+    /*
+     * The wheel is empty again, rewind the clock before it wraps,
+     * the walk does not cross the wrap of now_times.
+     */
+    now_times = clock_base;
+    olsr_scheduler_round();
+
+    start.runs++;
+    change.runs++;
+    stop.runs++;
+    walk.runs++;
+  }
+  bench_report(&start, "none", n, 0, NULL);
+  bench_report(&change, "none", n, 0, NULL);
+  bench_report(&stop, "none", n, 0, NULL);
+  bench_report(&walk, "none", n, 0, NULL);
+}
+
+/**
+ *Run one benchmark group in a child process, so that each one
+ *starts with an empty daemon, and copy its result lines into
+ *the results array
+ *
+ *@param topology the topology name or NULL for the building blocks
+ *@param nodes the number of nodes or elements
+ *@param first true until the first result was printed
+ *@return the updated first flag
+ */
+static bool
+bench_run_child(const char *topology, uint32_t nodes, bool first)
+{
+  char line[512];
+  int fds[2], status;
+  FILE *in;
+  pid_t pid;
+
+  if (pipe(fds) < 0) {
+    perror("pipe");
+    exit(EXIT_FAILURE);
+  }
+  fflush(stdout);
+
+  pid = fork();
+  if (pid < 0) {
+    perror("fork");
+    exit(EXIT_FAILURE);
+  }
+  if (pid == 0) {
+    close(fds[0]);
+    result_out = fdopen(fds[1], "w");
+    if (topology != NULL) {
+      struct bench_graph g;
+
+      bench_graph_generate(&g, topology, nodes);
+      bench_topology(&g);
+    } else {
+      bench_primitives(nodes);
+    }
+    fclose(result_out);
+    exit(EXIT_SUCCESS);
+  }
+
+  close(fds[1]);
+  in = fdopen(fds[0], "r");
+  while (fgets(line, sizeof(line), in) != NULL) {
+    line[strcspn(line, "\n")] = 0;
+    printf("%s\n    %s", first ? "" : ",", line);
+    first = false;
+  }
+  fclose(in);
+
+  if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    fprintf(stderr, "core_bench: %s with %u nodes failed\n", topology ? topology : "primitives", nodes);
+    exit(EXIT_FAILURE);
+  }
+  return first;
+}
+
+int
+main(int argc, char *argv[])
+{
+  uint32_t sizes[32];
+  unsigned int size_count = 0, i, k;
+  const char *topo = NULL;
+  bool first = true;
+  int a;
+
+  for (a = 1; a < argc; a++) {
+    if (a + 1 == argc)
+      usage();
+    if (strcmp(argv[a], "-topo") == 0) {
+      topo = argv[++a];
+      for (k = 0; k < sizeof(topologies) / sizeof(topologies[0]) && strcmp(topo, topologies[k]) != 0; k++);
+      if (k == sizeof(topologies) / sizeof(topologies[0]))
+        usage();
+    } else if (strcmp(argv[a], "-sizes") == 0) {
+      char *s = argv[++a], *end;
+
+      do {
+        if (size_count == sizeof(sizes) / sizeof(sizes[0]))
+          usage();
+        sizes[size_count] = strtoul(s, &end, 10);
+        if (end == s || sizes[size_count] < 2)
+          usage();
+        size_count++;
+        s = end + 1;
+      } while (*end == ',');
+      if (*end != 0)
+        usage();
+    } else if (strcmp(argv[a], "-time") == 0) {
+      time_budget = strtoul(argv[++a], NULL, 10) * 1000;
+    } else
+      usage();
+  }
+  if (size_count == 0) {
+    size_count = sizeof(default_sizes) / sizeof(default_sizes[0]);
+    memcpy(sizes, default_sizes, sizeof(default_sizes));
+  }
+
+  printf("{\n  \"version\": \"%s\",\n  \"time_budget_ms\": %llu,\n  \"results\": [", olsrd_version,
+         (unsigned long long)time_budget / 1000);
+
+  for (i = 0; i < size_count; i++) {
+    for (k = 0; k < sizeof(topologies) / sizeof(topologies[0]); k++) {
+      if (topo == NULL || strcmp(topo, topologies[k]) == 0)
+        first = bench_run_child(topologies[k], sizes[i], first);
+    }
+    first = bench_run_child(NULL, sizes[i], first);
+  }
+
+  printf("\n  ]\n}\n");
+  return 0;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,210 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/*
+ * Times olsr_calculate_mpr() on synthetic dense neighborhoods.
+ *
+ * usage: mpr_bench [runs]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "bench_util.h"
+#include "olsr.h"
+#include "mpr.h"
+#include "neighbor_table.h"
+#include "two_hop_neighbor_table.h"
+
+struct mpr_scenario {
+  uint32_t n1;                         /* symmetric 1-hop neighbors */
+  uint32_t n2;                         /* strict 2-hop neighbors */
+  uint32_t degree;                     /* 1-hop neighbors per 2-hop neighbor */
+};
+
+static const struct mpr_scenario scenarios[] = {
+  {16, 64, 2},
+  {32, 256, 4},
+  {64, 1024, 8},
+  {128, 2048, 16},
+  {256, 4096, 32},
+};
+
+static void
+bench_link_2hop(struct neighbor_entry *nbr, struct neighbor_2_entry *nbr2)
+{
+  struct neighbor_list_entry *nbl = olsr_malloc(sizeof(*nbl), "bench nbl");
+  struct neighbor_2_list_entry *n2l = olsr_malloc(sizeof(*n2l), "bench n2l");
+
+  nbl->neighbor = nbr;
+  nbl->path_linkcost = LINK_COST_BROKEN;
+  nbl->saved_path_linkcost = LINK_COST_BROKEN;
+  nbl->second_hop_linkcost = LINK_COST_BROKEN;
+  nbl->next = nbr2->neighbor_2_nblist.next;
+  nbl->prev = &nbr2->neighbor_2_nblist;
+  nbr2->neighbor_2_nblist.next->prev = nbl;
+  nbr2->neighbor_2_nblist.next = nbl;
+  nbr2->neighbor_2_pointer++;
+
+  n2l->neighbor_2 = nbr2;
+  n2l->nbr2_nbr = nbr;
+  n2l->next = nbr->neighbor_2_list.next;
+  n2l->prev = &nbr->neighbor_2_list;
+  nbr->neighbor_2_list.next->prev = n2l;
+  nbr->neighbor_2_list.next = n2l;
+}
+
+static void
+bench_build(const struct mpr_scenario *s, struct neighbor_entry **nbrs)
+{
+  union olsr_ip_addr addr;
+  uint32_t i, k;
+
+  for (i = 0; i < s->n1; i++) {
+    bench_make_addr(&addr, 1 + i);
+    nbrs[i] = olsr_insert_neighbor_table(&addr);
+    nbrs[i]->status = SYM;
+    nbrs[i]->willingness = (bench_random() % 4) ? WILL_DEFAULT : WILL_HIGH;
+  }
+
+  for (i = 0; i < s->n2; i++) {
+    struct neighbor_2_entry *nbr2 = olsr_malloc(sizeof(*nbr2), "bench nbr2");
+
+    bench_make_addr(&nbr2->neighbor_2_addr, 0x10000 + i);
+    nbr2->neighbor_2_nblist.next = &nbr2->neighbor_2_nblist;
+    nbr2->neighbor_2_nblist.prev = &nbr2->neighbor_2_nblist;
+    olsr_insert_two_hop_neighbor_table(nbr2);
+
+    /* a few 2-hop neighbors are only reachable over one link */
+    for (k = (i % 16) ? s->degree : 1; k > 0; k--) {
+      struct neighbor_entry *nbr = nbrs[bench_random() % s->n1];
+
+      if (olsr_lookup_my_neighbors(nbr, &nbr2->neighbor_2_addr) == NULL) {
+        bench_link_2hop(nbr, nbr2);
+      }
+    }
+  }
+}
+
+/**
+ *@return the number of 2-hop neighbors not reachable over any MPR
+ */
+static unsigned int
+bench_uncovered(void)
+{
+  struct neighbor_2_entry *nbr2;
+  struct neighbor_list_entry *nbl;
+  unsigned int uncovered = 0;
+  int idx;
+
+  for (idx = 0; idx < HASHSIZE; idx++) {
+    for (nbr2 = two_hop_neighbortable[idx].next; nbr2 != &two_hop_neighbortable[idx]; nbr2 = nbr2->next) {
+      for (nbl = nbr2->neighbor_2_nblist.next; nbl != &nbr2->neighbor_2_nblist; nbl = nbl->next) {
+        if (nbl->neighbor->is_mpr) {
+          break;
+        }
+      }
+      if (nbl == &nbr2->neighbor_2_nblist) {
+        uncovered++;
+      }
+    }
+  }
+  return uncovered;
+}
+
+static void
+bench_teardown(const struct mpr_scenario *s, struct neighbor_entry **nbrs)
+{
+  uint32_t i;
+
+  for (i = 0; i < s->n1; i++) {
+    olsr_delete_neighbor_table(&nbrs[i]->neighbor_main_addr);
+  }
+}
+
+int
+main(int argc, char *argv[])
+{
+  unsigned int runs = argc > 1 ? (unsigned int)atoi(argv[1]) : 200;
+  size_t i;
+
+  bench_init(AF_INET);
+
+  for (i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+    const struct mpr_scenario *s = &scenarios[i];
+    struct neighbor_entry **nbrs = olsr_malloc(s->n1 * sizeof(*nbrs), "bench nbrs");
+    struct neighbor_entry *nbr;
+    uint64_t start, usec;
+    unsigned int r, mprs = 0;
+
+    bench_build(s, nbrs);
+
+    /* warm up, the first run allocates */
+    olsr_calculate_mpr();
+
+    start = bench_usec();
+    for (r = 0; r < runs; r++) {
+      olsr_calculate_mpr();
+    }
+    usec = bench_usec() - start;
+
+    OLSR_FOR_ALL_NBR_ENTRIES(nbr) {
+      if (nbr->is_mpr) {
+        mprs++;
+      }
+    }
+    OLSR_FOR_ALL_NBR_ENTRIES_END(nbr);
+
+    printf("mpr n1=%u n2=%u degree=%u runs=%u usec/run=%.1f mprs=%u uncovered=%u\n",
+           s->n1, s->n2, s->degree, runs, (double)usec / runs, mprs, bench_uncovered());
+
+    bench_teardown(s, nbrs);
+    free(nbrs);
+  }
+  return 0;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,169 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/*
+ * Measures the throughput of the P2PD duplicate message filter.
+ * Every distinct message arrives several times, as it would when
+ * relayed by more than one neighbor, while the scheduler clock
+ * advances at the configured message rate. Entries age out from
+ * the aging timer, run here whenever the clock passes its interval,
+ * and the ring grows to hold everything within the hold time.
+ *
+ * usage: p2pd_dup_bench [messages]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "bench_util.h"
+#include "olsr.h"
+#include "scheduler.h"
+#include "DupFilter.h"
+
+/* hold time the plugin uses by default, in seconds */
+#define BENCH_HOLD_TIME 180
+
+struct dup_scenario {
+  uint32_t originators;                /* nodes sending P2PD messages */
+  uint32_t copies;                     /* times each message is received */
+  uint32_t rate;                       /* distinct messages per second */
+};
+
+static const struct dup_scenario scenarios[] = {
+  {16, 2, 10},
+  {64, 3, 40},
+  {256, 3, 400},
+  {1024, 4, 4000},
+};
+
+static void
+bench_fill_msg(union olsr_message *m, uint32_t originator, uint16_t seqno)
+{
+  union olsr_ip_addr addr;
+
+  bench_make_addr(&addr, 1 + originator);
+  memset(m, 0, sizeof(*m));
+  if (olsr_cnf->ip_version == AF_INET) {
+    m->v4.olsr_msgtype = 132;
+    m->v4.originator = addr.v4.s_addr;
+    m->v4.seqno = htons(seqno);
+  } else {
+    m->v6.olsr_msgtype = 132;
+    m->v6.originator = addr.v6;
+    m->v6.seqno = htons(seqno);
+  }
+}
+
+static void
+bench_run(const struct dup_scenario *s, uint32_t messages)
+{
+  union olsr_message *m = olsr_malloc(s->copies * sizeof(*m), "bench msgs");
+  uint16_t *seqno = olsr_malloc(s->originators * sizeof(*seqno), "bench seqno");
+  uint64_t start, usec, clock_usec = 0;
+  uint32_t i, c, dups = 0, received = 0, next_age = DUPFILTER_AGE_INTERVAL;
+
+  InitDupFilter(BENCH_HOLD_TIME * MSEC_PER_SEC);
+  now_times = 0;
+
+  start = bench_usec();
+  for (i = 0; i < messages; i++) {
+    uint32_t originator = bench_random() % s->originators;
+
+    bench_fill_msg(&m[0], originator, seqno[originator]++);
+    for (c = 1; c < s->copies; c++) {
+      m[c] = m[0];
+    }
+
+    for (c = 0; c < s->copies; c++) {
+      if (CheckAndMarkDupFilter(&m[c])) {
+        dups++;
+      }
+      received++;
+    }
+
+    clock_usec += 1000000 / s->rate;
+    now_times = (uint32_t)(clock_usec / 1000);
+    if (now_times >= next_age) {
+      AgeDupFilter();
+      next_age += DUPFILTER_AGE_INTERVAL;
+    }
+  }
+  usec = bench_usec() - start;
+
+  printf("p2pd_dup ipv%d originators=%u copies=%u rate=%u/s received=%u usec=%llu msgs/s=%.0f"
+         " duplicates=%u expired=%u grown=%u evicted=%u entries=%u size=%u\n",
+         olsr_cnf->ip_version == AF_INET ? 4 : 6, s->originators, s->copies, s->rate, received,
+         (unsigned long long)usec, usec ? received * 1000000.0 / usec : 0.0, dups,
+         DupFilterStats.expired, DupFilterStats.grown, DupFilterStats.evicted, DupFilterCount(), DupFilterSize());
+
+  if (dups != messages * (s->copies - 1)) {
+    printf("p2pd_dup: expected %u duplicates\n", messages * (s->copies - 1));
+  }
+
+  free(seqno);
+  free(m);
+}
+
+int
+main(int argc, char *argv[])
+{
+  uint32_t messages = argc > 1 ? (uint32_t)atoi(argv[1]) : 1000000;
+  size_t i;
+
+  bench_init(AF_INET);
+  for (i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+    bench_run(&scenarios[i], messages);
+  }
+
+  olsr_cnf->ip_version = AF_INET6;
+  olsr_cnf->ipsize = sizeof(struct in6_addr);
+  for (i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+    bench_run(&scenarios[i], messages);
+  }
+  return 0;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,536 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+/*
+ * Replays captured OLSR traffic through the preprocessors and
+ * parse_packet(), with the daemon clock taken from the capture.
+ * Ethernet, Linux cooked and raw IP captures in the classic pcap
+ * format are read, other traffic and ip fragments are skipped.
+ *
+ * -local should be the main address of the capturing node, so
+ * that its neighbors' HELLOs make the links symmetric and routes
+ * are calculated. -speed 0 (the default) replays as fast as
+ * possible, -speed x replays x times faster than captured.
+ *
+ * usage: pcap_replay [-ipv6] [-local addr] [-port n] [-speed x]
+ *                    [-lql level] [-lqa algorithm] [-d level]
+ *                    [-plugin lib [-pparam key value]...] file.pcap
+ */
+
+#include <sys/time.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+
+#include <pcap.h>
+
+#include "bench_util.h"
+#include "olsr.h"
+#include "olsr_cfg.h"
+#include "parser.h"
+#include "scheduler.h"
+#include "interfaces.h"
+#include "net_olsr.h"
+#include "link_set.h"
+#include "neighbor_table.h"
+#include "two_hop_neighbor_table.h"
+#include "tc_set.h"
+#include "mid_set.h"
+#include "hna_set.h"
+#include "routing_table.h"
+#include "plugin_loader.h"
+
+#define REPLAY_ETHERTYPE_IPV4 0x0800
+#define REPLAY_ETHERTYPE_IPV6 0x86dd
+#define REPLAY_ETHERTYPE_VLAN 0x8100
+#define REPLAY_ETHERTYPE_QINQ 0x88a8
+
+#define REPLAY_IPPROTO_UDP    17
+
+/* why a captured frame was not replayed */
+enum replay_skip {
+  REPLAY_OK,
+  REPLAY_NOT_OLSR,                     /* other traffic or the other ip version */
+  REPLAY_FRAGMENT,                     /* ip fragments are not reassembled */
+  REPLAY_TRUNCATED,                    /* capture snaplen too small */
+  REPLAY_OVERSIZE,                     /* larger than the daemon receive buffer */
+  REPLAY_SKIP_COUNT
+};
+
+static const char *const replay_skip_names[REPLAY_SKIP_COUNT] = {
+  "olsr_packets", "skipped_not_olsr", "skipped_fragment", "skipped_truncated", "skipped_oversize"
+};
+
+struct replay_stats {
+  uint64_t frames;
+  uint64_t skipped[REPLAY_SKIP_COUNT];
+  uint64_t own_packets;                /* sent by the local address */
+  uint64_t discarded;                  /* dropped by a preprocessor */
+  uint64_t bytes;
+  uint64_t parse_usec;                 /* preprocessors and parse_packet() */
+  uint64_t timer_usec;                 /* timers and route calculation */
+  uint64_t forwarded_bytes;
+};
+
+static void
+usage(void)
+{
+  fprintf(stderr, "usage: pcap_replay [-ipv6] [-local addr] [-port n] [-speed x]\n"
+          "                   [-lql level] [-lqa algorithm] [-d level]\n"
+          "                   [-plugin lib [-pparam key value]...] file.pcap\n");
+  exit(EXIT_FAILURE);
+}
+
+static uint16_t
+replay_get16(const unsigned char *p)
+{
+  return (uint16_t)(p[0] << 8 | p[1]);
+}
+
+/**
+ *Find the OLSR payload of a UDP datagram
+ *
+ *@param ip the ip header
+ *@param caplen the captured bytes from the ip header on
+ *@param from filled with the sender address
+ *@param payload filled with the start of the OLSR packet
+ *@param len filled with the size of the OLSR packet
+ *@return REPLAY_OK or the reason to skip the frame
+ */
+static enum replay_skip
+replay_decap_ip(const unsigned char *ip, uint32_t caplen, union olsr_ip_addr *from, const unsigned char **payload, uint32_t *len)
+{
+  const unsigned char *udp;
+  uint32_t hdrlen, udplen;
+  uint8_t proto;
+
+  if (caplen < 1 || (ip[0] >> 4) != (olsr_cnf->ip_version == AF_INET ? 4 : 6))
+    return REPLAY_NOT_OLSR;
+
+  if (olsr_cnf->ip_version == AF_INET) {
+    if (caplen < 20)
+      return REPLAY_TRUNCATED;
+    hdrlen = (ip[0] & 0x0f) * 4;
+    if (hdrlen < 20)
+      return REPLAY_NOT_OLSR;
+    if (ip[9] != REPLAY_IPPROTO_UDP)
+      return REPLAY_NOT_OLSR;
+    /* more fragments or a fragment offset */
+    if ((replay_get16(&ip[6]) & 0x3fff) != 0)
+      return REPLAY_FRAGMENT;
+    memcpy(&from->v4, &ip[12], sizeof(from->v4));
+  } else {
+    if (caplen < 40)
+      return REPLAY_TRUNCATED;
+    memcpy(&from->v6, &ip[8], sizeof(from->v6));
+
+    /* skip the extension headers an OLSR packet may carry */
+    hdrlen = 40;
+    proto = ip[6];
+    while (proto == 0 || proto == 43 || proto == 60) {
+      if (caplen < hdrlen + 2)
+        return REPLAY_TRUNCATED;
+      proto = ip[hdrlen];
+      hdrlen += (ip[hdrlen + 1] + 1) * 8;
+    }
+    if (proto == 44)
+      return REPLAY_FRAGMENT;
+    if (proto != REPLAY_IPPROTO_UDP)
+      return REPLAY_NOT_OLSR;
+  }
+
+  if (caplen < hdrlen + 8)
+    return REPLAY_TRUNCATED;
+  udp = ip + hdrlen;
+  if (replay_get16(&udp[2]) != olsr_cnf->olsrport)
+    return REPLAY_NOT_OLSR;
+
+  udplen = replay_get16(&udp[4]);
+  if (udplen < 8)
+    return REPLAY_NOT_OLSR;
+  if (caplen < hdrlen + udplen)
+    return REPLAY_TRUNCATED;
+
+  *payload = udp + 8;
+  *len = udplen - 8;
+  return *len > MAXMESSAGESIZE ? REPLAY_OVERSIZE : REPLAY_OK;
+}
+
+/**
+ *Strip the link layer header of a captured frame
+ *
+ *@return REPLAY_OK or the reason to skip the frame
+ */
+static enum replay_skip
+replay_decap(int dlt, const unsigned char *frame, uint32_t caplen, union olsr_ip_addr *from, const unsigned char **payload,
+             uint32_t *len)
+{
+  uint32_t offset;
+  uint16_t ethertype;
+
+  switch (dlt) {
+  case DLT_EN10MB:
+    offset = 12;
+    do {
+      if (caplen < offset + 2)
+        return REPLAY_TRUNCATED;
+      ethertype = replay_get16(&frame[offset]);
+      offset += ethertype == REPLAY_ETHERTYPE_VLAN || ethertype == REPLAY_ETHERTYPE_QINQ ? 4 : 2;
+    } while (ethertype == REPLAY_ETHERTYPE_VLAN || ethertype == REPLAY_ETHERTYPE_QINQ);
+    break;
+  case DLT_LINUX_SLL:
+    if (caplen < 16)
+      return REPLAY_TRUNCATED;
+    ethertype = replay_get16(&frame[14]);
+    offset = 16;
+    break;
+  case DLT_RAW:
+    ethertype = 0;
+    offset = 0;
+    break;
+  default:
+    return REPLAY_NOT_OLSR;
+  }
+
+  if (ethertype != 0 && ethertype != (olsr_cnf->ip_version == AF_INET ? REPLAY_ETHERTYPE_IPV4 : REPLAY_ETHERTYPE_IPV6))
+    return REPLAY_NOT_OLSR;
+
+  return replay_decap_ip(frame + offset, caplen - offset, from, payload, len);
+}
+
+/**
+ *Feed one OLSR packet to the daemon at the virtual time now
+ */
+static void
+replay_packet(struct replay_stats *st, struct interface *ifp, const unsigned char *payload, uint32_t len,
+              union olsr_ip_addr *from, uint32_t now)
+{
+  static union {
+    struct olsr packet;
+    uint32_t align;
+    char buf[MAXMESSAGESIZE + 1];
+  } in;
+  uint64_t t1, t2, t3;
+  char *packet;
+  int cc = len;
+
+  /* timers due before the packet arrived */
+  t1 = bench_usec();
+  now_times = now;
+  olsr_scheduler_round();
+  t2 = bench_usec();
+  st->timer_usec += t2 - t1;
+
+  /* are we talking to ourselves? */
+  if (if_ifwithaddr(from) != NULL) {
+    st->own_packets++;
+    return;
+  }
+
+  /* the parser converts the packet in place */
+  memcpy(in.buf, payload, len);
+  ifp->rx_packets++;
+  ifp->rx_bytes += len;
+  st->bytes += len;
+
+  packet = olsr_preprocess_packet(in.buf, ifp, from, &cc);
+  if (packet != NULL) {
+    parse_packet((struct olsr *)packet, cc, ifp, from, NULL);
+  } else {
+    st->discarded++;
+  }
+  t3 = bench_usec();
+  st->parse_usec += t3 - t2;
+
+  /*
+   * Nothing is sent, forwarded messages are dropped before the
+   * buffer timer flushes them. One packet never fills the buffer.
+   */
+  st->forwarded_bytes += ifp->netbuf.pending;
+  ifp->netbuf.pending = 0;
+}
+
+static void
+replay_print_tables(void)
+{
+  struct link_entry *link;
+  struct neighbor_entry *nbr;
+  struct neighbor_2_entry *nbr2;
+  struct tc_entry *tc;
+  struct mid_entry *mid;
+  struct mid_address *alias;
+  struct hna_entry *hna;
+  struct hna_net *net;
+  unsigned int links = 0, sym_links = 0, nbrs = 0, sym = 0, mprs = 0, twohop = 0, edges = 0, aliases = 0, nets = 0;
+  int idx;
+
+  OLSR_FOR_ALL_LINK_ENTRIES(link) {
+    links++;
+    if (lookup_link_status(link) == SYM_LINK)
+      sym_links++;
+  }
+  OLSR_FOR_ALL_LINK_ENTRIES_END(link);
+
+  OLSR_FOR_ALL_NBR_ENTRIES(nbr) {
+    nbrs++;
+    if (nbr->status == SYM)
+      sym++;
+    if (nbr->is_mpr)
+      mprs++;
+  }
+  OLSR_FOR_ALL_NBR_ENTRIES_END(nbr);
+
+  for (idx = 0; idx < HASHSIZE; idx++) {
+    for (nbr2 = two_hop_neighbortable[idx].next; nbr2 != &two_hop_neighbortable[idx]; nbr2 = nbr2->next) {
+      twohop++;
+    }
+    for (mid = mid_set[idx].next; mid != &mid_set[idx]; mid = mid->next) {
+      for (alias = mid->aliases; alias != NULL; alias = alias->next_alias) {
+        aliases++;
+      }
+    }
+  }
+
+  OLSR_FOR_ALL_TC_ENTRIES(tc) {
+    edges += tc->edge_tree.count;
+  }
+  OLSR_FOR_ALL_TC_ENTRIES_END(tc);
+
+  OLSR_FOR_ALL_HNA_ENTRIES(hna) {
+    for (net = hna->networks.next; net != &hna->networks; net = net->next) {
+      nets++;
+    }
+  }
+  OLSR_FOR_ALL_HNA_ENTRIES_END(hna);
+
+  printf("links %u\n", links);
+  printf("links_sym %u\n", sym_links);
+  printf("neighbors %u\n", nbrs);
+  printf("neighbors_sym %u\n", sym);
+  printf("mprs %u\n", mprs);
+  printf("two_hop_neighbors %u\n", twohop);
+  printf("tc_entries %u\n", tc_tree.count);
+  printf("tc_edges %u\n", edges);
+  printf("mid_aliases %u\n", aliases);
+  printf("hna_networks %u\n", nets);
+  printf("routes %u\n", routingtree.count);
+}
+
+int
+main(int argc, char *argv[])
+{
+  char errbuf[PCAP_ERRBUF_SIZE];
+  struct replay_stats st;
+  struct pcap_pkthdr *hdr;
+  const unsigned char *frame;
+  struct interface *ifp;
+  union olsr_ip_addr local;
+  struct plugin_entry *plugin = NULL;
+  const char *local_str = NULL, *file;
+  double speed = 0, capture, wall;
+  uint64_t first_usec = 0, last_usec = 0, wall_start, round_start;
+  uint32_t start_times = 0;
+  pcap_t *pcap;
+  int i, dlt, ret;
+  unsigned int type;
+
+  olsr_cnf = olsrd_get_default_cnf();
+  olsr_cnf->debug_level = 0;
+
+  for (i = 1; i < argc - 1; i++) {
+    const char *arg = argv[i];
+
+    if (strcmp(arg, "-ipv6") == 0) {
+      olsr_cnf->ip_version = AF_INET6;
+      continue;
+    }
+    if (i + 2 >= argc)
+      usage();
+    if (strcmp(arg, "-local") == 0)
+      local_str = argv[++i];
+    else if (strcmp(arg, "-port") == 0)
+      olsr_cnf->olsrport = atoi(argv[++i]);
+    else if (strcmp(arg, "-speed") == 0)
+      speed = atof(argv[++i]);
+    else if (strcmp(arg, "-lql") == 0)
+      olsr_cnf->lq_level = atoi(argv[++i]);
+    else if (strcmp(arg, "-lqa") == 0)
+      olsr_cnf->lq_algorithm = argv[++i];
+    else if (strcmp(arg, "-d") == 0)
+      olsr_cnf->debug_level = atoi(argv[++i]);
+    else if (strcmp(arg, "-plugin") == 0) {
+      plugin = olsr_malloc(sizeof(*plugin), "replay plugin");
+      plugin->name = argv[++i];
+      plugin->params = NULL;
+      plugin->next = olsr_cnf->plugins;
+      olsr_cnf->plugins = plugin;
+    } else if (strcmp(arg, "-pparam") == 0 && plugin != NULL && i + 3 < argc) {
+      struct plugin_param *param = olsr_malloc(sizeof(*param), "replay plugin param");
+
+      param->key = argv[++i];
+      param->value = argv[++i];
+      param->next = plugin->params;
+      plugin->params = param;
+    } else
+      usage();
+  }
+  if (i != argc - 1 || speed < 0)
+    usage();
+  file = argv[i];
+  debug_handle = stdout;
+
+  /* without -local the replay only listens, no link becomes symmetric */
+  if (local_str == NULL)
+    local_str = olsr_cnf->ip_version == AF_INET ? "192.0.2.1" : "2001:db8::1";
+  memset(&local, 0, sizeof(local));
+  if (inet_pton(olsr_cnf->ip_version, local_str, &local) != 1) {
+    fprintf(stderr, "pcap_replay: invalid local address %s\n", local_str);
+    return EXIT_FAILURE;
+  }
+
+  pcap = pcap_open_offline(file, errbuf);
+  if (pcap == NULL) {
+    fprintf(stderr, "pcap_replay: %s\n", errbuf);
+    return EXIT_FAILURE;
+  }
+  dlt = pcap_datalink(pcap);
+  if (dlt != DLT_EN10MB && dlt != DLT_LINUX_SLL && dlt != DLT_RAW) {
+    fprintf(stderr, "pcap_replay: unsupported link type %d\n", dlt);
+    return EXIT_FAILURE;
+  }
+
+  ifp = bench_init_daemon(&local, "replay0");
+  if (olsr_cnf->plugins != NULL)
+    olsr_load_plugins();
+  memset(&st, 0, sizeof(st));
+  memset(olsr_msgtype_stats, 0, sizeof(olsr_msgtype_stats));
+  start_times = now_times;
+  wall_start = bench_usec();
+
+  while ((ret = pcap_next_ex(pcap, &hdr, &frame)) >= 0) {
+    union olsr_ip_addr from;
+    const unsigned char *payload = NULL;
+    uint32_t len = 0;
+    uint64_t ts;
+    enum replay_skip skip;
+
+    if (ret == 0)
+      continue;
+
+    st.frames++;
+    ts = (uint64_t)hdr->ts.tv_sec * 1000000 + hdr->ts.tv_usec;
+    if (st.frames == 1)
+      first_usec = ts;
+    /* the clock must not run backwards on reordered captures */
+    if (ts > last_usec)
+      last_usec = ts;
+
+    memset(&from, 0, sizeof(from));
+    skip = replay_decap(dlt, frame, hdr->caplen, &from, &payload, &len);
+    st.skipped[skip]++;
+    if (skip != REPLAY_OK)
+      continue;
+
+    /* time-scaled replay waits for the wall clock to catch up */
+    if (speed > 0) {
+      uint64_t due = wall_start + (uint64_t)((last_usec - first_usec) / speed);
+      uint64_t now = bench_usec();
+
+      if (due > now)
+        usleep(due - now);
+    }
+
+    replay_packet(&st, ifp, payload, len, &from, start_times + (uint32_t)((last_usec - first_usec) / 1000));
+  }
+  if (ret == -1) {
+    fprintf(stderr, "pcap_replay: %s\n", pcap_geterr(pcap));
+  }
+  pcap_close(pcap);
+
+  /* process what the last packet changed */
+  round_start = bench_usec();
+  olsr_scheduler_round();
+  st.timer_usec += bench_usec() - round_start;
+
+  wall = (bench_usec() - wall_start) / 1e6;
+  capture = (last_usec - first_usec) / 1e6;
+
+  printf("file %s\n", file);
+  printf("link_type %s\n", pcap_datalink_val_to_name(dlt));
+  printf("frames %llu\n", (unsigned long long)st.frames);
+  for (i = 0; i < REPLAY_SKIP_COUNT; i++) {
+    printf("%s %llu\n", replay_skip_names[i], (unsigned long long)st.skipped[i]);
+  }
+  printf("own_packets %llu\n", (unsigned long long)st.own_packets);
+  printf("discarded_preprocessor %llu\n", (unsigned long long)st.discarded);
+  printf("bytes %llu\n", (unsigned long long)st.bytes);
+  printf("forwarded_bytes %llu\n", (unsigned long long)st.forwarded_bytes);
+  printf("capture_s %.3f\n", capture);
+  printf("wall_s %.3f\n", wall);
+  printf("parse_usec %llu\n", (unsigned long long)st.parse_usec);
+  printf("timer_usec %llu\n", (unsigned long long)st.timer_usec);
+  printf("packets_per_s %.1f\n",
+         st.parse_usec + st.timer_usec ? st.skipped[REPLAY_OK] * 1e6 / (st.parse_usec + st.timer_usec) : 0.0);
+  if (wall > 0)
+    printf("speedup %.1f\n", capture / wall);
+
+  for (type = 0; type < 256; type++) {
+    const struct olsr_msgtype_stats *s = &olsr_msgtype_stats[type];
+
+    if (s->messages == 0 && s->dropped_invalid == 0)
+      continue;
+    printf("msgtype type=%s messages=%u duplicates=%u forwarded=%u invalid=%u bytes=%llu sampled=%u wall_nsec/msg=%.1f\n",
+           olsr_msgtype_to_string(type), s->messages, s->duplicates, s->forwarded, s->dropped_invalid,
+           (unsigned long long)s->bytes, s->handler_samples,
+           s->handler_samples ? s->handler_usec * 1000.0 / s->handler_samples : 0.0);
+  }
+
+  replay_print_tables();
+  return 0;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,253 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/*
+ * Measures how many packets per second the secure plugin can sign and
+ * verify. The baseline is the MD5 path as it used to be, copying the
+ * packet and the key into one buffer and hashing that, next to the
+ * streaming MD5 digest and, when built with USE_OPENSSL, the SHA-1
+ * scheme and HMAC-SHA256.
+ *
+ * usage: secure_bench [packets]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "bench_util.h"
+#include "olsr.h"
+#include "md5.h"
+#include "secure_digest.h"
+
+#ifdef USE_OPENSSL
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#endif
+
+/* packet sizes, up to a full ethernet frame */
+static const size_t sizes[] = { 64, 256, 512, 1400 };
+
+static uint8_t key[KEYLENGTH];
+
+enum bench_digest {
+  BENCH_MD5_COPY,
+  BENCH_MD5,
+#ifdef USE_OPENSSL
+  BENCH_SHA1,
+  BENCH_HMAC_SHA256,
+#endif
+  BENCH_DIGESTS
+};
+
+static const char *digest_names[] = {
+  "md5-copy",
+  "md5",
+#ifdef USE_OPENSSL
+  "sha1",
+  "hmac-sha256",
+#endif
+};
+
+static void
+bench_md5(const uint8_t *data, size_t len, uint8_t *sig)
+{
+  MD5_CTX ctx;
+
+  MD5Init(&ctx);
+  MD5Update(&ctx, data, len);
+  MD5Update(&ctx, key, KEYLENGTH);
+  MD5Final(sig, &ctx);
+}
+
+/* the signing of the plugin before the keyed digests */
+static void
+bench_md5_copy(const uint8_t *data, size_t len, uint8_t *sig)
+{
+  uint8_t checksum_cache[1500 + KEYLENGTH];
+  MD5_CTX ctx;
+
+  memcpy(checksum_cache, data, len);
+  memcpy(&checksum_cache[len], key, KEYLENGTH);
+
+  MD5Init(&ctx);
+  MD5Update(&ctx, checksum_cache, len + KEYLENGTH);
+  MD5Final(sig, &ctx);
+}
+
+static void
+bench_sign(enum bench_digest d, const uint8_t *data, size_t len, uint8_t *sig)
+{
+  switch (d) {
+  case BENCH_MD5_COPY:
+    bench_md5_copy(data, len, sig);
+    break;
+  case BENCH_MD5:
+    bench_md5(data, len, sig);
+    break;
+#ifdef USE_OPENSSL
+  case BENCH_SHA1:
+    secure_digest(SHA1_INCLUDING_KEY, data, len, sig);
+    break;
+  case BENCH_HMAC_SHA256:
+    secure_digest(HMAC_SHA256, data, len, sig);
+    break;
+#endif
+  default:
+    break;
+  }
+}
+
+/**
+ *Compare the digests against the reference implementations
+ *
+ *@return 0 if all of them match
+ */
+static int
+bench_check(const uint8_t *data, size_t len)
+{
+  uint8_t a[SIGNATURE_SIZE], b[SIGNATURE_SIZE];
+  int errors = 0;
+
+  bench_md5(data, len, a);
+  bench_md5_copy(data, len, b);
+  if (memcmp(a, b, 16) != 0) {
+    printf("secure: md5 digest mismatch for %lu bytes\n", (unsigned long)len);
+    errors++;
+  }
+#ifdef USE_OPENSSL
+  {
+    uint8_t hmac[EVP_MAX_MD_SIZE];
+    unsigned int hmac_len;
+
+    secure_digest(HMAC_SHA256, data, len, a);
+    HMAC(EVP_sha256(), key, KEYLENGTH, data, len, hmac, &hmac_len);
+    if (memcmp(a, hmac, SIGNATURE_SIZE) != 0) {
+      printf("secure: hmac-sha256 digest mismatch for %lu bytes\n", (unsigned long)len);
+      errors++;
+    }
+  }
+#endif
+  return errors;
+}
+
+static void
+bench_run(enum bench_digest d, size_t len, uint32_t packets)
+{
+  uint8_t *pck = olsr_malloc(len, "bench packet");
+  uint8_t sig[SIGNATURE_SIZE], check[SIGNATURE_SIZE];
+  uint64_t start, sign_usec, verify_usec;
+  uint32_t i, bad = 0;
+
+  for (i = 0; i < len; i++) {
+    pck[i] = bench_random();
+  }
+
+  /* sign: the packet changes (sequence number) every time */
+  start = bench_usec();
+  for (i = 0; i < packets; i++) {
+    pck[2] = i >> 8;
+    pck[3] = i;
+    bench_sign(d, pck, len - SIGNATURE_SIZE, &pck[len - SIGNATURE_SIZE]);
+  }
+  sign_usec = bench_usec() - start;
+
+  /* verify: digest the received packet and compare */
+  memcpy(sig, &pck[len - SIGNATURE_SIZE], SIGNATURE_SIZE);
+  start = bench_usec();
+  for (i = 0; i < packets; i++) {
+    bench_sign(d, pck, len - SIGNATURE_SIZE, check);
+    if (memcmp(check, sig, d == BENCH_MD5_COPY || d == BENCH_MD5 ? 16 : SIGNATURE_SIZE) != 0) {
+      bad++;
+    }
+  }
+  verify_usec = bench_usec() - start;
+
+  printf("secure digest=%s size=%lu packets=%u sign_usec=%llu sign/s=%.0f verify_usec=%llu verify/s=%.0f MB/s=%.1f\n",
+         digest_names[d], (unsigned long)len, packets, (unsigned long long)sign_usec,
+         sign_usec ? packets * 1000000.0 / sign_usec : 0.0, (unsigned long long)verify_usec,
+         verify_usec ? packets * 1000000.0 / verify_usec : 0.0, verify_usec ? (double)packets * len / verify_usec : 0.0);
+  if (bad) {
+    printf("secure: %u packets failed to verify\n", bad);
+  }
+
+  free(pck);
+}
+
+int
+main(int argc, char *argv[])
+{
+  uint32_t packets = argc > 1 ? (uint32_t)atoi(argv[1]) : 200000;
+  uint8_t data[1500];
+  size_t i;
+  int d, errors = 0;
+
+  bench_init(AF_INET);
+  for (i = 0; i < sizeof(key); i++) {
+    key[i] = bench_random();
+  }
+  for (i = 0; i < sizeof(data); i++) {
+    data[i] = bench_random();
+  }
+  secure_digest_init(key);
+
+#ifdef USE_OPENSSL
+  printf("secure library=\"%s\"\n", SSLeay_version(SSLEAY_VERSION));
+#endif
+
+  for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    errors += bench_check(data, sizes[i] - SIGNATURE_SIZE);
+  }
+  for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    for (d = 0; d < BENCH_DIGESTS; d++) {
+      bench_run(d, sizes[i], packets);
+    }
+  }
+  return errors ? 1 : 0;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -732,6 +732,37 @@ olsr_recvfrom(int s, void *buf, size_t len, int flags __attribute__ ((unused)),
   return (count);
 }
 
+/**
+ * Time the datagram last read from a socket was received.
+ * There is no timestamp of the packet here, so this is the
+ * current time and includes the wait for the socket poll.
+ */
+
+void
+olsr_recv_time(int s __attribute__ ((unused)), struct timeval *stamp)
+{
+  gettimeofday(stamp, NULL);
+}
+
+/**
+ * Switch a socket to non-blocking mode, so the callbacks
+ * of the socket poll loop never wait for a peer.
+ *
+ *@param fd the socket
+ *@return -1 on error, 0 otherwise
+ */
+
+int
+olsr_set_nonblocking(int fd)
+{
+  int flags = fcntl(fd, F_GETFL, 0);
+
+  if (flags == -1) {
+    return -1;
+  }
+  return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
 /**
  * Wrapper for select(2)
  */
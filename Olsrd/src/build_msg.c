@@ -650,6 +650,9 @@ serialize_tc4(struct tc_message *message, struct interface *ifp)
     m->v4.seqno = htons(get_msg_seqno());
 
     net_outbuffer_push(ifp, msg_buffer, curr_size);
+    if (!partial_sent) {
+      olsr_msg_cache_store(ifp, MSG_CACHE_TC, message->ansn, msg_buffer, curr_size);
+    }
 
   } else {
     if ((!partial_sent) && (!TIMED_OUT(send_empty_tc))) {
@@ -761,6 +764,9 @@ serialize_tc6(struct tc_message *message, struct interface *ifp)
     m->v6.seqno = htons(get_msg_seqno());
 
     net_outbuffer_push(ifp, msg_buffer, curr_size);
+    if (!partial_sent) {
+      olsr_msg_cache_store(ifp, MSG_CACHE_TC, message->ansn, msg_buffer, curr_size);
+    }
 
   } else {
     if ((!partial_sent) && (!TIMED_OUT(send_empty_tc))) {
@@ -794,10 +800,14 @@ serialize_mid4(struct interface *ifp)
   union olsr_message *m;
   struct midaddr *addrs;
   struct interface *ifs;
+  bool partial_sent = false;
 
   if ((olsr_cnf->ip_version != AF_INET) || (!ifp) || (ifnet == NULL) || ((ifnet->int_next == NULL) && (ipequal(&olsr_cnf->main_addr, &ifnet->ip_addr))))
     return false;
 
+  if (olsr_msg_cache_output(ifp, MSG_CACHE_MID, 0, MAX_TTL))
+    return true;
+
   remainsize = net_outbuffer_bytes_left(ifp);
 
   m = (union olsr_message *)msg_buffer;
@@ -847,6 +857,7 @@ serialize_mid4(struct interface *ifp)
           net_outbuffer_push(ifp, msg_buffer, curr_size);
           curr_size = OLSR_MID_IPV4_HDRSIZE;
           addrs = m->v4.message.mid.mid_addr;
+          partial_sent = true;
         }
         net_output(ifp);
         remainsize = net_outbuffer_bytes_left(ifp);
@@ -866,8 +877,12 @@ serialize_mid4(struct interface *ifp)
   m->v4.olsr_msgsize = htons(curr_size);
 
   //printf("Sending MID (%d bytes)...\n", outputsize);
-  if (curr_size > OLSR_MID_IPV4_HDRSIZE)
+  if (curr_size > OLSR_MID_IPV4_HDRSIZE) {
     net_outbuffer_push(ifp, msg_buffer, curr_size);
+    if (!partial_sent) {
+      olsr_msg_cache_store(ifp, MSG_CACHE_MID, 0, msg_buffer, curr_size);
+    }
+  }
 
   return true;
 }
@@ -888,12 +903,16 @@ serialize_mid6(struct interface *ifp)
   union olsr_message *m;
   struct midaddr6 *addrs6;
   struct interface *ifs;
+  bool partial_sent = false;
 
   //printf("\t\tGenerating mid on %s\n", ifn->int_name);
 
   if ((olsr_cnf->ip_version != AF_INET6) || (!ifp) || (ifnet == NULL) || ((ifnet->int_next == NULL) && (ipequal(&olsr_cnf->main_addr, &ifnet->ip_addr))))
     return false;
 
+  if (olsr_msg_cache_output(ifp, MSG_CACHE_MID, 0, MAX_TTL))
+    return true;
+
   remainsize = net_outbuffer_bytes_left(ifp);
 
   curr_size = OLSR_MID_IPV6_HDRSIZE;
@@ -942,6 +961,7 @@ serialize_mid6(struct interface *ifp)
           net_outbuffer_push(ifp, msg_buffer, curr_size);
           curr_size = OLSR_MID_IPV6_HDRSIZE;
           addrs6 = m->v6.message.mid.mid_addr;
+          partial_sent = true;
         }
         net_output(ifp);
         remainsize = net_outbuffer_bytes_left(ifp);
@@ -961,8 +981,12 @@ serialize_mid6(struct interface *ifp)
   m->v6.seqno = htons(get_msg_seqno()); /* seqnumber */
 
   //printf("Sending MID (%d bytes)...\n", outputsize);
-  if (curr_size > OLSR_MID_IPV6_HDRSIZE)
+  if (curr_size > OLSR_MID_IPV6_HDRSIZE) {
     net_outbuffer_push(ifp, msg_buffer, curr_size);
+    if (!partial_sent) {
+      olsr_msg_cache_store(ifp, MSG_CACHE_MID, 0, msg_buffer, curr_size);
+    }
+  }
 
   return true;
 }
@@ -981,6 +1005,7 @@ serialize_hna4(struct interface *ifp)
   union olsr_message *m;
   struct hnapair *pair;
   struct ip_prefix_list *h;
+  bool partial_sent = false;
 
   /* No hna nets */
   if (ifp == NULL) {
@@ -994,6 +1019,10 @@ serialize_hna4(struct interface *ifp)
     return false;
   }
 
+  if (olsr_msg_cache_output(ifp, MSG_CACHE_HNA, olsr_cnf->hna_version, MAX_TTL)) {
+    return false;
+  }
+
   remainsize = net_outbuffer_bytes_left(ifp);
 
   curr_size = OLSR_HNA_IPV4_HDRSIZE;
@@ -1038,6 +1067,7 @@ serialize_hna4(struct interface *ifp)
         net_outbuffer_push(ifp, msg_buffer, curr_size);
         curr_size = OLSR_HNA_IPV4_HDRSIZE;
         pair = m->v4.message.hna.hna_net;
+        partial_sent = true;
       }
       net_output(ifp);
       remainsize = net_outbuffer_bytes_left(ifp);
@@ -1064,6 +1094,9 @@ serialize_hna4(struct interface *ifp)
   m->v4.olsr_msgsize = htons(curr_size);
 
   net_outbuffer_push(ifp, msg_buffer, curr_size);
+  if (!partial_sent) {
+    olsr_msg_cache_store(ifp, MSG_CACHE_HNA, olsr_cnf->hna_version, msg_buffer, curr_size);
+  }
 
   //printf("Sending HNA (%d bytes)...\n", outputsize);
   return false;
@@ -1084,11 +1117,15 @@ serialize_hna6(struct interface *ifp)
   struct hnapair6 *pair6;
   union olsr_ip_addr tmp_netmask;
   struct ip_prefix_list *h = olsr_cnf->hna_entries;
+  bool partial_sent = false;
 
   /* No hna nets */
   if ((olsr_cnf->ip_version != AF_INET6) || (!ifp) || h == NULL)
     return false;
 
+  if (olsr_msg_cache_output(ifp, MSG_CACHE_HNA, olsr_cnf->hna_version, MAX_TTL))
+    return false;
+
   remainsize = net_outbuffer_bytes_left(ifp);
 
   curr_size = OLSR_HNA_IPV6_HDRSIZE;
@@ -1132,6 +1169,7 @@ serialize_hna6(struct interface *ifp)
         net_outbuffer_push(ifp, msg_buffer, curr_size);
         curr_size = OLSR_HNA_IPV6_HDRSIZE;
         pair6 = m->v6.message.hna.hna_net;
+        partial_sent = true;
       }
       net_output(ifp);
       remainsize = net_outbuffer_bytes_left(ifp);
@@ -1158,6 +1196,9 @@ serialize_hna6(struct interface *ifp)
   m->v6.seqno = htons(get_msg_seqno());
 
   net_outbuffer_push(ifp, msg_buffer, curr_size);
+  if (!partial_sent) {
+    olsr_msg_cache_store(ifp, MSG_CACHE_HNA, olsr_cnf->hna_version, msg_buffer, curr_size);
+  }
 #if 0
   printf("Sending HNA (%d bytes)...\n", outputsize);
 #endif
@@ -1013,6 +1013,10 @@ ip_prefix_list_add(struct ip_prefix_list **list, const union olsr_ip_addr *net,
   new_entry->next = *list;
   *list = new_entry;
 
+  if (list == &olsr_cnf->hna_entries) {
+    olsr_cnf->hna_version++;
+  }
+
   /* update gateway flags */
   update_has_gateway_fields();
 }
@@ -1032,6 +1036,10 @@ ip_prefix_list_remove(struct ip_prefix_list **list, const union olsr_ip_addr *ne
       }
       free(h);
 
+      if (list == &olsr_cnf->hna_entries) {
+        olsr_cnf->hna_version++;
+      }
+
       /* update gateway flags */
       update_has_gateway_fields();
       return 1;
@@ -0,0 +1,146 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+#include "change_notify.h"
+#include "olsr.h"
+
+#include <stdlib.h>
+
+struct change_handler_entry {
+  olsr_change_handler function;
+  struct change_handler_entry *next;
+};
+
+static struct change_handler_entry *change_handlers;
+
+/**
+ *Register a function to be called for every change
+ *of a link, TC edge, route, HNA or MID entry.
+ *
+ *@param f the function to register
+ */
+void
+olsr_add_change_handler(olsr_change_handler f)
+{
+  struct change_handler_entry *new_entry;
+
+  new_entry = olsr_malloc(sizeof(*new_entry), "change handler");
+  new_entry->function = f;
+  new_entry->next = change_handlers;
+  change_handlers = new_entry;
+}
+
+/**
+ *Remove a registered change handler.
+ *
+ *@param f the function to remove
+ */
+void
+olsr_remove_change_handler(olsr_change_handler f)
+{
+  struct change_handler_entry **entry;
+
+  for (entry = &change_handlers; *entry != NULL; entry = &(*entry)->next) {
+    if ((*entry)->function == f) {
+      struct change_handler_entry *old = *entry;
+      *entry = old->next;
+      free(old);
+      return;
+    }
+  }
+}
+
+/**
+ *Report a change to all registered handlers.
+ *
+ *@param type the kind of change
+ *@param addr1 first address, see struct olsr_change
+ *@param addr2 second address, see struct olsr_change
+ *@param prefix_len prefix length of addr1 for routes and HNA
+ *@param cost the (new) cost of the entry
+ *@param hops hopcount of a route
+ */
+void
+olsr_notify_change(enum olsr_change_type type, const union olsr_ip_addr *addr1, const union olsr_ip_addr *addr2,
+                   uint8_t prefix_len, olsr_linkcost cost, uint32_t hops)
+{
+  struct change_handler_entry *entry;
+  struct olsr_change change;
+
+  if (change_handlers == NULL) {
+    return;
+  }
+
+  change.type = type;
+  change.addr1 = addr1;
+  change.addr2 = addr2;
+  change.prefix_len = prefix_len;
+  change.hops = hops;
+  change.cost = cost;
+
+  for (entry = change_handlers; entry != NULL; entry = entry->next) {
+    entry->function(&change);
+  }
+}
+
+const char *
+olsr_change_type_to_string(enum olsr_change_type type)
+{
+  static const char *const names[] = {
+    "UNKNOWN",
+    "LINK_ADD", "LINK_DEL", "LINK_COST",
+    "TC_EDGE_ADD", "TC_EDGE_DEL", "TC_EDGE_COST",
+    "ROUTE_ADD", "ROUTE_CHG", "ROUTE_DEL",
+    "HNA_ADD", "HNA_DEL",
+    "MID_ADD", "MID_DEL"
+  };
+
+  if ((unsigned int)type >= sizeof(names) / sizeof(*names)) {
+    return names[0];
+  }
+  return names[type];
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
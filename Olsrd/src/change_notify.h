@@ -0,0 +1,112 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+#ifndef _OLSR_CHANGE_NOTIFY_H
+#define _OLSR_CHANGE_NOTIFY_H
+
+#include "olsr_types.h"
+#include "lq_plugin.h"
+
+/*
+ * Fine grained notification of changes in the link set, the topology
+ * set, the routing table, the HNA set and the MID set.
+ *
+ * Unlike the pcf hook, which tells once per change processing run which
+ * tables changed, a change handler is called for every single entry
+ * that was added, removed or changed its cost, at the place where the
+ * change happens. Handlers must not modify any table. The state
+ * needed to detect changes is kept even while no handler is
+ * registered, so handlers may come and go at any time.
+ */
+
+enum olsr_change_type {
+  OLSR_CHG_LINK_ADD = 1,
+  OLSR_CHG_LINK_DEL,
+  OLSR_CHG_LINK_COST,
+  OLSR_CHG_TC_EDGE_ADD,
+  OLSR_CHG_TC_EDGE_DEL,
+  OLSR_CHG_TC_EDGE_COST,
+  OLSR_CHG_ROUTE_ADD,
+  OLSR_CHG_ROUTE_CHG,
+  OLSR_CHG_ROUTE_DEL,
+  OLSR_CHG_HNA_ADD,
+  OLSR_CHG_HNA_DEL,
+  OLSR_CHG_MID_ADD,
+  OLSR_CHG_MID_DEL
+};
+
+/*
+ * addr1/addr2 per type:
+ *   LINK     local interface address / neighbor interface address
+ *   TC_EDGE  originator (last hop) / destination
+ *   ROUTE    destination prefix / gateway
+ *   HNA      network prefix / gateway
+ *   MID      main address / alias
+ * prefix_len is only used for ROUTE and HNA, hops only for ROUTE.
+ * The pointers are only valid during the call of the handler.
+ */
+struct olsr_change {
+  enum olsr_change_type type;
+  const union olsr_ip_addr *addr1;
+  const union olsr_ip_addr *addr2;
+  uint8_t prefix_len;
+  uint32_t hops;
+  olsr_linkcost cost;
+};
+
+typedef void (*olsr_change_handler) (const struct olsr_change *);
+
+void olsr_add_change_handler(olsr_change_handler);
+
+void olsr_remove_change_handler(olsr_change_handler);
+
+void olsr_notify_change(enum olsr_change_type, const union olsr_ip_addr *, const union olsr_ip_addr *, uint8_t,
+                        olsr_linkcost, uint32_t);
+
+const char *olsr_change_type_to_string(enum olsr_change_type);
+
+#endif
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
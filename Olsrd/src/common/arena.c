@@ -0,0 +1,140 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004-2009, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+#include "common/arena.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define ROUND_UP(size) (((size) + ARENA_ALIGN - 1) & ~((size_t)ARENA_ALIGN - 1))
+#define ARENA_HEADER ROUND_UP(sizeof(struct arena_chunk))
+
+static struct arena_chunk *
+arena_add_chunk(struct arena *arena, size_t size)
+{
+  struct arena_chunk *chunk = malloc(ARENA_HEADER + size);
+
+  if (chunk == NULL) {
+    return NULL;
+  }
+  chunk->size = size;
+  chunk->next = arena->chunk;
+  arena->chunk = chunk;
+  arena->used = 0;
+  arena->total += size;
+  return chunk;
+}
+
+/**
+ *Allocate zeroed memory from an arena
+ *
+ *@param arena the arena to allocate from
+ *@param size number of bytes
+ *@return pointer to the memory, NULL if out of memory
+ */
+void *
+arena_alloc(struct arena *arena, size_t size)
+{
+  void *p;
+
+  size = ROUND_UP(size);
+  if (arena->chunk == NULL || arena->used + size > arena->chunk->size) {
+    size_t chunk_size = arena->total > ARENA_MIN_CHUNK ? arena->total : ARENA_MIN_CHUNK;
+
+    while (chunk_size < size) {
+      chunk_size *= 2;
+    }
+    if (arena_add_chunk(arena, chunk_size) == NULL) {
+      return NULL;
+    }
+  }
+
+  p = (char *)arena->chunk + ARENA_HEADER + arena->used;
+  arena->used += size;
+  memset(p, 0, size);
+  return p;
+}
+
+/**
+ *Release all allocations of an arena. The memory is kept
+ *for the next cycle, combined into a single chunk.
+ *
+ *@param arena the arena to reset
+ */
+void
+arena_reset(struct arena *arena)
+{
+  size_t total = arena->total;
+
+  arena->used = 0;
+  if (arena->chunk == NULL || arena->chunk->next == NULL) {
+    return;
+  }
+
+  /* more than one chunk, replace them with one big enough for all */
+  arena_free(arena);
+  arena_add_chunk(arena, total);
+}
+
+/**
+ *Release all memory of an arena
+ *
+ *@param arena the arena to free
+ */
+void
+arena_free(struct arena *arena)
+{
+  while (arena->chunk) {
+    struct arena_chunk *chunk = arena->chunk;
+
+    arena->chunk = chunk->next;
+    free(chunk);
+  }
+  arena->used = 0;
+  arena->total = 0;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
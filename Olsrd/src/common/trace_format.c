@@ -0,0 +1,162 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+#include "common/trace_format.h"
+
+#include <stdio.h>
+#include <string.h>
+#ifdef WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif
+
+/**
+ *Render a trace record as text
+ *
+ *The format is printf like: %a takes the next address, %u, %d
+ *and %x the next argument (with optional flags and width), %c
+ *and %r the next argument as link or route cost, and %t prints
+ *the time of the record.
+ *
+ *@param buf the buffer to write to
+ *@param size the size of the buffer, at least 1
+ *@param format the format of the event
+ *@param rec the record
+ *@param ip_version 4 or 6
+ *@param tz_offset seconds to add to the time of the record
+ *@param cost_text renders costs, NULL to print them as numbers
+ *@return the length of the text
+ */
+int
+olsr_trace_format(char *buf, size_t size, const char *format, const struct olsr_trace_record *rec,
+                  int ip_version, int tz_offset, olsr_trace_cost_text cost_text)
+{
+  unsigned int next_addr = 0, next_arg = 0;
+  size_t len = 0;
+  const char *f;
+
+  for (f = format; *f != 0 && len + 1 < size; f++) {
+    char spec[16], text[64];
+    const char *conv, *out = text;
+    uint32_t value = 0;
+    size_t n;
+
+    if (*f != '%') {
+      buf[len++] = *f;
+      continue;
+    }
+
+    conv = f + 1 + strspn(f + 1, "0123456789-");
+    if (*conv == 0 || (size_t)(conv - f) + 2 > sizeof(spec)) {
+      break;
+    }
+    if (strchr("ucrdx", *conv) != NULL && next_arg < OLSR_TRACE_ARGS) {
+      value = rec->arg[next_arg++];
+    }
+
+    switch (*conv) {
+    case 'a':
+      if (next_addr < OLSR_TRACE_ADDRS && (rec->addr_mask & (1 << next_addr)) != 0) {
+        out = inet_ntop(ip_version == 6 ? AF_INET6 : AF_INET, rec->addr[next_addr], text, sizeof(text));
+      } else {
+        out = "-";
+      }
+      next_addr++;
+      break;
+    case 'c':
+    case 'r':
+      if (cost_text != NULL) {
+        out = cost_text(value, *conv == 'r', text, sizeof(text));
+      } else {
+        snprintf(text, sizeof(text), "%u", value);
+      }
+      break;
+    case 'u':
+    case 'x':
+    case 'd':
+      memcpy(spec, f, conv - f + 1);
+      spec[conv - f + 1] = 0;
+      if (*conv == 'd') {
+        snprintf(text, sizeof(text), spec, (int)(int32_t)value);
+      } else {
+        snprintf(text, sizeof(text), spec, (unsigned int)value);
+      }
+      break;
+    case 't':
+      {
+        int sec = (int)rec->sec + tz_offset;
+
+        snprintf(text, sizeof(text), "%02d:%02d:%02d.%06u", (sec % 86400) / 3600, (sec % 3600) / 60, sec % 60,
+                 (unsigned int)rec->usec);
+      }
+      break;
+    case '%':
+      out = "%";
+      break;
+    default:
+      /* unknown conversions are copied */
+      memcpy(text, f, conv - f + 1);
+      text[conv - f + 1] = 0;
+      break;
+    }
+
+    if (out == NULL) {
+      out = "?";
+    }
+    n = snprintf(buf + len, size - len, "%s", out);
+    len += n < size - len ? n : size - len - 1;
+    f = conv;
+  }
+
+  buf[len] = 0;
+  return len;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
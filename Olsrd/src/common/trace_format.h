@@ -0,0 +1,109 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+#ifndef _COMMON_TRACE_FORMAT_H
+#define _COMMON_TRACE_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Binary trace records and the trace file layout, shared by the
+ * daemon and the offline decoder. This does not depend on anything
+ * else of the daemon, so the decoder can be built on its own.
+ *
+ * A trace file starts with a struct olsr_trace_file_header, followed
+ * by event_count event descriptions, each a struct olsr_trace_event_desc
+ * followed by the name and the format (without terminating zero).
+ * The rest of the file are records, in the byte order of the writer.
+ */
+
+#define OLSR_TRACE_MAGIC        "OLSRTRC"
+#define OLSR_TRACE_VERSION      1
+#define OLSR_TRACE_BYTE_ORDER   0x01020304
+
+#define OLSR_TRACE_ADDRS        2
+#define OLSR_TRACE_ARGS         5
+
+struct olsr_trace_record {
+  uint32_t sec;                        /* wallclock of the event */
+  uint32_t usec;
+  uint16_t id;
+  uint8_t addr_mask;                   /* bit n set if addr[n] is valid */
+  uint8_t reserved;
+  uint8_t addr[OLSR_TRACE_ADDRS][16];  /* IPv4 addresses use the first 4 bytes */
+  uint32_t arg[OLSR_TRACE_ARGS];
+};
+
+struct olsr_trace_file_header {
+  char magic[8];
+  uint32_t byte_order;
+  uint16_t version;
+  uint16_t record_size;
+  uint16_t ip_version;                 /* 4 or 6 */
+  uint16_t event_count;
+  int32_t tz_offset;                   /* seconds east of UTC of the writer */
+};
+
+struct olsr_trace_event_desc {
+  uint16_t id;
+  uint16_t name_len;
+  uint16_t format_len;
+  uint16_t reserved;
+};
+
+/*
+ * Renders a link cost, the decoder has no LQ plugin and prints
+ * the raw value if none is given.
+ */
+typedef const char *(*olsr_trace_cost_text) (uint32_t cost, int route, char *buf, size_t size);
+
+int olsr_trace_format(char *buf, size_t size, const char *format, const struct olsr_trace_record *rec,
+                      int ip_version, int tz_offset, olsr_trace_cost_text cost_text);
+
+#endif
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
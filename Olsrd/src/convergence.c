@@ -0,0 +1,357 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+#include "convergence.h"
+#include "olsr.h"
+#include "scheduler.h"
+#include "trace.h"
+
+#include <string.h>
+
+/* the cause the daemon is working on right now */
+struct conv_context {
+  enum olsr_conv_cause cause;
+  uint8_t msgtype;
+  const union olsr_ip_addr *originator;
+  const struct timeval *rx_time;       /* receipt of the packet carrying the message */
+  const struct olsr_cookie_info *cookie;
+  bool silent;                         /* the timer gave up on a link ... */
+  uint32_t silent_since;               /* ... last heard of at this clock tick */
+  unsigned int changes;                /* change flags set before the cause started */
+};
+
+enum conv_batch_state {
+  CONV_BATCH_NONE,
+  CONV_BATCH_PENDING,                  /* waiting for the route calculation */
+  CONV_BATCH_SPF,
+  CONV_BATCH_KERNEL
+};
+
+/* the changes on their way to the kernel */
+struct conv_batch {
+  enum conv_batch_state state;
+  uint32_t cause_id;                   /* 0 for route calculations without a cause */
+  struct timeval cause_time;
+  struct timeval spf_start;
+  struct timeval spf_done;
+};
+
+struct olsr_conv_stats olsr_conv_stats;
+
+const char *const olsr_conv_stage_names[OLSR_CONV_STAGE_MAX] = {
+  [OLSR_CONV_DETECT] = "detect",
+  [OLSR_CONV_FORWARD] = "forward",
+  [OLSR_CONV_QUEUE] = "queue",
+  [OLSR_CONV_SPF] = "spf",
+  [OLSR_CONV_KERNEL] = "kernel",
+  [OLSR_CONV_TOTAL] = "total",
+};
+
+static struct conv_context conv_context;
+static struct conv_batch conv_batch;
+static uint32_t conv_cause_id;
+
+/* change flags */
+#define CONV_CHANGES_NEIGHBORHOOD 1
+#define CONV_CHANGES_TOPOLOGY     2
+#define CONV_CHANGES_HNA          4
+
+/**
+ * The change flags currently set.
+ */
+static unsigned int
+conv_changes_set(void)
+{
+  return (changes_neighborhood ? CONV_CHANGES_NEIGHBORHOOD : 0) | (changes_topology ? CONV_CHANGES_TOPOLOGY : 0)
+    | (changes_hna ? CONV_CHANGES_HNA : 0);
+}
+
+/**
+ * Microseconds from one timestamp to a later one.
+ * Returns 0 if the clock went backwards.
+ */
+static uint64_t
+conv_usec(const struct timeval *from, const struct timeval *to)
+{
+  struct timeval diff;
+
+  if (timercmp(to, from, <)) {
+    return 0;
+  }
+  timersub(to, from, &diff);
+  return (uint64_t)diff.tv_sec * 1000000 + diff.tv_usec;
+}
+
+/**
+ * Count a latency in the histogram of a stage.
+ */
+static void
+conv_record(enum olsr_conv_stage stage, uint64_t usec)
+{
+  struct olsr_conv_histogram *h = &olsr_conv_stats.stage[stage];
+  unsigned int i = 0;
+
+  while (i < OLSR_CONV_BUCKETS - 1 && usec > OLSR_CONV_BUCKET_BOUND(i)) {
+    i++;
+  }
+  h->bucket[i]++;
+  h->count++;
+  h->usec += usec;
+  if (usec > h->max_usec) {
+    h->max_usec = usec > UINT32_MAX ? UINT32_MAX : usec;
+  }
+}
+
+/**
+ * Start a new batch of changes with the current cause.
+ */
+static void
+conv_open_batch(void)
+{
+  if (++conv_cause_id == 0) {
+    conv_cause_id = 1;
+  }
+  conv_batch.state = CONV_BATCH_PENDING;
+  conv_batch.cause_id = conv_cause_id;
+
+  switch (conv_context.cause) {
+  case OLSR_CONV_CAUSE_MESSAGE:
+    conv_batch.cause_time = *conv_context.rx_time;
+    OLSR_TRACE(2, OLSR_TRACE_CONV_MESSAGE, conv_context.originator, NULL, conv_cause_id, conv_context.msgtype, 0);
+    break;
+  case OLSR_CONV_CAUSE_TIMER:
+    gettimeofday(&conv_batch.cause_time, NULL);
+    OLSR_TRACE(2, OLSR_TRACE_CONV_TIMER, NULL, NULL, conv_cause_id, conv_context.cookie->ci_id, 0);
+    break;
+  default:
+    gettimeofday(&conv_batch.cause_time, NULL);
+    OLSR_TRACE(2, OLSR_TRACE_CONV_OTHER, NULL, NULL, conv_cause_id, 0, 0);
+    break;
+  }
+}
+
+/**
+ * Set the cause to a message. Called by the parser before
+ * the message is handed to the parse functions.
+ *
+ *@param msgtype the type of the message
+ *@param originator the originator of the message
+ *@param rx_time the time the packet was received
+ */
+void
+olsr_conv_cause_message(uint8_t msgtype, const union olsr_ip_addr *originator, const struct timeval *rx_time)
+{
+  conv_context.cause = OLSR_CONV_CAUSE_MESSAGE;
+  conv_context.msgtype = msgtype;
+  conv_context.originator = originator;
+  conv_context.rx_time = rx_time;
+  conv_context.silent = false;
+  conv_context.changes = conv_changes_set();
+}
+
+/**
+ * Set the cause to a timer. Called by the scheduler
+ * before the timer callback runs.
+ *
+ *@param cookie the cookie of the timer
+ */
+void
+olsr_conv_cause_timer(const struct olsr_cookie_info *cookie)
+{
+  conv_context.cause = OLSR_CONV_CAUSE_TIMER;
+  conv_context.cookie = cookie;
+  conv_context.silent = false;
+  conv_context.changes = conv_changes_set();
+}
+
+/**
+ * The message or timer is done, pick up its changes.
+ */
+void
+olsr_conv_cause_end(void)
+{
+  olsr_conv_changes();
+  memset(&conv_context, 0, sizeof(conv_context));
+}
+
+/**
+ * Note that the current timer gives up on a link which was heard
+ * of last at a given clock tick. If this changes the tables the
+ * silence is counted as detection latency.
+ *
+ *@param last_hello the now_times of the last HELLO on the link
+ */
+void
+olsr_conv_link_silent(uint32_t last_hello)
+{
+  conv_context.silent = true;
+  conv_context.silent_since = last_hello;
+}
+
+/**
+ * Check for changes of the current cause and open
+ * a batch for them unless one is pending already.
+ * Flags which were set before the cause started are
+ * not its changes.
+ */
+void
+olsr_conv_changes(void)
+{
+  if ((conv_changes_set() & ~conv_context.changes) == 0) {
+    return;
+  }
+
+  if (conv_context.silent) {
+    conv_record(OLSR_CONV_DETECT, (uint64_t)(uint32_t)(now_times - conv_context.silent_since) * 1000);
+    conv_context.silent = false;
+  }
+
+  if (conv_batch.state == CONV_BATCH_NONE) {
+    conv_open_batch();
+  }
+}
+
+/**
+ * A message of the current cause is queued for forwarding.
+ *
+ *@param stamp receipt of the oldest forwarded message in the
+ * output buffer, set if the buffer has none yet
+ */
+void
+olsr_conv_forwarded(struct timeval *stamp)
+{
+  if (conv_context.cause == OLSR_CONV_CAUSE_MESSAGE && !timerisset(stamp)) {
+    *stamp = *conv_context.rx_time;
+  }
+}
+
+/**
+ * An output buffer went out, count the time its
+ * oldest forwarded message was held.
+ *
+ *@param stamp as set by olsr_conv_forwarded(), cleared
+ */
+void
+olsr_conv_sent(struct timeval *stamp)
+{
+  struct timeval now;
+
+  if (!timerisset(stamp)) {
+    return;
+  }
+  gettimeofday(&now, NULL);
+  conv_record(OLSR_CONV_FORWARD, conv_usec(stamp, &now));
+  timerclear(stamp);
+}
+
+/**
+ * The route calculation starts.
+ *
+ *@param start the time it started
+ */
+void
+olsr_conv_spf_start(const struct timeval *start)
+{
+  if (conv_batch.state == CONV_BATCH_PENDING) {
+    uint64_t queue = conv_usec(&conv_batch.cause_time, start);
+
+    conv_record(OLSR_CONV_QUEUE, queue);
+    OLSR_TRACE(2, OLSR_TRACE_CONV_SPF_START, NULL, NULL, conv_batch.cause_id, queue, 0);
+  } else {
+    /* forced calculation, no cause to follow */
+    conv_batch.cause_id = 0;
+  }
+  conv_batch.state = CONV_BATCH_SPF;
+  conv_batch.spf_start = *start;
+}
+
+/**
+ * The RIB is updated, the kernel routes are next.
+ */
+void
+olsr_conv_spf_done(void)
+{
+  uint64_t spf;
+
+  if (conv_batch.state != CONV_BATCH_SPF) {
+    return;
+  }
+  gettimeofday(&conv_batch.spf_done, NULL);
+  spf = conv_usec(&conv_batch.spf_start, &conv_batch.spf_done);
+  conv_record(OLSR_CONV_SPF, spf);
+  OLSR_TRACE(2, OLSR_TRACE_CONV_SPF_DONE, NULL, NULL, conv_batch.cause_id, spf, 0);
+  conv_batch.state = CONV_BATCH_KERNEL;
+}
+
+/**
+ * The kernel route updates returned. The netlink route
+ * updates are acknowledged by then, exporters which queue
+ * the routes only account for the hand off.
+ */
+void
+olsr_conv_kernel_done(void)
+{
+  struct timeval now;
+  uint64_t kernel, total;
+
+  if (conv_batch.state != CONV_BATCH_KERNEL) {
+    return;
+  }
+  gettimeofday(&now, NULL);
+  kernel = conv_usec(&conv_batch.spf_done, &now);
+  conv_record(OLSR_CONV_KERNEL, kernel);
+
+  if (conv_batch.cause_id) {
+    total = conv_usec(&conv_batch.cause_time, &now);
+    conv_record(OLSR_CONV_TOTAL, total);
+    olsr_conv_stats.batches++;
+    olsr_conv_stats.last_cause = conv_batch.cause_id;
+    OLSR_TRACE(2, OLSR_TRACE_CONV_DONE, NULL, NULL, conv_batch.cause_id, kernel, total);
+  }
+  conv_batch.state = CONV_BATCH_NONE;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,122 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+#ifndef _OLSR_CONVERGENCE_H
+#define _OLSR_CONVERGENCE_H
+
+#include "defs.h"
+#include "olsr_types.h"
+#include "olsr_cookie.h"
+
+#include <sys/time.h>
+
+/*
+ * Convergence latency accounting. Every batch of topology changes
+ * gets a cause id and the time of its cause: the receipt of the
+ * packet carrying the message, or the firing of the timer which
+ * changed the tables. The batch is followed through the SPF backoff,
+ * the route calculation and the kernel route updates, and each stage
+ * ends up in a latency histogram. Changes arriving while a batch is
+ * pending are merged into it, so the histograms show the latency of
+ * the oldest change.
+ */
+
+enum olsr_conv_stage {
+  OLSR_CONV_DETECT,                    /* last HELLO of a link until its loss is noticed */
+  OLSR_CONV_FORWARD,                   /* receipt of a forwarded message until it is sent again */
+  OLSR_CONV_QUEUE,                     /* cause until the route calculation starts */
+  OLSR_CONV_SPF,                       /* route calculation and RIB update */
+  OLSR_CONV_KERNEL,                    /* kernel route updates until acknowledged */
+  OLSR_CONV_TOTAL,                     /* cause until the kernel routes are updated */
+  OLSR_CONV_STAGE_MAX
+};
+
+enum olsr_conv_cause {
+  OLSR_CONV_CAUSE_OTHER,               /* interface changes, plugins, ... */
+  OLSR_CONV_CAUSE_MESSAGE,
+  OLSR_CONV_CAUSE_TIMER
+};
+
+/*
+ * Histogram buckets. Bucket i counts latencies up to
+ * OLSR_CONV_BUCKET_BOUND(i) microseconds, the last one the rest.
+ */
+#define OLSR_CONV_BUCKET_USEC 16
+#define OLSR_CONV_BUCKETS     22
+#define OLSR_CONV_BUCKET_BOUND(i) ((uint64_t)OLSR_CONV_BUCKET_USEC << (i))
+
+struct olsr_conv_histogram {
+  uint32_t bucket[OLSR_CONV_BUCKETS];
+  uint32_t count;
+  uint32_t max_usec;
+  uint64_t usec;
+};
+
+struct olsr_conv_stats {
+  struct olsr_conv_histogram stage[OLSR_CONV_STAGE_MAX];
+  uint32_t batches;                    /* batches followed up to the kernel */
+  uint32_t last_cause;                 /* cause id of the last batch */
+};
+
+extern struct olsr_conv_stats olsr_conv_stats;
+extern const char *const olsr_conv_stage_names[OLSR_CONV_STAGE_MAX];
+
+void olsr_conv_cause_message(uint8_t, const union olsr_ip_addr *, const struct timeval *);
+void olsr_conv_cause_timer(const struct olsr_cookie_info *);
+void olsr_conv_cause_end(void);
+void olsr_conv_link_silent(uint32_t);
+void olsr_conv_changes(void);
+
+void olsr_conv_forwarded(struct timeval *);
+void olsr_conv_sent(struct timeval *);
+
+void olsr_conv_spf_start(const struct timeval *);
+void olsr_conv_spf_done(void);
+void olsr_conv_kernel_done(void);
+
+#endif
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
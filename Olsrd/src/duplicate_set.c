@@ -46,6 +46,8 @@
 #include "mid_set.h"
 #include "scheduler.h"
 #include "mantissa.h"
+#include "parser.h"
+#include "trace.h"
 
 static void olsr_cleanup_duplicate_entry(void *unused);
 
@@ -119,7 +121,6 @@ olsr_message_is_duplicate(union olsr_message *m)
   int diff;
   void *mainIp;
   uint32_t valid_until;
-  struct ipaddr_str buf;
   uint16_t seqnr;
   void *ip;
 
@@ -166,7 +167,8 @@ olsr_message_is_duplicate(union olsr_message *m)
       entry->array = 1;
       return false;             /* start with a new sequence number, so NO duplicate */
     }
-    OLSR_PRINTF(9, "blocked 0x%x from %s\n", seqnr, olsr_ip_to_string(&buf, mainIp));
+    OLSR_TRACE(9, OLSR_TRACE_DUP_BLOCKED, mainIp, NULL, seqnr, diff, entry->array);
+    olsr_msgtype_stats[m->v4.olsr_msgtype].duplicates++;
     return true;                /* duplicate ! */
   }
 
@@ -175,11 +177,12 @@ olsr_message_is_duplicate(union olsr_message *m)
     uint32_t bitmask = 1 << ((uint32_t) (-diff));
 
     if ((entry->array & bitmask) != 0) {
-      OLSR_PRINTF(9, "blocked 0x%x (diff=%d,mask=%08x) from %s\n", seqnr, diff, entry->array, olsr_ip_to_string(&buf, mainIp));
+      OLSR_TRACE(9, OLSR_TRACE_DUP_BLOCKED, mainIp, NULL, seqnr, diff, entry->array);
+      olsr_msgtype_stats[m->v4.olsr_msgtype].duplicates++;
       return true;              /* duplicate ! */
     }
     entry->array |= bitmask;
-    OLSR_PRINTF(9, "processed 0x%x from %s\n", seqnr, olsr_ip_to_string(&buf, mainIp));
+    OLSR_TRACE(9, OLSR_TRACE_DUP_PROCESSED, mainIp, NULL, seqnr, 0, 0);
     return false;               /* no duplicate */
   } else if (diff < 32) {
     entry->array <<= (uint32_t) diff;
@@ -188,7 +191,7 @@ olsr_message_is_duplicate(union olsr_message *m)
   }
   entry->array |= 1;
   entry->seqnr = seqnr;
-  OLSR_PRINTF(9, "processed 0x%x from %s\n", seqnr, olsr_ip_to_string(&buf, mainIp));
+  OLSR_TRACE(9, OLSR_TRACE_DUP_PROCESSED, mainIp, NULL, seqnr, 0, 0);
   return false;                 /* no duplicate */
 }
 
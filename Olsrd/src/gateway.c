@@ -131,6 +131,10 @@ olsr_init_gateways(void) {
 
 void refresh_smartgw_netmask(void) {
   uint8_t *ip;
+
+  /* the netmask is part of the default route HNA */
+  olsr_msg_cache_invalidate(MSG_CACHE_HNA);
+
   memset(&smart_gateway_netmask, 0, sizeof(smart_gateway_netmask));
 
   if (olsr_cnf->smart_gw_active) {
@@ -74,7 +74,7 @@ generate_hello(void *p)
   if (queue_hello(&hellopacket, ifn))
     net_output(ifn);
 
-  olsr_free_hello_packet(&hellopacket);
+  arena_reset(&olsr_output_arena);
 
 }
 
@@ -84,13 +84,21 @@ generate_tc(void *p)
   struct tc_message tcpacket;
   struct interface *ifn = (struct interface *)p;
 
+  /* unchanged since the last TC, no need to look at the tables */
+  if (!changes_neighborhood && olsr_msg_cache_output(ifn, MSG_CACHE_TC, get_local_ansn(), MAX_TTL)) {
+    if (TIMED_OUT(ifn->fwdtimer)) {
+      set_buffer_timer(ifn);
+    }
+    return;
+  }
+
   olsr_build_tc_packet(&tcpacket);
 
   if (queue_tc(&tcpacket, ifn) && TIMED_OUT(ifn->fwdtimer)) {
     set_buffer_timer(ifn);
   }
 
-  olsr_free_tc_packet(&tcpacket);
+  arena_reset(&olsr_output_arena);
 }
 
 void
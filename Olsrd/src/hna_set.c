@@ -48,6 +48,7 @@
 #include "parser.h"
 #include "gateway.h"
 #include "duplicate_handler.h"
+#include "change_notify.h"
 
 struct hna_entry hna_set[HASHSIZE];
 struct olsr_cookie_info *hna_net_timer_cookie = NULL;
@@ -205,6 +206,8 @@ olsr_add_hna_net(struct hna_entry *hna_gw, const union olsr_ip_addr *net, uint8_
   hna_gw->networks.next = new_net;
   new_net->prev = &hna_gw->networks;
 
+  olsr_notify_change(OLSR_CHG_HNA_ADD, net, &hna_gw->A_gateway_addr, prefixlen, 0, 0);
+
   return new_net;
 }
 
@@ -239,6 +242,9 @@ olsr_delete_hna_net_entry(struct hna_net *net_to_delete) {
   olsr_delete_routing_table(&net_to_delete->hna_prefix.prefix,
       net_to_delete->hna_prefix.prefix_len, &hna_gw->A_gateway_addr);
 
+  olsr_notify_change(OLSR_CHG_HNA_DEL, &net_to_delete->hna_prefix.prefix, &hna_gw->A_gateway_addr,
+                     net_to_delete->hna_prefix.prefix_len, 0, 0);
+
   DEQUEUE_ELEM(net_to_delete);
 
   /* Delete hna_gw if empty */
@@ -123,6 +123,9 @@ olsr_trigger_ifchange(int if_index, struct interface *ifp, enum olsr_ifchg_flag
 {
   struct ifchgf *tmp_ifchgf_list = ifchgf_list;
 
+  /* the MID message lists the interface addresses */
+  olsr_msg_cache_invalidate(MSG_CACHE_MID);
+
   while (tmp_ifchgf_list != NULL) {
     tmp_ifchgf_list->function(if_index, ifp, flag);
     tmp_ifchgf_list = tmp_ifchgf_list->next;
@@ -398,6 +401,7 @@ olsr_remove_interface(struct olsr_if * iface)
 
   /* Remove output buffer */
   net_remove_buffer(ifp);
+  olsr_msg_cache_free(ifp);
 
   /* Check main addr */
   /* deactivated to prevent change of originator IP */
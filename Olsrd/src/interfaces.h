@@ -50,9 +50,13 @@
 #include <sys/socket.h>
 #endif
 #include <time.h>
+#ifndef _MSC_VER
+#include <sys/time.h>
+#endif
 
 #include "olsr_types.h"
 #include "mantissa.h"
+#include "msg_cache.h"
 
 #define IPV6_ADDR_ANY		0x0000U
 
@@ -110,6 +114,7 @@ struct olsr_netbuf {
   int maxsize;                         /* Max bytes of payload that can be added to the buffer */
   int pending;                         /* How much data is currently pending in the buffer */
   int reserved;                        /* Plugins can reserve space in buffers */
+  struct timeval fwd_stamp;            /* Receipt of the oldest forwarded message pending */
 };
 
 /**
@@ -176,6 +181,16 @@ struct interface {
   /* Hello's are sent immediately normally, this flag prefers to send TC's */
   bool immediate_send_tc;
 
+  /* last serialized TC/MID/HNA messages */
+  struct olsr_msg_cache msg_cache[MSG_CACHE_TYPES];
+
+  /* traffic accounting */
+  uint32_t rx_packets;
+  uint32_t tx_packets;
+  uint32_t tx_errors;
+  uint64_t rx_bytes;
+  uint64_t tx_bytes;
+
   /* backpointer to olsr_if configuration */
   struct olsr_if *olsr_if;
   struct interface *int_next;
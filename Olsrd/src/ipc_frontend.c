@@ -53,7 +53,13 @@
 #include "parser.h"
 #include "scheduler.h"
 #include "net_olsr.h"
+#include "net_os.h"
 #include "ipcalc.h"
+#include "olsr_cookie.h"
+#include "common/avl.h"
+#include "common/list.h"
+
+#include <errno.h>
 
 #ifdef WIN32
 #define close(x) closesocket(x)
@@ -65,13 +71,51 @@ void WinSockPError(const char *);
 #define MSG_NOSIGNAL 0
 #endif
 
+/*
+ * Route state of the front-end. There is an entry for every
+ * destination the front-end holds or is about to learn about.
+ * Updates only mark the entry dirty, so repeated changes of a
+ * destination collapse into the last one before the output
+ * is flushed.
+ */
+struct ipc_route {
+  struct avl_node tree_node;
+  struct list_node dirty_node;         /* on ipc_dirty while not sent */
+  struct list_node gone_node;          /* on ipc_gone while the delete is queued */
+  union olsr_ip_addr dst;
+  union olsr_ip_addr gw;
+  uint8_t metric;
+  char device[4];
+  bool present;                        /* route exists in olsrd */
+  bool known;                          /* front-end may hold the route */
+};
+
+AVLNODE2STRUCT(tree2ipc_route, struct ipc_route, tree_node);
+LISTNODE2STRUCT(dirty2ipc_route, struct ipc_route, dirty_node);
+LISTNODE2STRUCT(gone2ipc_route, struct ipc_route, gone_node);
+
 static int ipc_sock = -1;
 static int ipc_conn = -1;
 static int ipc_active = false;
-
-static int ipc_send_all_routes(int fd);
-
-static int ipc_send_net_info(int fd);
+static bool ipc_writing = false;
+
+static struct avl_tree ipc_routes;
+static struct list_node ipc_dirty;
+static struct list_node ipc_gone;
+static struct olsr_cookie_info *ipc_route_cookie;
+
+/* output queued for the front-end, from buf + head to buf + head + len */
+static struct {
+  unsigned char *buf;
+  size_t head;
+  size_t len;
+  size_t mark;                         /* rest of a partially sent message */
+} ipc_out;
+
+static void ipc_send_all_routes(void);
+static void ipc_send_net_info(void);
+static void ipc_action(int, void *, unsigned int);
+static void ipc_disconnect(void);
 
 /**
  *Create the socket to use for IPC to the
@@ -89,6 +133,12 @@ ipc_init(void)
   /* Add parser function */
   olsr_parser_add_function(&frontend_msgparser, PROMISCUOUS);
 
+  avl_init(&ipc_routes, avl_comp_default);
+  list_head_init(&ipc_dirty);
+  list_head_init(&ipc_gone);
+  ipc_route_cookie = olsr_alloc_cookie("IPC route", OLSR_COOKIE_TYPE_MEMORY);
+  olsr_cookie_set_memory_size(ipc_route_cookie, sizeof(struct ipc_route));
+
   /* get an internet domain socket */
   if ((ipc_sock = socket(AF_INET, SOCK_STREAM, 0)) == -1) {
     perror("IPC socket");
@@ -137,24 +187,37 @@ ipc_accept(int fd, void *data __attribute__ ((unused)), unsigned int flags __att
   socklen_t addrlen;
   struct sockaddr_in pin;
   char *addr;
+  int conn;
 
   addrlen = sizeof(struct sockaddr_in);
 
-  if ((ipc_conn = accept(fd, (struct sockaddr *)&pin, &addrlen)) == -1) {
+  if ((conn = accept(fd, (struct sockaddr *)&pin, &addrlen)) == -1) {
     perror("IPC accept");
     olsr_exit("IPC accept", EXIT_FAILURE);
   } else {
     OLSR_PRINTF(1, "Front end connected\n");
     addr = inet_ntoa(pin.sin_addr);
     if (ipc_check_allowed_ip((union olsr_ip_addr *)&pin.sin_addr.s_addr)) {
+      /* one front-end at a time */
+      if (ipc_active) {
+        ipc_disconnect();
+      }
+      ipc_conn = conn;
+
+      olsr_set_nonblocking(ipc_conn);
+
+      ipc_out.buf = olsr_malloc(IPC_OUTPUT_MAX, "IPC output");
+      ipc_out.head = ipc_out.len = ipc_out.mark = 0;
       ipc_active = true;
-      ipc_send_net_info(ipc_conn);
-      ipc_send_all_routes(ipc_conn);
+      add_olsr_socket(ipc_conn, NULL, &ipc_action, NULL, SP_IMM_READ);
+
+      ipc_send_net_info();
+      ipc_send_all_routes();
       OLSR_PRINTF(1, "Connection from %s\n", addr);
     } else {
       OLSR_PRINTF(1, "Front end-connection from foregin host(%s) not allowed!\n", addr);
       olsr_syslog(OLSR_LOG_ERR, "OLSR: Front end-connection from foregin host(%s) not allowed!\n", addr);
-      CLOSE(ipc_conn);
+      CLOSE(conn);
     }
   }
 
@@ -204,6 +267,104 @@ ipc_input(int sock __attribute__ ((unused)))
 }
 #endif
 
+/**
+ *Queue data for the front-end.
+ *
+ *@return false if the output limit would be exceeded
+ */
+static bool
+ipc_put(const void *data, size_t len)
+{
+  if (ipc_out.len + len > IPC_OUTPUT_MAX) {
+    return false;
+  }
+  if (ipc_out.head + ipc_out.len + len > IPC_OUTPUT_MAX) {
+    memmove(ipc_out.buf, ipc_out.buf + ipc_out.head, ipc_out.len);
+    ipc_out.head = 0;
+  }
+  memcpy(ipc_out.buf + ipc_out.head + ipc_out.len, data, len);
+  ipc_out.len += len;
+  return true;
+}
+
+/**
+ *Drop n bytes sent to the front-end, keeping track of
+ *where the next message starts. All messages carry
+ *their size at offset 2, like olsr messages do.
+ */
+static void
+ipc_consume(size_t n)
+{
+  size_t b = ipc_out.mark;
+  const unsigned char *p;
+
+  while (b < n) {
+    p = ipc_out.buf + ipc_out.head + b;
+    b += (p[2] << 8) | p[3];
+  }
+  ipc_out.mark = b - n;
+
+  ipc_out.head += n;
+  ipc_out.len -= n;
+  if (ipc_out.len == 0) {
+    ipc_out.head = 0;
+  }
+}
+
+static void
+ipc_start_write(void)
+{
+  if (!ipc_writing) {
+    enable_olsr_socket(ipc_conn, NULL, &ipc_action, SP_IMM_WRITE);
+    ipc_writing = true;
+  }
+}
+
+static void
+ipc_mark_dirty(struct ipc_route *rt)
+{
+  if (!list_node_on_list(&rt->dirty_node)) {
+    list_add_before(&ipc_dirty, &rt->dirty_node);
+  }
+}
+
+static void
+ipc_free_route(struct ipc_route *rt)
+{
+  if (list_node_on_list(&rt->dirty_node)) {
+    list_remove(&rt->dirty_node);
+  }
+  if (list_node_on_list(&rt->gone_node)) {
+    list_remove(&rt->gone_node);
+  }
+  avl_delete(&ipc_routes, &rt->tree_node);
+  olsr_cookie_free(ipc_route_cookie, rt);
+}
+
+/**
+ *The front-end could not keep up. Everything queued but the
+ *message being sent is dropped and the front-end gets the
+ *net info and all routes again, preceded by a delete as it
+ *may or may not know them.
+ */
+static void
+ipc_overflow(void)
+{
+  struct avl_node *node;
+  struct ipc_route *rt;
+
+  OLSR_PRINTF(1, "(IPC) front end too slow, resynchronizing\n");
+
+  ipc_out.len = ipc_out.mark;
+
+  for (node = avl_walk_first(&ipc_routes); node; node = avl_walk_next(node)) {
+    rt = tree2ipc_route(node);
+    rt->known = true;
+    ipc_mark_dirty(rt);
+  }
+  ipc_send_net_info();
+}
+
 /**
  *Sends a olsr packet on the IPC socket.
  *
@@ -225,16 +386,18 @@ frontend_msgparser(union olsr_message * msg, struct interface * in_if __attribut
   else
     size = ntohs(msg->v6.olsr_msgsize);
 
-  if (send(ipc_conn, (void *)msg, size, MSG_NOSIGNAL) < 0) {
-    OLSR_PRINTF(1, "(OUTPUT)IPC connection lost!\n");
-    CLOSE(ipc_conn);
-    ipc_active = false;
+  /* the packet itself is lost on overflow, it is only informational */
+  if (!ipc_put(msg, size)) {
+    ipc_overflow();
   }
+  ipc_start_write();
   return true;
 }
 
 /**
  *Send a route table update to the front-end.
+ *The update is queued, replacing any pending update
+ *of the same destination.
  *
  *@param kernel_route a rtentry describing the route update
  *@param add 1 if the route is to be added 0 if it is to be deleted
@@ -245,8 +408,8 @@ frontend_msgparser(union olsr_message * msg, struct interface * in_if __attribut
 int
 ipc_route_send_rtentry(const union olsr_ip_addr *dst, const union olsr_ip_addr *gw, int met, int add, const char *int_name)
 {
-  struct ipcmsg packet;
-  char *tmp;
+  struct avl_node *node;
+  struct ipc_route *rt;
 
   if (olsr_cnf->ipc_connections <= 0) {
     return -1;
@@ -255,163 +418,238 @@ ipc_route_send_rtentry(const union olsr_ip_addr *dst, const union olsr_ip_addr *
   if (!ipc_active) {
     return 0;
   }
+
+  node = avl_find(&ipc_routes, dst);
+  if (node) {
+    rt = tree2ipc_route(node);
+  } else if (add) {
+    rt = olsr_cookie_malloc(ipc_route_cookie);
+    list_node_init(&rt->dirty_node);
+    list_node_init(&rt->gone_node);
+    rt->dst = *dst;
+    rt->tree_node.key = &rt->dst;
+    avl_insert(&ipc_routes, &rt->tree_node, AVL_DUP_NO);
+  } else {
+    /* never told the front-end about it */
+    return 1;
+  }
+
+  rt->present = add;
+  if (add) {
+    memset(&rt->gw, 0, sizeof(rt->gw));
+    if (gw) {
+      rt->gw = *gw;
+    }
+    rt->metric = met;
+    if (int_name != NULL)
+      memcpy(&rt->device[0], int_name, 4);
+    else
+      memset(&rt->device[0], 0, 4);
+
+    /* alive again, the delete still queued is followed by the add */
+    if (list_node_on_list(&rt->gone_node)) {
+      list_remove(&rt->gone_node);
+    }
+  }
+  ipc_mark_dirty(rt);
+  ipc_start_write();
+
+  return 1;
+}
+
+static void
+ipc_put_route(const struct ipc_route *rt, int add)
+{
+  struct ipcmsg packet;
+
   memset(&packet, 0, sizeof(struct ipcmsg));
   packet.size = htons(IPC_PACK_SIZE);
   packet.msgtype = ROUTE_IPC;
 
-  packet.target_addr = *dst;
+  packet.target_addr = rt->dst;
 
   packet.add = add;
-  if (add && gw) {
-    packet.metric = met;
-    packet.gateway_addr = *gw;
+  if (add) {
+    packet.metric = rt->metric;
+    packet.gateway_addr = rt->gw;
+    memcpy(&packet.device[0], &rt->device[0], 4);
   }
 
-  if (int_name != NULL)
-    memcpy(&packet.device[0], int_name, 4);
-  else
-    memset(&packet.device[0], 0, 4);
-
-  tmp = (char *)&packet;
-  /*
-     x = 0;
-     for(i = 0; i < IPC_PACK_SIZE;i++)
-     {
-     if(x == 4)
-     {
-     x = 0;
-     printf("\n\t");
-     }
-     x++;
-     printf(" %03i", (u_char) tmp[i]);
-     }
-
-     printf("\n");
-   */
-
-  if (send(ipc_conn, tmp, IPC_PACK_SIZE, MSG_NOSIGNAL) < 0)     // MSG_NOSIGNAL to avoid sigpipe
-  {
-    OLSR_PRINTF(1, "(RT_ENTRY)IPC connection lost!\n");
-    CLOSE(ipc_conn);
-
-    ipc_active = false;
-    return -1;
-  }
+  ipc_put(&packet, IPC_PACK_SIZE);
+}
 
-  return 1;
+/**
+ *Serialize pending route updates while the output queue
+ *is short. A route the front-end may hold is deleted before
+ *it is added again, the front-end appends every add.
+ */
+static void
+ipc_queue_routes(void)
+{
+  struct ipc_route *rt;
+
+  while (!list_is_empty(&ipc_dirty) && ipc_out.len < IPC_ROUTE_LOWAT) {
+    rt = dirty2ipc_route(ipc_dirty.next);
+    list_remove(&rt->dirty_node);
+
+    if (rt->present) {
+      if (rt->known) {
+        ipc_put_route(rt, 0);
+      }
+      ipc_put_route(rt, 1);
+      rt->known = true;
+    } else {
+      if (rt->known) {
+        ipc_put_route(rt, 0);
+        rt->known = false;
+
+        /* kept until the delete left the queue, for ipc_overflow() */
+        if (!list_node_on_list(&rt->gone_node)) {
+          list_add_before(&ipc_gone, &rt->gone_node);
+        }
+      } else if (!list_node_on_list(&rt->gone_node)) {
+        ipc_free_route(rt);
+      }
+    }
+  }
 }
 
-static int
-ipc_send_all_routes(int fd)
+/**
+ *Write queued output until the socket would block.
+ */
+static void
+ipc_flush(void)
 {
-  struct rt_entry *rt;
-  struct ipcmsg packet;
-  char *tmp;
+  struct ipc_route *rt;
+  int n;
 
-  if (!ipc_active)
-    return 0;
+  for (;;) {
+    ipc_queue_routes();
+    if (ipc_out.len == 0) {
+      break;
+    }
 
-  OLSR_FOR_ALL_RT_ENTRIES(rt) {
+    n = send(ipc_conn, (const char *)ipc_out.buf + ipc_out.head, ipc_out.len, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+        return;
+      }
+      OLSR_PRINTF(1, "(OUTPUT)IPC connection lost!\n");
+      ipc_disconnect();
+      return;
+    }
+    ipc_consume(n);
+
+    /* the deletes are with the kernel now */
+    if (ipc_out.len == 0) {
+      while (!list_is_empty(&ipc_gone)) {
+        rt = gone2ipc_route(ipc_gone.next);
+        list_remove(&rt->gone_node);
+        if (!list_node_on_list(&rt->dirty_node)) {
+          ipc_free_route(rt);
+        }
+      }
+    }
+  }
 
-    memset(&packet, 0, sizeof(struct ipcmsg));
-    packet.size = htons(IPC_PACK_SIZE);
-    packet.msgtype = ROUTE_IPC;
+  disable_olsr_socket(ipc_conn, NULL, &ipc_action, SP_IMM_WRITE);
+  ipc_writing = false;
+}
 
-    packet.target_addr = rt->rt_dst.prefix;
+static void
+ipc_action(int fd, void *data __attribute__ ((unused)), unsigned int flags)
+{
+  char buf[256];
+  int n;
+
+  if (flags & SP_IMM_READ) {
+    /* the front-end sends nothing, watch for it going away */
+    n = recv(fd, buf, sizeof(buf), 0);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+      OLSR_PRINTF(1, "(IPC) front end disconnected\n");
+      ipc_disconnect();
+      return;
+    }
+  }
+  if (flags & SP_IMM_WRITE) {
+    ipc_flush();
+  }
+}
 
-    packet.add = 1;
-    packet.metric = (uint8_t) (rt->rt_best->rtp_metric.hops);
+static void
+ipc_disconnect(void)
+{
+  struct avl_node *node;
 
-    packet.gateway_addr = rt->rt_nexthop.gateway;
+  remove_olsr_socket(ipc_conn, NULL, &ipc_action);
+  CLOSE(ipc_conn);
+  ipc_active = false;
+  ipc_writing = false;
 
-    memcpy(&packet.device[0], if_ifwithindex_name(rt->rt_nexthop.iif_index), 4);
+  free(ipc_out.buf);
+  memset(&ipc_out, 0, sizeof(ipc_out));
 
-    tmp = (char *)&packet;
+  while ((node = avl_walk_first(&ipc_routes)) != NULL) {
+    ipc_free_route(tree2ipc_route(node));
+  }
+}
 
-    /* MSG_NOSIGNAL to avoid sigpipe */
-    if (send(fd, tmp, IPC_PACK_SIZE, MSG_NOSIGNAL) < 0) {
-      OLSR_PRINTF(1, "(RT_ENTRY)IPC connection lost!\n");
-      CLOSE(ipc_conn);
-      ipc_active = false;
-      return -1;
+static void
+ipc_send_all_routes(void)
+{
+  struct rt_entry *rt;
+
+  OLSR_FOR_ALL_RT_ENTRIES(rt) {
+    if (rt->rt_best) {
+      ipc_route_send_rtentry(&rt->rt_dst.prefix, &rt->rt_nexthop.gateway, rt->rt_best->rtp_metric.hops, 1,
+                             if_ifwithindex_name(rt->rt_nexthop.iif_index));
     }
   }
   OLSR_FOR_ALL_RT_ENTRIES_END(rt);
-  return 1;
 }
 
 /**
  *Sends OLSR info to the front-end. This info consists of
  *the different time intervals and holding times, number
  *of interfaces, HNA routes and main address.
- *
- *@return negative on error
  */
-static int
-ipc_send_net_info(int fd)
+static void
+ipc_send_net_info(void)
 {
-  struct ipc_net_msg *net_msg;
-
-  net_msg = olsr_malloc(sizeof(struct ipc_net_msg), "send net info");
+  struct ipc_net_msg net_msg;
 
   OLSR_PRINTF(1, "Sending net-info to front end...\n");
 
-  memset(net_msg, 0, sizeof(struct ipc_net_msg));
+  memset(&net_msg, 0, sizeof(struct ipc_net_msg));
 
   /* Message size */
-  net_msg->size = htons(sizeof(struct ipc_net_msg));
+  net_msg.size = htons(sizeof(struct ipc_net_msg));
   /* Message type */
-  net_msg->msgtype = NET_IPC;
+  net_msg.msgtype = NET_IPC;
 
   /* MIDs */
   /* XXX fix IPC MIDcnt */
-  net_msg->mids = (ifnet != NULL && ifnet->int_next != NULL) ? 1 : 0;
+  net_msg.mids = (ifnet != NULL && ifnet->int_next != NULL) ? 1 : 0;
 
   /* HNAs */
-  net_msg->hnas = olsr_cnf->hna_entries == NULL ? 0 : 1;
+  net_msg.hnas = olsr_cnf->hna_entries == NULL ? 0 : 1;
 
   /* Different values */
   /* Temporary fixes */
   /* XXX fix IPC intervals */
-  net_msg->hello_int = 0;       //htons((uint16_t)hello_int);
-  net_msg->hello_lan_int = 0;   //htons((uint16_t)hello_int_nw);
-  net_msg->tc_int = 0;          //htons((uint16_t)tc_int);
-  net_msg->neigh_hold = 0;      //htons((uint16_t)neighbor_hold_time);
-  net_msg->topology_hold = 0;   //htons((uint16_t)topology_hold_time);
+  net_msg.hello_int = 0;        //htons((uint16_t)hello_int);
+  net_msg.hello_lan_int = 0;    //htons((uint16_t)hello_int_nw);
+  net_msg.tc_int = 0;           //htons((uint16_t)tc_int);
+  net_msg.neigh_hold = 0;       //htons((uint16_t)neighbor_hold_time);
+  net_msg.topology_hold = 0;    //htons((uint16_t)topology_hold_time);
 
-  net_msg->ipv6 = olsr_cnf->ip_version == AF_INET ? 0 : 1;
+  net_msg.ipv6 = olsr_cnf->ip_version == AF_INET ? 0 : 1;
 
   /* Main addr */
-  net_msg->main_addr = olsr_cnf->main_addr;
-
-  /*
-  {
-     unsigned int x, i;
-
-     printf("\t");
-     for(i = 0; i < sizeof(struct ipc_net_msg);i++)
-     {
-     if(x == 4)
-     {
-     x = 0;
-     printf("\n\t");
-     }
-     x++;
-     printf(" %03i", ((u_char *)net_msg)[i]);
-     }
-
-     printf("\n");
-  }
-  */
-
-  if (send(fd, (char *)net_msg, sizeof(struct ipc_net_msg), MSG_NOSIGNAL) < 0) {
-    OLSR_PRINTF(1, "(NETINFO)IPC connection lost!\n");
-    CLOSE(ipc_conn);
-    return -1;
-  }
+  net_msg.main_addr = olsr_cnf->main_addr;
 
-  free(net_msg);
-  return 0;
+  ipc_put(&net_msg, sizeof(struct ipc_net_msg));
+  ipc_start_write();
 }
 
 int
@@ -419,7 +657,9 @@ shutdown_ipc(void)
 {
   OLSR_PRINTF(1, "Shutting down IPC...\n");
   CLOSE(ipc_sock);
-  CLOSE(ipc_conn);
+  if (ipc_active) {
+    ipc_disconnect();
+  }
 
   return 1;
 }
@@ -63,6 +63,9 @@
 #define	ROUTE_IPC 11            /* IPC to front-end telling of route changes */
 #define NET_IPC 12              /* IPC to front end net-info */
 
+#define IPC_OUTPUT_MAX (64 * 1024)      /* output queued before the front-end is resynchronized */
+#define IPC_ROUTE_LOWAT (4 * 1024)      /* route updates are serialized below this much output */
+
 /*
  *IPC message sent to the front-end
  *at every route update. Both delete
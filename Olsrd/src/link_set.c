@@ -57,6 +57,8 @@
 #include "net_olsr.h"
 #include "ipcalc.h"
 #include "lq_plugin.h"
+#include "change_notify.h"
+#include "convergence.h"
 
 /* head node for all link sets */
 struct list_node link_entry_head;
@@ -67,6 +69,9 @@ void
 signal_link_changes(bool val)
 {                               /* XXX ugly */
   link_changes = val;
+  if (val) {
+    olsr_msg_cache_invalidate(MSG_CACHE_TC);
+  }
 }
 
 /* Prototypes. */
@@ -368,6 +373,7 @@ olsr_delete_link_entry(struct link_entry *link)
     olsr_delete_tc_edge_entry(tc_edge);
   }
 
+  olsr_notify_change(OLSR_CHG_LINK_DEL, &link->local_iface_addr, &link->neighbor_iface_addr, 0, link->linkcost, 0);
 
   /* Delete neighbor entry */
   if (link->neighbor->linkcount == 1) {
@@ -423,6 +429,7 @@ olsr_expire_link_loss_timer(void *context)
   struct link_entry *link;
 
   link = (struct link_entry *)context;
+  olsr_conv_link_silent(link->last_hello);
 
   /* count the lost packet */
   olsr_update_packet_loss_worker(link, true);
@@ -442,6 +449,7 @@ olsr_expire_link_sym_timer(void *context)
 
   link = (struct link_entry *)context;
   link->link_sym_timer = NULL;  /* be pedandic */
+  olsr_conv_link_silent(link->last_hello);
 
   if (link->prev_status != SYM_LINK) {
     return;
@@ -462,6 +470,7 @@ olsr_expire_link_hello_timer(void *context)
   struct link_entry *link;
 
   link = (struct link_entry *)context;
+  olsr_conv_link_silent(link->last_hello);
 
   link->L_link_quality = olsr_hyst_calc_instability(link->L_link_quality);
 
@@ -490,6 +499,7 @@ olsr_expire_link_entry(void *context)
 
   link = (struct link_entry *)context;
   link->link_timer = NULL;      /* be pedandic */
+  olsr_conv_link_silent(link->last_hello);
 
   olsr_delete_link_entry(link);
 }
@@ -595,10 +605,13 @@ add_link_entry(const union olsr_ip_addr *local, const union olsr_ip_addr *remote
   }
 
   new_link->linkcost = LINK_COST_BROKEN;
+  new_link->notified_linkcost = LINK_COST_BROKEN;
 
   /* Add to queue */
   list_add_before(&link_entry_head, &new_link->link_list);
 
+  olsr_notify_change(OLSR_CHG_LINK_ADD, &new_link->local_iface_addr, &new_link->neighbor_iface_addr, 0, new_link->linkcost, 0);
+
   /*
    * Create the neighbor entry
    */
@@ -693,6 +706,8 @@ update_link_entry(const union olsr_ip_addr *local, const union olsr_ip_addr *rem
   /* Add if not registered */
   entry = add_link_entry(local, remote, &message->source_addr, message->vtime, message->htime, in_if);
 
+  entry->last_hello = now_times;
+
   /* Update ASYM_time */
   entry->vtime = message->vtime;
   entry->ASYM_time = GET_TIMESTAMP(message->vtime);
@@ -66,6 +66,7 @@ struct link_entry {
   olsr_reltime vtime;
   struct neighbor_entry *neighbor;
   uint8_t prev_status;
+  uint32_t last_hello;                 /* now_times of the last HELLO, for convergence timing */
 
   /*
    * Hysteresis
@@ -89,6 +90,7 @@ struct link_entry {
 
   /* cost of this link */
   olsr_linkcost linkcost;
+  olsr_linkcost notified_linkcost;     /* last cost reported to change handlers */
 
   struct list_node link_list;          /* double linked list of all link entries */
   uint32_t linkquality[0];
@@ -614,8 +614,18 @@ static int olsr_os_process_rt_entry(int af_family, const struct rt_entry *rt, bo
 int
 olsr_ioctl_add_route(const struct rt_entry *rt)
 {
+  int rslt;
+
   OLSR_PRINTF(2, "KERN: Adding %s\n", olsr_rtp_to_string(rt->rt_best));
-  return olsr_os_process_rt_entry(AF_INET, rt, true);
+  rslt = olsr_os_process_rt_entry(AF_INET, rt, true);
+  if (rslt == 0) {
+    /*
+     * Send IPC route update message
+     */
+    ipc_route_send_rtentry(&rt->rt_dst.prefix, &rt->rt_best->rtp_nexthop.gateway, rt->rt_best->rtp_metric.hops, 1,
+                           if_ifwithindex_name(rt->rt_best->rtp_nexthop.iif_index));
+  }
+  return rslt;
 }
 
 /**
@@ -628,8 +638,18 @@ olsr_ioctl_add_route(const struct rt_entry *rt)
 int
 olsr_ioctl_add_route6(const struct rt_entry *rt)
 {
+  int rslt;
+
   OLSR_PRINTF(2, "KERN: Adding %s\n", olsr_rtp_to_string(rt->rt_best));
-  return olsr_os_process_rt_entry(AF_INET6, rt, true);
+  rslt = olsr_os_process_rt_entry(AF_INET6, rt, true);
+  if (rslt == 0) {
+    /*
+     * Send IPC route update message
+     */
+    ipc_route_send_rtentry(&rt->rt_dst.prefix, &rt->rt_best->rtp_nexthop.gateway, rt->rt_best->rtp_metric.hops, 1,
+                           if_ifwithindex_name(rt->rt_best->rtp_nexthop.iif_index));
+  }
+  return rslt;
 }
 
 /**
@@ -642,8 +662,17 @@ olsr_ioctl_add_route6(const struct rt_entry *rt)
 int
 olsr_ioctl_del_route(const struct rt_entry *rt)
 {
+  int rslt;
+
   OLSR_PRINTF(2, "KERN: Deleting %s\n", olsr_rt_to_string(rt));
-  return olsr_os_process_rt_entry(AF_INET, rt, false);
+  rslt = olsr_os_process_rt_entry(AF_INET, rt, false);
+  if (rslt == 0) {
+    /*
+     * Send IPC route update message
+     */
+    ipc_route_send_rtentry(&rt->rt_dst.prefix, NULL, 0, 0, NULL);
+  }
+  return rslt;
 }
 
 /**
@@ -656,8 +685,17 @@ olsr_ioctl_del_route(const struct rt_entry *rt)
 int
 olsr_ioctl_del_route6(const struct rt_entry *rt)
 {
+  int rslt;
+
   OLSR_PRINTF(2, "KERN: Deleting %s\n", olsr_rt_to_string(rt));
-  return olsr_os_process_rt_entry(AF_INET6, rt, false);
+  rslt = olsr_os_process_rt_entry(AF_INET6, rt, false);
+  if (rslt == 0) {
+    /*
+     * Send IPC route update message
+     */
+    ipc_route_send_rtentry(&rt->rt_dst.prefix, NULL, 0, 0, NULL);
+  }
+  return rslt;
 }
 
 #endif
@@ -54,6 +54,7 @@
 #include <net/if.h>
 
 #include <sys/ioctl.h>
+#include <linux/sockios.h>
 #include <sys/utsname.h>
 
 #include <fcntl.h>
@@ -683,6 +684,39 @@ olsr_recvfrom(int s, void *buf, size_t len, int flags, struct sockaddr * from, s
   return recvfrom(s, buf, len, flags, from, fromlen);
 }
 
+/**
+ * Time the kernel received the datagram last read from a
+ * socket. The first call switches the timestamps of the
+ * socket on, until then the current time is used.
+ */
+
+void
+olsr_recv_time(int s, struct timeval *stamp)
+{
+  if (ioctl(s, SIOCGSTAMP, stamp) < 0) {
+    gettimeofday(stamp, NULL);
+  }
+}
+
+/**
+ * Switch a socket to non-blocking mode, so the callbacks
+ * of the socket poll loop never wait for a peer.
+ *
+ *@param fd the socket
+ *@return -1 on error, 0 otherwise
+ */
+
+int
+olsr_set_nonblocking(int fd)
+{
+  int flags = fcntl(fd, F_GETFL, 0);
+
+  if (flags == -1) {
+    return -1;
+  }
+  return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
 /**
  * Wrapper for select(2)
  */
@@ -90,7 +90,7 @@ create_lq_hello(struct lq_hello_message *lq_hello, struct interface *outif)
   OLSR_FOR_ALL_LINK_ENTRIES(walker) {
 
     // allocate a neighbour entry
-    struct lq_hello_neighbor *neigh = olsr_malloc_lq_hello_neighbor("Build LQ_HELLO");
+    struct lq_hello_neighbor *neigh = olsr_alloc_lq_hello_neighbor(&olsr_output_arena, "Build LQ_HELLO");
 
     // a) this neighbor interface IS NOT visible via the output interface
     if (!ipequal(&walker->local_iface_addr, &outif->ip_addr))
@@ -132,28 +132,32 @@ create_lq_hello(struct lq_hello_message *lq_hello, struct interface *outif)
   OLSR_FOR_ALL_LINK_ENTRIES_END(walker);
 }
 
-static void
-destroy_lq_hello(struct lq_hello_message *lq_hello)
+static uint8_t
+get_lq_tc_ttl(struct interface *outif)
 {
-  struct lq_hello_neighbor *walker, *aux;
+  static int ttl_list[] = { 2, 8, 2, 16, 2, 8, 2, MAX_TTL };
+  uint8_t ttl;
 
-  // loop through the queued neighbour entries and free them
+  if (olsr_cnf->lq_fish > 0) {
+    if (outif->ttl_index >= (int)(sizeof(ttl_list) / sizeof(ttl_list[0])))
+      outif->ttl_index = 0;
+
+    ttl = (0 <= outif->ttl_index ? ttl_list[outif->ttl_index] : MAX_TTL);
+    outif->ttl_index++;
 
-  for (walker = lq_hello->neigh; walker != NULL; walker = aux) {
-    aux = walker->next;
-    free(walker);
+    OLSR_PRINTF(3, "Creating LQ TC with TTL %d.\n", ttl);
+    return ttl;
   }
 
-  lq_hello->neigh = NULL;
+  return MAX_TTL;
 }
 
 static void
-create_lq_tc(struct lq_tc_message *lq_tc, struct interface *outif)
+create_lq_tc(struct lq_tc_message *lq_tc, struct interface *outif, uint8_t ttl)
 {
   struct link_entry *lnk;
   struct neighbor_entry *walker;
   struct tc_mpr_addr *neigh;
-  static int ttl_list[] = { 2, 8, 2, 16, 2, 8, 2, MAX_TTL };
 
   // remember that we have generated an LQ TC message; this is
   // checked in net_output()
@@ -168,18 +172,7 @@ create_lq_tc(struct lq_tc_message *lq_tc, struct interface *outif)
 
   lq_tc->comm.orig = olsr_cnf->main_addr;
 
-  if (olsr_cnf->lq_fish > 0) {
-    if (outif->ttl_index >= (int)(sizeof(ttl_list) / sizeof(ttl_list[0])))
-      outif->ttl_index = 0;
-
-    lq_tc->comm.ttl = (0 <= outif->ttl_index ? ttl_list[outif->ttl_index] : MAX_TTL);
-    outif->ttl_index++;
-
-    OLSR_PRINTF(3, "Creating LQ TC with TTL %d.\n", lq_tc->comm.ttl);
-  }
-
-  else
-    lq_tc->comm.ttl = MAX_TTL;
+  lq_tc->comm.ttl = ttl;
 
   lq_tc->comm.hops = 0;
 
@@ -229,7 +222,7 @@ create_lq_tc(struct lq_tc_message *lq_tc, struct interface *outif)
     }
 
     /* Allocate a neighbour entry. */
-    neigh = olsr_malloc_tc_mpr_addr("Build LQ_TC");
+    neigh = olsr_alloc_tc_mpr_addr(&olsr_output_arena, "Build LQ_TC");
 
     /* Set the entry's main address. */
     neigh->address = walker->neighbor_main_addr;
@@ -266,19 +259,6 @@ create_lq_tc(struct lq_tc_message *lq_tc, struct interface *outif)
   OLSR_FOR_ALL_NBR_ENTRIES_END(walker);
 }
 
-static void
-destroy_lq_tc(struct lq_tc_message *lq_tc)
-{
-  struct tc_mpr_addr *walker, *aux;
-
-  // loop through the queued neighbour entries and free them
-
-  for (walker = lq_tc->neigh; walker != NULL; walker = aux) {
-    aux = walker->next;
-    free(walker);
-  }
-}
-
 static int
 common_size(void)
 {
@@ -519,6 +499,7 @@ serialize_lq_tc(struct lq_tc_message *lq_tc, struct interface *outif)
 
   union olsr_ip_addr *last_ip = NULL;
   uint8_t left_border_flag = 0xff;
+  bool partial_sent = false;
 
   // leave space for the OLSR header
 
@@ -590,6 +571,7 @@ serialize_lq_tc(struct lq_tc_message *lq_tc, struct interface *outif)
 
       size = 0;
       rem = net_outbuffer_bytes_left(outif) - off;
+      partial_sent = true;
     }
     // add the current neighbor's IP address
     genipcopy(buff + size, &neigh->address);
@@ -612,6 +594,11 @@ serialize_lq_tc(struct lq_tc_message *lq_tc, struct interface *outif)
   serialize_common((struct olsr_common *)lq_tc);
 
   net_outbuffer_push(outif, msg_buffer, size + off);
+
+  // remember complete, non-empty messages for the next emissions
+  if (!partial_sent && lq_tc->neigh != NULL) {
+    olsr_msg_cache_store(outif, MSG_CACHE_TC, lq_tc->ansn, msg_buffer, size + off);
+  }
 }
 
 void
@@ -630,7 +617,7 @@ olsr_output_lq_hello(void *para)
   serialize_lq_hello(&lq_hello, outif);
 
   // destroy internal format
-  destroy_lq_hello(&lq_hello);
+  arena_reset(&olsr_output_arena);
 
   if (net_output_pending(outif)) {
     if (outif->immediate_send_tc) {
@@ -648,41 +635,52 @@ olsr_output_lq_tc(void *para)
   static int prev_empty = 1;
   struct lq_tc_message lq_tc;
   struct interface *outif = para;
+  uint8_t ttl;
 
   if (outif == NULL) {
     return;
   }
-  // create LQ_TC in internal format
 
-  create_lq_tc(&lq_tc, outif);
+  ttl = get_lq_tc_ttl(outif);
 
-  // a) the message is not empty
+  // reuse the last LQ_TC if nothing changed since it was built
 
-  if (lq_tc.neigh != NULL) {
+  if (!changes_neighborhood && olsr_msg_cache_output(outif, MSG_CACHE_TC, get_local_ansn(), ttl)) {
     prev_empty = 0;
+    lq_tc_pending = true;
+  } else {
+    // create LQ_TC in internal format
 
-    // convert internal format into transmission format, send it
-    serialize_lq_tc(&lq_tc, outif);
+    create_lq_tc(&lq_tc, outif, ttl);
 
-    // b) this is the first empty message
-  } else if (prev_empty == 0) {
-    // initialize timer
+    // a) the message is not empty
 
-    set_empty_tc_timer(GET_TIMESTAMP(olsr_cnf->max_tc_vtime * 3 * MSEC_PER_SEC));
+    if (lq_tc.neigh != NULL) {
+      prev_empty = 0;
 
-    prev_empty = 1;
+      // convert internal format into transmission format, send it
+      serialize_lq_tc(&lq_tc, outif);
 
-    // convert internal format into transmission format, send it
+      // b) this is the first empty message
+    } else if (prev_empty == 0) {
+      // initialize timer
 
-    serialize_lq_tc(&lq_tc, outif);
+      set_empty_tc_timer(GET_TIMESTAMP(olsr_cnf->max_tc_vtime * 3 * MSEC_PER_SEC));
 
-    // c) this is not the first empty message, send if timer hasn't fired
-  } else if (!TIMED_OUT(get_empty_tc_timer())) {
-    serialize_lq_tc(&lq_tc, outif);
-  }
-  // destroy internal format
+      prev_empty = 1;
+
+      // convert internal format into transmission format, send it
 
-  destroy_lq_tc(&lq_tc);
+      serialize_lq_tc(&lq_tc, outif);
+
+      // c) this is not the first empty message, send if timer hasn't fired
+    } else if (!TIMED_OUT(get_empty_tc_timer())) {
+      serialize_lq_tc(&lq_tc, outif);
+    }
+    // destroy internal format
+
+    arena_reset(&olsr_output_arena);
+  }
 
   if (net_output_pending(outif)) {
     if (!outif->immediate_send_tc) {
@@ -52,6 +52,7 @@
 #include "lq_plugin_default_fpm.h"
 #include "lq_plugin_default_ff.h"
 #include "lq_plugin_default_ffeth.h"
+#include "change_notify.h"
 
 #include <assert.h>
 
@@ -394,21 +395,22 @@ olsr_clear_tc_lq(struct tc_mpr_addr *target)
 }
 
 /**
- * olsr_malloc_hello_neighbor
+ * olsr_alloc_hello_neighbor
  *
  * this function allocates memory for an hello_neighbor inclusive
- * linkquality data.
+ * linkquality data from a message arena.
  *
+ * @param arena the arena of the message being built or parsed
  * @param id string for memory debugging
  *
  * @return pointer to hello_neighbor
  */
 struct hello_neighbor *
-olsr_malloc_hello_neighbor(const char *id)
+olsr_alloc_hello_neighbor(struct arena *arena, const char *id)
 {
   struct hello_neighbor *h;
 
-  h = olsr_malloc(sizeof(struct hello_neighbor) + active_lq_handler->hello_lq_size, id);
+  h = olsr_arena_alloc(arena, sizeof(struct hello_neighbor) + active_lq_handler->hello_lq_size, id);
 
   assert((const char *)h + sizeof(*h) >= (const char *)h->linkquality);
   active_lq_handler->clear_hello(h->linkquality);
@@ -416,21 +418,22 @@ olsr_malloc_hello_neighbor(const char *id)
 }
 
 /**
- * olsr_malloc_tc_mpr_addr
+ * olsr_alloc_tc_mpr_addr
  *
  * this function allocates memory for an tc_mpr_addr inclusive
- * linkquality data.
+ * linkquality data from a message arena.
  *
+ * @param arena the arena of the message being built or parsed
  * @param id string for memory debugging
  *
  * @return pointer to tc_mpr_addr
  */
 struct tc_mpr_addr *
-olsr_malloc_tc_mpr_addr(const char *id)
+olsr_alloc_tc_mpr_addr(struct arena *arena, const char *id)
 {
   struct tc_mpr_addr *t;
 
-  t = olsr_malloc(sizeof(struct tc_mpr_addr) + active_lq_handler->tc_lq_size, id);
+  t = olsr_arena_alloc(arena, sizeof(struct tc_mpr_addr) + active_lq_handler->tc_lq_size, id);
 
   assert((const char *)t + sizeof(*t) >= (const char *)t->linkquality);
   active_lq_handler->clear_tc(t->linkquality);
@@ -438,21 +441,22 @@ olsr_malloc_tc_mpr_addr(const char *id)
 }
 
 /**
- * olsr_malloc_lq_hello_neighbor
+ * olsr_alloc_lq_hello_neighbor
  *
  * this function allocates memory for an lq_hello_neighbor inclusive
- * linkquality data.
+ * linkquality data from a message arena.
  *
+ * @param arena the arena of the message being built or parsed
  * @param id string for memory debugging
  *
  * @return pointer to lq_hello_neighbor
  */
 struct lq_hello_neighbor *
-olsr_malloc_lq_hello_neighbor(const char *id)
+olsr_alloc_lq_hello_neighbor(struct arena *arena, const char *id)
 {
   struct lq_hello_neighbor *h;
 
-  h = olsr_malloc(sizeof(struct lq_hello_neighbor) + active_lq_handler->hello_lq_size, id);
+  h = olsr_arena_alloc(arena, sizeof(struct lq_hello_neighbor) + active_lq_handler->hello_lq_size, id);
 
   assert((const char *)h + sizeof(*h) >= (const char *)h->linkquality);
   active_lq_handler->clear_hello(h->linkquality);
@@ -493,13 +497,18 @@ size_t olsr_sizeof_tc_lqdata(void) {
  * This function should be called whenever the current linkcost
  * value changed in a relevant way.
  *
- * @param link pointer to current link
- * @param newcost new cost of this link
+ * @param link pointer to the link whose cost was updated
  */
-void olsr_relevant_linkcost_change(void) {
+void olsr_relevant_linkcost_change(struct link_entry *link) {
   changes_neighborhood = true;
   changes_topology = true;
 
+  /* report the cost if it differs from the last one reported */
+  if (link->linkcost != link->notified_linkcost) {
+    link->notified_linkcost = link->linkcost;
+    olsr_notify_change(OLSR_CHG_LINK_COST, &link->local_iface_addr, &link->neighbor_iface_addr, 0, link->linkcost, 0);
+  }
+
   /* XXX - we should check whether we actually announce this neighbour */
   signal_link_changes(true);
 }
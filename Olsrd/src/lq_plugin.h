@@ -134,15 +134,15 @@ void olsr_copylq_link_entry_2_tc_mpr_addr(struct tc_mpr_addr *target, struct lin
 void olsr_copylq_link_entry_2_tc_edge_entry(struct tc_edge_entry *target, struct link_entry *source);
 void olsr_clear_tc_lq(struct tc_mpr_addr *target);
 
-struct hello_neighbor *olsr_malloc_hello_neighbor(const char *id);
-struct tc_mpr_addr *olsr_malloc_tc_mpr_addr(const char *id);
-struct lq_hello_neighbor *olsr_malloc_lq_hello_neighbor(const char *id);
+struct hello_neighbor *olsr_alloc_hello_neighbor(struct arena *arena, const char *id);
+struct tc_mpr_addr *olsr_alloc_tc_mpr_addr(struct arena *arena, const char *id);
+struct lq_hello_neighbor *olsr_alloc_lq_hello_neighbor(struct arena *arena, const char *id);
 struct link_entry *olsr_malloc_link_entry(const char *id);
 
 size_t olsr_sizeof_hello_lqdata(void);
 size_t olsr_sizeof_tc_lqdata(void);
 
-void olsr_relevant_linkcost_change(void);
+void olsr_relevant_linkcost_change(struct link_entry *);
 
 /* Externals. */
 extern struct lq_handler *active_lq_handler;
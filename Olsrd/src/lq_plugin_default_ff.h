@@ -64,6 +64,8 @@ struct default_lq_ff_hello {
   uint8_t windowSize, activePtr;
   uint16_t last_seq_nr;
   uint16_t missed_hellos;
+  /* sums of received[]/total[] over the first windowSize slots */
+  uint32_t sum_received, sum_total;
   uint16_t received[LQ_FF_WINDOW], total[LQ_FF_WINDOW];
 };
 
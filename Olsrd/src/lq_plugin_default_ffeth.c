@@ -147,6 +147,7 @@ default_lq_ffeth_handle_lqchange(void) {
     if (relevant) {
       memcpy(&lq->smoothed_lq, &lq->lq, sizeof(struct default_lq_ffeth));
       link->linkcost = default_lq_calc_cost_ffeth(&lq->smoothed_lq);
+      olsr_relevant_linkcost_change(link);
       triggered = true;
     }
   } OLSR_FOR_ALL_LINK_ENTRIES_END(link)
@@ -168,9 +169,8 @@ default_lq_ffeth_handle_lqchange(void) {
 
     memcpy(&lq->smoothed_lq, &lq->lq, sizeof(struct default_lq_ffeth));
     link->linkcost = default_lq_calc_cost_ffeth(&lq->smoothed_lq);
+    olsr_relevant_linkcost_change(link);
   } OLSR_FOR_ALL_LINK_ENTRIES_END(link)
-
-  olsr_relevant_linkcost_change();
 }
 
 static void
@@ -180,6 +180,7 @@ default_lq_parser_ffeth(struct olsr *olsr, struct interface *in_if, union olsr_i
   struct link_entry *lnk;
   struct default_lq_ffeth_hello *lq;
   uint32_t seq_diff;
+  uint16_t old_received, old_total;
 
   /* Find main address */
   main_addr = mid_lookup_main_addr(from_addr);
@@ -211,9 +212,16 @@ default_lq_parser_ffeth(struct olsr *olsr, struct interface *in_if, union olsr_i
     seq_diff = 1;
   }
 
-  lq->received[lq->activePtr]++;
+  old_received = lq->received[lq->activePtr]++;
+  old_total = lq->total[lq->activePtr];
   lq->total[lq->activePtr] += seq_diff;
 
+  /* keep the window sums in sync, including uint16_t wraparound of the slots */
+  if (lq->activePtr < lq->windowSize) {
+    lq->sum_received += (uint32_t)lq->received[lq->activePtr] - old_received;
+    lq->sum_total += (uint32_t)lq->total[lq->activePtr] - old_total;
+  }
+
   lq->last_seq_nr = olsr->olsr_seqno;
   lq->missed_hellos = 0;
 }
@@ -226,19 +234,16 @@ default_lq_ffeth_timer(void __attribute__ ((unused)) * context)
   OLSR_FOR_ALL_LINK_ENTRIES(link) {
     struct default_lq_ffeth_hello *tlq = (struct default_lq_ffeth_hello *)link->linkquality;
     fpm ratio;
-    int i, received, total;
-
-    received = 0;
-    total = 0;
+    int received, total;
 
     /* enlarge window if still in quickstart phase */
     if (tlq->windowSize < LQ_FFETH_WINDOW) {
       tlq->windowSize++;
+      tlq->sum_received += tlq->received[tlq->windowSize - 1];
+      tlq->sum_total += tlq->total[tlq->windowSize - 1];
     }
-    for (i = 0; i < tlq->windowSize; i++) {
-      received += tlq->received[i];
-      total += tlq->total[i];
-    }
+    received = tlq->sum_received;
+    total = tlq->sum_total;
 
     /* calculate link quality */
     if (total == 0) {
@@ -279,6 +284,10 @@ default_lq_ffeth_timer(void __attribute__ ((unused)) * context)
 
     // shift buffer
     tlq->activePtr = (tlq->activePtr + 1) % LQ_FFETH_WINDOW;
+    if (tlq->activePtr < tlq->windowSize) {
+      tlq->sum_received -= tlq->received[tlq->activePtr];
+      tlq->sum_total -= tlq->total[tlq->activePtr];
+    }
     tlq->total[tlq->activePtr] = 0;
     tlq->received[tlq->activePtr] = 0;
   } OLSR_FOR_ALL_LINK_ENTRIES_END(link);
@@ -437,6 +446,13 @@ default_lq_clear_ffeth_hello(void *target)
   for (i = 0; i < LQ_FFETH_WINDOW; i++) {
     local->total[i] = 3;
   }
+
+  local->sum_received = 0;
+  local->sum_total = 0;
+  for (i = 0; i < local->windowSize; i++) {
+    local->sum_received += local->received[i];
+    local->sum_total += local->total[i];
+  }
 }
 
 static const char *
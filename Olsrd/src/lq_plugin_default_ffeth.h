@@ -61,6 +61,8 @@ struct default_lq_ffeth_hello {
   uint8_t windowSize, activePtr;
   uint16_t last_seq_nr;
   uint16_t missed_hellos;
+  /* sums of received[]/total[] over the first windowSize slots */
+  uint32_t sum_received, sum_total;
   bool perfect_eth;
   uint16_t received[LQ_FFETH_WINDOW], total[LQ_FFETH_WINDOW];
 };
@@ -186,7 +186,7 @@ default_lq_packet_loss_worker_float(struct link_entry *link, void *ptr, bool los
     tlq->lq += (alpha * link->loss_link_multiplier / 65536);
   }
   link->linkcost = default_lq_calc_cost_float(ptr);
-  olsr_relevant_linkcost_change();
+  olsr_relevant_linkcost_change(link);
 }
 
 static void
@@ -197,7 +197,7 @@ default_lq_packet_loss_worker_fpm(struct link_entry *link __attribute__ ((unused
   tlq->valueLq = (value * 255 + LQ_FPM_INTERNAL_MULTIPLIER - 1) / LQ_FPM_INTERNAL_MULTIPLIER;
 
   link->linkcost = default_lq_calc_cost_fpm(ptr);
-  olsr_relevant_linkcost_change();
+  olsr_relevant_linkcost_change(link);
 }
 
 static void
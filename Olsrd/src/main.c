@@ -56,11 +56,14 @@
 #include "net_os.h"
 #include "build_msg.h"
 #include "net_olsr.h"
+#include "packet.h"
 #include "mid_set.h"
 #include "mpr_selector_set.h"
+#include "mpr.h"
 #include "gateway.h"
 #include "olsr_niit.h"
 #include "ignore_list.h"
+#include "trace.h"
 
 #ifdef LINUX_NETLINK_ROUTING
 #include <linux/types.h>
@@ -560,6 +563,12 @@ int main(int argc, char *argv[]) {
     sleep (1);
   }
 
+  /* Buffer the debug events if a trace target was given */
+  if (olsr_trace_init() < 0) {
+    fprintf(stderr, "Cannot write the trace file!\n");
+    olsr_exit(__func__, EXIT_FAILURE);
+  }
+
   /* Load plugins */
   olsr_load_plugins();
 
@@ -748,6 +757,8 @@ static void olsr_shutdown(int signo __attribute__ ((unused)))
 
   olsr_delete_all_mid_entries();
 
+  olsr_free_mpr_coverage();
+
 #ifdef LINUX_NETLINK_ROUTING
   /* trigger gateway selection */
   if (olsr_cnf->smart_gw_active) {
@@ -818,9 +829,14 @@ static void olsr_shutdown(int signo __attribute__ ((unused)))
   close(olsr_cnf->rts);
 #endif
 
+  /* write out the buffered debug events */
+  olsr_trace_shutdown();
+
   /* Free cookies and memory pools attached. */
   OLSR_PRINTF(0, "Free all memory...\n");
   olsr_delete_all_cookies();
+  arena_free(&olsr_input_arena);
+  arena_free(&olsr_output_arena);
 
   olsr_syslog(OLSR_LOG_INFO, "%s stopped", olsrd_version);
 
@@ -846,7 +862,8 @@ static void print_usage(bool error) {
         "  [-hint <hello interval (secs)>] [-tcint <tc interval (secs)>]\n"
         "  [-midint <mid interval (secs)>] [-hnaint <hna interval (secs)>]\n"
         "  [-T <Polling Rate (secs)>] [-nofork] [-hemu <ip_address>]\n"
-        "  [-lql <LQ level>] [-lqa <LQ aging factor>]\n",
+        "  [-lql <LQ level>] [-lqa <LQ aging factor>]\n"
+        "  [-trace <trace file>|syslog|stdout]\n",
         error ? "An error occured somwhere between your keyboard and your chair!\n" : "");
 }
 
@@ -1159,6 +1176,18 @@ static int olsr_process_arguments(int argc, char *argv[],
       continue;
     }
 
+    /*
+     * Buffer the debug events of the hot paths and write
+     * them from the scheduler instead of printing them.
+     */
+    if (strcmp(*argv, "-trace") == 0) {
+      NEXT_ARG;
+      CHECK_ARGC;
+
+      olsr_trace_set_target(*argv);
+      continue;
+    }
+
     if (strcmp(*argv, "-ignore") == 0) {
       char filename[256];
       NEXT_ARG;
@@ -53,6 +53,7 @@
 #include "packet.h"             /* struct mid_alias */
 #include "net_olsr.h"
 #include "duplicate_handler.h"
+#include "change_notify.h"
 
 struct mid_entry mid_set[HASHSIZE];
 struct mid_address reverse_mid_set[HASHSIZE];
@@ -199,6 +200,8 @@ insert_mid_tuple(union olsr_ip_addr *m_addr, struct mid_address *alias, olsr_rel
     QUEUE_ELEM(mid_set[hash], tmp);
   }
 
+  olsr_notify_change(OLSR_CHG_MID_ADD, m_addr, &alias->alias, 0, 0, 0);
+
   /*
    * Delete possible duplicate entries in 2 hop set
    * and delete duplicate neighbor entries. Redirect
@@ -473,6 +476,8 @@ olsr_prune_aliases(struct mid_message *message)
        */
       olsr_delete_routing_table(&current_alias->alias, olsr_cnf->maxplen, &entry->main_addr);
 
+      olsr_notify_change(OLSR_CHG_MID_DEL, &entry->main_addr, &current_alias->alias, 0, 0, 0);
+
       free(current_alias);
 
       /*
@@ -508,6 +513,8 @@ olsr_delete_mid_entry(struct mid_entry *mid)
      */
     olsr_delete_routing_table(&tmp_aliases->alias, olsr_cnf->maxplen, &mid->main_addr);
 
+    olsr_notify_change(OLSR_CHG_MID_DEL, &mid->main_addr, &tmp_aliases->alias, 0, 0, 0);
+
     free(tmp_aliases);
   }
 
@@ -569,7 +576,6 @@ olsr_input_mid(union olsr_message *m, struct interface *in_if __attribute__ ((un
   mid_chgestruct(&message, m);
 
   if (!olsr_validate_address(&message.mid_origaddr)) {
-    olsr_free_mid_packet(&message);
     return false;
   }
 #ifdef DEBUG
@@ -585,7 +591,6 @@ olsr_input_mid(union olsr_message *m, struct interface *in_if __attribute__ ((un
 
   if (check_neighbor_link(from_addr) != SYM_LINK) {
     OLSR_PRINTF(2, "Received MID from NON SYM neighbor %s\n", olsr_ip_to_string(&buf, from_addr));
-    olsr_free_mid_packet(&message);
     return false;
   }
 
@@ -618,7 +623,6 @@ olsr_input_mid(union olsr_message *m, struct interface *in_if __attribute__ ((un
   }
 
   olsr_prune_aliases(&message);
-  olsr_free_mid_packet(&message);
 
   /* Forward the message */
   return true;
@@ -42,6 +42,7 @@
 #include "ipcalc.h"
 #include "defs.h"
 #include "mpr.h"
+#include "mpr_coverage.h"
 #include "two_hop_neighbor_table.h"
 #include "olsr.h"
 #include "neighbor_table.h"
@@ -52,180 +53,97 @@
  * Prototypes for internal functions
  */
 
-static uint16_t add_will_always_nodes(void);
+static void add_will_always_nodes(void);
+
+static void add_single_link_nodes(int);
 
 static void olsr_optimize_mpr_set(void);
 
 static void olsr_clear_mprs(void);
 
-static void olsr_clear_two_hop_processed(void);
-
-static struct neighbor_entry *olsr_find_maximum_covered(int);
-
-static uint16_t olsr_calculate_two_hop_neighbors(void);
+static int olsr_find_maximum_covered(int);
 
 static int olsr_check_mpr_changes(void);
 
-static int olsr_chosen_mpr(struct neighbor_entry *, uint16_t *);
-
-static struct neighbor_2_list_entry *olsr_find_2_hop_neighbors_with_1_link(int);
+static void olsr_chosen_mpr(uint32_t);
 
 /* End:
  * Prototypes for internal functions
  */
 
+/* coverage matrix of the current calculation, reused between runs */
+static struct mpr_coverage mpr_cov;
+
 /**
- *Find all 2 hop neighbors with 1 link
- *connecting them to us trough neighbors
- *with a given willingness.
+ *Select all 1 hop neighbors with a given willingness
+ *that are the only link to one of our 2 hop neighbors.
  *
  *@param willingness the willigness of the neighbors
- *
- *@return a linked list of allocated neighbor_2_list_entry structures
  */
-static struct neighbor_2_list_entry *
-olsr_find_2_hop_neighbors_with_1_link(int willingness)
+static void
+add_single_link_nodes(int willingness)
 {
+  uint32_t j;
 
-  uint8_t idx;
-  struct neighbor_2_list_entry *two_hop_list_tmp = NULL;
-  struct neighbor_2_list_entry *two_hop_list = NULL;
-  struct neighbor_entry *dup_neighbor;
-  struct neighbor_2_entry *two_hop_neighbor = NULL;
-
-  for (idx = 0; idx < HASHSIZE; idx++) {
-
-    for (two_hop_neighbor = two_hop_neighbortable[idx].next; two_hop_neighbor != &two_hop_neighbortable[idx];
-         two_hop_neighbor = two_hop_neighbor->next) {
-
-      //two_hop_neighbor->neighbor_2_state=0;
-      //two_hop_neighbor->mpr_covered_count = 0;
-
-      dup_neighbor = olsr_lookup_neighbor_table(&two_hop_neighbor->neighbor_2_addr);
-
-      if ((dup_neighbor != NULL) && (dup_neighbor->status != NOT_SYM)) {
-
-        //OLSR_PRINTF(1, "(1)Skipping 2h neighbor %s - already 1hop\n", olsr_ip_to_string(&buf, &two_hop_neighbor->neighbor_2_addr));
-
-        continue;
-      }
-
-      if (two_hop_neighbor->neighbor_2_pointer == 1) {
-        if ((two_hop_neighbor->neighbor_2_nblist.next->neighbor->willingness == willingness)
-            && (two_hop_neighbor->neighbor_2_nblist.next->neighbor->status == SYM)) {
-          two_hop_list_tmp = olsr_malloc(sizeof(struct neighbor_2_list_entry), "MPR two hop list");
-
-          //OLSR_PRINTF(1, "ONE LINK ADDING %s\n", olsr_ip_to_string(&buf, &two_hop_neighbor->neighbor_2_addr));
-
-          /* Only queue one way here */
-          two_hop_list_tmp->neighbor_2 = two_hop_neighbor;
-
-          two_hop_list_tmp->next = two_hop_list;
-
-          two_hop_list = two_hop_list_tmp;
-        }
-      }
+  for (j = 0; j < mpr_cov.n2; j++) {
+    struct neighbor_entry *nbr;
 
+    if (mpr_cov.two_hop[j].degree != 1) {
+      continue;
+    }
+    nbr = mpr_cov.one_hop[mpr_cov.two_hop[j].sole].nbr;
+    if (nbr->willingness == willingness && !nbr->is_mpr) {
+      olsr_chosen_mpr(mpr_cov.two_hop[j].sole);
     }
-
   }
-
-  return (two_hop_list_tmp);
 }
 
 /**
- *This function processes the chosen MPRs and updates the counters
- *used in calculations
+ *This function processes the chosen MPRs and updates the
+ *coverage of their 2 hop neighbors
+ *
+ *@param i the coverage index of the chosen neighbor
  */
-static int
-olsr_chosen_mpr(struct neighbor_entry *one_hop_neighbor, uint16_t * two_hop_covered_count)
+static void
+olsr_chosen_mpr(uint32_t i)
 {
-  struct neighbor_list_entry *the_one_hop_list;
-  struct neighbor_2_list_entry *second_hop_entries;
-  struct neighbor_entry *dup_neighbor;
-  uint16_t count;
+  struct neighbor_entry *one_hop_neighbor = mpr_cov.one_hop[i].nbr;
   struct ipaddr_str buf;
-  count = *two_hop_covered_count;
 
   OLSR_PRINTF(1, "Setting %s as MPR\n", olsr_ip_to_string(&buf, &one_hop_neighbor->neighbor_main_addr));
 
-  //printf("PRE COUNT: %d\n\n", count);
-
   one_hop_neighbor->is_mpr = true;      //NBS_MPR;
 
-  for (second_hop_entries = one_hop_neighbor->neighbor_2_list.next; second_hop_entries != &one_hop_neighbor->neighbor_2_list;
-       second_hop_entries = second_hop_entries->next) {
-    dup_neighbor = olsr_lookup_neighbor_table(&second_hop_entries->neighbor_2->neighbor_2_addr);
-
-    if ((dup_neighbor != NULL) && (dup_neighbor->status == SYM)) {
-      //OLSR_PRINTF(7, "(2)Skipping 2h neighbor %s - already 1hop\n", olsr_ip_to_string(&buf, &second_hop_entries->neighbor_2->neighbor_2_addr));
-      continue;
-    }
-    //      if(!second_hop_entries->neighbor_2->neighbor_2_state)
-    //if(second_hop_entries->neighbor_2->mpr_covered_count < olsr_cnf->mpr_coverage)
-    //{
-    /*
-       Now the neighbor is covered by this mpr
-     */
-    second_hop_entries->neighbor_2->mpr_covered_count++;
-    the_one_hop_list = second_hop_entries->neighbor_2->neighbor_2_nblist.next;
-
-    //OLSR_PRINTF(1, "[%s](%x) has coverage %d\n", olsr_ip_to_string(&buf, &second_hop_entries->neighbor_2->neighbor_2_addr), second_hop_entries->neighbor_2, second_hop_entries->neighbor_2->mpr_covered_count);
-
-    if (second_hop_entries->neighbor_2->mpr_covered_count >= olsr_cnf->mpr_coverage)
-      count++;
-
-    while (the_one_hop_list != &second_hop_entries->neighbor_2->neighbor_2_nblist) {
-
-      if ((the_one_hop_list->neighbor->status == SYM)) {
-        if (second_hop_entries->neighbor_2->mpr_covered_count >= olsr_cnf->mpr_coverage) {
-          the_one_hop_list->neighbor->neighbor_2_nocov--;
-        }
-      }
-      the_one_hop_list = the_one_hop_list->next;
-    }
-
-    //}
-  }
-
-  //printf("POST COUNT %d\n\n", count);
-
-  *two_hop_covered_count = count;
-  return count;
-
+  olsr_mpr_coverage_select(&mpr_cov, i, olsr_cnf->mpr_coverage);
 }
 
 /**
- *Find the neighbor that covers the most 2 hop neighbors
- *with a given willingness
+ *Find the neighbor that covers the most uncovered
+ *2 hop neighbors with a given willingness
  *
  *@param willingness the willingness of the neighbor
  *
- *@return a pointer to the neighbor_entry struct
+ *@return the coverage index of the neighbor or -1
  */
-static struct neighbor_entry *
+static int
 olsr_find_maximum_covered(int willingness)
 {
-  uint16_t maximum;
-  struct neighbor_entry *a_neighbor;
-  struct neighbor_entry *mpr_candidate = NULL;
-
-  maximum = 0;
+  uint32_t i, gain, maximum = 0;
+  int mpr_candidate = -1;
 
-  OLSR_FOR_ALL_NBR_ENTRIES(a_neighbor) {
-
-#if 0
-    printf("[%s] nocov: %d mpr: %d will: %d max: %d\n\n", olsr_ip_to_string(&buf, &a_neighbor->neighbor_main_addr),
-           a_neighbor->neighbor_2_nocov, a_neighbor->is_mpr, a_neighbor->willingness, maximum);
-#endif
+  for (i = 0; i < mpr_cov.n1; i++) {
+    struct neighbor_entry *a_neighbor = mpr_cov.one_hop[i].nbr;
 
-    if ((!a_neighbor->is_mpr) && (a_neighbor->willingness == willingness) && (maximum < a_neighbor->neighbor_2_nocov)) {
+    if (a_neighbor->is_mpr || a_neighbor->willingness != willingness) {
+      continue;
+    }
 
-      maximum = a_neighbor->neighbor_2_nocov;
-      mpr_candidate = a_neighbor;
+    gain = olsr_mpr_coverage_gain(&mpr_cov, i);
+    if (maximum < gain) {
+      maximum = gain;
+      mpr_candidate = i;
     }
   }
-  OLSR_FOR_ALL_NBR_ENTRIES_END(a_neighbor);
 
   return mpr_candidate;
 }
@@ -237,7 +155,6 @@ static void
 olsr_clear_mprs(void)
 {
   struct neighbor_entry *a_neighbor;
-  struct neighbor_2_list_entry *two_hop_list;
 
   OLSR_FOR_ALL_NBR_ENTRIES(a_neighbor) {
 
@@ -246,13 +163,6 @@ olsr_clear_mprs(void)
       a_neighbor->was_mpr = true;
       a_neighbor->is_mpr = false;
     }
-
-    /* Clear two hop neighbors coverage count/ */
-    for (two_hop_list = a_neighbor->neighbor_2_list.next; two_hop_list != &a_neighbor->neighbor_2_list;
-         two_hop_list = two_hop_list->next) {
-      two_hop_list->neighbor_2->mpr_covered_count = 0;
-    }
-
   }
   OLSR_FOR_ALL_NBR_ENTRIES_END(a_neighbor);
 }
@@ -285,101 +195,24 @@ olsr_check_mpr_changes(void)
   return retval;
 }
 
-/**
- *Clears out proccess registration
- *on two hop neighbors
- */
-static void
-olsr_clear_two_hop_processed(void)
-{
-  int idx;
-
-  for (idx = 0; idx < HASHSIZE; idx++) {
-    struct neighbor_2_entry *neighbor_2;
-    for (neighbor_2 = two_hop_neighbortable[idx].next; neighbor_2 != &two_hop_neighbortable[idx]; neighbor_2 = neighbor_2->next) {
-      /* Clear */
-      neighbor_2->processed = 0;
-    }
-  }
-
-}
-
-/**
- *This function calculates the number of two hop neighbors
- */
-static uint16_t
-olsr_calculate_two_hop_neighbors(void)
-{
-  struct neighbor_entry *a_neighbor, *dup_neighbor;
-  struct neighbor_2_list_entry *twohop_neighbors;
-  uint16_t count = 0;
-  uint16_t n_count = 0;
-  uint16_t sum = 0;
-
-  /* Clear 2 hop neighs */
-  olsr_clear_two_hop_processed();
-
-  OLSR_FOR_ALL_NBR_ENTRIES(a_neighbor) {
-
-    if (a_neighbor->status == NOT_SYM) {
-      a_neighbor->neighbor_2_nocov = count;
-      continue;
-    }
-
-    for (twohop_neighbors = a_neighbor->neighbor_2_list.next; twohop_neighbors != &a_neighbor->neighbor_2_list;
-         twohop_neighbors = twohop_neighbors->next) {
-
-      dup_neighbor = olsr_lookup_neighbor_table(&twohop_neighbors->neighbor_2->neighbor_2_addr);
-
-      if ((dup_neighbor == NULL) || (dup_neighbor->status != SYM)) {
-        n_count++;
-        if (!twohop_neighbors->neighbor_2->processed) {
-          count++;
-          twohop_neighbors->neighbor_2->processed = 1;
-        }
-      }
-    }
-    a_neighbor->neighbor_2_nocov = n_count;
-
-    /* Add the two hop count */
-    sum += count;
-
-  }
-  OLSR_FOR_ALL_NBR_ENTRIES_END(a_neighbor);
-
-  OLSR_PRINTF(3, "Two hop neighbors: %d\n", sum);
-  return sum;
-}
-
 /**
  * Adds all nodes with willingness set to WILL_ALWAYS
  */
-static uint16_t
+static void
 add_will_always_nodes(void)
 {
-  struct neighbor_entry *a_neighbor;
-  uint16_t count = 0;
-
-#if 0
-  printf("\nAdding WILL ALWAYS nodes....\n");
-#endif
+  uint32_t i;
 
-  OLSR_FOR_ALL_NBR_ENTRIES(a_neighbor) {
+  for (i = 0; i < mpr_cov.n1; i++) {
     struct ipaddr_str buf;
-    if ((a_neighbor->status == NOT_SYM) || (a_neighbor->willingness != WILL_ALWAYS)) {
+
+    if (mpr_cov.one_hop[i].nbr->willingness != WILL_ALWAYS) {
       continue;
     }
-    olsr_chosen_mpr(a_neighbor, &count);
-
-    OLSR_PRINTF(3, "Adding WILL_ALWAYS: %s\n", olsr_ip_to_string(&buf, &a_neighbor->neighbor_main_addr));
+    olsr_chosen_mpr(i);
 
+    OLSR_PRINTF(3, "Adding WILL_ALWAYS: %s\n", olsr_ip_to_string(&buf, &mpr_cov.one_hop[i].nbr->neighbor_main_addr));
   }
-  OLSR_FOR_ALL_NBR_ENTRIES_END(a_neighbor);
-
-#if 0
-  OLSR_PRINTF(1, "Count: %d\n", count);
-#endif
-  return count;
 }
 
 /**
@@ -389,60 +222,32 @@ add_will_always_nodes(void)
 void
 olsr_calculate_mpr(void)
 {
-  uint16_t two_hop_covered_count;
-  uint16_t two_hop_count;
   int i;
 
   OLSR_PRINTF(3, "\n**RECALCULATING MPR**\n\n");
 
   olsr_clear_mprs();
-  two_hop_count = olsr_calculate_two_hop_neighbors();
-  two_hop_covered_count = add_will_always_nodes();
+  olsr_mpr_coverage_build(&mpr_cov);
+
+  OLSR_PRINTF(3, "Two hop neighbors: %u\n", mpr_cov.n2);
 
+  add_will_always_nodes();
 
   // Calculate MPRs based on WILLINGNESS.
   // NOTE: Nodes with higher WILLINGNESS are chosen to be MPRs first.
 
-  for (i = WILL_ALWAYS - 1; i > WILL_NEVER; i--) {
-    struct neighbor_entry *mprs;
-    struct neighbor_2_list_entry *two_hop_list = olsr_find_2_hop_neighbors_with_1_link(i);
-
-    // NOTE: Iterate over two hop neighbor list. For each two hop neighbor get its neighbor list.
-    // Mark next neighbor in list as MPR (initially ensures coverage). Optimize MPRs later.
-
-    while (two_hop_list != NULL) {
-      struct neighbor_2_list_entry *tmp;
-      //printf("CHOSEN FROM 1 LINK\n");
-      if (!two_hop_list->neighbor_2->neighbor_2_nblist.next->neighbor->is_mpr)
-        olsr_chosen_mpr(two_hop_list->neighbor_2->neighbor_2_nblist.next->neighbor, &two_hop_covered_count);
-      tmp = two_hop_list;
-      two_hop_list = two_hop_list->next;;
-      free(tmp);
-    }
-
-    if (two_hop_covered_count >= two_hop_count) {
-      i = WILL_NEVER;
-      break;
-    }
-    //printf("two hop covered count: %d\n", two_hop_covered_count);
+  for (i = WILL_ALWAYS - 1; i > WILL_NEVER && olsr_mpr_coverage_remaining(&mpr_cov) > 0; i--) {
+    int mpr;
 
-    while ((mprs = olsr_find_maximum_covered(i)) != NULL) {
-      //printf("CHOSEN FROM MAXCOV\n");
-      olsr_chosen_mpr(mprs, &two_hop_covered_count);
-
-      if (two_hop_covered_count >= two_hop_count) {
-        i = WILL_NEVER; // NOTE: Break out of main loop.
-        break;
-      }
+    // NOTE: First select the neighbors which are the only link to a
+    // two hop neighbor (initially ensures coverage). Optimize MPRs later.
+    add_single_link_nodes(i);
 
+    while (olsr_mpr_coverage_remaining(&mpr_cov) > 0 && (mpr = olsr_find_maximum_covered(i)) >= 0) {
+      olsr_chosen_mpr(mpr);
     }
   }
 
-  /*
-     increment the mpr sequence number
-   */
-  //neighbortable.neighbor_mpr_seq++;
-
   /* Optimize selection */
   olsr_optimize_mpr_set();
 
@@ -466,50 +271,37 @@ olsr_calculate_mpr(void)
 static void
 olsr_optimize_mpr_set(void)
 {
-  struct neighbor_entry *a_neighbor, *dup_neighbor;
-  struct neighbor_2_list_entry *two_hop_list;
-  int i, removeit;
-
-#if 0
-  printf("\n**MPR OPTIMIZING**\n\n");
-#endif
+  uint32_t idx;
+  int i;
 
   for (i = WILL_NEVER + 1; i < WILL_ALWAYS; i++) {
+    for (idx = 0; idx < mpr_cov.n1; idx++) {
+      struct neighbor_entry *a_neighbor = mpr_cov.one_hop[idx].nbr;
 
-    OLSR_FOR_ALL_NBR_ENTRIES(a_neighbor) {
-
-      if (a_neighbor->willingness != i) {
+      if (a_neighbor->willingness != i || !a_neighbor->is_mpr) {
         continue;
       }
 
-      if (a_neighbor->is_mpr) {
-        removeit = 1;
-
-        for (two_hop_list = a_neighbor->neighbor_2_list.next; two_hop_list != &a_neighbor->neighbor_2_list;
-             two_hop_list = two_hop_list->next) {
-
-          dup_neighbor = olsr_lookup_neighbor_table(&two_hop_list->neighbor_2->neighbor_2_addr);
-
-          if ((dup_neighbor != NULL) && (dup_neighbor->status != NOT_SYM)) {
-            continue;
-          }
-          //printf("\t[%s] coverage %d\n", olsr_ip_to_string(&buf, &two_hop_list->neighbor_2->neighbor_2_addr), two_hop_list->neighbor_2->mpr_covered_count);
-          /* Do not remove if we find a entry which need this MPR */
-          if (two_hop_list->neighbor_2->mpr_covered_count <= olsr_cnf->mpr_coverage) {
-            removeit = 0;
-          }
-        }
-
-        if (removeit) {
-          struct ipaddr_str buf;
-          OLSR_PRINTF(3, "MPR OPTIMIZE: removiong mpr %s\n\n", olsr_ip_to_string(&buf, &a_neighbor->neighbor_main_addr));
-          a_neighbor->is_mpr = false;
-        }
+      /* Do not remove if we find a entry which need this MPR */
+      if (olsr_mpr_coverage_redundant(&mpr_cov, idx, olsr_cnf->mpr_coverage)) {
+        struct ipaddr_str buf;
+        OLSR_PRINTF(3, "MPR OPTIMIZE: removiong mpr %s\n\n", olsr_ip_to_string(&buf, &a_neighbor->neighbor_main_addr));
+        a_neighbor->is_mpr = false;
+        olsr_mpr_coverage_unselect(&mpr_cov, idx, olsr_cnf->mpr_coverage);
       }
-    } OLSR_FOR_ALL_NBR_ENTRIES_END(a_neighbor);
+    }
   }
 }
 
+/**
+ *Release the coverage matrix kept between MPR calculations
+ */
+void
+olsr_free_mpr_coverage(void)
+{
+  olsr_mpr_coverage_free(&mpr_cov);
+}
+
 void
 olsr_print_mpr_set(void)
 {
@@ -44,6 +44,8 @@
 
 void olsr_calculate_mpr(void);
 
+void olsr_free_mpr_coverage(void);
+
 void olsr_print_mpr_set(void);
 
 #endif
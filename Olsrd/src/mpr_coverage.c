@@ -0,0 +1,296 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+#include "mpr_coverage.h"
+#include "olsr.h"
+
+/**
+ *Make sure an array holds at least the requested number
+ *of elements. Arrays grow in powers of two and are never
+ *shrunk, so they are reused by later calculations.
+ */
+static void
+olsr_mpr_coverage_reserve(void **array, uint32_t * size, uint32_t needed, size_t elemsize)
+{
+  uint32_t new_size = *size ? *size : 16;
+  void *p;
+
+  if (needed <= *size) {
+    return;
+  }
+  while (new_size < needed) {
+    new_size *= 2;
+  }
+  p = realloc(*array, new_size * elemsize);
+  if (p == NULL) {
+    olsr_exit("MPR coverage: out of memory", EXIT_FAILURE);
+  }
+  *array = p;
+  *size = new_size;
+}
+
+/**
+ *Assign dense indices to all symmetric 1-hop and strict 2-hop
+ *neighbors and fill the coverage bitsets from the neighbor tables.
+ *All 2-hop neighbors start out uncovered.
+ *
+ *@param c the coverage matrix to (re)build
+ */
+void
+olsr_mpr_coverage_build(struct mpr_coverage *c)
+{
+  struct neighbor_entry *nbr;
+  struct neighbor_2_list_entry *n2l;
+  uint32_t n1 = 0, n2 = 0, edges = 0, words, i, e;
+  int idx;
+
+  for (idx = 0; idx < HASHSIZE; idx++) {
+    struct neighbor_2_entry *nbr2;
+    for (nbr2 = two_hop_neighbortable[idx].next; nbr2 != &two_hop_neighbortable[idx]; nbr2 = nbr2->next) {
+      nbr2->cov_index = OLSR_COV_INDEX_UNSET;
+    }
+  }
+
+  /* walk the neighbor lists once, numbering 1-hop and 2-hop neighbors */
+  OLSR_FOR_ALL_NBR_ENTRIES(nbr) {
+    if (nbr->status != SYM) {
+      continue;
+    }
+
+    for (n2l = nbr->neighbor_2_list.next; n2l != &nbr->neighbor_2_list; n2l = n2l->next) {
+      struct neighbor_2_entry *nbr2 = n2l->neighbor_2;
+
+      if (nbr2->cov_index == OLSR_COV_INDEX_UNSET) {
+        struct neighbor_entry *dup_neighbor = olsr_lookup_neighbor_table(&nbr2->neighbor_2_addr);
+
+        if (dup_neighbor != NULL && dup_neighbor->status == SYM) {
+          nbr2->cov_index = OLSR_COV_INDEX_SKIP;
+        } else {
+          nbr2->cov_index = n2++;
+        }
+      }
+      if (nbr2->cov_index != OLSR_COV_INDEX_SKIP) {
+        if (edges == c->edge_size) {
+          olsr_mpr_coverage_reserve((void **)&c->edge, &c->edge_size, edges + 1, sizeof(*c->edge));
+        }
+        c->edge[edges++] = nbr2->cov_index;
+      }
+    }
+
+    olsr_mpr_coverage_reserve((void **)&c->one_hop, &c->one_hop_size, n1 + 1, sizeof(*c->one_hop));
+    c->one_hop[n1].nbr = nbr;
+    c->one_hop[n1++].edge_end = edges;
+  }
+  OLSR_FOR_ALL_NBR_ENTRIES_END(nbr);
+
+  words = (n2 + OLSR_COVWORD_BITS - 1) / OLSR_COVWORD_BITS;
+
+  olsr_mpr_coverage_reserve((void **)&c->two_hop, &c->two_hop_size, n2, sizeof(*c->two_hop));
+  olsr_mpr_coverage_reserve((void **)&c->cov, &c->cov_size, n1 * words, sizeof(*c->cov));
+  olsr_mpr_coverage_reserve((void **)&c->uncovered, &c->uncovered_size, words, sizeof(*c->uncovered));
+
+  c->n1 = n1;
+  c->n2 = n2;
+  c->words = words;
+
+  memset(c->cov, 0, n1 * words * sizeof(*c->cov));
+  memset(c->two_hop, 0, n2 * sizeof(*c->two_hop));
+
+  /* fill the coverage rows from the collected edges */
+  for (i = 0, e = 0; i < n1; i++) {
+    olsr_covword *row = &c->cov[i * words];
+
+    for (; e < c->one_hop[i].edge_end; e++) {
+      uint32_t j = c->edge[e];
+      olsr_covword bit = (olsr_covword)1 << (j % OLSR_COVWORD_BITS);
+
+      if ((row[j / OLSR_COVWORD_BITS] & bit) == 0) {
+        row[j / OLSR_COVWORD_BITS] |= bit;
+        c->two_hop[j].degree++;
+        c->two_hop[j].sole = i;
+      }
+    }
+  }
+
+  /* every numbered 2-hop neighbor starts uncovered */
+  if (words > 0) {
+    memset(c->uncovered, 0xff, words * sizeof(*c->uncovered));
+    if (n2 % OLSR_COVWORD_BITS) {
+      c->uncovered[words - 1] = ((olsr_covword)1 << (n2 % OLSR_COVWORD_BITS)) - 1;
+    }
+  }
+}
+
+/**
+ *Release all memory of a coverage matrix
+ */
+void
+olsr_mpr_coverage_free(struct mpr_coverage *c)
+{
+  free(c->one_hop);
+  free(c->two_hop);
+  free(c->edge);
+  free(c->cov);
+  free(c->uncovered);
+  memset(c, 0, sizeof(*c));
+}
+
+/**
+ *Account a newly selected MPR. 2-hop neighbors reaching
+ *the requested coverage are removed from the uncovered set.
+ *
+ *@param c the coverage matrix
+ *@param i index of the selected 1-hop neighbor
+ *@param coverage the requested MPR coverage
+ */
+void
+olsr_mpr_coverage_select(struct mpr_coverage *c, uint32_t i, uint8_t coverage)
+{
+  const olsr_covword *row = &c->cov[i * c->words];
+  uint32_t w;
+
+  for (w = 0; w < c->words; w++) {
+    olsr_covword bits = row[w];
+
+    while (bits) {
+      unsigned int b = __builtin_ctzl(bits);
+      uint32_t j = w * OLSR_COVWORD_BITS + b;
+
+      bits &= bits - 1;
+      if (c->two_hop[j].covered_count < 255) {
+        c->two_hop[j].covered_count++;
+      }
+      if (c->two_hop[j].covered_count >= coverage) {
+        c->uncovered[w] &= ~((olsr_covword)1 << b);
+      }
+    }
+  }
+}
+
+/**
+ *Revert olsr_mpr_coverage_select() for a removed MPR
+ */
+void
+olsr_mpr_coverage_unselect(struct mpr_coverage *c, uint32_t i, uint8_t coverage)
+{
+  const olsr_covword *row = &c->cov[i * c->words];
+  uint32_t w;
+
+  for (w = 0; w < c->words; w++) {
+    olsr_covword bits = row[w];
+
+    while (bits) {
+      unsigned int b = __builtin_ctzl(bits);
+      uint32_t j = w * OLSR_COVWORD_BITS + b;
+
+      bits &= bits - 1;
+      if (c->two_hop[j].covered_count > 0) {
+        c->two_hop[j].covered_count--;
+      }
+      if (c->two_hop[j].covered_count < coverage) {
+        c->uncovered[w] |= (olsr_covword)1 << b;
+      }
+    }
+  }
+}
+
+/**
+ *Check if all 2-hop neighbors of a selected MPR are
+ *covered by more MPRs than requested, so that it can
+ *be removed (RFC3626 section 8.3.1 point 5)
+ */
+bool
+olsr_mpr_coverage_redundant(const struct mpr_coverage *c, uint32_t i, uint8_t coverage)
+{
+  const olsr_covword *row = &c->cov[i * c->words];
+  uint32_t w;
+
+  for (w = 0; w < c->words; w++) {
+    olsr_covword bits = row[w];
+
+    while (bits) {
+      uint32_t j = w * OLSR_COVWORD_BITS + __builtin_ctzl(bits);
+
+      bits &= bits - 1;
+      if (c->two_hop[j].covered_count <= coverage) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ *@return the number of uncovered 2-hop neighbors
+ *a 1-hop neighbor would cover
+ */
+uint32_t
+olsr_mpr_coverage_gain(const struct mpr_coverage *c, uint32_t i)
+{
+  const olsr_covword *row = &c->cov[i * c->words];
+  uint32_t w, gain = 0;
+
+  for (w = 0; w < c->words; w++) {
+    gain += __builtin_popcountl(row[w] & c->uncovered[w]);
+  }
+  return gain;
+}
+
+/**
+ *@return the number of 2-hop neighbors still lacking coverage
+ */
+uint32_t
+olsr_mpr_coverage_remaining(const struct mpr_coverage *c)
+{
+  uint32_t w, remaining = 0;
+
+  for (w = 0; w < c->words; w++) {
+    remaining += __builtin_popcountl(c->uncovered[w]);
+  }
+  return remaining;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,118 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+#ifndef _OLSR_MPR_COVERAGE
+#define _OLSR_MPR_COVERAGE
+
+#include "defs.h"
+#include "neighbor_table.h"
+#include "two_hop_neighbor_table.h"
+
+/*
+ * Dense two hop coverage matrix used by the MPR heuristic.
+ *
+ * Every symmetric 1-hop neighbor and every strict 2-hop neighbor gets
+ * a dense index. The set of 2-hop neighbors reachable through a 1-hop
+ * neighbor is stored as one bitset row, so coverage questions become
+ * AND/popcount loops over a few machine words instead of list walks.
+ */
+
+typedef unsigned long olsr_covword;
+
+#define OLSR_COVWORD_BITS (sizeof(olsr_covword) * 8)
+
+/* special cov_index values of struct neighbor_2_entry */
+#define OLSR_COV_INDEX_UNSET 0xffffffff /* not visited yet */
+#define OLSR_COV_INDEX_SKIP  0xfffffffe /* also a symmetric 1-hop neighbor */
+
+struct mpr_cov_1hop {
+  struct neighbor_entry *nbr;
+  uint32_t edge_end;                   /* end of its 2-hop indices in the edge array */
+};
+
+struct mpr_cov_2hop {
+  uint32_t degree;                     /* number of 1-hop neighbors covering it */
+  uint32_t sole;                       /* the covering 1-hop neighbor if degree is 1 */
+  uint8_t covered_count;               /* number of selected MPRs covering it */
+};
+
+struct mpr_coverage {
+  uint32_t n1;                         /* number of 1-hop candidates */
+  uint32_t n2;                         /* number of strict 2-hop neighbors */
+  uint32_t words;                      /* bitset words per row */
+
+  struct mpr_cov_1hop *one_hop;
+  struct mpr_cov_2hop *two_hop;
+  uint32_t *edge;                      /* 2-hop indices of all 1-hop neighbors */
+  olsr_covword *cov;                   /* n1 rows of coverage bitsets */
+  olsr_covword *uncovered;             /* 2-hop neighbors lacking coverage */
+
+  /* allocated sizes, the arrays are reused between calculations */
+  uint32_t one_hop_size;
+  uint32_t two_hop_size;
+  uint32_t edge_size;
+  uint32_t cov_size;
+  uint32_t uncovered_size;
+};
+
+void olsr_mpr_coverage_build(struct mpr_coverage *);
+
+void olsr_mpr_coverage_free(struct mpr_coverage *);
+
+void olsr_mpr_coverage_select(struct mpr_coverage *, uint32_t, uint8_t);
+
+void olsr_mpr_coverage_unselect(struct mpr_coverage *, uint32_t, uint8_t);
+
+bool olsr_mpr_coverage_redundant(const struct mpr_coverage *, uint32_t, uint8_t);
+
+uint32_t olsr_mpr_coverage_gain(const struct mpr_coverage *, uint32_t);
+
+uint32_t olsr_mpr_coverage_remaining(const struct mpr_coverage *);
+
+#endif
+
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,174 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+#include "msg_cache.h"
+#include "olsr.h"
+#include "interfaces.h"
+#include "net_olsr.h"
+#include "olsr_protocol.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+struct olsr_msg_cache_stats msg_cache_stats[MSG_CACHE_TYPES];
+
+/* current generation of each message type, never 0 */
+static uint32_t msg_cache_generation[MSG_CACHE_TYPES] = { 1, 1, 1 };
+
+/**
+ *Invalidate the cached messages of one type on all interfaces,
+ *to be called whenever the content of these messages changes.
+ *
+ *@param type the message type
+ */
+void
+olsr_msg_cache_invalidate(enum olsr_msg_cache_type type)
+{
+  if (++msg_cache_generation[type] == 0) {
+    msg_cache_generation[type] = 1;
+  }
+}
+
+/**
+ *Queue the cached message of an interface to its output
+ *buffer, with a fresh seqno and the given TTL.
+ *
+ *@param ifp the interface to send on
+ *@param type the message type
+ *@param key the key the message has to be built for
+ *@param ttl the TTL of the message
+ *@return true if the cached message was used, false if the
+ *caller has to build the message
+ */
+bool
+olsr_msg_cache_output(struct interface *ifp, enum olsr_msg_cache_type type, uint32_t key, uint8_t ttl)
+{
+  struct olsr_msg_cache *cache = &ifp->msg_cache[type];
+  union olsr_message *m;
+
+  if (cache->generation != msg_cache_generation[type] || cache->key != key) {
+    msg_cache_stats[type].rebuilds++;
+    return false;
+  }
+
+  /* Send pending packet if not room in buffer */
+  if (cache->size > net_outbuffer_bytes_left(ifp)) {
+    net_output(ifp);
+    if (cache->size > net_outbuffer_bytes_left(ifp)) {
+      msg_cache_stats[type].rebuilds++;
+      return false;
+    }
+  }
+
+  m = (union olsr_message *)cache->body;
+  if (olsr_cnf->ip_version == AF_INET) {
+    m->v4.ttl = ttl;
+    m->v4.hopcnt = 0;
+    m->v4.seqno = htons(get_msg_seqno());
+  } else {
+    m->v6.ttl = ttl;
+    m->v6.hopcnt = 0;
+    m->v6.seqno = htons(get_msg_seqno());
+  }
+
+  net_outbuffer_push(ifp, cache->body, cache->size);
+  msg_cache_stats[type].hits++;
+  return true;
+}
+
+/**
+ *Remember a serialized message for olsr_msg_cache_output().
+ *Only complete messages may be stored, not parts of a message
+ *that had to be split over several packets.
+ *
+ *@param ifp the interface the message was built for
+ *@param type the message type
+ *@param key the key the message was built for
+ *@param msg the serialized message including the OLSR header
+ *@param size the size of the message
+ */
+void
+olsr_msg_cache_store(struct interface *ifp, enum olsr_msg_cache_type type, uint32_t key, const uint8_t *msg, uint16_t size)
+{
+  struct olsr_msg_cache *cache = &ifp->msg_cache[type];
+
+  if (size > cache->bufsize) {
+    free(cache->body);
+    cache->body = olsr_malloc(size, "Message cache");
+    cache->bufsize = size;
+  }
+
+  memcpy(cache->body, msg, size);
+  cache->size = size;
+  cache->key = key;
+  cache->generation = msg_cache_generation[type];
+}
+
+/**
+ *Free the message cache of an interface
+ *
+ *@param ifp the interface
+ */
+void
+olsr_msg_cache_free(struct interface *ifp)
+{
+  int i;
+
+  for (i = 0; i < MSG_CACHE_TYPES; i++) {
+    free(ifp->msg_cache[i].body);
+    memset(&ifp->msg_cache[i], 0, sizeof(ifp->msg_cache[i]));
+  }
+}
+
+const char *
+olsr_msg_cache_type_to_string(enum olsr_msg_cache_type type)
+{
+  static const char *const names[MSG_CACHE_TYPES] = { "TC", "MID", "HNA" };
+
+  return type < MSG_CACHE_TYPES ? names[type] : "???";
+}
+
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
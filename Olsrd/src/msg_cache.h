@@ -0,0 +1,99 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+#ifndef _OLSR_MSG_CACHE_H
+#define _OLSR_MSG_CACHE_H
+
+#include "olsr_types.h"
+
+/*
+ * Cache of the serialized TC, MID and HNA messages of an interface.
+ *
+ * Between changes of the underlying tables these messages differ
+ * only in their seqno, ttl and hopcount, so the last serialized
+ * message is kept and reused by patching these header fields.
+ * An entry is valid as long as the generation of its type has not
+ * been bumped by olsr_msg_cache_invalidate() and the key (e.g. the
+ * ANSN of a TC) is unchanged.
+ */
+
+enum olsr_msg_cache_type {
+  MSG_CACHE_TC,
+  MSG_CACHE_MID,
+  MSG_CACHE_HNA,
+  MSG_CACHE_TYPES
+};
+
+struct olsr_msg_cache {
+  uint32_t generation;                 /* 0 = nothing cached */
+  uint32_t key;
+  uint16_t size;
+  uint16_t bufsize;
+  uint8_t *body;
+};
+
+struct olsr_msg_cache_stats {
+  uint32_t hits;
+  uint32_t rebuilds;
+};
+
+extern struct olsr_msg_cache_stats msg_cache_stats[MSG_CACHE_TYPES];
+
+struct interface;
+
+void olsr_msg_cache_invalidate(enum olsr_msg_cache_type);
+
+bool olsr_msg_cache_output(struct interface *, enum olsr_msg_cache_type, uint32_t, uint8_t);
+
+void olsr_msg_cache_store(struct interface *, enum olsr_msg_cache_type, uint32_t, const uint8_t *, uint16_t);
+
+void olsr_msg_cache_free(struct interface *);
+
+const char *olsr_msg_cache_type_to_string(enum olsr_msg_cache_type);
+
+#endif
+
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -62,7 +62,6 @@ struct neighbor_entry {
   bool is_mpr;
   bool was_mpr;                        /* Used to detect changes in MPR */
   bool skip;
-  int neighbor_2_nocov;
   int linkcount;
   struct neighbor_2_list_entry neighbor_2_list;
   struct neighbor_entry *next;
@@ -47,6 +47,7 @@
 #include "print_packet.h"
 #include "link_set.h"
 #include "lq_packet.h"
+#include "convergence.h"
 
 #include <stdlib.h>
 #include <assert.h>
@@ -413,6 +414,16 @@ net_output(struct interface *ifp)
     }
   }
 
+  /* forwarded messages are on their way, or lost */
+  olsr_conv_sent(&ifp->netbuf.fwd_stamp);
+
+  if (retval != -1) {
+    ifp->tx_packets++;
+    ifp->tx_bytes += ifp->netbuf.pending;
+  } else {
+    ifp->tx_errors++;
+  }
+
   ifp->netbuf.pending = 0;
 
   /*
@@ -57,6 +57,10 @@ ssize_t olsr_sendto(int, const void *, size_t, int, const struct sockaddr *, soc
 
 ssize_t olsr_recvfrom(int, void *, size_t, int, struct sockaddr *, socklen_t *);
 
+void olsr_recv_time(int, struct timeval *);
+
+int olsr_set_nonblocking(int);
+
 int olsr_select(int, fd_set *, fd_set *, fd_set *, struct timeval *);
 
 int bind_socket_to_device(int, char *);
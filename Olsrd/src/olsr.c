@@ -65,6 +65,8 @@
 #include "lq_plugin.h"
 #include "gateway.h"
 #include "duplicate_handler.h"
+#include "parser.h"
+#include "convergence.h"
 
 #include <stdarg.h>
 #include <signal.h>
@@ -192,12 +194,18 @@ olsr_process_changes(void)
   if (!changes_neighborhood && !changes_topology && !changes_hna)
     return;
 
+  /* time the changes from their cause */
+  olsr_conv_changes();
+
   if (olsr_cnf->debug_level > 0 && olsr_cnf->clear_screen && isatty(1)) {
     clear_console();
     printf("       *** %s (%s on %s) ***\n", olsrd_version, build_date, build_host);
   }
 
   if (changes_neighborhood) {
+    /* MPR flags and neighbor status are advertised in TCs */
+    olsr_msg_cache_invalidate(MSG_CACHE_TC);
+
     if (olsr_cnf->lq_level < 1) {
       olsr_calculate_mpr();
     } else {
@@ -403,7 +411,9 @@ olsr_forward_message(union olsr_message *m, struct interface *in_if, union olsr_
         olsr_syslog(OLSR_LOG_ERR, "Received message to big to be forwarded on %s(%d bytes)!", ifn->int_name, msgsize);
       }
     }
+    olsr_conv_forwarded(&ifn->netbuf.fwd_stamp);
   }
+  olsr_msgtype_stats[m->v4.olsr_msgtype].forwarded++;
   return 1;
 }
 
@@ -596,6 +606,30 @@ olsr_malloc(size_t size, const char *id)
   return ptr;
 }
 
+/**
+ * Wrapper for arena_alloc() that does error-checking
+ *
+ * @param arena the arena to allocate from
+ * @param size the number of bytes to allocate
+ * @param caller a string identifying the caller for
+ * use in error messaging
+ *
+ * @return a void pointer to the zeroed memory
+ */
+void *
+olsr_arena_alloc(struct arena *arena, size_t size, const char *id)
+{
+  void *ptr = arena_alloc(arena, size);
+
+  if (!ptr) {
+    const char *const err_msg = strerror(errno);
+    OLSR_PRINTF(1, "OUT OF MEMORY: %s\n", err_msg);
+    olsr_syslog(OLSR_LOG_ERR, "olsrd: out of memory!: %s\n", err_msg);
+    olsr_exit(id, EXIT_FAILURE);
+  }
+  return ptr;
+}
+
 /**
  *Wrapper for printf that prints to a specific
  *debuglevel upper limit
@@ -247,7 +247,7 @@ struct olsrd_config {
   uint8_t lq_level;
   uint8_t lq_fish;
   float lq_aging;
-  char *lq_algorithm;
+  const char *lq_algorithm;
 
   float min_tc_vtime;
 
@@ -277,6 +277,8 @@ struct olsrd_config {
   /*many potential parameters or helper variables for smartgateway*/
   bool has_ipv4_gateway, has_ipv6_gateway;
 
+  uint32_t hna_version;                /* incremented on every change of hna_entries */
+
   int ioctl_s;                         /* Socket used for ioctl calls */
 #ifdef LINUX_NETLINK_ROUTING
   int rtnl_s;                          /* Socket used for rtnetlink messages */
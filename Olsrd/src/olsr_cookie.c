@@ -185,6 +185,16 @@ olsr_cookie_usage_decr(olsr_cookie_t cookie_id)
   }
 }
 
+/*
+ * Return a cookie by its id, NULL if there is none.
+ * Used by plugins reporting resource usage.
+ */
+struct olsr_cookie_info *
+olsr_get_cookie(olsr_cookie_t cookie_id)
+{
+  return olsr_cookie_valid(cookie_id) ? cookies[cookie_id] : NULL;
+}
+
 /*
  * Return a cookie name.
  * Mostly used for logging purposes.
@@ -66,10 +66,15 @@
 #include "olsr_spf.h"
 #include "net_olsr.h"
 #include "lq_plugin.h"
+#include "convergence.h"
 #include "gateway.h"
+#include "change_notify.h"
+#include "trace.h"
 
 struct timer_entry *spf_backoff_timer = NULL;
 
+struct olsr_spf_stats olsr_spf_stats;
+
 /*
  * avl_comp_etx
  *
@@ -101,15 +106,10 @@ avl_comp_etx(const void *etx1, const void *etx2)
 static void
 olsr_spf_add_cand_tree(struct avl_tree *tree, struct tc_entry *tc)
 {
-#if !defined(NODEBUG) && defined(DEBUG)
-  struct ipaddr_str buf;
-  struct lqtextbuffer lqbuffer;
-#endif
   tc->cand_tree_node.key = &tc->path_cost;
 
 #ifdef DEBUG
-  OLSR_PRINTF(2, "SPF: insert candidate %s, cost %s\n", olsr_ip_to_string(&buf, &tc->addr),
-              get_linkcost_text(tc->path_cost, false, &lqbuffer));
+  OLSR_TRACE(2, OLSR_TRACE_SPF_ADD_CAND, &tc->addr, NULL, tc->path_cost, 0, 0);
 #endif
 
   avl_insert(tree, &tc->cand_tree_node, AVL_DUP);
@@ -125,12 +125,7 @@ olsr_spf_del_cand_tree(struct avl_tree *tree, struct tc_entry *tc)
 {
 
 #ifdef DEBUG
-#ifndef NODEBUG
-  struct ipaddr_str buf;
-  struct lqtextbuffer lqbuffer;
-#endif
-  OLSR_PRINTF(2, "SPF: delete candidate %s, cost %s\n", olsr_ip_to_string(&buf, &tc->addr),
-              get_linkcost_text(tc->path_cost, false, &lqbuffer));
+  OLSR_TRACE(2, OLSR_TRACE_SPF_DEL_CAND, &tc->addr, NULL, tc->path_cost, 0, 0);
 #endif
 
   avl_delete(tree, &tc->cand_tree_node);
@@ -144,16 +139,9 @@ olsr_spf_del_cand_tree(struct avl_tree *tree, struct tc_entry *tc)
 static void
 olsr_spf_add_path_list(struct list_node *head, int *path_count, struct tc_entry *tc)
 {
-#if !defined(NODEBUG) && defined(DEBUG)
-  struct ipaddr_str pathbuf, nbuf;
-  struct lqtextbuffer lqbuffer;
-#endif
-
 #ifdef DEBUG
-  OLSR_PRINTF(2, "SPF: append path %s, cost %s, via %s\n", olsr_ip_to_string(&pathbuf, &tc->addr),
-              get_linkcost_text(tc->path_cost, false, &lqbuffer), tc->next_hop ? olsr_ip_to_string(&nbuf,
-                                                                                                   &tc->next_hop->
-                                                                                                   neighbor_iface_addr) : "-");
+  OLSR_TRACE(2, OLSR_TRACE_SPF_ADD_PATH, &tc->addr, tc->next_hop ? &tc->next_hop->neighbor_iface_addr : NULL,
+             tc->path_cost, 0, 0);
 #endif
 
   list_add_before(head, &tc->path_list_node);
@@ -187,12 +175,7 @@ olsr_spf_relax(struct avl_tree *cand_tree, struct tc_entry *tc)
   olsr_linkcost new_cost;
 
 #ifdef DEBUG
-#ifndef NODEBUG
-  struct ipaddr_str buf, nbuf;
-  struct lqtextbuffer lqbuffer;
-#endif
-  OLSR_PRINTF(2, "SPF: exploring node %s, cost %s\n", olsr_ip_to_string(&buf, &tc->addr),
-              get_linkcost_text(tc->path_cost, false, &lqbuffer));
+  OLSR_TRACE(2, OLSR_TRACE_SPF_EXPLORE_NODE, &tc->addr, NULL, tc->path_cost, 0, 0);
 #endif
 
   /*
@@ -208,17 +191,14 @@ olsr_spf_relax(struct avl_tree *cand_tree, struct tc_entry *tc)
      */
     if (!tc_edge->edge_inv) {
 #ifdef DEBUG
-      OLSR_PRINTF(2, "SPF:   ignoring edge %s\n", olsr_ip_to_string(&buf, &tc_edge->T_dest_addr));
-      if (!tc_edge->edge_inv) {
-        OLSR_PRINTF(2, "SPF:     no inverse edge\n");
-      }
+      OLSR_TRACE(2, OLSR_TRACE_SPF_NO_INVERSE, &tc_edge->T_dest_addr, NULL, 0, 0, 0);
 #endif
       continue;
     }
 
     if (tc_edge->cost == LINK_COST_BROKEN) {
 #ifdef DEBUG
-      OLSR_PRINTF(2, "SPF:   ignore edge %s (broken)\n", olsr_ip_to_string(&buf, &tc_edge->T_dest_addr));
+      OLSR_TRACE(2, OLSR_TRACE_SPF_BROKEN_EDGE, &tc_edge->T_dest_addr, NULL, 0, 0, 0);
 #endif
       continue;
     }
@@ -229,8 +209,7 @@ olsr_spf_relax(struct avl_tree *cand_tree, struct tc_entry *tc)
     new_cost = tc->path_cost + tc_edge->cost;
 
 #ifdef DEBUG
-    OLSR_PRINTF(2, "SPF:   exploring edge %s, cost %s\n", olsr_ip_to_string(&buf, &tc_edge->T_dest_addr),
-                get_linkcost_text(new_cost, true, &lqbuffer));
+    OLSR_TRACE(2, OLSR_TRACE_SPF_EXPLORE_EDGE, &tc_edge->T_dest_addr, NULL, new_cost, 0, 0);
 #endif
 
     /*
@@ -257,10 +236,8 @@ olsr_spf_relax(struct avl_tree *cand_tree, struct tc_entry *tc)
       new_tc->hops = tc->hops + 1;
 
 #ifdef DEBUG
-      OLSR_PRINTF(2, "SPF:   better path to %s, cost %s, via %s, hops %u\n", olsr_ip_to_string(&buf, &new_tc->addr),
-                  get_linkcost_text(new_cost, true, &lqbuffer), tc->next_hop ? olsr_ip_to_string(&nbuf,
-                                                                                                 &tc->next_hop->neighbor_iface_addr)
-                  : "<none>", new_tc->hops);
+      OLSR_TRACE(2, OLSR_TRACE_SPF_BETTER_PATH, &new_tc->addr, tc->next_hop ? &tc->next_hop->neighbor_iface_addr : NULL,
+                 new_cost, new_tc->hops, 0);
 #endif
 
     }
@@ -314,6 +291,7 @@ olsr_calculate_routing_table(bool force)
 #ifdef SPF_PROFILING
   struct timeval t1, t2, t3, t4, t5, spf_init, spf_run, route, kernel, total;
 #endif
+  struct timeval spf_start, spf_end, spf_time;
   struct avl_tree cand_tree;
   struct avl_node *rtp_tree_node;
   struct list_node path_list;          /* head of the path_list */
@@ -334,8 +312,10 @@ olsr_calculate_routing_table(bool force)
     spf_backoff_timer = olsr_start_timer(1000, 5, OLSR_TIMER_ONESHOT, &olsr_expire_spf_backoff, NULL, 0);
   }
 
+  gettimeofday(&spf_start, NULL);
+  olsr_conv_spf_start(&spf_start);
 #ifdef SPF_PROFILING
-  gettimeofday(&t1, NULL);
+  t1 = spf_start;
 #endif
 
   /*
@@ -366,6 +346,7 @@ olsr_calculate_routing_table(bool force)
      * All gone now. Flush all routes.
      */
     olsr_update_rib_routes();
+    olsr_conv_spf_done();
     olsr_update_kernel_routes();
     return;
   }
@@ -419,8 +400,13 @@ olsr_calculate_routing_table(bool force)
         /*
          * Update LQ and timers, such that the edge does not get deleted.
          */
+        olsr_linkcost old_cost = tc_edge->cost;
+
         olsr_copylq_link_entry_2_tc_edge_entry(tc_edge, link);
         olsr_calc_tc_edge_entry_etx(tc_edge);
+        if (tc_edge->cost != old_cost) {
+          olsr_notify_change(OLSR_CHG_TC_EDGE_COST, &tc_myself->addr, &tc_edge->T_dest_addr, 0, tc_edge->cost, 0);
+        }
       }
       if (tc_edge->edge_inv) {
         tc_edge->edge_inv->tc->next_hop = link;
@@ -438,7 +424,7 @@ olsr_calculate_routing_table(bool force)
    */
   olsr_spf_run_full(&cand_tree, &path_list, &path_count);
 
-  OLSR_PRINTF(2, "\n--- %s ------------------------------------------------- DIJKSTRA\n\n", olsr_wallclock_string());
+  OLSR_TRACE(2, OLSR_TRACE_SPF_DONE, NULL, NULL, path_count, 0, 0);
 
 #ifdef SPF_PROFILING
   gettimeofday(&t3, NULL);
@@ -459,8 +445,7 @@ olsr_calculate_routing_table(bool force)
        * does not contain a next-hop.
        */
       if (tc != tc_myself) {
-        struct ipaddr_str buf;
-        OLSR_PRINTF(2, "SPF: %s no next-hop\n", olsr_ip_to_string(&buf, &tc->addr));
+        OLSR_TRACE(2, OLSR_TRACE_SPF_NO_NEXTHOP, &tc->addr, NULL, 0, 0, 0);
       }
 #endif
       continue;
@@ -508,10 +493,17 @@ olsr_calculate_routing_table(bool force)
 
   /* move the route changes into the kernel */
 
+  olsr_conv_spf_done();
   olsr_update_kernel_routes();
 
+  gettimeofday(&spf_end, NULL);
+  timersub(&spf_end, &spf_start, &spf_time);
+  olsr_spf_stats.runs++;
+  olsr_spf_stats.last_usec = spf_time.tv_sec * 1000000 + spf_time.tv_usec;
+  olsr_spf_stats.usec += olsr_spf_stats.last_usec;
+
 #ifdef SPF_PROFILING
-  gettimeofday(&t5, NULL);
+  t5 = spf_end;
 #endif
 
 #ifdef SPF_PROFILING
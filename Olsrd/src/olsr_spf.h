@@ -42,6 +42,15 @@
 #ifndef _OLSR_SPF_H
 #define _OLSR_SPF_H
 
+/* Accounting of the route calculation, read by monitoring plugins */
+struct olsr_spf_stats {
+  uint32_t runs;
+  uint32_t last_usec;                  /* duration of the last run including the kernel updates */
+  uint64_t usec;                       /* duration of all runs */
+};
+
+extern struct olsr_spf_stats olsr_spf_stats;
+
 void olsr_calculate_routing_table(bool force);
 
 #endif
@@ -0,0 +1,139 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/*
+ * In-process mesh emulator: many olsrd nodes sharing one process
+ */
+
+#ifndef _OLSR_SWITCH_EMU
+#define _OLSR_SWITCH_EMU
+
+#include "defs.h"
+
+/* node i has the address 10.0.0.0 + i + 1 */
+#define EMU_ADDR_BASE 0x0a000000
+#define EMU_MAX_NODES 0x00fffffe
+#define EMU_NONE 0xffffffff
+
+/* a packet on the air, shared by all receivers */
+struct emu_frame {
+  unsigned int refcount;
+  uint32_t from;
+  uint16_t len;
+  unsigned char data[];
+};
+
+/* one direction of a link */
+struct emu_link {
+  uint32_t to;
+  uint32_t delay;                      /* milliseconds */
+  float loss;                          /* probability, 0 - 1 */
+  bool up;
+};
+
+struct emu_delivery {
+  uint32_t time;
+  uint32_t to;
+  uint64_t seq;
+  struct emu_frame *frame;
+};
+
+struct emu_node {
+  union olsr_ip_addr addr;
+  struct interface *ifp;
+  unsigned char *state;                /* daemon state while switched out */
+  uint32_t next_timer;                 /* virtual time the next timer fires */
+  uint32_t last_round;                 /* virtual time of the last round, run or skipped */
+
+  struct emu_link *links;
+  uint32_t link_count;
+  uint32_t link_size;
+
+  /* deliveries due in the current round */
+  struct emu_delivery *inbox;
+  uint32_t inbox_count;
+  uint32_t inbox_size;
+
+  uint32_t *routes;                    /* bitset, route to node j installed */
+  uint32_t *reachable;                 /* bitset, node j reachable over up links */
+
+  uint64_t tx_packets;
+  uint64_t tx_bytes;
+  uint64_t rx_packets;
+  uint64_t rx_bytes;
+  uint64_t cpu_nsec;
+};
+
+struct emu_config {
+  double hello_interval;
+  double tc_interval;
+  uint32_t pollrate;                   /* milliseconds */
+  unsigned int seed;
+};
+
+extern struct emu_node *emu_nodes;
+extern uint32_t emu_node_count;
+extern uint32_t emu_current;
+extern uint64_t emu_route_mismatch;
+
+#define EMU_BITSET_WORDS(n) (((n) + 31) / 32)
+#define EMU_BIT_TEST(set, i) (((set)[(i) >> 5] >> ((i) & 31)) & 1)
+#define EMU_BIT_SET(set, i) ((set)[(i) >> 5] |= 1u << ((i) & 31))
+#define EMU_BIT_CLEAR(set, i) ((set)[(i) >> 5] &= ~(1u << ((i) & 31)))
+
+/* node.c */
+uint64_t emu_cpu_nsec(void);
+size_t emu_state_size(void);
+void emu_node_create(uint32_t, const struct emu_config *);
+void emu_node_run(uint32_t, uint32_t);
+
+/* olsr_switch.c */
+void emu_transmit(const void *, size_t);
+uint32_t emu_addr2node(const union olsr_ip_addr *);
+
+#endif
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,374 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/*
+ * Emulated nodes: one set of daemon globals per node
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "emu.h"
+#include "olsr.h"
+#include "olsr_cfg.h"
+#include "olsr_cookie.h"
+#include "scheduler.h"
+#include "interfaces.h"
+#include "ifnet.h"
+#include "net_os.h"
+#include "net_olsr.h"
+#include "parser.h"
+#include "build_msg.h"
+#include "link_set.h"
+#include "mantissa.h"
+#include "msg_cache.h"
+#include "generate_msg.h"
+#include "lq_packet.h"
+#include "process_routes.h"
+#include "routing_table.h"
+
+/*
+ * The Makefile renames all writable data of the daemon objects
+ * to the section olsr_state, the linker provides its bounds.
+ * Switching nodes copies this region in and out.
+ */
+extern unsigned char __start_olsr_state[];
+extern unsigned char __stop_olsr_state[];
+
+#define OLSR_STATE __attribute__ ((section("olsr_state")))
+
+/* normally provided by main.c */
+struct olsr_cookie_info *def_timer_ci OLSR_STATE = NULL;
+
+/* the daemon globals before any initialization */
+static unsigned char *pristine_state;
+
+/**
+ *@return the CPU time used by the process in nanoseconds
+ */
+uint64_t
+emu_cpu_nsec(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ *@return the size of the state of one node in bytes
+ */
+size_t
+emu_state_size(void)
+{
+  return __stop_olsr_state - __start_olsr_state;
+}
+
+/**
+ *Make node id the current one, saving the state
+ *of the previous node
+ *
+ *@param id the node to switch to
+ */
+static void
+emu_switch(uint32_t id)
+{
+  size_t size = emu_state_size();
+
+  if (id == emu_current) {
+    return;
+  }
+  if (emu_current != EMU_NONE) {
+    memcpy(emu_nodes[emu_current].state, __start_olsr_state, size);
+  }
+  memcpy(__start_olsr_state, emu_nodes[id].state, size);
+  emu_current = id;
+}
+
+/**
+ *Keep the route bitset of the current node and the
+ *global count of wrong routes up to date
+ */
+static int
+emu_route_change(const struct rt_entry *rt, bool add)
+{
+  struct emu_node *node = &emu_nodes[emu_current];
+  uint32_t id;
+
+  if (rt->rt_dst.prefix_len != olsr_cnf->maxplen) {
+    return 0;
+  }
+  id = emu_addr2node(&rt->rt_dst.prefix);
+  if (id >= emu_node_count || EMU_BIT_TEST(node->routes, id) == add) {
+    return 0;
+  }
+
+  if (add) {
+    EMU_BIT_SET(node->routes, id);
+  } else {
+    EMU_BIT_CLEAR(node->routes, id);
+  }
+  if (EMU_BIT_TEST(node->reachable, id) == add) {
+    emu_route_mismatch--;
+  } else {
+    emu_route_mismatch++;
+  }
+  return 0;
+}
+
+static int
+emu_add_route(const struct rt_entry *rt)
+{
+  return emu_route_change(rt, true);
+}
+
+static int
+emu_del_route(const struct rt_entry *rt)
+{
+  return emu_route_change(rt, false);
+}
+
+/**
+ *Replaces the socket send of the daemon, every packet
+ *goes to the emulated air of the current node
+ */
+ssize_t
+olsr_sendto(int s __attribute__ ((unused)), const void *buf, size_t len, int flags __attribute__ ((unused)),
+            const struct sockaddr *to __attribute__ ((unused)), socklen_t tolen __attribute__ ((unused)))
+{
+  emu_transmit(buf, len);
+  return len;
+}
+
+/**
+ *Replaces the host emulation interface of the daemon,
+ *the same setup without the olsr_switch socket
+ */
+int
+add_hemu_if(struct olsr_if *iface)
+{
+  struct interface *ifp;
+
+  if (!iface->host_emul)
+    return -1;
+
+  ifp = olsr_malloc(sizeof(struct interface), "emu interface");
+
+  ifp->olsr_if = iface;
+  iface->configured = true;
+  iface->interf = ifp;
+
+  ifp->is_hcif = true;
+  ifp->int_name = olsr_malloc(strlen(iface->name) + 1, "emu interface name");
+  strcpy(ifp->int_name, iface->name);
+  ifp->olsr_socket = -1;
+  ifp->send_socket = -1;
+
+  ifp->int_next = ifnet;
+  ifnet = ifp;
+  olsr_msg_cache_invalidate(MSG_CACHE_MID);
+
+  olsr_cnf->main_addr = iface->hemu_ip;
+  olsr_cnf->unicast_src_ip = iface->hemu_ip;
+  ifp->ip_addr.v4 = iface->hemu_ip.v4;
+  memcpy(&((struct sockaddr_in *)&ifp->int_addr)->sin_addr, &iface->hemu_ip, olsr_cnf->ipsize);
+
+  ifp->int_mtu = OLSR_DEFAULT_MTU - UDP_IPV4_HDRSIZE;
+  net_add_buffer(ifp);
+
+  ifp->hello_gen_timer =
+    olsr_start_timer(iface->cnf->hello_params.emission_interval * MSEC_PER_SEC, HELLO_JITTER, OLSR_TIMER_PERIODIC,
+                     olsr_cnf->lq_level == 0 ? &generate_hello : &olsr_output_lq_hello, ifp, hello_gen_timer_cookie);
+  ifp->tc_gen_timer =
+    olsr_start_timer(iface->cnf->tc_params.emission_interval * MSEC_PER_SEC, TC_JITTER, OLSR_TIMER_PERIODIC,
+                     olsr_cnf->lq_level == 0 ? &generate_tc : &olsr_output_lq_tc, ifp, tc_gen_timer_cookie);
+  ifp->mid_gen_timer =
+    olsr_start_timer(iface->cnf->mid_params.emission_interval * MSEC_PER_SEC, MID_JITTER, OLSR_TIMER_PERIODIC, &generate_mid, ifp,
+                     mid_gen_timer_cookie);
+  ifp->hna_gen_timer =
+    olsr_start_timer(iface->cnf->hna_params.emission_interval * MSEC_PER_SEC, HNA_JITTER, OLSR_TIMER_PERIODIC, &generate_hna, ifp,
+                     hna_gen_timer_cookie);
+
+  if (olsr_cnf->max_tc_vtime < iface->cnf->tc_params.emission_interval)
+    olsr_cnf->max_tc_vtime = iface->cnf->tc_params.emission_interval;
+
+  ifp->hello_etime = (olsr_reltime) (iface->cnf->hello_params.emission_interval * MSEC_PER_SEC);
+  ifp->valtimes.hello = reltime_to_me(iface->cnf->hello_params.validity_time * MSEC_PER_SEC);
+  ifp->valtimes.tc = reltime_to_me(iface->cnf->tc_params.validity_time * MSEC_PER_SEC);
+  ifp->valtimes.mid = reltime_to_me(iface->cnf->mid_params.validity_time * MSEC_PER_SEC);
+  ifp->valtimes.hna = reltime_to_me(iface->cnf->hna_params.validity_time * MSEC_PER_SEC);
+
+  ifp->mode = iface->cnf->mode;
+
+  return 1;
+}
+
+/**
+ *Create node id and run the daemon initialization
+ *of main() for it, with one emulated interface
+ *
+ *@param id the node number
+ *@param cfg the protocol parameters
+ */
+void
+emu_node_create(uint32_t id, const struct emu_config *cfg)
+{
+  struct emu_node *node = &emu_nodes[id];
+  struct if_config_options *ifcnf;
+  struct olsr_if *iface;
+  size_t size = emu_state_size();
+
+  if (pristine_state == NULL) {
+    pristine_state = olsr_malloc(size, "emu pristine state");
+    memcpy(pristine_state, __start_olsr_state, size);
+  }
+
+  node->state = olsr_malloc(size, "emu node state");
+  memcpy(node->state, pristine_state, size);
+  emu_switch(id);
+
+  olsr_cnf = olsrd_get_default_cnf();
+  olsr_cnf->debug_level = 0;
+  olsr_cnf->pollrate = cfg->pollrate / 1000.0;
+
+  ifcnf = get_default_if_config();
+  if (cfg->hello_interval > 0) {
+    ifcnf->hello_params.emission_interval = cfg->hello_interval;
+    ifcnf->hello_params.validity_time = cfg->hello_interval * 3;
+  }
+  if (cfg->tc_interval > 0) {
+    ifcnf->tc_params.emission_interval = cfg->tc_interval;
+    ifcnf->tc_params.validity_time = cfg->tc_interval * 3;
+  }
+
+  iface = olsr_create_olsrif("emu0", true);
+  memcpy(iface->cnf, ifcnf, sizeof(*ifcnf));
+  iface->hemu_ip = node->addr;
+  olsr_cnf->interface_defaults = ifcnf;
+
+  /* all nodes start together at virtual time 0 */
+  olsr_init_timers();
+  now_times = 0;
+  def_timer_ci = olsr_alloc_cookie("Default Timer Cookie", OLSR_COOKIE_TYPE_TIMER);
+
+  set_empty_tc_timer(GET_TIMESTAMP(0));
+  olsr_init_parser();
+  olsr_init_export_route();
+  init_msg_seqno();
+  olsr_init_willingness();
+  init_net();
+  olsr_init_interfacedb();
+  olsr_init_tables();
+
+  olsr_addroute_function = &emu_add_route;
+  olsr_addroute6_function = &emu_add_route;
+  olsr_delroute_function = &emu_del_route;
+  olsr_delroute6_function = &emu_del_route;
+
+  link_changes = false;
+  node->ifp = ifnet;
+}
+
+/**
+ *Run one scheduler round of node id at the virtual time
+ *now, feeding it the packets that arrived since the last one.
+ *A node without packets and without a timer due is not
+ *switched in, the round would not change it.
+ *
+ *@param id the node number
+ *@param now the virtual time in milliseconds
+ */
+void
+emu_node_run(uint32_t id, uint32_t now)
+{
+  static union {
+    struct olsr packet;
+    unsigned char buf[MAXMESSAGESIZE + 1];
+  } in;
+  struct emu_node *node = &emu_nodes[id];
+  uint64_t start;
+  uint32_t i;
+
+  if (node->inbox_count == 0 && node->next_timer > now) {
+    node->last_round = now;
+    return;
+  }
+
+  emu_switch(id);
+  start = emu_cpu_nsec();
+
+  /* packets are parsed no earlier than the last round, as if
+     the skipped rounds had run */
+  now_times = node->last_round;
+
+  for (i = 0; i < node->inbox_count; i++) {
+    struct emu_frame *frame = node->inbox[i].frame;
+
+    /* the parser converts the packet in place */
+    memcpy(in.buf, frame->data, frame->len);
+    if (node->inbox[i].time > now_times) {
+      now_times = node->inbox[i].time;
+    }
+    node->rx_packets++;
+    node->rx_bytes += frame->len;
+    parse_packet(&in.packet, frame->len, node->ifp, &emu_nodes[frame->from].addr, NULL);
+
+    if (--frame->refcount == 0) {
+      free(frame);
+    }
+  }
+  node->inbox_count = 0;
+
+  now_times = now;
+  olsr_scheduler_round();
+  node->next_timer = olsr_next_timer_clock();
+  node->last_round = now;
+
+  node->cpu_nsec += emu_cpu_nsec() - start;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
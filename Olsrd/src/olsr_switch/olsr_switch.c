@@ -0,0 +1,670 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/*
+ * olsr_switch: runs a whole mesh of olsrd nodes in one process
+ * with emulated links and a virtual clock
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/time.h>
+
+#include "emu.h"
+#include "olsr.h"
+#include "olsr_cfg.h"
+#include "scheduler.h"
+
+struct emu_node *emu_nodes;
+uint32_t emu_node_count;
+uint32_t emu_current = EMU_NONE;
+uint64_t emu_route_mismatch;
+
+/* a scheduled change of the topology */
+struct emu_event {
+  uint32_t time;                       /* milliseconds */
+  uint32_t a, b;
+  bool up;
+};
+
+static struct emu_event *events;
+static uint32_t event_count, event_size;
+
+/* min-heap of the packets in flight, ordered by arrival */
+static struct emu_delivery *heap;
+static uint32_t heap_count, heap_size;
+static uint64_t delivery_seq;
+
+static uint32_t link_count;
+static uint32_t emu_seed;
+
+/* parameters of generated links and links without own ones */
+static float default_loss;
+static uint32_t default_delay;
+
+static void
+usage(void)
+{
+  fprintf(stderr, "usage: olsr_switch (-grid WxH | -line N | -random N [-degree D] | -topo file)\n"
+          "                   [-loss percent] [-delay ms] [-time s] [-fail s]\n"
+          "                   [-pollrate ms] [-hint s] [-tcint s] [-seed n]\n");
+  exit(EXIT_FAILURE);
+}
+
+static void *
+emu_grow(void *array, uint32_t * size, size_t elem)
+{
+  *size = *size ? *size * 2 : 16;
+  array = realloc(array, *size * elem);
+  if (array == NULL) {
+    olsr_exit("olsr_switch: out of memory", EXIT_FAILURE);
+  }
+  return array;
+}
+
+/**
+ *Small xorshift generator for loss and topologies, so
+ *they do not depend on the random() calls of the daemon
+ */
+static uint32_t
+emu_random(void)
+{
+  emu_seed ^= emu_seed << 13;
+  emu_seed ^= emu_seed >> 17;
+  emu_seed ^= emu_seed << 5;
+  return emu_seed;
+}
+
+static double
+emu_random_unit(void)
+{
+  return emu_random() / 4294967296.0;
+}
+
+/**
+ *@return the node with the address addr or EMU_NONE
+ */
+uint32_t
+emu_addr2node(const union olsr_ip_addr *addr)
+{
+  uint32_t id = ntohl(addr->v4.s_addr) - EMU_ADDR_BASE - 1;
+
+  return id < emu_node_count ? id : EMU_NONE;
+}
+
+static struct emu_link *
+emu_find_link(uint32_t a, uint32_t b)
+{
+  struct emu_node *node = &emu_nodes[a];
+  uint32_t i;
+
+  for (i = 0; i < node->link_count; i++) {
+    if (node->links[i].to == b) {
+      return &node->links[i];
+    }
+  }
+  return NULL;
+}
+
+static void
+emu_add_half_link(uint32_t a, uint32_t b, float loss, uint32_t delay)
+{
+  struct emu_node *node = &emu_nodes[a];
+  struct emu_link *link;
+
+  if (node->link_count == node->link_size) {
+    node->links = emu_grow(node->links, &node->link_size, sizeof(*node->links));
+  }
+  link = &node->links[node->link_count++];
+  link->to = b;
+  link->loss = loss;
+  link->delay = delay;
+  link->up = true;
+}
+
+static void
+emu_add_link(uint32_t a, uint32_t b, float loss, uint32_t delay)
+{
+  if (a == b || a >= emu_node_count || b >= emu_node_count) {
+    fprintf(stderr, "olsr_switch: bad link %u - %u\n", a, b);
+    exit(EXIT_FAILURE);
+  }
+  if (emu_find_link(a, b) != NULL) {
+    return;
+  }
+  emu_add_half_link(a, b, loss, delay);
+  emu_add_half_link(b, a, loss, delay);
+  link_count++;
+}
+
+static void
+emu_set_nodes(uint32_t count)
+{
+  if (count < 2 || count > EMU_MAX_NODES) {
+    fprintf(stderr, "olsr_switch: bad number of nodes %u\n", count);
+    exit(EXIT_FAILURE);
+  }
+  emu_node_count = count;
+  emu_nodes = olsr_malloc(count * sizeof(*emu_nodes), "emu nodes");
+}
+
+static void
+emu_add_event(uint32_t time, uint32_t a, uint32_t b, bool up)
+{
+  struct emu_event *ev;
+
+  if (event_count == event_size) {
+    events = emu_grow(events, &event_size, sizeof(*events));
+  }
+  ev = &events[event_count++];
+  ev->time = time;
+  ev->a = a;
+  ev->b = b;
+  ev->up = up;
+}
+
+static int
+emu_event_cmp(const void *p1, const void *p2)
+{
+  const struct emu_event *e1 = p1, *e2 = p2;
+
+  return e1->time < e2->time ? -1 : e1->time > e2->time;
+}
+
+static void
+topo_grid(uint32_t w, uint32_t h)
+{
+  uint32_t x, y;
+
+  emu_set_nodes(w * h);
+  for (y = 0; y < h; y++) {
+    for (x = 0; x < w; x++) {
+      if (x + 1 < w)
+        emu_add_link(y * w + x, y * w + x + 1, default_loss, default_delay);
+      if (y + 1 < h)
+        emu_add_link(y * w + x, (y + 1) * w + x, default_loss, default_delay);
+    }
+  }
+}
+
+static void
+topo_line(uint32_t n)
+{
+  uint32_t i;
+
+  emu_set_nodes(n);
+  for (i = 0; i + 1 < n; i++) {
+    emu_add_link(i, i + 1, default_loss, default_delay);
+  }
+}
+
+/**
+ *Random geometric graph in the unit square, the radio
+ *range is chosen for the requested average degree
+ */
+static void
+topo_random(uint32_t n, double degree)
+{
+  double *x, *y, r2;
+  uint32_t i, j;
+
+  emu_set_nodes(n);
+  x = olsr_malloc(n * sizeof(*x), "emu random x");
+  y = olsr_malloc(n * sizeof(*y), "emu random y");
+  for (i = 0; i < n; i++) {
+    x[i] = emu_random_unit();
+    y[i] = emu_random_unit();
+  }
+
+  r2 = degree / (M_PI * n);
+  for (i = 0; i < n; i++) {
+    for (j = i + 1; j < n; j++) {
+      double dx = x[i] - x[j], dy = y[i] - y[j];
+      if (dx * dx + dy * dy < r2)
+        emu_add_link(i, j, default_loss, default_delay);
+    }
+  }
+  free(x);
+  free(y);
+}
+
+/**
+ *Read a topology file with the lines
+ *  nodes <n>
+ *  link <a> <b> [loss <percent>] [delay <ms>]
+ *  down <s> <a> <b>
+ *  up <s> <a> <b>
+ *Nodes are numbered from 0, '#' starts a comment.
+ */
+static void
+topo_file(const char *name)
+{
+  char line[256];
+  unsigned int lineno = 0;
+  FILE *f = fopen(name, "r");
+
+  if (f == NULL) {
+    perror(name);
+    exit(EXIT_FAILURE);
+  }
+
+  while (fgets(line, sizeof(line), f) != NULL) {
+    char *word, *save;
+    unsigned int a, b, n;
+    double t;
+
+    lineno++;
+    if ((word = strchr(line, '#')) != NULL)
+      *word = 0;
+    word = strtok_r(line, " \t\r\n", &save);
+    if (word == NULL)
+      continue;
+
+    if (strcmp(word, "nodes") == 0 && emu_nodes == NULL && sscanf(save, "%u", &n) == 1) {
+      emu_set_nodes(n);
+    } else if (emu_nodes == NULL) {
+      break;
+    } else if (strcmp(word, "link") == 0 && sscanf(save, "%u %u", &a, &b) == 2) {
+      float loss = default_loss;
+      uint32_t delay = default_delay;
+
+      strtok_r(NULL, " \t\r\n", &save);
+      strtok_r(NULL, " \t\r\n", &save);
+      while ((word = strtok_r(NULL, " \t\r\n", &save)) != NULL) {
+        const char *value = strtok_r(NULL, " \t\r\n", &save);
+        if (value != NULL && strcmp(word, "loss") == 0)
+          loss = atof(value) / 100;
+        else if (value != NULL && strcmp(word, "delay") == 0)
+          delay = atoi(value);
+        else
+          break;
+      }
+      if (word != NULL)
+        break;
+      emu_add_link(a, b, loss, delay);
+    } else if ((strcmp(word, "down") == 0 || strcmp(word, "up") == 0)
+               && sscanf(save, "%lf %u %u", &t, &a, &b) == 3) {
+      emu_add_event(t * MSEC_PER_SEC, a, b, word[0] == 'u');
+    } else {
+      break;
+    }
+  }
+
+  if (!feof(f) || emu_nodes == NULL) {
+    fprintf(stderr, "%s:%u: syntax error\n", name, lineno);
+    exit(EXIT_FAILURE);
+  }
+  fclose(f);
+}
+
+static bool
+heap_less(const struct emu_delivery *d1, const struct emu_delivery *d2)
+{
+  return d1->time < d2->time || (d1->time == d2->time && d1->seq < d2->seq);
+}
+
+static void
+heap_push(uint32_t time, uint32_t to, struct emu_frame *frame)
+{
+  struct emu_delivery d;
+  uint32_t i;
+
+  if (heap_count == heap_size) {
+    heap = emu_grow(heap, &heap_size, sizeof(*heap));
+  }
+
+  d.time = time;
+  d.to = to;
+  d.seq = delivery_seq++;
+  d.frame = frame;
+
+  for (i = heap_count++; i > 0 && heap_less(&d, &heap[(i - 1) / 2]); i = (i - 1) / 2) {
+    heap[i] = heap[(i - 1) / 2];
+  }
+  heap[i] = d;
+}
+
+static void
+heap_pop(struct emu_delivery *top)
+{
+  struct emu_delivery last;
+  uint32_t i = 0, child;
+
+  *top = heap[0];
+  last = heap[--heap_count];
+  while ((child = 2 * i + 1) < heap_count) {
+    if (child + 1 < heap_count && heap_less(&heap[child + 1], &heap[child]))
+      child++;
+    if (!heap_less(&heap[child], &last))
+      break;
+    heap[i] = heap[child];
+    i = child;
+  }
+  heap[i] = last;
+}
+
+/**
+ *Called for every packet the current node sends, queues
+ *a delivery for every neighbor the link loss lets through
+ *
+ *@param buf the packet
+ *@param len its length
+ */
+void
+emu_transmit(const void *buf, size_t len)
+{
+  struct emu_node *node = &emu_nodes[emu_current];
+  struct emu_frame *frame;
+  uint32_t i;
+
+  node->tx_packets++;
+  node->tx_bytes += len;
+
+  frame = olsr_malloc(sizeof(*frame) + len, "emu frame");
+  frame->from = emu_current;
+  frame->len = len;
+  memcpy(frame->data, buf, len);
+
+  for (i = 0; i < node->link_count; i++) {
+    struct emu_link *link = &node->links[i];
+
+    if (!link->up || (link->loss > 0 && emu_random_unit() < link->loss))
+      continue;
+    frame->refcount++;
+    heap_push(now_times + link->delay, link->to, frame);
+  }
+
+  if (frame->refcount == 0) {
+    free(frame);
+  }
+}
+
+/**
+ *Compute the nodes every node can reach over links that are
+ *up and count the installed routes which differ from that
+ */
+static void
+emu_update_reachable(void)
+{
+  uint32_t words = EMU_BITSET_WORDS(emu_node_count);
+  uint32_t *queue = olsr_malloc(emu_node_count * sizeof(*queue), "emu bfs");
+  uint32_t i, w;
+
+  emu_route_mismatch = 0;
+  for (i = 0; i < emu_node_count; i++) {
+    struct emu_node *node = &emu_nodes[i];
+    uint32_t head = 0, tail = 0;
+
+    memset(node->reachable, 0, words * sizeof(uint32_t));
+    EMU_BIT_SET(node->reachable, i);
+    queue[tail++] = i;
+    while (head < tail) {
+      struct emu_node *cur = &emu_nodes[queue[head++]];
+      uint32_t l;
+
+      for (l = 0; l < cur->link_count; l++) {
+        struct emu_link *link = &cur->links[l];
+        if (link->up && link->loss < 1 && !EMU_BIT_TEST(node->reachable, link->to)) {
+          EMU_BIT_SET(node->reachable, link->to);
+          queue[tail++] = link->to;
+        }
+      }
+    }
+    EMU_BIT_CLEAR(node->reachable, i);
+
+    for (w = 0; w < words; w++) {
+      emu_route_mismatch += __builtin_popcount(node->reachable[w] ^ node->routes[w]);
+    }
+  }
+  free(queue);
+}
+
+static void
+emu_set_link(const struct emu_event *ev)
+{
+  struct emu_link *ab, *ba;
+
+  if (ev->a >= emu_node_count || ev->b >= emu_node_count || (ab = emu_find_link(ev->a, ev->b)) == NULL) {
+    fprintf(stderr, "olsr_switch: no link %u - %u\n", ev->a, ev->b);
+    exit(EXIT_FAILURE);
+  }
+  ba = emu_find_link(ev->b, ev->a);
+  ab->up = ba->up = ev->up;
+  printf("event %.3f %s %u %u\n", ev->time / 1000.0, ev->up ? "up" : "down", ev->a, ev->b);
+}
+
+/**
+ *Schedule a seeded random link to go down at time
+ */
+static void
+emu_add_failure(uint32_t time)
+{
+  uint32_t pick, a, l;
+
+  if (link_count == 0)
+    return;
+
+  pick = emu_random() % link_count;
+  for (a = 0; a < emu_node_count; a++) {
+    for (l = 0; l < emu_nodes[a].link_count; l++) {
+      if (emu_nodes[a].links[l].to > a && pick-- == 0) {
+        emu_add_event(time, a, emu_nodes[a].links[l].to, false);
+        return;
+      }
+    }
+  }
+}
+
+static void
+emu_print_convergence(const char *key, uint32_t start, uint32_t converged)
+{
+  if (converged == EMU_NONE) {
+    printf("%s none\n", key);
+  } else {
+    printf("%s %.3f\n", key, (converged - start) / 1000.0);
+  }
+}
+
+static double
+emu_wallclock(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct emu_config cfg;
+  uint32_t duration = 60 * MSEC_PER_SEC, fail_time = 0;
+  uint32_t tick, next_event = 0, epoch_start = 0, converged = EMU_NONE;
+  uint64_t tx_total = 0, tx_max = 0, rx_total = 0, cpu_total = 0, cpu_max = 0;
+  unsigned int w, h, n;
+  double degree = 6, wall, seconds;
+  const char *topo = NULL, *topo_arg = NULL;
+  int i;
+
+  memset(&cfg, 0, sizeof(cfg));
+  cfg.pollrate = 50;
+  cfg.seed = 1;
+
+  for (i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+
+    if (i + 1 == argc)
+      usage();
+    if (strcmp(arg, "-grid") == 0 || strcmp(arg, "-line") == 0 || strcmp(arg, "-random") == 0 || strcmp(arg, "-topo") == 0) {
+      topo = arg;
+      topo_arg = argv[++i];
+    } else if (strcmp(arg, "-degree") == 0)
+      degree = atof(argv[++i]);
+    else if (strcmp(arg, "-loss") == 0)
+      default_loss = atof(argv[++i]) / 100;
+    else if (strcmp(arg, "-delay") == 0)
+      default_delay = atoi(argv[++i]);
+    else if (strcmp(arg, "-time") == 0)
+      duration = atof(argv[++i]) * MSEC_PER_SEC;
+    else if (strcmp(arg, "-fail") == 0)
+      fail_time = atof(argv[++i]) * MSEC_PER_SEC;
+    else if (strcmp(arg, "-pollrate") == 0)
+      cfg.pollrate = atoi(argv[++i]);
+    else if (strcmp(arg, "-hint") == 0)
+      cfg.hello_interval = atof(argv[++i]);
+    else if (strcmp(arg, "-tcint") == 0)
+      cfg.tc_interval = atof(argv[++i]);
+    else if (strcmp(arg, "-seed") == 0)
+      cfg.seed = strtoul(argv[++i], NULL, 0);
+    else
+      usage();
+  }
+  if (topo == NULL || cfg.pollrate == 0 || duration == 0)
+    usage();
+
+  /* the same seed gives the same run */
+  emu_seed = cfg.seed ? cfg.seed : 1;
+  srandom(cfg.seed);
+
+  if (strcmp(topo, "-grid") == 0 && sscanf(topo_arg, "%ux%u", &w, &h) == 2)
+    topo_grid(w, h);
+  else if (strcmp(topo, "-line") == 0 && sscanf(topo_arg, "%u", &n) == 1)
+    topo_line(n);
+  else if (strcmp(topo, "-random") == 0 && sscanf(topo_arg, "%u", &n) == 1)
+    topo_random(n, degree);
+  else if (strcmp(topo, "-topo") == 0)
+    topo_file(topo_arg);
+  else
+    usage();
+
+  if (fail_time)
+    emu_add_failure(fail_time);
+  qsort(events, event_count, sizeof(*events), emu_event_cmp);
+
+  wall = emu_wallclock();
+
+  for (n = 0; n < emu_node_count; n++) {
+    struct emu_node *node = &emu_nodes[n];
+
+    node->addr.v4.s_addr = htonl(EMU_ADDR_BASE + n + 1);
+    node->routes = olsr_malloc(EMU_BITSET_WORDS(emu_node_count) * sizeof(uint32_t), "emu routes");
+    node->reachable = olsr_malloc(EMU_BITSET_WORDS(emu_node_count) * sizeof(uint32_t), "emu reachable");
+    emu_node_create(n, &cfg);
+  }
+  emu_update_reachable();
+
+  printf("nodes %u\n", emu_node_count);
+  printf("links %u\n", link_count);
+  printf("state_bytes %lu\n", (unsigned long)emu_state_size());
+
+  for (tick = cfg.pollrate; tick <= duration; tick += cfg.pollrate) {
+    struct emu_delivery d;
+
+    /* topology changes start a new convergence epoch */
+    if (next_event < event_count && events[next_event].time <= tick) {
+      emu_print_convergence(epoch_start ? "reconverged_s" : "converged_s", epoch_start, converged);
+      while (next_event < event_count && events[next_event].time <= tick) {
+        emu_set_link(&events[next_event++]);
+      }
+      emu_update_reachable();
+      epoch_start = tick;
+      converged = EMU_NONE;
+    }
+
+    while (heap_count > 0 && heap[0].time <= tick) {
+      struct emu_node *node;
+
+      heap_pop(&d);
+      node = &emu_nodes[d.to];
+      if (node->inbox_count == node->inbox_size) {
+        node->inbox = emu_grow(node->inbox, &node->inbox_size, sizeof(*node->inbox));
+      }
+      node->inbox[node->inbox_count++] = d;
+    }
+
+    for (n = 0; n < emu_node_count; n++) {
+      emu_node_run(n, tick);
+    }
+
+    if (emu_route_mismatch != 0) {
+      converged = EMU_NONE;
+    } else if (converged == EMU_NONE) {
+      converged = tick;
+    }
+  }
+  emu_print_convergence(epoch_start ? "reconverged_s" : "converged_s", epoch_start, converged);
+  printf("route_mismatch %lu\n", (unsigned long)emu_route_mismatch);
+
+  wall = emu_wallclock() - wall;
+  seconds = duration / 1000.0;
+
+  for (n = 0; n < emu_node_count; n++) {
+    struct emu_node *node = &emu_nodes[n];
+
+    tx_total += node->tx_bytes;
+    rx_total += node->rx_bytes;
+    cpu_total += node->cpu_nsec;
+    if (node->tx_bytes > tx_max)
+      tx_max = node->tx_bytes;
+    if (node->cpu_nsec > cpu_max)
+      cpu_max = node->cpu_nsec;
+  }
+
+  printf("duration_s %.3f\n", seconds);
+  printf("tx_bytes_per_node_s %.1f\n", tx_total / seconds / emu_node_count);
+  printf("tx_bytes_per_node_s_max %.1f\n", tx_max / seconds);
+  printf("rx_bytes_per_node_s %.1f\n", rx_total / seconds / emu_node_count);
+  printf("cpu_usec_per_node_s %.1f\n", cpu_total / 1000.0 / seconds / emu_node_count);
+  printf("cpu_usec_per_node_s_max %.1f\n", cpu_max / 1000.0 / seconds);
+  printf("wall_s %.3f\n", wall);
+  printf("speedup %.1f\n", seconds / wall);
+
+  return 0;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,253 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/*
+ * Prints the binary trace files written by "olsrd -trace <file>".
+ * The event names and formats are taken from the file, so traces
+ * of other olsrd versions decode as well.
+ *
+ * usage: olsr_tracedump [-e event[,event...]] [-s] [file]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/trace_format.h"
+
+struct tracedump_event {
+  char *name;
+  char *format;
+  int selected;
+  unsigned long count;
+};
+
+static struct tracedump_event *events;
+static unsigned int event_count;
+
+static void
+usage(void)
+{
+  fprintf(stderr, "usage: olsr_tracedump [-e event[,event...]] [-s] [file]\n");
+  exit(EXIT_FAILURE);
+}
+
+static char *
+tracedump_read_string(FILE *in, size_t len)
+{
+  char *s = malloc(len + 1);
+
+  if (s == NULL || (len > 0 && fread(s, len, 1, in) != 1)) {
+    fprintf(stderr, "olsr_tracedump: truncated event description\n");
+    exit(EXIT_FAILURE);
+  }
+  s[len] = 0;
+  return s;
+}
+
+/**
+ *Read and check the file header and the event descriptions
+ *
+ *@param in the trace file
+ *@param hdr the header is returned here
+ */
+static void
+tracedump_read_header(FILE *in, struct olsr_trace_file_header *hdr)
+{
+  unsigned int i;
+
+  if (fread(hdr, sizeof(*hdr), 1, in) != 1 || memcmp(hdr->magic, OLSR_TRACE_MAGIC, sizeof(OLSR_TRACE_MAGIC)) != 0) {
+    fprintf(stderr, "olsr_tracedump: not an olsrd trace file\n");
+    exit(EXIT_FAILURE);
+  }
+  if (hdr->byte_order != OLSR_TRACE_BYTE_ORDER) {
+    fprintf(stderr, "olsr_tracedump: trace file written with a different byte order\n");
+    exit(EXIT_FAILURE);
+  }
+  if (hdr->version != OLSR_TRACE_VERSION || hdr->record_size < sizeof(struct olsr_trace_record)) {
+    fprintf(stderr, "olsr_tracedump: unsupported trace file version %u\n", hdr->version);
+    exit(EXIT_FAILURE);
+  }
+
+  for (i = 0; i < hdr->event_count; i++) {
+    struct olsr_trace_event_desc desc;
+    char *name, *format;
+
+    if (fread(&desc, sizeof(desc), 1, in) != 1) {
+      fprintf(stderr, "olsr_tracedump: truncated event description\n");
+      exit(EXIT_FAILURE);
+    }
+    name = tracedump_read_string(in, desc.name_len);
+    format = tracedump_read_string(in, desc.format_len);
+
+    if (desc.id >= event_count) {
+      events = realloc(events, (desc.id + 1) * sizeof(*events));
+      if (events == NULL) {
+        fprintf(stderr, "olsr_tracedump: out of memory\n");
+        exit(EXIT_FAILURE);
+      }
+      memset(&events[event_count], 0, (desc.id + 1 - event_count) * sizeof(*events));
+      event_count = desc.id + 1;
+    }
+    events[desc.id].name = name;
+    events[desc.id].format = format;
+    events[desc.id].selected = 1;
+  }
+}
+
+/**
+ *Print only the listed events
+ *
+ *@param list comma separated event names
+ */
+static void
+tracedump_select(char *list)
+{
+  unsigned int i;
+  char *name;
+
+  for (i = 0; i < event_count; i++) {
+    events[i].selected = 0;
+  }
+  for (name = strtok(list, ","); name != NULL; name = strtok(NULL, ",")) {
+    for (i = 0; i < event_count; i++) {
+      if (events[i].name != NULL && strcmp(events[i].name, name) == 0) {
+        events[i].selected = 1;
+        break;
+      }
+    }
+    if (i == event_count) {
+      fprintf(stderr, "olsr_tracedump: no event %s in this trace\n", name);
+      exit(EXIT_FAILURE);
+    }
+  }
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct olsr_trace_file_header hdr;
+  struct olsr_trace_record *rec;
+  unsigned long records = 0, dropped = 0;
+  char *select = NULL;
+  int summary = 0, i;
+  FILE *in = stdin;
+
+  for (i = 1; i < argc && argv[i][0] == '-' && argv[i][1] != 0; i++) {
+    if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) {
+      select = argv[++i];
+    } else if (strcmp(argv[i], "-s") == 0) {
+      summary = 1;
+    } else {
+      usage();
+    }
+  }
+  if (i + 1 < argc) {
+    usage();
+  }
+  if (i + 1 == argc && strcmp(argv[i], "-") != 0) {
+    in = fopen(argv[i], "rb");
+    if (in == NULL) {
+      perror(argv[i]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  tracedump_read_header(in, &hdr);
+  if (select != NULL) {
+    tracedump_select(select);
+  }
+
+  /* newer writers may append fields to the records */
+  rec = malloc(hdr.record_size);
+  if (rec == NULL) {
+    fprintf(stderr, "olsr_tracedump: out of memory\n");
+    return EXIT_FAILURE;
+  }
+
+  /* a partly written last record is ignored */
+  while (fread(rec, hdr.record_size, 1, in) == 1) {
+    char line[512];
+    int len;
+
+    records++;
+    if (rec->id >= event_count || events[rec->id].format == NULL) {
+      printf("unknown event %u\n", rec->id);
+      continue;
+    }
+    events[rec->id].count++;
+    if (events[rec->id].name != NULL && strcmp(events[rec->id].name, "dropped") == 0) {
+      dropped += rec->arg[0];
+    }
+    if (summary || !events[rec->id].selected) {
+      continue;
+    }
+
+    len = olsr_trace_format(line, sizeof(line), "%t ", rec, hdr.ip_version, hdr.tz_offset, NULL);
+    olsr_trace_format(line + len, sizeof(line) - len, events[rec->id].format, rec, hdr.ip_version, hdr.tz_offset, NULL);
+    printf("%s\n", line);
+  }
+
+  if (summary) {
+    unsigned int id;
+
+    for (id = 0; id < event_count; id++) {
+      if (events[id].count > 0) {
+        printf("%-24s %lu\n", events[id].name, events[id].count);
+      }
+    }
+    printf("%-24s %lu\n", "records", records);
+    printf("%-24s %lu\n", "events_dropped", dropped);
+  }
+
+  if (in != stdin) {
+    fclose(in);
+  }
+  free(rec);
+  return 0;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -52,28 +52,8 @@
 
 static bool sending_tc = false;
 
-/**
- *Free the memory allocated for a HELLO packet.
- *
- *@param message the pointer to the packet to erase
- *
- *@return nada
- */
-void
-olsr_free_hello_packet(struct hello_message *message)
-{
-  struct hello_neighbor *nb;
-
-  if (!message)
-    return;
-
-  nb = message->neighbors;
-  while (nb) {
-    struct hello_neighbor *prev_nb = nb;
-    nb = nb->next;
-    free(prev_nb);
-  }
-}
+struct arena olsr_input_arena;
+struct arena olsr_output_arena;
 
 /**
  *Build an internal HELLO package for this
@@ -129,7 +109,7 @@ olsr_build_hello_packet(struct hello_message *message, struct interface *outif)
       continue;
     }
 
-    message_neighbor = olsr_malloc_hello_neighbor("Build HELLO");
+    message_neighbor = olsr_alloc_hello_neighbor(&olsr_output_arena, "Build HELLO");
 
     /* Find the link status */
     message_neighbor->link = lnk;
@@ -221,7 +201,7 @@ olsr_build_hello_packet(struct hello_message *message, struct interface *outif)
       continue;
     }
 
-    message_neighbor = olsr_malloc_hello_neighbor("Build HELLO 2");
+    message_neighbor = olsr_alloc_hello_neighbor(&olsr_output_arena, "Build HELLO 2");
 
     message_neighbor->link = UNSPEC_LINK;
 
@@ -283,29 +263,6 @@ olsr_build_hello_packet(struct hello_message *message, struct interface *outif)
   return 0;
 }
 
-/**
- *Free the memory allocated for a TC packet.
- *
- *@param message the pointer to the packet to erase
- *
- *@return nada
- */
-void
-olsr_free_tc_packet(struct tc_message *message)
-{
-  struct tc_mpr_addr *mprs;
-
-  if (!message)
-    return;
-
-  mprs = message->multipoint_relay_selector_address;
-  while (mprs != NULL) {
-    struct tc_mpr_addr *prev_mprs = mprs;
-    mprs = mprs->next;
-    free(prev_mprs);
-  }
-}
-
 /**
  *Build an internal TC package for this
  *node.
@@ -341,7 +298,7 @@ olsr_build_tc_packet(struct tc_message *message)
       {
         /* 2 = Add all neighbors */
         //printf("\t%s\n", olsr_ip_to_string(&mprs->mpr_selector_addr));
-        message_mpr = olsr_malloc_tc_mpr_addr("Build TC");
+        message_mpr = olsr_alloc_tc_mpr_addr(&olsr_output_arena, "Build TC");
 
         message_mpr->address = entry->neighbor_main_addr;
         message_mpr->next = message->multipoint_relay_selector_address;
@@ -354,7 +311,7 @@ olsr_build_tc_packet(struct tc_message *message)
         /* 1 = Add all MPR selectors and selected MPRs */
         if ((entry->is_mpr) || (olsr_lookup_mprs_set(&entry->neighbor_main_addr) != NULL)) {
           //printf("\t%s\n", olsr_ip_to_string(&mprs->mpr_selector_addr));
-          message_mpr = olsr_malloc_tc_mpr_addr("Build TC 2");
+          message_mpr = olsr_alloc_tc_mpr_addr(&olsr_output_arena, "Build TC 2");
 
           message_mpr->address = entry->neighbor_main_addr;
           message_mpr->next = message->multipoint_relay_selector_address;
@@ -368,7 +325,7 @@ olsr_build_tc_packet(struct tc_message *message)
         /* 0 = Add only MPR selectors(default) */
         if (olsr_lookup_mprs_set(&entry->neighbor_main_addr) != NULL) {
           //printf("\t%s\n", olsr_ip_to_string(&mprs->mpr_selector_addr));
-          message_mpr = olsr_malloc_tc_mpr_addr("Build TC 3");
+          message_mpr = olsr_alloc_tc_mpr_addr(&olsr_output_arena, "Build TC 3");
 
           message_mpr->address = entry->neighbor_main_addr;
           message_mpr->next = message->multipoint_relay_selector_address;
@@ -396,28 +353,6 @@ olsr_build_tc_packet(struct tc_message *message)
   return 0;
 }
 
-/**
- *Free the memory allocated for a MID packet.
- *
- *@param message the pointer to the packet to erase
- *
- *@return nada
- */
-
-void
-olsr_free_mid_packet(struct mid_message *message)
-{
-  struct mid_alias *tmp_adr, *tmp_adr2;
-
-  tmp_adr = message->mid_addr;
-
-  while (tmp_adr) {
-    tmp_adr2 = tmp_adr;
-    tmp_adr = tmp_adr->next;
-    free(tmp_adr2);
-  }
-}
-
 /*
  * Local Variables:
  * c-basic-offset: 2
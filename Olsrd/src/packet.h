@@ -45,6 +45,7 @@
 #include "olsr_protocol.h"
 #include "interfaces.h"
 #include "mantissa.h"
+#include "common/arena.h"
 
 struct hello_neighbor {
   uint8_t status;
@@ -115,16 +116,19 @@ struct unknown_message {
   uint8_t type;
 };
 
-void olsr_free_hello_packet(struct hello_message *);
+/*
+ * The neighbor and address lists of the internal message formats
+ * above are allocated from these arenas. The input arena is reset
+ * by parse_packet() after each message, the output arena after each
+ * generated message has been serialized.
+ */
+extern struct arena olsr_input_arena;
+extern struct arena olsr_output_arena;
 
 int olsr_build_hello_packet(struct hello_message *, struct interface *);
 
-void olsr_free_tc_packet(struct tc_message *);
-
 int olsr_build_tc_packet(struct tc_message *);
 
-void olsr_free_mid_packet(struct mid_message *);
-
 #endif
 
 /*
@@ -54,6 +54,8 @@
 #include "print_packet.h"
 #include "net_olsr.h"
 #include "duplicate_handler.h"
+#include "trace.h"
+#include "convergence.h"
 
 #ifdef WIN32
 #undef EWOULDBLOCK
@@ -73,7 +75,17 @@ char *StrError(unsigned int ErrNo);
 
 unsigned int cpu_overload_exit = 0;
 
-struct parse_function_entry *parse_functions;
+struct olsr_msgtype_stats olsr_msgtype_stats[256];
+
+/*
+ * Parse functions indexed by message type. Functions registered
+ * for PROMISCUOUS are kept in their own list; parse_packet()
+ * merges both by registration order.
+ */
+static struct parse_function_entry *parse_functions[256];
+static struct parse_function_entry *promiscuous_parse_functions;
+static uint32_t parse_function_seq;
+
 struct preprocessor_function_entry *preprocessor_functions;
 struct packetparser_function_entry *packetparser_functions;
 
@@ -108,11 +120,20 @@ olsr_destroy_parser(void) {
   struct parse_function_entry *pe, *pe_next;
   struct preprocessor_function_entry *ppe, *ppe_next;
   struct packetparser_function_entry *pae, *pae_next;
+  int i;
 
-  for (pe = parse_functions; pe; pe = pe_next) {
+  for (i = 0; i < 256; i++) {
+    for (pe = parse_functions[i]; pe; pe = pe_next) {
+      pe_next = pe->next;
+      free (pe);
+    }
+    parse_functions[i] = NULL;
+  }
+  for (pe = promiscuous_parse_functions; pe; pe = pe_next) {
     pe_next = pe->next;
     free (pe);
   }
+  promiscuous_parse_functions = NULL;
   for (ppe = preprocessor_functions; ppe; ppe = ppe_next) {
     ppe_next = ppe->next;
     free (ppe);
@@ -123,21 +144,41 @@ olsr_destroy_parser(void) {
   }
 }
 
+static struct parse_function_entry **
+parse_function_list(uint32_t type)
+{
+  if (type == PROMISCUOUS) {
+    return &promiscuous_parse_functions;
+  }
+  if (type < 256) {
+    return &parse_functions[type];
+  }
+  return NULL;
+}
+
 void
 olsr_parser_add_function(parse_function * function, uint32_t type)
 {
   struct parse_function_entry *new_entry;
+  struct parse_function_entry **list;
 
   OLSR_PRINTF(3, "Parser: registering event for type %d\n", type);
 
+  list = parse_function_list(type);
+  if (list == NULL) {
+    OLSR_PRINTF(1, "Register parse function: invalid message type %u\n", type);
+    return;
+  }
+
   new_entry = olsr_malloc(sizeof(struct parse_function_entry), "Register parse function");
 
   new_entry->function = function;
   new_entry->type = type;
+  new_entry->seq = ++parse_function_seq;
 
   /* Queue */
-  new_entry->next = parse_functions;
-  parse_functions = new_entry;
+  new_entry->next = *list;
+  *list = new_entry;
 
   OLSR_PRINTF(3, "Register parse function: Added function for type %d\n", type);
 
@@ -147,14 +188,20 @@ int
 olsr_parser_remove_function(parse_function * function, uint32_t type)
 {
   struct parse_function_entry *entry, *prev;
+  struct parse_function_entry **list;
 
-  entry = parse_functions;
+  list = parse_function_list(type);
+  if (list == NULL) {
+    return 0;
+  }
+
+  entry = *list;
   prev = NULL;
 
   while (entry) {
-    if ((entry->function == function) && (entry->type == type)) {
-      if (entry == parse_functions) {
-        parse_functions = entry->next;
+    if (entry->function == function) {
+      if (entry == *list) {
+        *list = entry->next;
       } else {
         prev->next = entry->next;
       }
@@ -214,6 +261,27 @@ olsr_preprocessor_remove_function(preprocessor_function * function)
   return 0;
 }
 
+/**
+ *Run a received packet through the registered preprocessors,
+ *latest registered first.
+ *
+ *@param packet the received packet
+ *@param in_if the interface the packet arrived on
+ *@param from_addr the sender of the packet
+ *@param length the size of the packet, updated by the preprocessors
+ *@return the packet to parse or NULL if it was discarded
+ */
+char *
+olsr_preprocess_packet(char *packet, struct interface *in_if, union olsr_ip_addr *from_addr, int *length)
+{
+  struct preprocessor_function_entry *entry;
+
+  for (entry = preprocessor_functions; entry != NULL && packet != NULL; entry = entry->next) {
+    packet = entry->function(packet, in_if, from_addr, length);
+  }
+  return packet;
+}
+
 void
 olsr_packetparser_add_function(packetparser_function * function)
 {
@@ -266,21 +334,31 @@ olsr_packetparser_remove_function(packetparser_function * function)
  *@param from the sockaddr struct describing the sender
  *@param olsr the olsr struct containing the message
  *@param size the size of the message
+ *@param rx_time the time the packet was received, NULL for now
  *@return nada
  */
 
 void
-parse_packet(struct olsr *olsr, int size, struct interface *in_if, union olsr_ip_addr *from_addr)
+parse_packet(struct olsr *olsr, int size, struct interface *in_if, union olsr_ip_addr *from_addr, const struct timeval *rx_time)
 {
   union olsr_message *m = (union olsr_message *)olsr->olsr_msg;
   uint32_t count;
   uint32_t msgsize;
   uint16_t seqno;
-  struct parse_function_entry *entry;
+  uint8_t msgtype;
+  struct parse_function_entry *entry, *typed, *promisc;
   struct packetparser_function_entry *packetparser;
+  struct olsr_msgtype_stats *stats;
+  struct timeval now, t1, t2;
 
   count = size - ((char *)m - (char *)olsr);
 
+  /* topology changes caused by this packet are timed from its receipt */
+  if (rx_time == NULL) {
+    gettimeofday(&now, NULL);
+    rx_time = &now;
+  }
+
   /* minimum packet size is 4 */
   if (count < 4)
     return;
@@ -325,6 +403,7 @@ parse_packet(struct olsr *olsr, int size, struct interface *in_if, union olsr_ip
   for (; count > 0; m = (union olsr_message *)((char *)m + (msgsize))) {
     bool forward = true;
     bool validated;
+    bool sampled;
 
     /* minimum message size is 8 + ipsize */
     if (count < 8 + olsr_cnf->ipsize)
@@ -339,6 +418,10 @@ parse_packet(struct olsr *olsr, int size, struct interface *in_if, union olsr_ip
       seqno = ntohs(m->v6.seqno);
     }
 
+    /* Should be the same for IPv4 and IPv6 */
+    msgtype = m->v4.olsr_msgtype;
+    stats = &olsr_msgtype_stats[msgtype];
+
     /* sanity check for msgsize */
     if (msgsize < 8 + olsr_cnf->ipsize) {
       struct ipaddr_str buf;
@@ -349,6 +432,7 @@ parse_packet(struct olsr *olsr, int size, struct interface *in_if, union olsr_ip
       olsr_syslog(OLSR_LOG_ERR, "Error, OLSR message from %s (type %d) is too small (%d bytes)"
           ", ignoring all further content of the packet\n",
           olsr_ip_to_string(&buf, msgorig), m->v4.olsr_msgtype, msgsize);
+      stats->dropped_invalid++;
       break;
     }
 
@@ -361,6 +445,7 @@ parse_packet(struct olsr *olsr, int size, struct interface *in_if, union olsr_ip
       olsr_syslog(OLSR_LOG_ERR, "Error, OLSR message from %s (type %d) must be"
           " longword aligned, but has a length of %d bytes",
           olsr_ip_to_string(&buf, msgorig), m->v4.olsr_msgtype, msgsize);
+      stats->dropped_invalid++;
       break;
     }
 
@@ -373,10 +458,13 @@ parse_packet(struct olsr *olsr, int size, struct interface *in_if, union olsr_ip
       olsr_syslog(OLSR_LOG_ERR, "Error, OLSR message from %s (type %d) says"
           " length=%d, but only %d bytes left",
           olsr_ip_to_string(&buf, msgorig), m->v4.olsr_msgtype, msgsize, count);
+      stats->dropped_invalid++;
       break;
     }
 
     count -= msgsize;
+    stats->messages++;
+    stats->bytes += msgsize;
 
     /*RFC 3626 section 3.4:
      *  2    If the time to live of the message is less than or equal to
@@ -390,33 +478,55 @@ parse_packet(struct olsr *olsr, int size, struct interface *in_if, union olsr_ip
     validated = olsr_validate_address((union olsr_ip_addr *)&m->v4.originator);
     if (ipequal((union olsr_ip_addr *)&m->v4.originator, &olsr_cnf->main_addr) || !validated) {
 #ifdef DEBUG
-      struct ipaddr_str buf;
-      OLSR_PRINTF(3, "Not processing message originating from %s!\n",
-                  olsr_ip_to_string(&buf, (union olsr_ip_addr *)&m->v4.originator));
+      OLSR_TRACE(3, OLSR_TRACE_MSG_NOT_PROCESSED, (union olsr_ip_addr *)&m->v4.originator, NULL, 0, 0, 0);
 #endif
 #ifndef NO_DUPLICATE_DETECTION_HANDLER
       if (validated) {
         olsr_test_originator_collision(m->v4.olsr_msgtype, seqno);
       }
 #endif
+      if (!validated) {
+        stats->dropped_invalid++;
+      }
       continue;
     }
 
-    entry = parse_functions;
-    while (entry) {
-      /* Should be the same for IPv4 and IPv6 */
-
-      /* Promiscuous or exact match */
-      if ((entry->type == PROMISCUOUS) || (entry->type == m->v4.olsr_msgtype)) {
-        if (!entry->function(m, in_if, from_addr))
-          forward = false;
+    /* time a sample of the messages, the clock is not free */
+    sampled = stats->messages % OLSR_MSGTYPE_SAMPLE_RATE == 1;
+    if (sampled) {
+      gettimeofday(&t1, NULL);
+    }
+    olsr_conv_cause_message(msgtype, (union olsr_ip_addr *)&m->v4.originator, rx_time);
+
+    /* call the parse functions for this type and the promiscuous ones, latest registered first */
+    typed = parse_functions[msgtype];
+    promisc = promiscuous_parse_functions;
+    while (typed || promisc) {
+      if (promisc == NULL || (typed != NULL && typed->seq > promisc->seq)) {
+        entry = typed;
+        typed = typed->next;
+      } else {
+        entry = promisc;
+        promisc = promisc->next;
       }
-      entry = entry->next;
+
+      if (!entry->function(m, in_if, from_addr))
+        forward = false;
+    }
+
+    if (sampled) {
+      gettimeofday(&t2, NULL);
+      stats->handler_samples++;
+      stats->handler_usec += (uint64_t)(t2.tv_sec - t1.tv_sec) * 1000000 + (t2.tv_usec - t1.tv_usec);
     }
 
+    /* drop the internal representations built by the parse functions */
+    arena_reset(&olsr_input_arena);
+
     if (forward) {
       olsr_forward_message(m, in_if, from_addr);
     }
+    olsr_conv_cause_end();
   }                             /* for olsr_msg */
 }
 
@@ -433,7 +543,7 @@ olsr_input(int fd, void *data __attribute__ ((unused)), unsigned int flags __att
 {
   struct interface *olsr_in_if;
   union olsr_ip_addr from_addr;
-  struct preprocessor_function_entry *entry;
+  struct timeval rx_time;
   char *packet;
 
   cpu_overload_exit = 0;
@@ -462,6 +572,8 @@ olsr_input(int fd, void *data __attribute__ ((unused)), unsigned int flags __att
       }
       break;
     }
+    olsr_recv_time(fd, &rx_time);
+
     if (olsr_cnf->ip_version == AF_INET) {
       /* IPv4 sender address */
       memcpy(&from_addr.v4, &((struct sockaddr_in *)&from)->sin_addr, sizeof(from_addr.v4));
@@ -490,17 +602,14 @@ olsr_input(int fd, void *data __attribute__ ((unused)), unsigned int flags __att
                   cc);
       return;
     }
+    olsr_in_if->rx_packets++;
+    olsr_in_if->rx_bytes += cc;
+
     // call preprocessors
-    entry = preprocessor_functions;
-    packet = &inbuf[0];
-
-    while (entry) {
-      packet = entry->function(packet, olsr_in_if, &from_addr, &cc);
-      // discard package ?
-      if (packet == NULL) {
-        return;
-      }
-      entry = entry->next;
+    packet = olsr_preprocess_packet(&inbuf[0], olsr_in_if, &from_addr, &cc);
+    // discard package ?
+    if (packet == NULL) {
+      return;
     }
 
     /*
@@ -508,7 +617,7 @@ olsr_input(int fd, void *data __attribute__ ((unused)), unsigned int flags __att
      * &inbuf.olsr
      * cc - bytes read
      */
-    parse_packet((struct olsr *)packet, cc, olsr_in_if, &from_addr);
+    parse_packet((struct olsr *)packet, cc, olsr_in_if, &from_addr, &rx_time);
 
   }
 }
@@ -530,7 +639,6 @@ olsr_input_hostemu(int fd, void *data __attribute__ ((unused)), unsigned int fla
   struct interface *olsr_in_if;
   union olsr_ip_addr from_addr;
   uint16_t pcklen;
-  struct preprocessor_function_entry *entry;
   char *packet;
 
   /* Host emulator receives IP address first to emulate
@@ -584,16 +692,10 @@ olsr_input_hostemu(int fd, void *data __attribute__ ((unused)), unsigned int fla
     return;
   }
   // call preprocessors
-  entry = preprocessor_functions;
-  packet = &inbuf[0];
-
-  while (entry) {
-    packet = entry->function(packet, olsr_in_if, &from_addr, &cc);
-    // discard package ?
-    if (packet == NULL) {
-      return;
-    }
-    entry = entry->next;
+  packet = olsr_preprocess_packet(&inbuf[0], olsr_in_if, &from_addr, &cc);
+  // discard package ?
+  if (packet == NULL) {
+    return;
   }
 
   /*
@@ -601,7 +703,7 @@ olsr_input_hostemu(int fd, void *data __attribute__ ((unused)), unsigned int fla
    * &inbuf.olsr
    * cc - bytes read
    */
-  parse_packet((struct olsr *)inbuf, cc, olsr_in_if, &from_addr);
+  parse_packet((struct olsr *)packet, cc, olsr_in_if, &from_addr, NULL);
 
 }
 
@@ -52,10 +52,27 @@ typedef bool parse_function(union olsr_message *, struct interface *, union olsr
 
 struct parse_function_entry {
   uint32_t type;                       /* If set to PROMISCUOUS all messages will be received */
+  uint32_t seq;                        /* registration order */
   parse_function *function;
   struct parse_function_entry *next;
 };
 
+/* Per message type accounting of parse_packet() */
+struct olsr_msgtype_stats {
+  uint32_t messages;                   /* messages received */
+  uint32_t duplicates;                 /* messages found in the duplicate set */
+  uint32_t forwarded;                  /* messages forwarded */
+  uint32_t dropped_invalid;            /* malformed or invalid originator */
+  uint64_t bytes;                      /* bytes of the received messages */
+  uint32_t handler_samples;            /* messages whose parse functions were timed */
+  uint64_t handler_usec;               /* wall clock time of the timed parse functions */
+};
+
+/* the parse functions are timed for one in this many messages of a type */
+#define OLSR_MSGTYPE_SAMPLE_RATE 16
+
+extern struct olsr_msgtype_stats olsr_msgtype_stats[256];
+
 typedef char *preprocessor_function(char *packet, struct interface *, union olsr_ip_addr *, int *length);
 
 struct preprocessor_function_entry {
@@ -88,10 +105,12 @@ void olsr_preprocessor_add_function(preprocessor_function);
 
 int olsr_preprocessor_remove_function(preprocessor_function);
 
+char *olsr_preprocess_packet(char *, struct interface *, union olsr_ip_addr *, int *);
+
 void olsr_packetparser_add_function(packetparser_function * function);
 
 int olsr_packetparser_remove_function(packetparser_function * function);
 
-void parse_packet(struct olsr *, int, struct interface *, union olsr_ip_addr *);
+void parse_packet(struct olsr *, int, struct interface *, union olsr_ip_addr *, const struct timeval *);
 
 #endif
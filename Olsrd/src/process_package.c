@@ -352,7 +352,7 @@ deserialize_hello(struct hello_message *hello, const void *ser)
 
     limit2 += size2;
     while (curr < limit2) {
-      struct hello_neighbor *neigh = olsr_malloc_hello_neighbor("HELLO deserialization");
+      struct hello_neighbor *neigh = olsr_alloc_hello_neighbor(&olsr_input_arena, "HELLO deserialization");
       pkt_get_ipaddress(&curr, &neigh->address);
       if (type == LQ_HELLO_MESSAGE) {
         olsr_deserialize_hello_lq_pair(&curr, neigh);
@@ -505,8 +505,6 @@ olsr_hello_tap(struct hello_message *message, struct interface *in_if, const uni
   /* Process changes immedeatly in case of MPR updates */
   olsr_process_changes();
 
-  olsr_free_hello_packet(message);
-
   return;
 }
 
@@ -53,6 +53,8 @@
 #include "tc_set.h"
 #include "olsr_cookie.h"
 #include "olsr_niit.h"
+#include "change_notify.h"
+#include "convergence.h"
 
 #ifdef WIN32
 char *StrError(unsigned int ErrNo);
@@ -93,6 +95,8 @@ export_route_function olsr_addroute6_function;
 export_route_function olsr_delroute_function;
 export_route_function olsr_delroute6_function;
 
+struct olsr_kernel_route_stats olsr_kernel_route_stats;
+
 void
 olsr_init_export_route(void)
 {
@@ -169,9 +173,12 @@ olsr_delete_kernel_route(struct rt_entry *rt)
   if (!olsr_cnf->host_emul) {
     int16_t error = olsr_cnf->ip_version == AF_INET ? olsr_delroute_function(rt) : olsr_delroute6_function(rt);
 
+    olsr_kernel_route_stats.deletes++;
     if (error != 0) {
       const char *const err_msg = strerror(errno);
       const char *const routestr = olsr_rt_to_string(rt);
+
+      olsr_kernel_route_stats.delete_errors++;
       OLSR_PRINTF(1, "KERN: ERROR deleting %s: %s\n", routestr, err_msg);
 
       olsr_syslog(OLSR_LOG_ERR, "Delete route %s: %s", routestr, err_msg);
@@ -205,9 +212,12 @@ olsr_add_kernel_route(struct rt_entry *rt)
   if (!olsr_cnf->host_emul) {
     int16_t error = (olsr_cnf->ip_version == AF_INET) ? olsr_addroute_function(rt) : olsr_addroute6_function(rt);
 
+    olsr_kernel_route_stats.adds++;
     if (error != 0) {
       const char *const err_msg = strerror(errno);
       const char *const routestr = olsr_rtp_to_string(rt->rt_best);
+
+      olsr_kernel_route_stats.add_errors++;
       OLSR_PRINTF(1, "KERN: ERROR adding %s: %s\n", routestr, err_msg);
 
       olsr_syslog(OLSR_LOG_ERR, "Add route %s: %s", routestr, err_msg);
@@ -307,6 +317,32 @@ olsr_delete_outdated_routes(struct rt_entry *rt)
   }
 }
 
+/**
+ * Report a new route, or a change of nexthop or metric of the
+ * best path of a route, to the change handlers.
+ */
+static void
+olsr_notify_rt_change(struct rt_entry *rt)
+{
+  const struct rt_path *rtp = rt->rt_best;
+  enum olsr_change_type type;
+
+  if (rt->rt_notified_nexthop.iif_index == -1) {
+    type = OLSR_CHG_ROUTE_ADD;
+  } else if (olsr_nh_change(&rtp->rtp_nexthop, &rt->rt_notified_nexthop)
+             || rtp->rtp_metric.cost != rt->rt_notified_metric.cost
+             || olsr_hopcount_change(&rtp->rtp_metric, &rt->rt_notified_metric)) {
+    type = OLSR_CHG_ROUTE_CHG;
+  } else {
+    return;
+  }
+
+  rt->rt_notified_nexthop = rtp->rtp_nexthop;
+  rt->rt_notified_metric = rtp->rtp_metric;
+  olsr_notify_change(type, &rt->rt_dst.prefix, &rtp->rtp_nexthop.gateway, rt->rt_dst.prefix_len,
+                     rtp->rtp_metric.cost, rtp->rtp_metric.hops);
+}
+
 /**
  * Walk all the routes, remove outdated routes and run
  * best path selection on the remaining set.
@@ -333,6 +369,10 @@ olsr_update_rib_routes(void)
   
       if (olsr_delete_kernel_route(rt) == 0) {
         /*only remove if deletion was successful*/
+        if (rt->rt_notified_nexthop.iif_index != -1) {
+          olsr_notify_change(OLSR_CHG_ROUTE_DEL, &rt->rt_dst.prefix, &rt->rt_notified_nexthop.gateway, rt->rt_dst.prefix_len,
+                             rt->rt_notified_metric.cost, rt->rt_notified_metric.hops);
+        }
         avl_delete(&routingtree, &rt->rt_tree_node);
         olsr_cookie_free(rt_mem_cookie, rt);
       }
@@ -343,6 +383,8 @@ olsr_update_rib_routes(void)
     /* run best route election */
     olsr_rt_best(rt);
 
+    olsr_notify_rt_change(rt);
+
     /* nexthop or hopcount change ? */
     if (olsr_nh_change(&rt->rt_best->rtp_nexthop, &rt->rt_nexthop)
         || (FIBM_CORRECT == olsr_cnf->fib_metric && olsr_hopcount_change(&rt->rt_best->rtp_metric, &rt->rt_metric))) {
@@ -412,6 +454,7 @@ olsr_update_kernel_routes(void)
 {
   /* route changes */
   olsr_chg_kernel_routes(&chg_kernel_list);
+  olsr_conv_kernel_done();
 
 #if DEBUG
   olsr_print_routing_table(&routingtree);
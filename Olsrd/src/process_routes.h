@@ -47,6 +47,16 @@
 
 typedef int (*export_route_function) (const struct rt_entry *);
 
+/* Kernel route operations, read by monitoring plugins */
+struct olsr_kernel_route_stats {
+  uint32_t adds;
+  uint32_t add_errors;
+  uint32_t deletes;
+  uint32_t delete_errors;
+};
+
+extern struct olsr_kernel_route_stats olsr_kernel_route_stats;
+
 extern export_route_function olsr_addroute_function;
 extern export_route_function olsr_addroute6_function;
 extern export_route_function olsr_delroute_function;
@@ -52,6 +52,7 @@
 #include "common/avl.h"
 #include "olsr_spf.h"
 #include "net_olsr.h"
+#include "trace.h"
 
 #include <assert.h>
 
@@ -240,6 +241,7 @@ olsr_alloc_rt_entry(struct olsr_ip_prefix *prefix)
 
   /* Mark this entry as fresh (see process_routes.c:512) */
   rt->rt_nexthop.iif_index = -1;
+  rt->rt_notified_nexthop.iif_index = -1;
 
   /* set key and backpointer prior to tree insertion */
   rt->rt_dst = *prefix;
@@ -523,9 +525,6 @@ olsr_rt_best(struct rt_entry *rt)
 struct rt_path *
 olsr_insert_routing_table(union olsr_ip_addr *dst, int plen, union olsr_ip_addr *originator, int origin)
 {
-#ifdef DEBUG
-  struct ipaddr_str dstbuf, origbuf;
-#endif
   struct tc_entry *tc;
   struct rt_path *rtp;
   struct avl_node *node;
@@ -562,8 +561,7 @@ olsr_insert_routing_table(union olsr_ip_addr *dst, int plen, union olsr_ip_addr
       return NULL;
     }
 #ifdef DEBUG
-    OLSR_PRINTF(1, "RIB: add prefix %s/%u from %s\n", olsr_ip_to_string(&dstbuf, dst), plen,
-                olsr_ip_to_string(&origbuf, originator));
+    OLSR_TRACE(1, OLSR_TRACE_RIB_ADD, dst, originator, plen, 0, 0);
 #endif
 
     /* overload the hna change bit for flagging a prefix change */
@@ -582,10 +580,6 @@ olsr_insert_routing_table(union olsr_ip_addr *dst, int plen, union olsr_ip_addr
 void
 olsr_delete_routing_table(union olsr_ip_addr *dst, int plen, union olsr_ip_addr *originator)
 {
-#ifdef DEBUG
-  struct ipaddr_str dstbuf, origbuf;
-#endif
-
   struct tc_entry *tc;
   struct rt_path *rtp;
   struct avl_node *node;
@@ -616,8 +610,7 @@ olsr_delete_routing_table(union olsr_ip_addr *dst, int plen, union olsr_ip_addr
     olsr_delete_rt_path(rtp);
 
 #ifdef DEBUG
-    OLSR_PRINTF(1, "RIB: del prefix %s/%u from %s\n", olsr_ip_to_string(&dstbuf, dst), plen,
-                olsr_ip_to_string(&origbuf, originator));
+    OLSR_TRACE(1, OLSR_TRACE_RIB_DEL, dst, originator, plen, 0, 0);
 #endif
 
     /* overload the hna change bit for flagging a prefix change */
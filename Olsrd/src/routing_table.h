@@ -90,6 +90,8 @@ struct rt_entry {
   struct rt_metric rt_metric;          /* metric of FIB route */
   struct avl_tree rt_path_tree;
   struct list_node rt_change_node;     /* queue for kernel FIB add/chg/del */
+  struct rt_nexthop rt_notified_nexthop;  /* last state reported to change handlers, */
+  struct rt_metric rt_notified_metric;    /* iif_index -1 if not reported yet */
 };
 
 AVLNODE2STRUCT(rt_tree2rt, struct rt_entry, rt_tree_node);
@@ -46,6 +46,7 @@
 #include "olsr_cookie.h"
 #include "net_os.h"
 #include "mpr_selector_set.h"
+#include "convergence.h"
 
 #include <sys/times.h>
 
@@ -61,6 +62,9 @@ uint32_t now_times;                    /* relative time compared to startup (in
 struct timeval first_tv;               /* timevalue during startup */
 struct timeval last_tv;                /* timevalue used for last olsr_times() calculation */
 
+struct olsr_scheduler_stats olsr_scheduler_stats;
+static struct timeval loop_start_tv;   /* start of the current scheduler round */
+
 /* Hashed root of all timers */
 static struct list_node timer_wheel[TIMER_WHEEL_SLOTS];
 static uint32_t timer_last_run;        /* remember the last timeslot walk */
@@ -349,6 +353,20 @@ handle_fds(uint32_t next_interval)
   /* calculate the first timeout */
   now_times = olsr_times();
 
+  /* the round ends here, the rest is waiting */
+  {
+    struct timeval loop_tv;
+    uint32_t usec;
+
+    timersub(&last_tv, &loop_start_tv, &loop_tv);
+    usec = loop_tv.tv_sec * 1000000 + loop_tv.tv_usec;
+    olsr_scheduler_stats.loops++;
+    olsr_scheduler_stats.loop_usec += usec;
+    if (usec > olsr_scheduler_stats.loop_usec_max) {
+      olsr_scheduler_stats.loop_usec_max = usec;
+    }
+  }
+
   remaining = TIME_DUE(next_interval);
   if (remaining <= 0) {
     /* we are already over the interval */
@@ -447,6 +465,28 @@ handle_fds(uint32_t next_interval)
   } OLSR_FOR_ALL_SOCKETS_END(entry);
 }
 
+/**
+ * Fire the timers due at now_times and process the resulting
+ * changes. This is the part of a scheduler round without any
+ * I/O, the mesh emulator runs it with its own clock.
+ */
+void
+olsr_scheduler_round(void)
+{
+  /* Process timers */
+  walk_timers(&timer_last_run);
+
+  /* Update */
+  olsr_process_changes();
+
+  /* Check for changes in topology */
+  if (link_changes) {
+    increase_local_ansn();
+    OLSR_PRINTF(3, "ANSN UPDATED %d\n\n", get_local_ansn());
+    link_changes = false;
+  }
+}
+
 /**
  * Main scheduler event loop. Polls at every
  * sched_poll_interval and calls all functions
@@ -470,23 +510,13 @@ olsr_scheduler(void)
      * to avoid any undesired side effects if the system clock changes.
      */
     now_times = olsr_times();
+    loop_start_tv = last_tv;
     next_interval = GET_TIMESTAMP(olsr_cnf->pollrate * 1000);
 
     /* Read incoming data */
     poll_sockets();
 
-    /* Process timers */
-    walk_timers(&timer_last_run);
-
-    /* Update */
-    olsr_process_changes();
-
-    /* Check for changes in topology */
-    if (link_changes) {
-      increase_local_ansn();
-      OLSR_PRINTF(3, "ANSN UPDATED %d\n\n", get_local_ansn());
-      link_changes = false;
-    }
+    olsr_scheduler_round();
 
     /* Read incoming data and handle it immediiately */
     handle_fds(next_interval);
@@ -612,7 +642,9 @@ walk_timers(uint32_t * last_run)
                    timer, timer->timer_cb_context, (unsigned int)*last_run, olsr_wallclock_string());
 
         /* This timer is expired, call into the provided callback function */
+        olsr_conv_cause_timer(timer->timer_cookie);
         timer->timer_cb(timer->timer_cb_context);
+        olsr_conv_cause_end();
 
         /* Only act on actually running timers */
         if (timer->timer_flags & OLSR_TIMER_RUNNING) {
@@ -648,6 +680,12 @@ walk_timers(uint32_t * last_run)
     wheel_slot_walks++;
   }
 
+  olsr_scheduler_stats.timer_walks++;
+  olsr_scheduler_stats.last_timers_walked = total_timers_walked;
+  olsr_scheduler_stats.last_timers_fired = total_timers_fired;
+  olsr_scheduler_stats.timers_walked += total_timers_walked;
+  olsr_scheduler_stats.timers_fired += total_timers_fired;
+
   OLSR_PRINTF(7, "TIMER: processed %4u/%d clockwheel slots, "
              "timers walked %4u/%u, timers fired %u\n",
              wheel_slot_walks, TIMER_WHEEL_SLOTS, total_timers_walked, timer_mem_cookie->ci_usage, total_timers_fired);
@@ -659,6 +697,32 @@ walk_timers(uint32_t * last_run)
   *last_run = now_times;
 }
 
+/**
+ * Find the clock tick of the next timer due, looking at
+ * most one turn of the timer wheel ahead.
+ *
+ * @return the clock tick the next timer fires at, or one
+ *   wheel turn after the last walk if none fires before
+ */
+uint32_t
+olsr_next_timer_clock(void)
+{
+  uint32_t tick;
+
+  for (tick = timer_last_run; tick != timer_last_run + TIMER_WHEEL_SLOTS; tick++) {
+    struct list_node *const timer_head_node = &timer_wheel[tick & TIMER_WHEEL_MASK];
+    struct list_node *timer_node;
+
+    /* the slot also holds timers of later wheel turns */
+    for (timer_node = timer_head_node->next; timer_node != timer_head_node; timer_node = timer_node->next) {
+      if ((int32_t)(list2timer(timer_node)->timer_clock - tick) <= 0) {
+        return tick;
+      }
+    }
+  }
+  return tick;
+}
+
 /**
  * Stop and delete all timers.
  */
@@ -684,7 +748,7 @@ olsr_flush_timers(void)
  *
  * taken and slightly modified from www.tcpdump.org.
  */
-static int
+int
 olsr_get_timezone(void)
 {
 #define OLSR_TIMEZONE_UNINITIALIZED -1
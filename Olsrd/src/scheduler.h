@@ -98,14 +98,18 @@ void olsr_set_timer (struct timer_entry **, unsigned int, uint8_t, bool, timer_c
 struct timer_entry *olsr_start_timer (unsigned int, uint8_t, bool, timer_cb_func, void *, struct olsr_cookie_info *);
 void olsr_change_timer(struct timer_entry *, unsigned int, uint8_t, bool);
 void olsr_stop_timer (struct timer_entry *);
+uint32_t olsr_next_timer_clock(void);
 
 /* Printing timestamps */
 const char *olsr_clock_string(uint32_t);
 const char *olsr_wallclock_string(void);
+int olsr_get_timezone(void);
 
 /* Main scheduler loop */
 void olsr_scheduler(void);
 
+void olsr_scheduler_round(void);
+
 /*
  * Provides a timestamp s1 milliseconds in the future
  */
@@ -120,6 +124,20 @@ void olsr_scheduler(void);
 /* Timer data */
 extern uint32_t now_times;     /* current idea of times(2) reported uptime */
 
+/* Accounting of the main loop, read by monitoring plugins */
+struct olsr_scheduler_stats {
+  uint32_t timer_walks;                /* walk_timers() runs */
+  uint32_t last_timers_walked;         /* timers looked at by the last run */
+  uint32_t last_timers_fired;          /* timers fired by the last run */
+  uint64_t timers_walked;
+  uint64_t timers_fired;
+  uint32_t loops;                      /* scheduler rounds */
+  uint32_t loop_usec_max;              /* longest round */
+  uint64_t loop_usec;                  /* time spent in rounds, without waiting for sockets */
+};
+
+extern struct olsr_scheduler_stats olsr_scheduler_stats;
+
 
 #define SP_PR_READ		0x01
 #define SP_PR_WRITE		0x02
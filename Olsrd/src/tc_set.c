@@ -54,6 +54,8 @@
 #include "olsr_cookie.h"
 #include "duplicate_set.h"
 #include "gateway.h"
+#include "change_notify.h"
+#include "trace.h"
 
 #include <assert.h>
 
@@ -374,11 +376,10 @@ static void
 olsr_expire_tc_entry(void *context)
 {
   struct tc_entry *tc;
-  struct ipaddr_str buf;
 
   tc = (struct tc_entry *)context;
 
-  OLSR_PRINTF(3, "TC: expire node entry %s\n", olsr_ip_to_string(&buf, &tc->addr));
+  OLSR_TRACE(3, OLSR_TRACE_TC_EXPIRE_NODE, &tc->addr, NULL, 0, 0, 0);
 
   tc->validity_timer = NULL;
 
@@ -395,11 +396,10 @@ static void
 olsr_expire_tc_edge_gc(void *context)
 {
   struct tc_entry *tc;
-  struct ipaddr_str buf;
 
   tc = (struct tc_entry *)context;
 
-  OLSR_PRINTF(3, "TC: expire edge entry %s\n", olsr_ip_to_string(&buf, &tc->addr));
+  OLSR_TRACE(3, OLSR_TRACE_TC_EXPIRE_EDGE, &tc->addr, NULL, 0, 0, 0);
 
   tc->edge_gc_timer = NULL;
 
@@ -499,6 +499,8 @@ olsr_add_tc_edge_entry(struct tc_entry *tc, union olsr_ip_addr *addr, uint16_t a
   OLSR_PRINTF(1, "TC: add edge entry %s\n", olsr_tc_edge_to_string(tc_edge));
 #endif
 
+  olsr_notify_change(OLSR_CHG_TC_EDGE_ADD, &tc->addr, &tc_edge->T_dest_addr, 0, tc_edge->cost, 0);
+
   return tc_edge;
 }
 
@@ -519,6 +521,8 @@ olsr_delete_tc_edge_entry(struct tc_edge_entry *tc_edge)
 #endif
 
   tc = tc_edge->tc;
+  olsr_notify_change(OLSR_CHG_TC_EDGE_DEL, &tc->addr, &tc_edge->T_dest_addr, 0, tc_edge->cost, 0);
+
   avl_delete(&tc->edge_tree, &tc_edge->edge_node);
   olsr_unlock_tc_entry(tc);
 
@@ -648,6 +652,7 @@ olsr_tc_update_edge(struct tc_entry *tc, uint16_t ansn, const unsigned char **cu
     edge_change = 1;
 
   } else {
+    olsr_linkcost old_cost = tc_edge->cost;
 
     /*
      * We know this edge - Update entry.
@@ -667,6 +672,9 @@ olsr_tc_update_edge(struct tc_entry *tc, uint16_t ansn, const unsigned char **cu
     if (olsr_calc_tc_edge_entry_etx(tc_edge)) {
       edge_change = 1;
     }
+    if (tc_edge->cost != old_cost) {
+      olsr_notify_change(OLSR_CHG_TC_EDGE_COST, &tc->addr, &tc_edge->T_dest_addr, 0, tc_edge->cost, 0);
+    }
 #if DEBUG
     if (edge_change) {
       OLSR_PRINTF(1, "TC:   chg edge entry %s\n", olsr_tc_edge_to_string(tc_edge));
@@ -786,7 +794,6 @@ olsr_calculate_tc_border(uint8_t lower_border, union olsr_ip_addr *lower_border_
 bool
 olsr_input_tc(union olsr_message * msg, struct interface * input_if __attribute__ ((unused)), union olsr_ip_addr * from_addr)
 {
-  struct ipaddr_str buf;
   uint16_t size, msg_seq, ansn;
   uint8_t type, ttl, msg_hops, lower_border, upper_border;
   olsr_reltime vtime;
@@ -815,7 +822,7 @@ olsr_input_tc(union olsr_message * msg, struct interface * input_if __attribute_
    * message MUST be discarded.
    */
   if (check_neighbor_link(from_addr) != SYM_LINK) {
-    OLSR_PRINTF(2, "Received TC from NON SYM neighbor %s\n", olsr_ip_to_string(&buf, from_addr));
+    OLSR_TRACE(2, OLSR_TRACE_TC_NON_SYM, from_addr, NULL, 0, 0, 0);
     return false;
   }
 
@@ -851,7 +858,7 @@ olsr_input_tc(union olsr_message * msg, struct interface * input_if __attribute_
         return false;
       }
 
-      OLSR_PRINTF(1, "Ignored to much LQTC's for %s, restarting\n", olsr_ip_to_string(&buf, &originator));
+      OLSR_TRACE(1, OLSR_TRACE_TC_IGNORED, &originator, NULL, 0, 0, 0);
 
     } else if (!olsr_seq_inrange_high(tc->msg_seq, (int)tc->msg_seq + TC_SEQNO_WINDOW * TC_SEQNO_WINDOW_MULT, msg_seq)
                || !olsr_seq_inrange_low(tc->ansn, (int)tc->ansn + TC_ANSN_WINDOW * TC_ANSN_WINDOW_MULT, ansn)) {
@@ -868,7 +875,7 @@ olsr_input_tc(union olsr_message * msg, struct interface * input_if __attribute_
         return false;
       }
 
-      OLSR_PRINTF(2, "Detected node restart for %s\n", olsr_ip_to_string(&buf, &originator));
+      OLSR_TRACE(2, OLSR_TRACE_TC_RESTART, &originator, NULL, 0, 0, 0);
     }
   }
 
@@ -888,7 +895,7 @@ olsr_input_tc(union olsr_message * msg, struct interface * input_if __attribute_
   tc->ignored = 0;
   tc->err_seq_valid = false;
 
-  OLSR_PRINTF(1, "Processing TC from %s, seq 0x%04x\n", olsr_ip_to_string(&buf, &originator), tc->msg_seq);
+  OLSR_TRACE(1, OLSR_TRACE_TC_PROCESS, &originator, NULL, tc->msg_seq, 0, 0);
 
   /*
    * Now walk the edge advertisements contained in the packet.
@@ -0,0 +1,381 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+#include "trace.h"
+#include "olsr.h"
+#include "log.h"
+#include "scheduler.h"
+#include "olsr_cookie.h"
+#include "lq_plugin.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/time.h>
+
+/* records in the ring, a power of 2 */
+#define OLSR_TRACE_RING_SIZE      8192
+
+/* the ring is drained every OLSR_TRACE_DRAIN_INTERVAL ms */
+#define OLSR_TRACE_DRAIN_INTERVAL 100
+
+/* formatted lines per drain, the rest waits for the next one */
+#define OLSR_TRACE_DRAIN_LINES    1024
+
+enum olsr_trace_target {
+  TRACE_TARGET_NONE,
+  TRACE_TARGET_FILE,                   /* binary records */
+  TRACE_TARGET_SYSLOG,
+  TRACE_TARGET_DEBUG                   /* debug_handle */
+};
+
+struct olsr_trace_event_info {
+  const char *name;
+  const char *format;
+};
+
+static const struct olsr_trace_event_info trace_events[OLSR_TRACE_ID_MAX] = {
+  [OLSR_TRACE_DROPPED] = {"dropped", "TRACE: %u events dropped"},
+  [OLSR_TRACE_SPF_ADD_CAND] = {"spf_add_cand", "SPF: insert candidate %a, cost %c"},
+  [OLSR_TRACE_SPF_DEL_CAND] = {"spf_del_cand", "SPF: delete candidate %a, cost %c"},
+  [OLSR_TRACE_SPF_ADD_PATH] = {"spf_add_path", "SPF: append path %a, cost %c, via %a"},
+  [OLSR_TRACE_SPF_EXPLORE_NODE] = {"spf_explore_node", "SPF: exploring node %a, cost %c"},
+  [OLSR_TRACE_SPF_NO_INVERSE] = {"spf_no_inverse", "SPF:   ignoring edge %a, no inverse edge"},
+  [OLSR_TRACE_SPF_BROKEN_EDGE] = {"spf_broken_edge", "SPF:   ignore edge %a (broken)"},
+  [OLSR_TRACE_SPF_EXPLORE_EDGE] = {"spf_explore_edge", "SPF:   exploring edge %a, cost %r"},
+  [OLSR_TRACE_SPF_BETTER_PATH] = {"spf_better_path", "SPF:   better path to %a, cost %r, via %a, hops %u"},
+  [OLSR_TRACE_SPF_DONE] = {"spf_done", "--- %t ------------------------------------------------- DIJKSTRA (%u paths)"},
+  [OLSR_TRACE_SPF_NO_NEXTHOP] = {"spf_no_nexthop", "SPF: %a no next-hop"},
+  [OLSR_TRACE_TC_PROCESS] = {"tc_process", "Processing TC from %a, seq 0x%04x"},
+  [OLSR_TRACE_TC_NON_SYM] = {"tc_non_sym", "Received TC from NON SYM neighbor %a"},
+  [OLSR_TRACE_TC_RESTART] = {"tc_restart", "Detected node restart for %a"},
+  [OLSR_TRACE_TC_IGNORED] = {"tc_ignored", "Ignored to much LQTC's for %a, restarting"},
+  [OLSR_TRACE_TC_EXPIRE_NODE] = {"tc_expire_node", "TC: expire node entry %a"},
+  [OLSR_TRACE_TC_EXPIRE_EDGE] = {"tc_expire_edge", "TC: expire edge entry %a"},
+  [OLSR_TRACE_MSG_NOT_PROCESSED] = {"msg_not_processed", "Not processing message originating from %a!"},
+  [OLSR_TRACE_DUP_BLOCKED] = {"dup_blocked", "blocked 0x%x (diff=%d,mask=%08x) from %a"},
+  [OLSR_TRACE_DUP_PROCESSED] = {"dup_processed", "processed 0x%x from %a"},
+  [OLSR_TRACE_RIB_ADD] = {"rib_add", "RIB: add prefix %a/%u from %a"},
+  [OLSR_TRACE_RIB_DEL] = {"rib_del", "RIB: del prefix %a/%u from %a"},
+  [OLSR_TRACE_CONV_MESSAGE] = {"conv_message", "CONV: cause %u, message type %u from %a"},
+  [OLSR_TRACE_CONV_TIMER] = {"conv_timer", "CONV: cause %u, timer cookie %u"},
+  [OLSR_TRACE_CONV_OTHER] = {"conv_other", "CONV: cause %u"},
+  [OLSR_TRACE_CONV_SPF_START] = {"conv_spf_start", "CONV: cause %u, route calculation after %u us"},
+  [OLSR_TRACE_CONV_SPF_DONE] = {"conv_spf_done", "CONV: cause %u, route calculation took %u us"},
+  [OLSR_TRACE_CONV_DONE] = {"conv_done", "CONV: cause %u, kernel routes took %u us, converged after %u us"},
+};
+
+uint32_t olsr_trace_recorded, olsr_trace_dropped;
+
+static enum olsr_trace_target trace_target;
+static const char *trace_file_name;
+static FILE *trace_file;
+
+/*
+ * Single producer, single consumer ring. The indices run freely,
+ * OLSR_TRACE() only moves the head and the drain only the tail.
+ * The last free slot is kept for a DROPPED record, which counts
+ * the events lost until the drain makes room again.
+ */
+static struct olsr_trace_record *trace_ring;
+static uint32_t trace_head, trace_tail;
+
+static struct timer_entry *trace_drain_timer;
+
+static const char *
+trace_cost_text(uint32_t cost, int route, char *buf, size_t size)
+{
+  struct lqtextbuffer lqbuffer;
+
+  snprintf(buf, size, "%s", get_linkcost_text(cost, route != 0, &lqbuffer));
+  return buf;
+}
+
+/**
+ *Format a record and write it to the debug output or syslog
+ *
+ *@param rec the record
+ *@param timestamp true to prefix the time of the event
+ */
+static void
+trace_print(const struct olsr_trace_record *rec, bool timestamp)
+{
+  char line[512];
+  int len = 0;
+
+  if (timestamp) {
+    len = olsr_trace_format(line, sizeof(line), "%t ", rec, 0, olsr_get_timezone(), NULL);
+  }
+  olsr_trace_format(line + len, sizeof(line) - len, trace_events[rec->id].format, rec,
+                    olsr_cnf->ip_version == AF_INET6 ? 6 : 4, olsr_get_timezone(), &trace_cost_text);
+
+  if (trace_target == TRACE_TARGET_SYSLOG) {
+    olsr_syslog(OLSR_LOG_INFO, "%s", line);
+  } else if (debug_handle) {
+    fprintf(debug_handle, "%s\n", line);
+  }
+}
+
+/**
+ *Write the records in the ring to the trace target
+ *
+ *@param max_lines the maximum number of formatted lines
+ */
+static void
+trace_flush(uint32_t max_lines)
+{
+  if (trace_target == TRACE_TARGET_FILE) {
+    while (trace_tail != trace_head) {
+      uint32_t start = trace_tail & (OLSR_TRACE_RING_SIZE - 1);
+      uint32_t count = trace_head - trace_tail;
+
+      if (count > OLSR_TRACE_RING_SIZE - start) {
+        count = OLSR_TRACE_RING_SIZE - start;
+      }
+      if (fwrite(&trace_ring[start], sizeof(*trace_ring), count, trace_file) != count) {
+        OLSR_PRINTF(1, "TRACE: cannot write %s: %s\n", trace_file_name, strerror(errno));
+      }
+      trace_tail += count;
+    }
+    fflush(trace_file);
+    return;
+  }
+
+  for (; trace_tail != trace_head && max_lines > 0; trace_tail++, max_lines--) {
+    trace_print(&trace_ring[trace_tail & (OLSR_TRACE_RING_SIZE - 1)], true);
+  }
+}
+
+static void
+olsr_trace_drain(void *context __attribute__ ((unused)))
+{
+  trace_flush(OLSR_TRACE_DRAIN_LINES);
+}
+
+/**
+ *Record an event, see OLSR_TRACE()
+ *
+ *@param id the event
+ *@param addr1 the first address or NULL
+ *@param addr2 the second address or NULL
+ *@param arg1 the first argument
+ *@param arg2 the second argument
+ *@param arg3 the third argument
+ */
+void
+olsr_trace_event(enum olsr_trace_id id, const union olsr_ip_addr *addr1, const union olsr_ip_addr *addr2,
+                 uint32_t arg1, uint32_t arg2, uint32_t arg3)
+{
+  struct olsr_trace_record *rec, unbuffered;
+  struct timeval now;
+
+  if (trace_ring) {
+    uint32_t used = trace_head - trace_tail;
+
+    if (used >= OLSR_TRACE_RING_SIZE - 1) {
+      olsr_trace_dropped++;
+      if (used == OLSR_TRACE_RING_SIZE) {
+        /* the last record is the DROPPED record */
+        trace_ring[(trace_head - 1) & (OLSR_TRACE_RING_SIZE - 1)].arg[0]++;
+        return;
+      }
+      id = OLSR_TRACE_DROPPED;
+      addr1 = addr2 = NULL;
+      arg1 = 1;
+      arg2 = arg3 = 0;
+    }
+    rec = &trace_ring[trace_head & (OLSR_TRACE_RING_SIZE - 1)];
+  } else {
+    rec = &unbuffered;
+  }
+
+  gettimeofday(&now, NULL);
+  rec->sec = now.tv_sec;
+  rec->usec = now.tv_usec;
+  rec->id = id;
+  rec->addr_mask = 0;
+  rec->reserved = 0;
+  if (addr1) {
+    memcpy(rec->addr[0], addr1, olsr_cnf->ipsize);
+    rec->addr_mask |= 1;
+  }
+  if (addr2) {
+    memcpy(rec->addr[1], addr2, olsr_cnf->ipsize);
+    rec->addr_mask |= 2;
+  }
+  rec->arg[0] = arg1;
+  rec->arg[1] = arg2;
+  rec->arg[2] = arg3;
+  rec->arg[3] = 0;
+  rec->arg[4] = 0;
+
+  if (!trace_ring) {
+    olsr_trace_recorded++;
+    trace_print(rec, false);
+    return;
+  }
+  if (id != OLSR_TRACE_DROPPED) {
+    olsr_trace_recorded++;
+  }
+  trace_head++;
+}
+
+/**
+ *Select where the events go, called while parsing the command line
+ *
+ *@param target a file name for binary records, "syslog" or "stdout"
+ */
+void
+olsr_trace_set_target(const char *target)
+{
+  if (strcmp(target, "syslog") == 0) {
+    trace_target = TRACE_TARGET_SYSLOG;
+  } else if (strcmp(target, "stdout") == 0) {
+    trace_target = TRACE_TARGET_DEBUG;
+  } else {
+    trace_target = TRACE_TARGET_FILE;
+    trace_file_name = target;
+  }
+}
+
+/**
+ *Write the header and the event descriptions of a trace file
+ */
+static int
+trace_write_header(void)
+{
+  struct olsr_trace_file_header hdr;
+  unsigned int i;
+
+  memset(&hdr, 0, sizeof(hdr));
+  memcpy(hdr.magic, OLSR_TRACE_MAGIC, sizeof(OLSR_TRACE_MAGIC));
+  hdr.byte_order = OLSR_TRACE_BYTE_ORDER;
+  hdr.version = OLSR_TRACE_VERSION;
+  hdr.record_size = sizeof(struct olsr_trace_record);
+  hdr.ip_version = olsr_cnf->ip_version == AF_INET6 ? 6 : 4;
+  hdr.event_count = OLSR_TRACE_ID_MAX;
+  hdr.tz_offset = olsr_get_timezone();
+  if (fwrite(&hdr, sizeof(hdr), 1, trace_file) != 1) {
+    return -1;
+  }
+
+  for (i = 0; i < OLSR_TRACE_ID_MAX; i++) {
+    struct olsr_trace_event_desc desc;
+
+    memset(&desc, 0, sizeof(desc));
+    desc.id = i;
+    desc.name_len = strlen(trace_events[i].name);
+    desc.format_len = strlen(trace_events[i].format);
+    if (fwrite(&desc, sizeof(desc), 1, trace_file) != 1
+        || fwrite(trace_events[i].name, desc.name_len, 1, trace_file) != 1
+        || fwrite(trace_events[i].format, desc.format_len, 1, trace_file) != 1) {
+      return -1;
+    }
+  }
+  return fflush(trace_file);
+}
+
+/**
+ *Set up the ring and the drain if a trace target was given
+ *
+ *@return 0 on success, -1 if the trace file cannot be written
+ */
+int
+olsr_trace_init(void)
+{
+  struct olsr_cookie_info *drain_cookie;
+
+  if (trace_target == TRACE_TARGET_NONE) {
+    return 0;
+  }
+
+  if (trace_target == TRACE_TARGET_FILE) {
+    trace_file = fopen(trace_file_name, "wb");
+    if (trace_file == NULL || trace_write_header() < 0) {
+      olsr_syslog(OLSR_LOG_ERR, "Cannot write trace file %s: %s", trace_file_name, strerror(errno));
+      if (trace_file) {
+        fclose(trace_file);
+        trace_file = NULL;
+      }
+      trace_target = TRACE_TARGET_NONE;
+      return -1;
+    }
+  }
+
+  trace_ring = olsr_malloc(OLSR_TRACE_RING_SIZE * sizeof(*trace_ring), "trace ring");
+  trace_head = trace_tail = 0;
+
+  drain_cookie = olsr_alloc_cookie("Trace drain", OLSR_COOKIE_TYPE_TIMER);
+  trace_drain_timer = olsr_start_timer(OLSR_TRACE_DRAIN_INTERVAL, 0, OLSR_TIMER_PERIODIC, &olsr_trace_drain, NULL,
+                                       drain_cookie);
+  return 0;
+}
+
+/**
+ *Write out all buffered events and close the trace target,
+ *later events are printed right away
+ */
+void
+olsr_trace_shutdown(void)
+{
+  if (!trace_ring) {
+    return;
+  }
+
+  olsr_stop_timer(trace_drain_timer);
+  trace_drain_timer = NULL;
+  trace_flush(OLSR_TRACE_RING_SIZE);
+
+  if (trace_file) {
+    fclose(trace_file);
+    trace_file = NULL;
+  }
+  free(trace_ring);
+  trace_ring = NULL;
+  trace_target = TRACE_TARGET_NONE;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
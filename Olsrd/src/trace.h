@@ -0,0 +1,115 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+#ifndef _OLSR_TRACE_H
+#define _OLSR_TRACE_H
+
+#include "defs.h"
+#include "olsr_types.h"
+#include "common/trace_format.h"
+
+/*
+ * Debug output of the hot paths. OLSR_TRACE() records an event as a
+ * binary record without any formatting. Without a trace target the
+ * events are printed right away like OLSR_PRINTF() does. With one
+ * they go to a ring buffer which a low priority timer drains to a
+ * binary trace file (decoded by olsr_tracedump), to syslog or to the
+ * debug output. If the ring is full the event is dropped and counted.
+ */
+
+enum olsr_trace_id {
+  OLSR_TRACE_DROPPED,
+  OLSR_TRACE_SPF_ADD_CAND,
+  OLSR_TRACE_SPF_DEL_CAND,
+  OLSR_TRACE_SPF_ADD_PATH,
+  OLSR_TRACE_SPF_EXPLORE_NODE,
+  OLSR_TRACE_SPF_NO_INVERSE,
+  OLSR_TRACE_SPF_BROKEN_EDGE,
+  OLSR_TRACE_SPF_EXPLORE_EDGE,
+  OLSR_TRACE_SPF_BETTER_PATH,
+  OLSR_TRACE_SPF_DONE,
+  OLSR_TRACE_SPF_NO_NEXTHOP,
+  OLSR_TRACE_TC_PROCESS,
+  OLSR_TRACE_TC_NON_SYM,
+  OLSR_TRACE_TC_RESTART,
+  OLSR_TRACE_TC_IGNORED,
+  OLSR_TRACE_TC_EXPIRE_NODE,
+  OLSR_TRACE_TC_EXPIRE_EDGE,
+  OLSR_TRACE_MSG_NOT_PROCESSED,
+  OLSR_TRACE_DUP_BLOCKED,
+  OLSR_TRACE_DUP_PROCESSED,
+  OLSR_TRACE_RIB_ADD,
+  OLSR_TRACE_RIB_DEL,
+  OLSR_TRACE_CONV_MESSAGE,
+  OLSR_TRACE_CONV_TIMER,
+  OLSR_TRACE_CONV_OTHER,
+  OLSR_TRACE_CONV_SPF_START,
+  OLSR_TRACE_CONV_SPF_DONE,
+  OLSR_TRACE_CONV_DONE,
+  OLSR_TRACE_ID_MAX
+};
+
+/* events recorded and events lost on ring overflow */
+extern uint32_t olsr_trace_recorded, olsr_trace_dropped;
+
+void olsr_trace_set_target(const char *);
+int olsr_trace_init(void);
+void olsr_trace_shutdown(void);
+void olsr_trace_event(enum olsr_trace_id, const union olsr_ip_addr *, const union olsr_ip_addr *,
+                      uint32_t, uint32_t, uint32_t);
+
+#ifdef NODEBUG
+#define OLSR_TRACE(lvl, id, addr1, addr2, arg1, arg2, arg3) do { } while(0)
+#else
+#define OLSR_TRACE(lvl, id, addr1, addr2, arg1, arg2, arg3) do {          \
+    if (olsr_cnf->debug_level >= (lvl))                                   \
+      olsr_trace_event((id), (addr1), (addr2), (arg1), (arg2), (arg3));   \
+  } while (0)
+#endif
+
+#endif
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
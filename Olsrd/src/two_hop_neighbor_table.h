@@ -59,8 +59,7 @@ struct neighbor_list_entry {
 
 struct neighbor_2_entry {
   union olsr_ip_addr neighbor_2_addr;
-  uint8_t mpr_covered_count;           /*used in mpr calculation */
-  uint8_t processed;                   /*used in mpr calculation */
+  uint32_t cov_index;                  /* dense index, used in mpr calculation */
   int16_t neighbor_2_pointer;          /* Neighbor count */
   struct neighbor_list_entry neighbor_2_nblist;
   struct neighbor_2_entry *prev;
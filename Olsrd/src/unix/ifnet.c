@@ -416,6 +416,7 @@ add_hemu_if(struct olsr_if *iface)
 
   ifp->int_next = ifnet;
   ifnet = ifp;
+  olsr_msg_cache_invalidate(MSG_CACHE_MID);
 
   memset(&null_addr, 0, olsr_cnf->ipsize);
   if (ipequal(&null_addr, &olsr_cnf->main_addr)) {
@@ -799,6 +800,7 @@ chk_if_up(struct olsr_if *iface, int debuglvl __attribute__ ((unused)))
   ifp->gen_properties = NULL;
   ifp->int_next = ifnet;
   ifnet = ifp;
+  olsr_msg_cache_invalidate(MSG_CACHE_MID);
 
   set_buffer_timer(ifp);
 
@@ -507,6 +507,7 @@ add_hemu_if(struct olsr_if *iface)
 
   ifp->int_next = ifnet;
   ifnet = ifp;
+  olsr_msg_cache_invalidate(MSG_CACHE_MID);
 
   memset(&null_addr, 0, olsr_cnf->ipsize);
   if (ipequal(&null_addr, &olsr_cnf->main_addr)) {
@@ -866,6 +867,7 @@ chk_if_up(struct olsr_if *IntConf, int DebugLevel __attribute__ ((unused)))
 
   New->int_next = ifnet;
   ifnet = New;
+  olsr_msg_cache_invalidate(MSG_CACHE_MID);
 
   IntConf->interf = New;
   IntConf->configured = 1;